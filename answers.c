@@ -0,0 +1,109 @@
+/*
+ * answers.c - 'answers' module for the CS50 TSE querier
+ *
+ * see answers.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* fork and pipe are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "answers.h"
+#include "mem.h"
+
+/* the start of a rejected query's answer */
+#define ERROR_PREFIX "Error:"
+
+/**************** local functions ****************/
+static int double_cmp(const void *a, const void *b);
+
+/**************** answers_start ****************/
+/* see answers.h for description */
+pid_t
+answers_start(char **command, const char *progName, int *in_out,
+              int *out_out)
+{
+  int toChild[2], fromChild[2];
+  if (pipe(toChild) != 0 || pipe(fromChild) != 0) {
+    fprintf(stderr, "%s: cannot make pipes\n", progName);
+    exit(2);
+  }
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid < 0) {
+    fprintf(stderr, "%s: cannot start processes\n", progName);
+    exit(2);
+  }
+  if (pid == 0) {
+    dup2(toChild[0], STDIN_FILENO);
+    dup2(fromChild[1], STDOUT_FILENO);
+    dup2(fromChild[1], STDERR_FILENO);
+    close(toChild[0]);
+    close(toChild[1]);
+    close(fromChild[0]);
+    close(fromChild[1]);
+    execvp(command[0], command);
+    fprintf(stderr, "%s: cannot run '%s'\n", progName, command[0]);
+    _exit(127);
+  }
+  close(toChild[0]);
+  close(fromChild[1]);
+
+  /* processes started later must not hold this one's stdin open */
+  fcntl(toChild[1], F_SETFD, FD_CLOEXEC);
+  fcntl(fromChild[0], F_SETFD, FD_CLOEXEC);
+  *in_out = toChild[1];
+  *out_out = fromChild[0];
+  return pid;
+}
+
+/**************** answers_end ****************/
+/* see answers.h for description */
+bool
+answers_end(const char *line, const size_t len, bool *error)
+{
+  *error = (len >= strlen(ERROR_PREFIX)
+            && strncmp(line, ERROR_PREFIX, strlen(ERROR_PREFIX)) == 0);
+  return *error || (len == strlen(ANSWERS_SEPARATOR)
+                    && strncmp(line, ANSWERS_SEPARATOR, len) == 0);
+}
+
+/**************** answers_percentile ****************/
+/* see answers.h for description */
+double
+answers_percentile(const double *values, const long n, const double p)
+{
+  if (n == 0) {
+    return 0;
+  }
+  double *sorted = mem_malloc_assert(n * sizeof(double),
+                                     "answers_percentile");
+  memcpy(sorted, values, n * sizeof(double));
+  qsort(sorted, n, sizeof(double), double_cmp);
+  double exact = p / 100.0 * n;
+  long rank = (long) exact;
+  if (rank < exact) {
+    rank++;
+  }
+  double value = sorted[(rank < 1) ? 0 : rank - 1];
+  mem_free(sorted);
+  return value;
+}
+
+/* double_cmp */
+/* qsort comparator for ascending doubles. */
+static int
+double_cmp(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
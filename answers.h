@@ -0,0 +1,50 @@
+/*
+ * answers.h - header file for the querier's 'answers' module
+ *
+ * How the querier frames its answer to each query line, and what the
+ * programs that read its answers (the hedger, loadgen) share: running
+ * a querier on a pair of pipes, finding where each answer ends, and the
+ * percentiles of the latencies they report.
+ *
+ * An answer ends with the separator line. A rejected query's answer is
+ * instead its error message, one line starting "Error:", which the
+ * querier prints on stderr; a querier started by answers_start writes
+ * its stderr into the same pipe as its stdout.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __ANSWERS_H
+#define __ANSWERS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* the last line of the answer to each query */
+#define ANSWERS_SEPARATOR "-----------------------------------------------"
+
+/**************** answers_start ****************/
+/* Run command (a NULL-terminated argument vector, run with execvp) as a
+ * new process, its stdin fed by *in_out and its stdout and stderr read
+ * from *out_out; neither is inherited by processes started later.
+ * Returns the process ID. Exits on failure, saying so as progName.
+ */
+pid_t answers_start(char **command, const char *progName, int *in_out,
+                    int *out_out);
+
+/**************** answers_end ****************/
+/* Return true if line, of len characters without its newline, ends an
+ * answer: the separator line, or an error message (then *error is
+ * true).
+ */
+bool answers_end(const char *line, const size_t len, bool *error);
+
+/**************** answers_percentile ****************/
+/* Return the p-th percentile (nearest rank) of the n values, which are
+ * left as they are; 0 if there are none.
+ */
+double answers_percentile(const double *values, const long n,
+                          const double p);
+
+#endif // __ANSWERS_H
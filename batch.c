@@ -0,0 +1,382 @@
+/*
+ * batch.c - 'batch' module for the CS50 TSE querier
+ *
+ * see batch.h for more information.
+ *
+ * Results are memoized under text keys. An andsequence's key is its
+ * distinct words, sorted, then "|" and the filter key, since "a and b"
+ * and "b and a and a" match the same documents with the same scores.
+ * A query's key is its andsequences' keys, sorted but not deduplicated,
+ * since "a or a" scores each document twice. batch_plan counts the uses
+ * of every key; the andsequences of a repeated query are counted only
+ * once, as the repeats are answered from the query's own memo.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "batch.h"
+#include "blocks.h"
+#include "hashtable.h"
+#include "mem.h"
+
+/* hashtable slots for each of the batch's tables */
+#define BATCH_SLOTS 2048
+
+/**************** local types ****************/
+/* word_t: a word looked up in the index; term is NULL if not indexed. */
+typedef struct word {
+  term_t *term;
+} word_t;
+
+/* memo_t: the shared result of an andsequence or a whole query. */
+typedef struct memo {
+  int uses;            // registered uses not yet served
+  bool done;           // list holds the result
+  long cost;           // postings read to compute it
+  plist_t list;        // the result, in docID order
+} memo_t;
+
+/**************** global types ****************/
+struct batch {
+  postings_t *postings;
+  hashtable_t *words;      // word -> word_t
+  hashtable_t *seqs;       // andsequence key -> memo_t
+  hashtable_t *queries;    // query key -> memo_t
+  batchstats_t stats;
+};
+
+/**************** local functions ****************/
+static char *seq_key(const andseq_t *andseq, const char *filterKey);
+static char *query_key(const query_t *query, const char *filterKey);
+static char *join_keys(char **keys, const int n, const char sep,
+                       const bool distinct, const char *suffix);
+static int cmp_string(const void *a, const void *b);
+static memo_t *memo_use(hashtable_t *table, const char *key);
+static void memo_release(memo_t *memo);
+static void memo_delete(void *item);
+static term_t *find_word(batch_t *batch, const char *word);
+static void evaluate_seq(batch_t *batch, const andseq_t *andseq,
+                         const bitmap_t *allowed, plist_t *out,
+                         long *cost_out);
+static void union_into(plist_t *result, const plist_t *list);
+static int to_docs(const plist_t *list, docscore_t **docs_out);
+
+/**************** batch_new ****************/
+/* see batch.h for description */
+batch_t *
+batch_new(postings_t *postings)
+{
+  batch_t *batch = mem_calloc_assert(1, sizeof(batch_t), "batch_new");
+  batch->postings = postings;
+  batch->words = hashtable_new(BATCH_SLOTS);
+  batch->seqs = hashtable_new(BATCH_SLOTS);
+  batch->queries = hashtable_new(BATCH_SLOTS);
+  mem_assert(batch->words, "batch_new");
+  mem_assert(batch->seqs, "batch_new");
+  mem_assert(batch->queries, "batch_new");
+  return batch;
+}
+
+/**************** batch_plan ****************/
+/* see batch.h for description */
+void
+batch_plan(batch_t *batch, const query_t *query, const char *filterKey)
+{
+  if (batch == NULL || query == NULL || filterKey == NULL) {
+    return;
+  }
+  char *qkey = query_key(query, filterKey);
+  memo_t *qmemo = memo_use(batch->queries, qkey);
+  mem_free(qkey);
+  if (qmemo->uses > 1) {
+    return;                   // a repeat: its andsequences are not run
+  }
+  for (int s = 0; s < query->nseqs; s++) {
+    char *skey = seq_key(&query->seqs[s], filterKey);
+    memo_use(batch->seqs, skey);
+    mem_free(skey);
+  }
+}
+
+/**************** batch_evaluate ****************/
+/* see batch.h for description */
+int
+batch_evaluate(batch_t *batch, const query_t *query, const char *filterKey,
+               const bitmap_t *allowed, docscore_t **docs_out)
+{
+  *docs_out = NULL;
+  if (batch == NULL || query == NULL || filterKey == NULL) {
+    return 0;
+  }
+  batch->stats.nqueries++;
+
+  /* an identical query already ran: share its answer */
+  char *qkey = query_key(query, filterKey);
+  memo_t *qmemo = hashtable_find(batch->queries, qkey);
+  mem_free(qkey);
+  if (qmemo != NULL && qmemo->done) {
+    batch->stats.queryRepeats++;
+    batch->stats.postingsSaved += qmemo->cost;
+    int n = to_docs(&qmemo->list, docs_out);
+    memo_release(qmemo);
+    return n;
+  }
+
+  plist_t result = { 0, NULL, NULL };
+  long cost = 0;
+  for (int s = 0; s < query->nseqs; s++) {
+    const andseq_t *andseq = &query->seqs[s];
+    char *skey = seq_key(andseq, filterKey);
+    memo_t *smemo = hashtable_find(batch->seqs, skey);
+    mem_free(skey);
+    batch->stats.seqUses++;
+
+    plist_t own = { 0, NULL, NULL };
+    const plist_t *list = &own;
+    if (smemo != NULL && smemo->done) {
+      batch->stats.postingsSaved += smemo->cost;
+      cost += smemo->cost;
+      list = &smemo->list;
+    } else {
+      long seqCost;
+      evaluate_seq(batch, andseq, allowed, &own, &seqCost);
+      cost += seqCost;
+      if (smemo != NULL) {
+        smemo->list = own;
+        smemo->done = true;
+        smemo->cost = seqCost;
+        list = &smemo->list;
+      }
+    }
+
+    union_into(&result, list);
+    if (smemo != NULL) {
+      memo_release(smemo);
+    } else {
+      mem_free(own.docs);
+      mem_free(own.counts);
+    }
+  }
+
+  int n = to_docs(&result, docs_out);
+  if (qmemo != NULL && qmemo->uses > 1) {
+    qmemo->list = result;     // keep it for the repeats
+    qmemo->done = true;
+    qmemo->cost = cost;
+  } else {
+    mem_free(result.docs);
+    mem_free(result.counts);
+  }
+  if (qmemo != NULL) {
+    memo_release(qmemo);
+  }
+  return n;
+}
+
+/**************** batch_stats ****************/
+/* see batch.h for description */
+void
+batch_stats(const batch_t *batch, batchstats_t *stats)
+{
+  if (batch == NULL || stats == NULL) {
+    return;
+  }
+  *stats = batch->stats;
+}
+
+/**************** batch_delete ****************/
+/* see batch.h for description */
+void
+batch_delete(batch_t *batch)
+{
+  if (batch == NULL) {
+    return;
+  }
+  hashtable_delete(batch->words, mem_free);
+  hashtable_delete(batch->seqs, memo_delete);
+  hashtable_delete(batch->queries, memo_delete);
+  mem_free(batch);
+}
+
+/* seq_key */
+/* Return the key of andseq under filterKey (caller frees). */
+static char *
+seq_key(const andseq_t *andseq, const char *filterKey)
+{
+  char *words[andseq->nterms > 0 ? andseq->nterms : 1];
+  for (int t = 0; t < andseq->nterms; t++) {
+    words[t] = andseq->terms[t];
+  }
+  return join_keys(words, andseq->nterms, ' ', true, filterKey);
+}
+
+/* query_key */
+/* Return the key of query under filterKey (caller frees). */
+static char *
+query_key(const query_t *query, const char *filterKey)
+{
+  char *keys[query->nseqs > 0 ? query->nseqs : 1];
+  for (int s = 0; s < query->nseqs; s++) {
+    keys[s] = seq_key(&query->seqs[s], filterKey);
+  }
+  char *key = join_keys(keys, query->nseqs, '\n', false, "");
+  for (int s = 0; s < query->nseqs; s++) {
+    mem_free(keys[s]);
+  }
+  return key;
+}
+
+/* join_keys */
+/* Sort the n strings of keys (reordering the array), drop repeats if
+ * distinct, and return a new string of them separated by sep, followed
+ * by "|" and suffix. Caller frees with mem_free.
+ */
+static char *
+join_keys(char **keys, const int n, const char sep, const bool distinct,
+          const char *suffix)
+{
+  qsort(keys, n, sizeof(char *), cmp_string);
+  size_t len = strlen(suffix) + 2;
+  for (int i = 0; i < n; i++) {
+    len += strlen(keys[i]) + 1;
+  }
+
+  char *key = mem_malloc_assert(len, "join_keys");
+  char *p = key;
+  for (int i = 0; i < n; i++) {
+    if (distinct && i > 0 && strcmp(keys[i], keys[i-1]) == 0) {
+      continue;
+    }
+    if (p != key) {
+      *p++ = sep;
+    }
+    strcpy(p, keys[i]);
+    p += strlen(p);
+  }
+  *p++ = '|';
+  strcpy(p, suffix);
+  return key;
+}
+
+/* cmp_string */
+/* qsort comparison for an array of char *. */
+static int
+cmp_string(const void *a, const void *b)
+{
+  return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+/* memo_use */
+/* Count one more use of key in table, adding its memo if new. */
+static memo_t *
+memo_use(hashtable_t *table, const char *key)
+{
+  memo_t *memo = hashtable_find(table, key);
+  if (memo == NULL) {
+    memo = mem_calloc_assert(1, sizeof(memo_t), "memo_use");
+    hashtable_insert(table, key, memo);
+  }
+  memo->uses++;
+  return memo;
+}
+
+/* memo_release */
+/* Count one use of memo as served, and free its result after the last
+ * one. A result is recomputed if more uses come than were registered.
+ */
+static void
+memo_release(memo_t *memo)
+{
+  if (--memo->uses <= 0 && memo->done) {
+    mem_free(memo->list.docs);
+    mem_free(memo->list.counts);
+    memo->list.n = 0;
+    memo->list.docs = NULL;
+    memo->list.counts = NULL;
+    memo->done = false;
+  }
+}
+
+/* memo_delete */
+/* Free a memo_t and any result it still holds. */
+static void
+memo_delete(void *item)
+{
+  memo_t *memo = item;
+  mem_free(memo->list.docs);
+  mem_free(memo->list.counts);
+  mem_free(memo);
+}
+
+/* find_word */
+/* Return word's term_t (NULL if not indexed), looking it up in the
+ * index only the first time the batch meets the word.
+ */
+static term_t *
+find_word(batch_t *batch, const char *word)
+{
+  word_t *found = hashtable_find(batch->words, word);
+  if (found == NULL) {
+    found = mem_malloc_assert(sizeof(word_t), "find_word");
+    found->term = postings_find(batch->postings, word);
+    hashtable_insert(batch->words, word, found);
+    batch->stats.wordsLoaded++;
+  }
+  batch->stats.wordUses++;
+  return found->term;
+}
+
+/* evaluate_seq */
+/* Intersect andseq's words into *out (a new list; see
+ * blocks_andsequence), and set *cost_out to the postings read.
+ */
+static void
+evaluate_seq(batch_t *batch, const andseq_t *andseq, const bitmap_t *allowed,
+             plist_t *out, long *cost_out)
+{
+  const term_t *terms[andseq->nterms > 0 ? andseq->nterms : 1];
+  long cost = 0;
+  for (int t = 0; t < andseq->nterms; t++) {
+    terms[t] = find_word(batch, andseq->terms[t]);
+    cost += (terms[t] == NULL) ? 0 : terms[t]->full.n;
+  }
+  /* the result is memoized for other queries, so never cut short */
+  blocks_andsequence(terms, andseq->nterms, allowed, NULL, out);
+  batch->stats.seqEvaluated++;
+  batch->stats.postingsRead += cost;
+  *cost_out = cost;
+}
+
+/* union_into */
+/* Replace *result, which we own, by its union with list. */
+static void
+union_into(plist_t *result, const plist_t *list)
+{
+  int cap = result->n + list->n + 1;
+  plist_t out;
+  out.docs = mem_malloc_assert(cap * sizeof(int), "union_into");
+  out.counts = mem_malloc_assert(cap * sizeof(int), "union_into");
+  blocks_union(result, list, &out);
+  mem_free(result->docs);
+  mem_free(result->counts);
+  *result = out;
+}
+
+/* to_docs */
+/* Copy list into a new docscore_t array; returns list->n. */
+static int
+to_docs(const plist_t *list, docscore_t **docs_out)
+{
+  docscore_t *docs = mem_malloc_assert((list->n + 1) * sizeof(docscore_t),
+                                       "to_docs");
+  for (int i = 0; i < list->n; i++) {
+    docs[i].docID = list->docs[i];
+    docs[i].score = list->counts[i];
+  }
+  *docs_out = docs;
+  return list->n;
+}
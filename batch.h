@@ -0,0 +1,76 @@
+/*
+ * batch.h - header file for the querier's 'batch' module
+ *
+ * Batch evaluation shares work between the queries of one batch. The
+ * querier first registers every query of the batch (batch_plan), which
+ * counts how often each andsequence, and each whole query, occurs; it
+ * then evaluates them in order (batch_evaluate). Each distinct word is
+ * looked up once per batch, each distinct andsequence (the same words
+ * under the same host filter, in any order) is intersected once, and a
+ * repeated query is answered from the first one's result. A memoized
+ * result is freed as soon as its last registered use has been served.
+ *
+ * Evaluation uses the block engine's primitives (see blocks.h), so
+ * results are the same as every other engine's.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __BATCH_H
+#define __BATCH_H
+
+#include "postings.h"
+#include "query.h"
+#include "bitmap.h"
+
+typedef struct batch batch_t;
+
+/* batchstats_t: how much work the batch shared. */
+typedef struct batchstats {
+  int nqueries;        // queries evaluated
+  int queryRepeats;    // ...answered from an identical earlier query
+  int seqUses;         // andsequences in the queries not repeated
+  int seqEvaluated;    // ...actually intersected
+  int wordUses;        // words looked up by those intersections
+  int wordsLoaded;     // ...distinct, each found in the index once
+  long postingsRead;   // postings fed to the intersections
+  long postingsSaved;  // postings shared results saved reading again
+} batchstats_t;
+
+/**************** batch_new ****************/
+/* Return a new, empty batch over postings; caller must batch_delete it.
+ * Exits if out of memory.
+ */
+batch_t *batch_new(postings_t *postings);
+
+/**************** batch_plan ****************/
+/* Register one use of query, with the host filter named by filterKey
+ * ("" for none; queries with the same key must allow the same
+ * documents). Every query must be registered before any is evaluated.
+ */
+void batch_plan(batch_t *batch, const query_t *query, const char *filterKey);
+
+/**************** batch_evaluate ****************/
+/* Evaluate a registered query, sharing work with the rest of the batch.
+ *
+ * Caller provides:
+ *   the query and filterKey it was registered with, and allowed, the
+ *   documents the key's filter allows (NULL for all).
+ * We return:
+ *   the number of results, and in *docs_out a new array of them in
+ *   docID order (caller frees with mem_free).
+ * Unregistered queries are evaluated too, but share nothing.
+ */
+int batch_evaluate(batch_t *batch, const query_t *query,
+                   const char *filterKey, const bitmap_t *allowed,
+                   docscore_t **docs_out);
+
+/**************** batch_stats ****************/
+/* Fill *stats with the sharing counts so far. */
+void batch_stats(const batch_t *batch, batchstats_t *stats);
+
+/**************** batch_delete ****************/
+/* Free the batch and any results still memoized; NULL is ignored. */
+void batch_delete(batch_t *batch);
+
+#endif // __BATCH_H
@@ -0,0 +1,245 @@
+#!/usr/bin/env bash
+# bench.sh — compare the querier's evaluation engines on one index
+#
+# usage: bash bench.sh [pageDirectory indexFilename [nqueries]]
+#
+# Builds a query mix from the index's own words (single words, two-word
+# ANDs, two-word ORs, and three-word mixes of both), runs it through each
+# engine with -stats, and checks every engine printed the same results.
+
+set -e
+
+Q=./querier
+
+PDIR=${1:-/cs50/shared/tse/output/letters-1}
+IDX=${2:-/cs50/shared/tse/output/letters-1.index}
+[[ -f "$PDIR/.crawler" ]] || PDIR="$HOME/cs50-dev/shared/tse/output/letters-1"
+[[ -r "$IDX" ]] || IDX="$HOME/cs50-dev/shared/tse/output/letters-1.index"
+NQ=${3:-400}
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# the same mix every run
+cut -d' ' -f1 "$IDX" > "$TMP/words"
+awk -v nq="$NQ" 'BEGIN { srand(1) }
+  { w[n++] = $1 }
+  END {
+    if (n == 0) exit
+    for (i = 0; i < nq; i++) {
+      a = w[int(rand() * n)]; b = w[int(rand() * n)]; c = w[int(rand() * n)]
+      if (i % 4 == 0)      print a
+      else if (i % 4 == 1) print a, b
+      else if (i % 4 == 2) print a, "or", b
+      else                 print a, b, "or", c
+    }
+  }' "$TMP/words" > "$TMP/mix"
+
+echo "$(wc -l < "$TMP/mix") queries over $(wc -l < "$IDX") words"
+for k in "" "-k 10"; do
+  for engine in taat daat block auto; do
+    echo "== -engine $engine $k =="
+    $Q $k -engine $engine -stats "$PDIR" "$IDX" < "$TMP/mix" \
+      > "$TMP/$engine.out" 2> "$TMP/$engine.err"
+    grep "engine" "$TMP/$engine.err"
+  done
+  cmp "$TMP/taat.out" "$TMP/daat.out"
+  cmp "$TMP/taat.out" "$TMP/block.out"
+  cmp "$TMP/taat.out" "$TMP/auto.out"
+done
+
+# skewed conjunctions: a rare word (bottom quarter by postings) and one
+# or two long-listed words (top tenth, but not the top 2%, which are on
+# nearly every page, so probing them seldom misses), with and without
+# Bloom filters on the long lists
+awk '{ print (NF - 1) / 2, $1 }' "$IDX" | sort -n > "$TMP/bysize"
+NWORDS=$(wc -l < "$TMP/bysize")
+head -n $((NWORDS / 4)) "$TMP/bysize" | cut -d' ' -f2 > "$TMP/rare"
+sed -n "$((NWORDS * 9 / 10)),$((NWORDS * 98 / 100))p" "$TMP/bysize" \
+  | cut -d' ' -f2 > "$TMP/common"
+awk -v nq="$NQ" 'BEGIN { srand(2) }
+  FNR == NR { r[nr++] = $1; next }
+  { c[nc++] = $1 }
+  END {
+    if (nr == 0 || nc == 0) exit
+    for (i = 0; i < nq; i++) {
+      a = r[int(rand() * nr)]; b = c[int(rand() * nc)]; d = c[int(rand() * nc)]
+      if (i % 2 == 0) print a, b
+      else            print a, b, d
+    }
+  }' "$TMP/rare" "$TMP/common" > "$TMP/skewed"
+
+echo "$(wc -l < "$TMP/skewed") skewed conjunctions"
+for engine in taat block; do
+  for bloom in "" "-bloom"; do
+    echo "== -engine $engine $bloom =="
+    $Q -engine $engine $bloom -stats "$PDIR" "$IDX" < "$TMP/skewed" \
+      > "$TMP/skewed$bloom.out" 2> "$TMP/skewed.err"
+    grep "engine $engine:" "$TMP/skewed.err"
+  done
+  cmp "$TMP/skewed.out" "$TMP/skewed-bloom.out"
+done
+
+# the same conjunctions written long word first, with and without
+# sketch-based planning (which reorders them, and guides -engine auto)
+awk '{ for (i = NF; i > 0; i--) printf "%s%s", $i, (i > 1 ? " " : "\n") }' \
+  "$TMP/skewed" > "$TMP/reversed"
+for engine in taat block auto; do
+  for plan in "" "-plan"; do
+    echo "== -engine $engine $plan (long word first) =="
+    $Q -engine $engine $plan -stats "$PDIR" "$IDX" < "$TMP/reversed" \
+      > "$TMP/reversed$plan.out" 2> "$TMP/reversed.err"
+    grep -v " 0 queries" "$TMP/reversed.err"
+  done
+  cmp "$TMP/reversed.out" "$TMP/reversed-plan.out"
+done
+
+# a stream with repeated queries and shared andsequences (the mix, the
+# skewed conjunctions, and the mix again), query by query and as a batch
+cat "$TMP/mix" "$TMP/skewed" "$TMP/mix" > "$TMP/stream"
+echo "$(wc -l < "$TMP/stream") queries in a stream"
+echo "== -engine block =="
+$Q -engine block -stats "$PDIR" "$IDX" < "$TMP/stream" \
+  > "$TMP/stream.out" 2> "$TMP/stream.err"
+grep "engine block:" "$TMP/stream.err"
+echo "== -batch =="
+$Q -batch "$PDIR" "$IDX" < "$TMP/stream" \
+  > "$TMP/stream-batch.out" 2> "$TMP/stream.err"
+grep "batch:" "$TMP/stream.err"
+cmp "$TMP/stream.out" "$TMP/stream-batch.out"
+
+# the same stream on compressed postings, through block caches of
+# several sizes
+for cache in 64 256 1024 4096; do
+  echo "== -engine block -compressed -cache $cache =="
+  $Q -engine block -compressed -cache $cache -stats "$PDIR" "$IDX" \
+    < "$TMP/stream" > "$TMP/stream-packed.out" 2> "$TMP/stream.err"
+  grep -E "compressed|block cache|engine block:" "$TMP/stream.err"
+  cmp "$TMP/stream.out" "$TMP/stream-packed.out"
+done
+
+# one-word, two-word and, and two-word or queries over the longer half
+# of the lists, through TAAT's fast paths and its general loop
+sed -n "$((NWORDS / 2)),\$p" "$TMP/bysize" | cut -d' ' -f2 > "$TMP/upper"
+awk -v nq="$NQ" 'BEGIN { srand(3) }
+  { w[n++] = $1 }
+  END {
+    if (n == 0) exit
+    for (i = 0; i < nq; i++) {
+      a = w[int(rand() * n)]; b = w[int(rand() * n)]
+      if (i % 4 == 0)      print a
+      else if (i % 4 == 1) print a, b
+      else if (i % 4 == 2) print a, "and", b
+      else                 print a, "or", b
+    }
+  }' "$TMP/upper" > "$TMP/shapes"
+echo "$(wc -l < "$TMP/shapes") one- and two-word queries"
+for fast in "-nofast" ""; do
+  for bloom in "" "-bloom"; do
+    echo "== -engine taat $fast $bloom =="
+    $Q -engine taat $fast $bloom -stats "$PDIR" "$IDX" < "$TMP/shapes" \
+      > "$TMP/shapes$fast.out" 2> "$TMP/shapes.err"
+    grep "taat" "$TMP/shapes.err"
+  done
+done
+cmp "$TMP/shapes.out" "$TMP/shapes-nofast.out"
+
+# ranking sorts across result sizes (beyond what a query here returns)
+echo "== ranking sorts =="
+if [[ -x ./sortbench ]]; then
+  ./sortbench
+fi
+
+# time to first and last result, streaming, for every query in the mix
+for k in "" "-k 10"; do
+  echo "== -stream $k =="
+  $Q -stream $k -engine block "$PDIR" "$IDX" < "$TMP/mix" > /dev/null 2> "$TMP/stream.err"
+  grep "stream:" "$TMP/stream.err"
+done
+
+# the mix on worker threads, with each NUMA placement
+for mode in "" "-workers 1" "-workers 2" "-workers 4" "-numa replicate" \
+            "-numa interleave"; do
+  echo "== -engine block $mode =="
+  start=$(date +%s%N)
+  $Q $mode -engine block "$PDIR" "$IDX" < "$TMP/mix" > "$TMP/workers.out" \
+    2> "$TMP/workers.err"
+  echo "$(( ($(date +%s%N) - start) / 1000000 )) ms in all"
+  grep -E "workers|node" "$TMP/workers.err" || true
+  [[ -n "$mode" ]] || cp "$TMP/workers.out" "$TMP/serial.out"
+  cmp "$TMP/serial.out" "$TMP/workers.out"
+done
+
+# open-loop latency vs. offered rate, to find each engine's saturation
+for engine in taat daat block; do
+  echo "== loadgen -engine $engine =="
+  if [[ -x ./loadgen ]]; then
+    ./loadgen -procs 2 -rate 50,100,200,400,800 -seconds 2 -drain 10 \
+      "$TMP/mix" $Q -engine $engine "$PDIR" "$IDX"
+  fi
+done
+
+# the same curve on one querier's workers, with and without lanes
+for mode in "-workers 3" "-workers 3 -lanes 1"; do
+  echo "== loadgen $mode =="
+  if [[ -x ./loadgen ]]; then
+    ./loadgen -procs 1 -rate 50,100,200,400,800 -seconds 2 -drain 10 \
+      "$TMP/mix" $Q $mode "$PDIR" "$IDX"
+  fi
+done
+
+# head-of-line blocking on one thread: the mix on one stream, while
+# another asks for the union of the 20 longest posting lists
+awk '{ print NF, $1 }' "$IDX" | sort -rn | head -20 | cut -d' ' -f2 \
+  | paste -sd' ' | sed 's/ / or /g' > "$TMP/h1"
+for i in $(seq 20); do cat "$TMP/h1"; done > "$TMP/heavy"
+cp "$TMP/mix" "$TMP/light"
+for slice in 0 4096 1024 256; do
+  echo "== -inputs heavy,light -slice $slice =="
+  $Q -k 10 -slice $slice -inputs "$TMP/heavy,$TMP/light" "$PDIR" "$IDX" \
+    2>&1 | grep "input"
+done
+
+# many clients on one socket-serving querier: system calls per query and
+# the highest rate sustained, for each event loop (one-word queries, so
+# the loop's own costs show)
+grep -v -x -E 'and|or' "$TMP/words" > "$TMP/oneword"
+for io in uring epoll; do
+  echo "== loadgen -connect, 256 connections, -io $io =="
+  if [[ -x ./loadgen ]]; then
+    rm -f "$TMP/fifo"
+    mkfifo "$TMP/fifo"
+    $Q -k 10 -listen 0 -io $io "$PDIR" "$IDX" < "$TMP/fifo" 2> "$TMP/listen.err" &
+    lpid=$!
+    exec 3> "$TMP/fifo"
+    until grep -q 'listening on port' "$TMP/listen.err"; do
+      sleep 0.1
+    done
+    port=$(sed -n 's/.*listening on port \([0-9]*\).*/\1/p' "$TMP/listen.err")
+    ./loadgen -connect $port -procs 256 -rate 1000,2000,4000,8000,16000 \
+      -seconds 2 -drain 10 "$TMP/oneword"
+    exec 3>&-
+    wait $lpid
+    grep "listen (" "$TMP/listen.err"
+  fi
+done
+
+# a replica that stalls now and then (stopped 50 ms of every 500, as if
+# paging) drives the tail; hedging after the p95 should cut it
+for hedge in 0 95; do
+  echo "== loadgen -replicas 3 -hedge $hedge, one replica stalling =="
+  if [[ -x ./loadgen ]]; then
+    ( sleep 2
+      while true; do
+        fe=$(pgrep -n -f -- "-replicas 3 -hedge $hedge") || break
+        r0=$(pgrep -o -P "$fe") || break
+        kill -STOP "$r0"; sleep 0.05; kill -CONT "$r0"; sleep 0.45
+      done ) &
+    stutter=$!
+    ./loadgen -procs 1 -rate 50,100,200 -seconds 4 -drain 10 \
+      "$TMP/mix" $Q -k 10 -replicas 3 -hedge $hedge "$PDIR" "$IDX" 2>&1 \
+      | grep -v "^querier: replica [0-9] is process"
+    kill $stutter 2> /dev/null || true
+    wait $stutter 2> /dev/null || true
+  fi
+done
@@ -0,0 +1,81 @@
+/*
+ * bitmap.c - 'bitmap' module for the CS50 TSE querier
+ *
+ * see bitmap.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "bitmap.h"
+#include "mem.h"
+
+/**************** bitmap_new ****************/
+/* see bitmap.h for description */
+bitmap_t *
+bitmap_new(const int nbits)
+{
+  int n = (nbits > 0) ? nbits : 0;
+  bitmap_t *bitmap = mem_malloc_assert(sizeof(bitmap_t), "bitmap_new");
+  bitmap->nbits = n;
+  bitmap->words = mem_calloc_assert((n + 63) / 64 + 1, sizeof(uint64_t),
+                                    "bitmap_new words");
+  return bitmap;
+}
+
+/**************** bitmap_set ****************/
+/* see bitmap.h for description */
+void
+bitmap_set(bitmap_t *bitmap, const int bit)
+{
+  if (bitmap != NULL && bit >= 0 && bit < bitmap->nbits) {
+    bitmap->words[bit >> 6] |= (uint64_t) 1 << (bit & 63);
+  }
+}
+
+/**************** bitmap_or ****************/
+/* see bitmap.h for description */
+void
+bitmap_or(bitmap_t *dest, const bitmap_t *src)
+{
+  if (dest == NULL || src == NULL) {
+    return;
+  }
+  int nbits = (dest->nbits < src->nbits) ? dest->nbits : src->nbits;
+  int nwords = (nbits + 63) / 64;
+  for (int i = 0; i < nwords; i++) {
+    dest->words[i] |= src->words[i];
+  }
+  /* keep bits beyond dest->nbits clear */
+  if (nbits == dest->nbits && (nbits & 63) != 0) {
+    dest->words[nwords-1] &= ((uint64_t) 1 << (nbits & 63)) - 1;
+  }
+}
+
+/**************** bitmap_count ****************/
+/* see bitmap.h for description */
+int
+bitmap_count(const bitmap_t *bitmap)
+{
+  if (bitmap == NULL) {
+    return 0;
+  }
+  int count = 0;
+  int nwords = (bitmap->nbits + 63) / 64;
+  for (int i = 0; i < nwords; i++) {
+    count += __builtin_popcountll(bitmap->words[i]);
+  }
+  return count;
+}
+
+/**************** bitmap_delete ****************/
+/* see bitmap.h for description */
+void
+bitmap_delete(bitmap_t *bitmap)
+{
+  if (bitmap != NULL) {
+    mem_free(bitmap->words);
+    mem_free(bitmap);
+  }
+}
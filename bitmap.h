@@ -0,0 +1,54 @@
+/*
+ * bitmap.h - header file for the querier's 'bitmap' module
+ *
+ * A bitmap_t is a fixed-size set of small non-negative integers
+ * (docIDs, in the querier), one bit each.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __BITMAP_H
+#define __BITMAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct bitmap {
+  int nbits;           // bits 0..nbits-1 are valid
+  uint64_t *words;     // (nbits+63)/64 words
+} bitmap_t;
+
+/**************** bitmap_new ****************/
+/* Return a new, all-clear bitmap of nbits bits; caller must
+ * bitmap_delete it. Exits if out of memory.
+ */
+bitmap_t *bitmap_new(const int nbits);
+
+/**************** bitmap_set ****************/
+/* Set bit; bits outside the bitmap are ignored. */
+void bitmap_set(bitmap_t *bitmap, const int bit);
+
+/**************** bitmap_or ****************/
+/* dest |= src, over the bits both bitmaps have. */
+void bitmap_or(bitmap_t *dest, const bitmap_t *src);
+
+/**************** bitmap_count ****************/
+/* Return the number of set bits. */
+int bitmap_count(const bitmap_t *bitmap);
+
+/**************** bitmap_delete ****************/
+/* Free the bitmap; NULL is ignored. */
+void bitmap_delete(bitmap_t *bitmap);
+
+/**************** bitmap_test ****************/
+/* Return true if bit is set; bits outside the bitmap are clear.
+ * Inline because it sits in the inner loop of every filtered query.
+ */
+static inline bool
+bitmap_test(const bitmap_t *bitmap, const int bit)
+{
+  return bit >= 0 && bit < bitmap->nbits
+    && ((bitmap->words[bit >> 6] >> (bit & 63)) & 1) != 0;
+}
+
+#endif // __BITMAP_H
@@ -0,0 +1,440 @@
+/*
+ * blocks.c - 'blocks' module for the CS50 TSE querier
+ *
+ * see blocks.h for more information.
+ *
+ * Each andsequence intersects its words shortest list first (or, when
+ * the terms have sketches and the lists are long, in the order
+ * sketch_order plans), so every
+ * intermediate result fits in a buffer the size of the first list;
+ * two such buffers are swapped as the words go by. A list much longer
+ * than the other is probed by galloping instead of merged block by
+ * block. The andsequences are then unioned one at a time.
+ *
+ * A compressed list (see pcache.h) is intersected a block at a time:
+ * the skip table says which of its blocks can hold the next documents
+ * of the other list, and only those blocks are fetched from the cache
+ * (and decoded on a miss). A block none of whose candidates passes the
+ * list's Bloom filter is not fetched at all.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "blocks.h"
+#include "pcache.h"
+#include "mem.h"
+
+/* gallop through b instead of merging once b is this many times longer */
+#define GALLOP_RATIO 32
+
+/* planning from sketches costs microseconds; below this many postings
+ * in an andsequence, shortest first is cheaper than a better order */
+#define PLAN_MIN_POSTINGS 8192
+
+/**************** local functions ****************/
+static int intersect_block(const int *adocs, const int *acounts,
+                           const int *bdocs, const int *bcounts,
+                           int *docs, int *counts);
+static int intersect_gallop(const plist_t *a, const plist_t *b,
+                            const bloom_t *bbloom, plist_t *out);
+static int intersect_packed(const plist_t *a, const term_t *term,
+                            plist_t *out);
+static int evaluate_andsequence(postings_t *postings, const andseq_t *andseq,
+                                const bitmap_t *allowed, cancel_t *cancel,
+                                plist_t *out);
+static int filter_allowed(plist_t *list, const bitmap_t *allowed);
+
+/**************** blocks_intersect ****************/
+/* see blocks.h for description */
+int
+blocks_intersect(const plist_t *a, const plist_t *b, const bloom_t *bbloom,
+                 plist_t *out)
+{
+  /* a is the shorter list; the filter is only for b */
+  if (a->n > b->n) {
+    const plist_t *swap = a;
+    a = b;
+    b = swap;
+    bbloom = NULL;
+  }
+  if (a->n == 0) {
+    return out->n = 0;
+  }
+  if (b->n / a->n >= GALLOP_RATIO) {
+    return intersect_gallop(a, b, bbloom, out);
+  }
+
+  int *docs = out->docs;
+  int *counts = out->counts;
+  int i = 0, j = 0, n = 0;
+
+  /* whole blocks; the block with the smaller last docID moves on */
+  while (i + BLOCK_SIZE <= a->n && j + BLOCK_SIZE <= b->n) {
+    n += intersect_block(&a->docs[i], &a->counts[i],
+                         &b->docs[j], &b->counts[j], &docs[n], &counts[n]);
+    int alast = a->docs[i + BLOCK_SIZE - 1];
+    int blast = b->docs[j + BLOCK_SIZE - 1];
+    i += (alast <= blast) * BLOCK_SIZE;
+    j += (blast <= alast) * BLOCK_SIZE;
+  }
+
+  /* the tail, a docID at a time; the output slot is always written and
+   * kept only on a match */
+  while (i < a->n && j < b->n) {
+    int adoc = a->docs[i], bdoc = b->docs[j];
+    int acount = a->counts[i], bcount = b->counts[j];
+    docs[n] = adoc;
+    counts[n] = (acount < bcount) ? acount : bcount;
+    n += (adoc == bdoc);
+    i += (adoc <= bdoc);
+    j += (bdoc <= adoc);
+  }
+
+  return out->n = n;
+}
+
+/* intersect_block */
+/* Find which of the BLOCK_SIZE docIDs at adocs also appear among the
+ * BLOCK_SIZE at bdocs, and write those, in order, with the min of their
+ * two counts. Always writes BLOCK_SIZE slots of docs and counts; returns
+ * how many of them hold matches.
+ */
+static int
+intersect_block(const int *adocs, const int *acounts,
+                const int *bdocs, const int *bcounts,
+                int *docs, int *counts)
+{
+  int mins[BLOCK_SIZE];
+  int mask;
+
+#ifdef __SSE2__
+  __m128i va = _mm_loadu_si128((const __m128i *) adocs);
+  __m128i vb = _mm_loadu_si128((const __m128i *) bdocs);
+  __m128i cb = _mm_loadu_si128((const __m128i *) bcounts);
+  __m128i match = _mm_setzero_si128();
+  __m128i other = _mm_setzero_si128();   // b's count, where a lane matched
+
+  /* compare with all four rotations of b's block */
+  for (int r = 0; r < BLOCK_SIZE; r++) {
+    __m128i eq = _mm_cmpeq_epi32(va, vb);
+    match = _mm_or_si128(match, eq);
+    other = _mm_or_si128(other, _mm_and_si128(eq, cb));
+    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+    cb = _mm_shuffle_epi32(cb, _MM_SHUFFLE(0, 3, 2, 1));
+  }
+
+  /* min(a's count, b's count); SSE2 has no 32-bit min */
+  __m128i ca = _mm_loadu_si128((const __m128i *) acounts);
+  __m128i gt = _mm_cmpgt_epi32(ca, other);
+  __m128i min = _mm_or_si128(_mm_and_si128(gt, other),
+                             _mm_andnot_si128(gt, ca));
+  _mm_storeu_si128((__m128i *) mins, min);
+  mask = _mm_movemask_ps(_mm_castsi128_ps(match));
+#else
+  mask = 0;
+  for (int x = 0; x < BLOCK_SIZE; x++) {
+    int other = 0;
+    int eq = 0;
+    for (int y = 0; y < BLOCK_SIZE; y++) {
+      int hit = (adocs[x] == bdocs[y]);
+      eq |= hit;
+      other |= -hit & bcounts[y];
+    }
+    mins[x] = (acounts[x] < other) ? acounts[x] : other;
+    mask |= eq << x;
+  }
+#endif
+
+  /* branch-free compaction of the survivors */
+  int n = 0;
+  for (int x = 0; x < BLOCK_SIZE; x++) {
+    docs[n] = adocs[x];
+    counts[n] = mins[x];
+    n += (mask >> x) & 1;
+  }
+  return n;
+}
+
+/* intersect_gallop */
+/* Intersect a with a much longer b by seeking each of a's docIDs in b,
+ * unless bbloom (if not NULL) says it is not there.
+ */
+static int
+intersect_gallop(const plist_t *a, const plist_t *b, const bloom_t *bbloom,
+                 plist_t *out)
+{
+  int n = 0;
+  int j = 0;
+  for (int i = 0; i < a->n; i++) {
+    int doc = a->docs[i];
+    if (bbloom != NULL && !bloom_test(bbloom, doc)) {
+      continue;
+    }
+    j = postings_seek(b, j, doc);
+    if (j == b->n) {
+      break;
+    }
+    int acount = a->counts[i], bcount = b->counts[j];
+    out->docs[n] = doc;
+    out->counts[n] = (acount < bcount) ? acount : bcount;
+    n += (b->docs[j] == doc);
+  }
+  return out->n = n;
+}
+
+/**************** blocks_union ****************/
+/* see blocks.h for description */
+int
+blocks_union(const plist_t *a, const plist_t *b, plist_t *out)
+{
+  int i = 0, j = 0, n = 0;
+
+  /* take the smaller docID, or both when equal, without branching */
+  while (i < a->n && j < b->n) {
+    int adoc = a->docs[i], bdoc = b->docs[j];
+    int takea = (adoc <= bdoc);
+    int takeb = (bdoc <= adoc);
+    out->docs[n] = takea ? adoc : bdoc;
+    out->counts[n] = (-takea & a->counts[i]) + (-takeb & b->counts[j]);
+    n++;
+    i += takea;
+    j += takeb;
+  }
+  for (; i < a->n; i++, n++) {
+    out->docs[n] = a->docs[i];
+    out->counts[n] = a->counts[i];
+  }
+  for (; j < b->n; j++, n++) {
+    out->docs[n] = b->docs[j];
+    out->counts[n] = b->counts[j];
+  }
+
+  return out->n = n;
+}
+
+/**************** blocks_evaluate ****************/
+/* see blocks.h for description */
+int
+blocks_evaluate(postings_t *postings, const query_t *query,
+                const bitmap_t *allowed, cancel_t *cancel,
+                docscore_t **docs_out)
+{
+  plist_t acc = { 0, NULL, NULL };    // union of andsequences so far
+
+  for (int s = 0; postings != NULL && query != NULL && s < query->nseqs
+         && !cancel_check(cancel); s++) {
+    plist_t seq;
+    if (evaluate_andsequence(postings, &query->seqs[s], allowed, cancel,
+                             &seq) == 0) {
+      mem_free(seq.docs);
+      mem_free(seq.counts);
+      continue;
+    }
+    if (acc.n == 0) {
+      mem_free(acc.docs);
+      mem_free(acc.counts);
+      acc = seq;
+      continue;
+    }
+
+    plist_t both;
+    both.docs = mem_malloc_assert((acc.n + seq.n) * sizeof(int),
+                                  "blocks_evaluate");
+    both.counts = mem_malloc_assert((acc.n + seq.n) * sizeof(int),
+                                    "blocks_evaluate");
+    blocks_union(&acc, &seq, &both);
+    mem_free(acc.docs);
+    mem_free(acc.counts);
+    mem_free(seq.docs);
+    mem_free(seq.counts);
+    acc = both;
+  }
+
+  docscore_t *docs = mem_malloc_assert((acc.n + 1) * sizeof(docscore_t),
+                                       "blocks_evaluate");
+  for (int i = 0; i < acc.n; i++) {
+    docs[i].docID = acc.docs[i];
+    docs[i].score = acc.counts[i];
+  }
+  mem_free(acc.docs);
+  mem_free(acc.counts);
+
+  *docs_out = docs;
+  return acc.n;
+}
+
+/* evaluate_andsequence */
+/* Look up the words of andseq and intersect them (blocks_andsequence). */
+static int
+evaluate_andsequence(postings_t *postings, const andseq_t *andseq,
+                     const bitmap_t *allowed, cancel_t *cancel,
+                     plist_t *out)
+{
+  const term_t *terms[andseq->nterms > 0 ? andseq->nterms : 1];
+  for (int t = 0; t < andseq->nterms; t++) {
+    terms[t] = postings_find(postings, andseq->terms[t]);
+  }
+  return blocks_andsequence(terms, andseq->nterms, allowed, cancel, out);
+}
+
+/**************** blocks_andsequence ****************/
+/* see blocks.h for description */
+int
+blocks_andsequence(const term_t *const words[], const int nterms,
+                   const bitmap_t *allowed, cancel_t *cancel, plist_t *out)
+{
+  out->n = 0;
+  out->docs = NULL;
+  out->counts = NULL;
+  if (nterms == 0) {
+    return 0;
+  }
+
+  /* a missing word means no matches */
+  const term_t *terms[nterms];
+  for (int t = 0; t < nterms; t++) {
+    if (words[t] == NULL || words[t]->full.n == 0) {
+      return 0;
+    }
+    terms[t] = words[t];
+  }
+
+  /* in planned order if we can; else shortest first (insertion sort:
+   * there are only a few words) */
+  bool planned = true;
+  long total = 0;
+  for (int t = 0; t < nterms; t++) {
+    planned = planned && (terms[t]->sketch != NULL);
+    total += terms[t]->full.n;
+  }
+  planned = planned && total >= PLAN_MIN_POSTINGS;
+  if (planned) {
+    const sketch_t *sketches[nterms];
+    const term_t *unplanned[nterms];
+    int order[nterms];
+    for (int t = 0; t < nterms; t++) {
+      sketches[t] = terms[t]->sketch;
+      unplanned[t] = terms[t];
+    }
+    sketch_order(sketches, nterms, order);
+    for (int t = 0; t < nterms; t++) {
+      terms[t] = unplanned[order[t]];
+    }
+  } else {
+    for (int t = 1; t < nterms; t++) {
+      const term_t *term = terms[t];
+      int u = t;
+      for (; u > 0 && terms[u-1]->full.n > term->full.n; u--) {
+        terms[u] = terms[u-1];
+      }
+      terms[u] = term;
+    }
+  }
+
+  /* results only shrink, so two buffers the size of the first list
+   * are enough */
+  int cap = terms[0]->full.n + BLOCK_SIZE;
+  plist_t buf[2];
+  for (int b = 0; b < 2; b++) {
+    buf[b].n = 0;
+    buf[b].docs = mem_malloc_assert(cap * sizeof(int), "blocks_andsequence");
+    buf[b].counts = mem_malloc_assert(cap * sizeof(int),
+                                      "blocks_andsequence");
+  }
+
+  /* a compressed first list is decoded into the buffer not written
+   * first */
+  const plist_t *cur = &terms[0]->full;
+  if (terms[0]->packed != NULL) {
+    pcache_decode(terms[0]->packed, &buf[1]);
+    cur = &buf[1];
+  }
+  int which = 0;
+  for (int t = 1; t < nterms && cur->n > 0 && !cancel_check(cancel); t++) {
+    if (terms[t]->packed != NULL) {
+      intersect_packed(cur, terms[t], &buf[which]);
+    } else {
+      blocks_intersect(cur, &terms[t]->full, terms[t]->bloom, &buf[which]);
+    }
+    cur = &buf[which];
+    which = 1 - which;
+  }
+
+  /* cur is either a buffer or, for one plain word, the postings
+   * themselves, which we must not modify */
+  plist_t *result = (cur == &buf[0]) ? &buf[0] : &buf[1];
+  if (cur != result) {
+    for (int i = 0; i < cur->n; i++) {
+      result->docs[i] = cur->docs[i];
+      result->counts[i] = cur->counts[i];
+    }
+    result->n = cur->n;
+  }
+  filter_allowed(result, allowed);
+
+  *out = *result;
+  plist_t *spare = (result == &buf[0]) ? &buf[1] : &buf[0];
+  mem_free(spare->docs);
+  mem_free(spare->counts);
+  return out->n;
+}
+
+/* intersect_packed */
+/* Like blocks_intersect(a, term's full list, ...), for a term whose
+ * list is compressed: each run of a's documents that falls within one
+ * block of the term's list is intersected with that block, and blocks
+ * holding no run, or whose run fails the Bloom filter throughout, are
+ * never fetched. out needs room for a->n + BLOCK_SIZE entries.
+ */
+static int
+intersect_packed(const plist_t *a, const term_t *term, plist_t *out)
+{
+  clist_t *clist = term->packed;
+  int n = 0;
+  int pos = 0;
+  while (pos < a->n) {
+    int block = clist_block_of(clist, a->docs[pos]);
+    int limit = (block + 1 < clist->nblocks) ? clist->first[block + 1]
+                                             : INT_MAX;
+    int end = postings_seek(a, pos, limit);
+
+    bool maybe = (term->bloom == NULL);
+    for (int i = pos; i < end && !maybe; i++) {
+      maybe = bloom_test(term->bloom, a->docs[i]);
+    }
+    if (maybe) {
+      plist_t run = { end - pos, a->docs + pos, a->counts + pos };
+      plist_t part = { 0, out->docs + n, out->counts + n };
+      n += blocks_intersect(&run, pcache_get(clist, block), term->bloom,
+                            &part);
+    }
+    pos = end;
+  }
+  return out->n = n;
+}
+
+/* filter_allowed */
+/* Remove, in place and without branching, every document of list that
+ * allowed (if not NULL) does not permit. Returns the new list->n.
+ */
+static int
+filter_allowed(plist_t *list, const bitmap_t *allowed)
+{
+  if (allowed == NULL) {
+    return list->n;
+  }
+  int n = 0;
+  for (int i = 0; i < list->n; i++) {
+    list->docs[n] = list->docs[i];
+    list->counts[n] = list->counts[i];
+    n += bitmap_test(allowed, list->docs[i]);
+  }
+  return list->n = n;
+}
@@ -0,0 +1,91 @@
+/*
+ * blocks.h - header file for the querier's 'blocks' module
+ *
+ * Block-at-a-time evaluation. Like the original evaluator this works
+ * term at a time, but on the sorted posting arrays of postings.h rather
+ * than on counters_t: intersections compare fixed-size blocks of docIDs
+ * at once (with SSE2, a block is one vector and is compared against all
+ * rotations of the other list's block), take the min of the counts in
+ * the same step, and compact the survivors without branching. Unions
+ * are a branch-free merge that adds the scores of common documents.
+ * When one list is much longer than the other it is probed instead,
+ * after its Bloom filter (if any) has been asked.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __BLOCKS_H
+#define __BLOCKS_H
+
+#include "postings.h"
+#include "query.h"
+#include "bitmap.h"
+#include "bloom.h"
+#include "cancel.h"
+
+/* docIDs compared at once; output arrays need this much slack */
+#define BLOCK_SIZE 4
+
+/**************** blocks_intersect ****************/
+/* Intersect two posting lists, keeping the min count of each document.
+ *
+ * Caller provides:
+ *   two docID-sorted lists; bbloom, a Bloom filter of b's docIDs, or
+ *   NULL; and out, whose docs and counts arrays have room for
+ *   min(a->n, b->n) + BLOCK_SIZE entries.
+ * We set:
+ *   out->n, and fill out in docID order.
+ * We return:
+ *   out->n.
+ */
+int blocks_intersect(const plist_t *a, const plist_t *b,
+                     const bloom_t *bbloom, plist_t *out);
+
+/**************** blocks_union ****************/
+/* Union two posting lists, adding the counts of common documents.
+ *
+ * Caller provides:
+ *   two docID-sorted lists, and out, with room for a->n + b->n entries.
+ * We set:
+ *   out->n, and fill out in docID order.
+ * We return:
+ *   out->n.
+ */
+int blocks_union(const plist_t *a, const plist_t *b, plist_t *out);
+
+/**************** blocks_andsequence ****************/
+/* Intersect the posting lists of an andsequence's words.
+ *
+ * Caller provides:
+ *   the nterms words' terms (NULL for a word not in the index);
+ *   allowed, the documents a host filter allows (NULL for all); and
+ *   cancel, checked before each word (NULL: never stop).
+ * We set:
+ *   *out to a new list, in docID order, of the documents in every list
+ *   that allowed permits, each with its min count; the caller frees
+ *   out->docs and out->counts with mem_free, even when empty. If
+ *   cancel stopped us, the list is not the intersection.
+ * We return:
+ *   out->n.
+ */
+int blocks_andsequence(const term_t *const words[], const int nterms,
+                       const bitmap_t *allowed, cancel_t *cancel,
+                       plist_t *out);
+
+/**************** blocks_evaluate ****************/
+/* Evaluate query block-at-a-time.
+ *
+ * Caller provides:
+ *   loaded postings; a parsed query; allowed, the documents a host
+ *   filter allows (NULL for all); and cancel, checked before each
+ *   word and andsequence (NULL: never stop).
+ * We return:
+ *   the number of results, and in *docs_out a new array of them in
+ *   docID order (caller frees with mem_free). If cancel stopped us,
+ *   they are not the query's results.
+ */
+int blocks_evaluate(postings_t *postings, const query_t *query,
+                    const bitmap_t *allowed, cancel_t *cancel,
+                    docscore_t **docs_out);
+
+#endif // __BLOCKS_H
@@ -0,0 +1,48 @@
+/*
+ * bloom.c - 'bloom' module for the CS50 TSE querier
+ *
+ * see bloom.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bloom.h"
+#include "mem.h"
+
+/**************** bloom_new ****************/
+/* see bloom.h for description */
+bloom_t *
+bloom_new(const int nkeys, const int bitsPerKey)
+{
+  bloom_t *bloom = mem_malloc_assert(sizeof(bloom_t), "bloom_new");
+  long bits = (long) nkeys * bitsPerKey;
+  bloom->nwords = (int) ((bits + 63) / 64);
+  if (bloom->nwords < 1) {
+    bloom->nwords = 1;
+  }
+  bloom->words = mem_calloc_assert(bloom->nwords, sizeof(uint64_t),
+                                   "bloom_new");
+  return bloom;
+}
+
+/**************** bloom_add ****************/
+/* see bloom.h for description */
+void
+bloom_add(bloom_t *bloom, const int docID)
+{
+  uint64_t h = bloom_hash(docID);
+  bloom->words[((h >> 32) * (uint64_t) bloom->nwords) >> 32] |= bloom_mask(h);
+}
+
+/**************** bloom_delete ****************/
+/* see bloom.h for description */
+void
+bloom_delete(bloom_t *bloom)
+{
+  if (bloom != NULL) {
+    mem_free(bloom->words);
+    mem_free(bloom);
+  }
+}
@@ -0,0 +1,83 @@
+/*
+ * bloom.h - header file for the querier's 'bloom' module
+ *
+ * A Bloom filter over docIDs: a compact set that answers "maybe
+ * present" or "certainly absent". The AND evaluators test a filter
+ * before probing a long posting list, so most documents missing from
+ * the list are rejected without touching the list at all.
+ *
+ * The filter is "blocked": every docID's bits lie in a single 64-bit
+ * word, so a test costs one memory access, however many bits it checks.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __BLOOM_H
+#define __BLOOM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* bits set per docID */
+#define BLOOM_HASHES 4
+
+typedef struct bloom {
+  int nwords;          // size of words[], at least 1
+  uint64_t *words;
+} bloom_t;
+
+/**************** bloom_new ****************/
+/* Return a new, empty filter sized for nkeys docIDs at bitsPerKey bits
+ * each (16 gives about 1% false positives); caller must bloom_delete
+ * it. Exits if out of memory.
+ */
+bloom_t *bloom_new(const int nkeys, const int bitsPerKey);
+
+/**************** bloom_add ****************/
+/* Add docID to the filter. */
+void bloom_add(bloom_t *bloom, const int docID);
+
+/**************** bloom_delete ****************/
+/* Free the filter; NULL is ignored. */
+void bloom_delete(bloom_t *bloom);
+
+/**************** bloom_hash ****************/
+/* Mix docID into 64 well-spread bits (the murmur3 finalizer). */
+static inline uint64_t
+bloom_hash(const int docID)
+{
+  uint64_t h = (uint64_t) (uint32_t) docID;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**************** bloom_mask ****************/
+/* The BLOOM_HASHES bits docID sets in its word, from hash h. */
+static inline uint64_t
+bloom_mask(const uint64_t h)
+{
+  uint64_t mask = 0;
+  for (int i = 0; i < BLOOM_HASHES; i++) {
+    mask |= (uint64_t) 1 << ((h >> (6 * i)) & 63);
+  }
+  return mask;
+}
+
+/**************** bloom_test ****************/
+/* Return false if docID is certainly not in the filter; true if it may
+ * be. Inline because it sits in the inner loop of AND evaluation.
+ */
+static inline bool
+bloom_test(const bloom_t *bloom, const int docID)
+{
+  uint64_t h = bloom_hash(docID);
+  uint64_t word = bloom->words[((h >> 32) * (uint64_t) bloom->nwords) >> 32];
+  uint64_t mask = bloom_mask(h);
+  return (word & mask) == mask;
+}
+
+#endif // __BLOOM_H
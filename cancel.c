@@ -0,0 +1,214 @@
+/*
+ * cancel.c - 'cancel' module for the CS50 TSE querier
+ *
+ * see cancel.h for more information.
+ *
+ * SIGINT is recorded by bumping a global generation number, which every
+ * token compares with the one it saw when armed; so a signal cancels
+ * the queries running when it came, and a query started afterwards
+ * sees the new number and runs. Times are kept as integer nanoseconds
+ * so the signal handler can store them atomically.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* poll and clock_gettime are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <poll.h>
+#include <time.h>
+#include "cancel.h"
+#include "mem.h"
+
+/**************** global state ****************/
+/* written by signal handlers and read by every token */
+static atomic_int running = 0;          // armed tokens
+static atomic_int generation = 0;       // SIGINTs that cancelled something
+static atomic_llong interruptedAt = 0;  // ns, of the last such SIGINT
+static atomic_bool hungup = false;
+static atomic_llong hungupAt = 0;       // ns
+
+/**************** local types ****************/
+struct cancel {
+  double timeoutMs;        // 0: none
+  int fd;                  // output to poll; -1: none
+  bool armed;
+  int generation;          // global generation when armed
+  long long deadline;      // ns; 0: none
+  long long lastPoll;      // ns
+  cancel_reason_t reason;
+  long long cancelledAt;   // ns
+};
+
+/**************** local functions ****************/
+static long long now_ns(void);
+
+/**************** cancel_new ****************/
+/* see cancel.h for description */
+cancel_t *
+cancel_new(const double timeoutMs, const int outputFd)
+{
+  cancel_t *cancel = mem_calloc_assert(1, sizeof(cancel_t), "cancel_new");
+  cancel->timeoutMs = (timeoutMs > 0) ? timeoutMs : 0;
+  cancel->fd = outputFd;
+  return cancel;
+}
+
+/**************** cancel_start ****************/
+/* see cancel.h for description */
+void
+cancel_start(cancel_t *cancel)
+{
+  if (cancel == NULL) {
+    return;
+  }
+  long long now = now_ns();
+  cancel->reason = CANCEL_NONE;
+  cancel->cancelledAt = 0;
+  cancel->lastPoll = now;
+  cancel->deadline = (cancel->timeoutMs == 0) ? 0
+    : now + (long long) (cancel->timeoutMs * 1e6);
+  if (!cancel->armed) {
+    cancel->armed = true;
+    atomic_fetch_add(&running, 1);
+  }
+  cancel->generation = atomic_load(&generation);
+}
+
+/**************** cancel_check ****************/
+/* see cancel.h for description */
+bool
+cancel_check(cancel_t *cancel)
+{
+  if (cancel == NULL) {
+    return false;
+  }
+  if (cancel->reason != CANCEL_NONE) {
+    return true;
+  }
+
+  if (atomic_load(&hungup)) {
+    cancel->reason = CANCEL_HANGUP;
+    cancel->cancelledAt = atomic_load(&hungupAt);
+  } else if (atomic_load(&generation) != cancel->generation) {
+    cancel->reason = CANCEL_INTERRUPT;
+    cancel->cancelledAt = atomic_load(&interruptedAt);
+  } else {
+    long long now = now_ns();
+    if (cancel->deadline != 0 && now >= cancel->deadline) {
+      cancel->reason = CANCEL_TIMEOUT;
+      cancel->cancelledAt = cancel->deadline;
+    } else if (cancel->fd >= 0
+               && now - cancel->lastPoll >= CANCEL_POLL_MS * 1e6) {
+      cancel->lastPoll = now;
+      struct pollfd pfd = { cancel->fd, 0, 0 };
+      if (poll(&pfd, 1, 0) == 1 && (pfd.revents & (POLLHUP | POLLERR))) {
+        cancel_hangup();
+        cancel->reason = CANCEL_HANGUP;
+        cancel->cancelledAt = now;
+      }
+    }
+  }
+  return cancel->reason != CANCEL_NONE;
+}
+
+/**************** cancel_reason ****************/
+/* see cancel.h for description */
+cancel_reason_t
+cancel_reason(const cancel_t *cancel)
+{
+  return (cancel == NULL) ? CANCEL_NONE : cancel->reason;
+}
+
+/**************** cancel_latency ****************/
+/* see cancel.h for description */
+double
+cancel_latency(const cancel_t *cancel)
+{
+  if (cancel == NULL || cancel->reason == CANCEL_NONE) {
+    return 0;
+  }
+  long long ns = now_ns() - cancel->cancelledAt;
+  return (ns < 0) ? 0 : ns / 1e6;
+}
+
+/**************** cancel_finish ****************/
+/* see cancel.h for description */
+void
+cancel_finish(cancel_t *cancel)
+{
+  if (cancel != NULL && cancel->armed) {
+    cancel->armed = false;
+    atomic_fetch_sub(&running, 1);
+  }
+}
+
+/**************** cancel_interrupt ****************/
+/* see cancel.h for description */
+bool
+cancel_interrupt(void)
+{
+  if (atomic_load(&running) == 0) {
+    return false;
+  }
+  atomic_store(&interruptedAt, now_ns());
+  atomic_fetch_add(&generation, 1);
+  return true;
+}
+
+/**************** cancel_hangup ****************/
+/* see cancel.h for description */
+void
+cancel_hangup(void)
+{
+  if (!atomic_load(&hungup)) {
+    atomic_store(&hungupAt, now_ns());
+    atomic_store(&hungup, true);
+  }
+}
+
+/**************** cancel_hungup ****************/
+/* see cancel.h for description */
+bool
+cancel_hungup(void)
+{
+  return atomic_load(&hungup);
+}
+
+/**************** cancel_name ****************/
+/* see cancel.h for description */
+const char *
+cancel_name(const cancel_reason_t reason)
+{
+  switch (reason) {
+  case CANCEL_TIMEOUT:   return "timed out";
+  case CANCEL_INTERRUPT: return "interrupted";
+  case CANCEL_HANGUP:    return "output closed";
+  default:               return "not cancelled";
+  }
+}
+
+/**************** cancel_delete ****************/
+/* see cancel.h for description */
+void
+cancel_delete(cancel_t *cancel)
+{
+  cancel_finish(cancel);
+  mem_free(cancel);
+}
+
+/* now_ns */
+/* Return a monotonic clock reading in nanoseconds (clock_gettime is
+ * safe in a signal handler).
+ */
+static long long
+now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
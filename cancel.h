@@ -0,0 +1,96 @@
+/*
+ * cancel.h - header file for the querier's 'cancel' module
+ *
+ * Cooperative cancellation of queries. Each thread that answers
+ * queries owns a token (cancel_t), arms it when a query starts and
+ * disarms it when the query ends; the evaluators, the ranking sort and
+ * the result printer ask it, between blocks of work, whether to stop.
+ * A query is cancelled when
+ *
+ *   - its time limit passes (CANCEL_TIMEOUT);
+ *   - SIGINT arrives while it runs (CANCEL_INTERRUPT): the signal
+ *     handler calls cancel_interrupt, which cancels every query running
+ *     at that moment, and only those;
+ *   - nobody is left to read the output (CANCEL_HANGUP): the output
+ *     descriptor reports POLLHUP or POLLERR (the reading end of a pipe
+ *     or socket was closed), or a write failed with EPIPE. A hangup is
+ *     permanent and cancels every query, running or not.
+ *
+ * Asking is cheap (a few atomic loads and a clock read), and the output
+ * descriptor is polled at most once per CANCEL_POLL_MS, so a check can
+ * go wherever stopping within a millisecond or so is wanted. Once a
+ * token says stop, it keeps saying so until it is armed again.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __CANCEL_H
+#define __CANCEL_H
+
+#include <stdbool.h>
+
+/* poll the output for a hangup at most this often, in ms */
+#define CANCEL_POLL_MS 1.0
+
+typedef struct cancel cancel_t;
+
+/* cancel_reason_t: why a query was cancelled. */
+typedef enum cancel_reason {
+  CANCEL_NONE, CANCEL_TIMEOUT, CANCEL_INTERRUPT, CANCEL_HANGUP
+} cancel_reason_t;
+#define CANCEL_REASONS 4
+
+/**************** cancel_new ****************/
+/* Return a new token that gives each query timeoutMs milliseconds (0:
+ * no limit) and watches outputFd for a hangup (-1: none). Caller must
+ * cancel_delete it.
+ */
+cancel_t *cancel_new(const double timeoutMs, const int outputFd);
+
+/**************** cancel_start ****************/
+/* Arm the token for a query starting now. */
+void cancel_start(cancel_t *cancel);
+
+/**************** cancel_check ****************/
+/* Return true if the current query should stop. NULL never stops. */
+bool cancel_check(cancel_t *cancel);
+
+/**************** cancel_reason ****************/
+/* Return why the current query stopped, or CANCEL_NONE. */
+cancel_reason_t cancel_reason(const cancel_t *cancel);
+
+/**************** cancel_latency ****************/
+/* Return the ms from the cancellation (the deadline, the signal, or the
+ * poll that saw the hangup) until now, or 0 if not cancelled.
+ */
+double cancel_latency(const cancel_t *cancel);
+
+/**************** cancel_finish ****************/
+/* Disarm the token: its query is over. */
+void cancel_finish(cancel_t *cancel);
+
+/**************** cancel_interrupt ****************/
+/* Cancel every query running now. Safe to call from a signal handler.
+ * Returns false if no query was running.
+ */
+bool cancel_interrupt(void);
+
+/**************** cancel_hangup ****************/
+/* Note that the output is gone (say, a write failed with EPIPE); every
+ * query stops, now and from now on. Safe to call from a signal handler.
+ */
+void cancel_hangup(void);
+
+/**************** cancel_hungup ****************/
+/* Return true once the output is known to be gone. */
+bool cancel_hungup(void);
+
+/**************** cancel_name ****************/
+/* Return a short description of reason, for messages. */
+const char *cancel_name(const cancel_reason_t reason);
+
+/**************** cancel_delete ****************/
+/* Free the token; NULL is ignored. */
+void cancel_delete(cancel_t *cancel);
+
+#endif // __CANCEL_H
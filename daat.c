@@ -0,0 +1,305 @@
+/*
+ * daat.c - 'daat' module for the CS50 TSE querier
+ *
+ * see daat.h for more information.
+ *
+ * Each andsequence keeps one cursor per word and finds its next match
+ * by "leapfrogging": every cursor in turn seeks to the largest docID
+ * seen so far, until all of them agree. The query then repeatedly takes
+ * the smallest next match over all andsequences, sums the scores of the
+ * andsequences matching that document, and advances them.
+ *
+ * A daat_t keeps all of that between slices: which andsequences are
+ * still to be set up (each set up seeks its cursors to its first
+ * match), then the cursors themselves.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "daat.h"
+#include "mem.h"
+
+/**************** local types ****************/
+/* cursor_t: a position in one word's posting list. */
+typedef struct cursor {
+  const plist_t *list;
+  int pos;
+} cursor_t;
+
+/* seqcursor_t: the cursors of one andsequence and its current match. */
+typedef struct seqcursor {
+  int nterms;
+  cursor_t *cursors;
+  bool done;           // no more matches
+  int doc;             // current match, if not done
+  int score;           // min count of the words in doc
+} seqcursor_t;
+
+/* results_t: where matches go, either all of them or a top-k heap. */
+typedef struct results {
+  int k;               // 0: keep all
+  int n;
+  int cap;
+  docscore_t *docs;
+} results_t;
+
+/**************** global types ****************/
+struct daat {
+  postings_t *postings;
+  const query_t *query;
+  const bitmap_t *allowed;
+  seqcursor_t *seqs;
+  int ready;           // andsequences set up so far
+  bool done;
+  long visited;        // postings visited: cursor seeks
+  results_t results;
+};
+
+/**************** local functions ****************/
+static void seq_next(seqcursor_t *seq, const int target,
+                     const bitmap_t *allowed, long *visited);
+static void results_add(results_t *results, const int docID,
+                        const int score);
+static void heap_down(docscore_t *heap, const int n, int i);
+
+/**************** daat_evaluate ****************/
+/* see daat.h for description */
+int
+daat_evaluate(postings_t *postings, const query_t *query,
+              const bitmap_t *allowed, const int k, cancel_t *cancel,
+              docscore_t **docs_out)
+{
+  daat_t *daat = daat_start(postings, query, allowed, k);
+  while (!daat_step(daat, DAAT_CHECK)) {
+    if (cancel_check(cancel)) {
+      break;
+    }
+  }
+  return daat_finish(daat, docs_out);
+}
+
+/**************** daat_start ****************/
+/* see daat.h for description */
+daat_t *
+daat_start(postings_t *postings, const query_t *query,
+           const bitmap_t *allowed, const int k)
+{
+  daat_t *daat = mem_calloc_assert(1, sizeof(daat_t), "daat_start");
+  daat->postings = postings;
+  daat->query = query;
+  daat->allowed = allowed;
+  daat->results = (results_t) { k > 0 ? k : 0, 0, 0, NULL };
+  daat->results.cap = (k > 0) ? k : 64;
+  daat->results.docs = mem_malloc_assert(daat->results.cap
+                                         * sizeof(docscore_t), "daat_start");
+  if (postings == NULL || query == NULL) {
+    daat->done = true;
+    return daat;
+  }
+  daat->seqs = mem_calloc_assert(query->nseqs + 1, sizeof(seqcursor_t),
+                                 "daat_start");
+  return daat;
+}
+
+/**************** daat_step ****************/
+/* see daat.h for description */
+bool
+daat_step(daat_t *daat, const long budget)
+{
+  if (daat == NULL || daat->done) {
+    return true;
+  }
+  const query_t *query = daat->query;
+  seqcursor_t *seqs = daat->seqs;
+  long until = (budget > 0) ? daat->visited + budget : -1;
+
+  /* set up cursors; an andsequence with an unknown word never matches */
+  for (; daat->ready < query->nseqs; daat->ready++) {
+    if (until >= 0 && daat->visited >= until) {
+      return false;
+    }
+    const andseq_t *andseq = &query->seqs[daat->ready];
+    seqcursor_t *seq = &seqs[daat->ready];
+    seq->nterms = andseq->nterms;
+    seq->cursors = mem_malloc_assert(andseq->nterms * sizeof(cursor_t),
+                                     "daat_step");
+    for (int t = 0; t < andseq->nterms; t++) {
+      term_t *term = postings_find(daat->postings, andseq->terms[t]);
+      if (term == NULL) {
+        seq->done = true;
+        break;
+      }
+      seq->cursors[t].list = &term->full;
+      seq->cursors[t].pos = 0;
+    }
+    if (!seq->done) {
+      seq_next(seq, 0, daat->allowed, &daat->visited);
+    }
+  }
+
+  /* score documents in increasing docID order */
+  while (until < 0 || daat->visited < until) {
+    int doc = -1;
+    for (int s = 0; s < query->nseqs; s++) {
+      if (!seqs[s].done && (doc < 0 || seqs[s].doc < doc)) {
+        doc = seqs[s].doc;
+      }
+    }
+    if (doc < 0) {
+      daat->done = true;
+      break;
+    }
+    int score = 0;
+    for (int s = 0; s < query->nseqs; s++) {
+      if (!seqs[s].done && seqs[s].doc == doc) {
+        score += seqs[s].score;
+        seq_next(&seqs[s], doc + 1, daat->allowed, &daat->visited);
+      }
+    }
+    results_add(&daat->results, doc, score);
+  }
+  return daat->done;
+}
+
+/**************** daat_visited ****************/
+/* see daat.h for description */
+long
+daat_visited(const daat_t *daat)
+{
+  return (daat == NULL) ? 0 : daat->visited;
+}
+
+/**************** daat_finish ****************/
+/* see daat.h for description */
+int
+daat_finish(daat_t *daat, docscore_t **docs_out)
+{
+  if (daat == NULL) {
+    *docs_out = NULL;
+    return 0;
+  }
+  for (int s = 0; s < daat->ready; s++) {
+    mem_free(daat->seqs[s].cursors);
+  }
+  mem_free(daat->seqs);
+
+  /* a heap comes out worst-first; put it in ranked order */
+  results_t *results = &daat->results;
+  if (results->k > 0) {
+    qsort(results->docs, results->n, sizeof(docscore_t), docscore_cmp);
+  }
+  *docs_out = results->docs;
+  int n = results->n;
+  mem_free(daat);
+  return n;
+}
+
+/* seq_next */
+/* Move seq to its first match with docID >= target that allowed (if not
+ * NULL) permits, or mark it done; add the seeks made to *visited.
+ */
+static void
+seq_next(seqcursor_t *seq, const int target, const bitmap_t *allowed,
+         long *visited)
+{
+  int doc = target;
+  while (true) {
+    /* leapfrog until all cursors sit on the same docID */
+    int agree = 0;
+    int t = 0;
+    while (agree < seq->nterms) {
+      cursor_t *c = &seq->cursors[t];
+      c->pos = postings_seek(c->list, c->pos, doc);
+      (*visited)++;
+      if (c->pos >= c->list->n) {
+        seq->done = true;
+        return;
+      }
+      int d = c->list->docs[c->pos];
+      if (d == doc) {
+        agree++;
+      } else {
+        doc = d;
+        agree = 1;
+      }
+      t = (t + 1 == seq->nterms) ? 0 : t + 1;
+    }
+
+    if (allowed == NULL || bitmap_test(allowed, doc)) {
+      break;
+    }
+    doc++;
+  }
+
+  int score = seq->cursors[0].list->counts[seq->cursors[0].pos];
+  for (int t = 1; t < seq->nterms; t++) {
+    int count = seq->cursors[t].list->counts[seq->cursors[t].pos];
+    if (count < score) {
+      score = count;
+    }
+  }
+  seq->doc = doc;
+  seq->score = score;
+}
+
+/* results_add */
+/* Keep a match: append it, or with k > 0 keep it only if it beats the
+ * worst of the current top k (the root of a heap ordered worst-first).
+ */
+static void
+results_add(results_t *results, const int docID, const int score)
+{
+  docscore_t ds = { docID, score };
+
+  if (results->k == 0) {
+    if (results->n == results->cap) {
+      results->cap *= 2;
+      docscore_t *bigger = mem_malloc_assert(results->cap * sizeof(docscore_t),
+                                             "results_add");
+      for (int i = 0; i < results->n; i++) {
+        bigger[i] = results->docs[i];
+      }
+      mem_free(results->docs);
+      results->docs = bigger;
+    }
+    results->docs[results->n++] = ds;
+    return;
+  }
+
+  docscore_t *heap = results->docs;
+  if (results->n < results->k) {
+    /* sift up */
+    int i = results->n++;
+    while (i > 0 && docscore_cmp(&heap[(i-1)/2], &ds) < 0) {
+      heap[i] = heap[(i-1)/2];
+      i = (i-1)/2;
+    }
+    heap[i] = ds;
+  } else if (docscore_cmp(&ds, &heap[0]) < 0) {
+    heap[0] = ds;
+    heap_down(heap, results->n, 0);
+  }
+}
+
+/* heap_down */
+/* Restore the worst-first heap property below position i. */
+static void
+heap_down(docscore_t *heap, const int n, int i)
+{
+  docscore_t item = heap[i];
+  while (2*i + 1 < n) {
+    int child = 2*i + 1;
+    if (child + 1 < n && docscore_cmp(&heap[child+1], &heap[child]) > 0) {
+      child++;
+    }
+    if (docscore_cmp(&heap[child], &item) <= 0) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = item;
+}
@@ -0,0 +1,81 @@
+/*
+ * daat.h - header file for the querier's 'daat' module
+ *
+ * Document-at-a-time evaluation. The querier's original evaluator works
+ * term at a time: it builds a counters_t for each andsequence and
+ * unions them. Here instead every query word gets a cursor into its
+ * sorted posting list (see postings.h), and the cursors advance
+ * together in docID order, so each matching document is scored once,
+ * completely, with the same and/or semantics. Apart from the results
+ * themselves, memory is O(number of query words).
+ *
+ * Since all of the evaluation's state is in the cursors, it can also
+ * be run a slice at a time: daat_start sets a query up, daat_step
+ * advances it by about a given number of postings and returns, and
+ * daat_finish hands over the results, so one thread can take turns
+ * between several queries.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __DAAT_H
+#define __DAAT_H
+
+#include <stdbool.h>
+#include "postings.h"
+#include "query.h"
+#include "bitmap.h"
+#include "cancel.h"
+
+/* postings visited between cancellation checks */
+#define DAAT_CHECK 1024
+
+typedef struct daat daat_t;
+
+/**************** daat_evaluate ****************/
+/* Evaluate query document-at-a-time.
+ *
+ * Caller provides:
+ *   loaded postings; a parsed query; allowed, the documents a host
+ *   filter allows (NULL for all); k: if k > 0 only the best k
+ *   results are kept (in a heap of size k), else all of them; and
+ *   cancel, checked every DAAT_CHECK postings (NULL: never stop).
+ * We return:
+ *   the number of results, and in *docs_out a new array of them (caller
+ *   frees with mem_free). With k > 0 the array is in ranked order;
+ *   otherwise it is in docID order. If cancel stopped us, they are
+ *   only the results found so far.
+ */
+int daat_evaluate(postings_t *postings, const query_t *query,
+                  const bitmap_t *allowed, const int k,
+                  cancel_t *cancel, docscore_t **docs_out);
+
+/**************** daat_start ****************/
+/* Set query up for evaluation a slice at a time, with postings,
+ * allowed and k as for daat_evaluate; no postings are visited yet.
+ * query and allowed must outlive the daat_t. Returns a new daat_t,
+ * which the caller must pass to daat_finish.
+ */
+daat_t *daat_start(postings_t *postings, const query_t *query,
+                   const bitmap_t *allowed, const int k);
+
+/**************** daat_step ****************/
+/* Evaluate on until budget more postings have been visited (every
+ * cursor seek visits one), then return at the next document boundary;
+ * budget <= 0 means to the end. Returns true once the evaluation is
+ * complete, after which further steps do nothing.
+ */
+bool daat_step(daat_t *daat, const long budget);
+
+/**************** daat_visited ****************/
+/* Return the number of postings visited so far. */
+long daat_visited(const daat_t *daat);
+
+/**************** daat_finish ****************/
+/* Return the number of results found so far, complete if daat_step
+ * returned true, with the new array of them in *docs_out as
+ * daat_evaluate would; and free daat.
+ */
+int daat_finish(daat_t *daat, docscore_t **docs_out);
+
+#endif // __DAAT_H
@@ -0,0 +1,282 @@
+/*
+ * docattrs.c - 'docattrs' module for the CS50 TSE querier
+ *
+ * see docattrs.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include "docattrs.h"
+#include "mem.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+/**************** global types ****************/
+struct docattrs {
+  int maxdoc;                  // columns have maxdoc+1 entries
+  int *columns[ATTR_NUM];      // columns[attr][docID]
+};
+
+/* keyed_t: a document with its sort key, for docattrs_sort. */
+typedef struct keyed {
+  int key;
+  docscore_t ds;
+} keyed_t;
+
+/**************** local functions ****************/
+static void read_priors(const char *pageDirectory, docattrs_t *attrs);
+static void select_pass(const int *values, const int n, const predop_t op,
+                        const int value, uint8_t *keep);
+static int  cmp_keyed_asc(const void *a, const void *b);
+static int  cmp_keyed_desc(const void *a, const void *b);
+
+static const char *attrNames[ATTR_NUM] = { "depth", "length", "host", "prior" };
+
+/**************** docattrs_load ****************/
+/* see docattrs.h for description */
+docattrs_t *
+docattrs_load(const char *pageDirectory, const hosts_t *hosts)
+{
+  docattrs_t *attrs = mem_malloc_assert(sizeof(docattrs_t), "docattrs_load");
+  attrs->maxdoc = hosts_maxdoc(hosts);
+  for (int a = 0; a < ATTR_NUM; a++) {
+    attrs->columns[a] = mem_calloc_assert(attrs->maxdoc + 1, sizeof(int),
+                                          "docattrs_load");
+  }
+
+  for (int docID = 1; docID <= attrs->maxdoc; docID++) {
+    hosts_page(hosts, docID, &attrs->columns[ATTR_DEPTH][docID],
+               &attrs->columns[ATTR_LENGTH][docID]);
+    attrs->columns[ATTR_HOST][docID] = hosts_id(hosts, docID);
+  }
+  read_priors(pageDirectory, attrs);
+  return attrs;
+}
+
+/* read_priors */
+/* Read "docID score" lines from pageDirectory/.prior, if it exists. */
+static void
+read_priors(const char *pageDirectory, docattrs_t *attrs)
+{
+  char filename[PATH_MAX];
+  snprintf(filename, sizeof(filename), "%s/.prior", pageDirectory);
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL) {
+    return;
+  }
+  int docID, prior;
+  while (fscanf(fp, "%d %d", &docID, &prior) == 2) {
+    if (docID > 0 && docID <= attrs->maxdoc) {
+      attrs->columns[ATTR_PRIOR][docID] = prior;
+    }
+  }
+  fclose(fp);
+}
+
+/**************** docattrs_get ****************/
+/* see docattrs.h for description */
+int
+docattrs_get(const docattrs_t *attrs, const attr_t attr, const int docID)
+{
+  if (attrs == NULL || attr < 0 || attr >= ATTR_NUM
+      || docID < 0 || docID > attrs->maxdoc) {
+    return 0;
+  }
+  return attrs->columns[attr][docID];
+}
+
+/**************** docattrs_parse_attr ****************/
+/* see docattrs.h for description */
+bool
+docattrs_parse_attr(const char *name, attr_t *attr)
+{
+  for (int a = 0; a < ATTR_NUM; a++) {
+    if (strcmp(name, attrNames[a]) == 0) {
+      *attr = a;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************** docattrs_parse_pred ****************/
+/* see docattrs.h for description */
+bool
+docattrs_parse_pred(const char *token, pred_t *pred)
+{
+  if (token == NULL || pred == NULL) {
+    return false;
+  }
+
+  /* the attribute name runs up to the first operator character */
+  size_t nameLen = strcspn(token, "<>=!");
+  if (nameLen == 0 || token[nameLen] == '\0' || nameLen >= 16) {
+    return false;
+  }
+  char name[16];
+  memcpy(name, token, nameLen);
+  name[nameLen] = '\0';
+  if (!docattrs_parse_attr(name, &pred->attr)) {
+    return false;
+  }
+
+  const char *op = token + nameLen;
+  int opLen = 2;
+  if (strncmp(op, "<=", 2) == 0) {
+    pred->op = PRED_LE;
+  } else if (strncmp(op, ">=", 2) == 0) {
+    pred->op = PRED_GE;
+  } else if (strncmp(op, "!=", 2) == 0) {
+    pred->op = PRED_NE;
+  } else {
+    opLen = 1;
+    if (*op == '<') {
+      pred->op = PRED_LT;
+    } else if (*op == '>') {
+      pred->op = PRED_GT;
+    } else if (*op == '=') {
+      pred->op = PRED_EQ;
+    } else {
+      return false;
+    }
+  }
+
+  char extra;
+  return sscanf(op + opLen, "%d%c", &pred->value, &extra) == 1;
+}
+
+/**************** docattrs_filter ****************/
+/* see docattrs.h for description */
+int
+docattrs_filter(const docattrs_t *attrs, const pred_t *preds,
+                const int npreds, docscore_t *docs, const int n)
+{
+  if (attrs == NULL || preds == NULL || npreds == 0 || n == 0) {
+    return n;
+  }
+
+  int *values = mem_malloc_assert(n * sizeof(int), "docattrs_filter");
+  uint8_t *keep = mem_malloc_assert(n, "docattrs_filter");
+  memset(keep, 1, n);
+
+  for (int p = 0; p < npreds; p++) {
+    /* gather this predicate's column for the candidates... */
+    const int *column = attrs->columns[preds[p].attr];
+    for (int i = 0; i < n; i++) {
+      int docID = docs[i].docID;
+      values[i] = (docID >= 0 && docID <= attrs->maxdoc) ? column[docID] : 0;
+    }
+    /* ...then compare them all in one pass */
+    select_pass(values, n, preds[p].op, preds[p].value, keep);
+  }
+
+  /* branch-free compaction of the survivors */
+  int kept = 0;
+  for (int i = 0; i < n; i++) {
+    docs[kept] = docs[i];
+    kept += keep[i];
+  }
+
+  mem_free(values);
+  mem_free(keep);
+  return kept;
+}
+
+/* select_pass */
+/* keep[i] &= (values[i] op value). The switch is outside the loops so
+ * each loop body is a single compare-and-mask the compiler vectorizes.
+ */
+static void
+select_pass(const int *values, const int n, const predop_t op,
+            const int value, uint8_t *keep)
+{
+  switch (op) {
+  case PRED_LT:
+    for (int i = 0; i < n; i++) keep[i] &= (values[i] < value);
+    break;
+  case PRED_LE:
+    for (int i = 0; i < n; i++) keep[i] &= (values[i] <= value);
+    break;
+  case PRED_EQ:
+    for (int i = 0; i < n; i++) keep[i] &= (values[i] == value);
+    break;
+  case PRED_NE:
+    for (int i = 0; i < n; i++) keep[i] &= (values[i] != value);
+    break;
+  case PRED_GE:
+    for (int i = 0; i < n; i++) keep[i] &= (values[i] >= value);
+    break;
+  case PRED_GT:
+    for (int i = 0; i < n; i++) keep[i] &= (values[i] > value);
+    break;
+  }
+}
+
+/**************** docattrs_sort ****************/
+/* see docattrs.h for description */
+void
+docattrs_sort(const docattrs_t *attrs, const attr_t attr,
+              const bool descending, docscore_t *docs, const int n)
+{
+  if (attrs == NULL || docs == NULL || n <= 1) {
+    return;
+  }
+  keyed_t *keyed = mem_malloc_assert(n * sizeof(keyed_t), "docattrs_sort");
+  for (int i = 0; i < n; i++) {
+    keyed[i].key = docattrs_get(attrs, attr, docs[i].docID);
+    keyed[i].ds = docs[i];
+  }
+  qsort(keyed, n, sizeof(keyed_t), descending ? cmp_keyed_desc : cmp_keyed_asc);
+  for (int i = 0; i < n; i++) {
+    docs[i] = keyed[i].ds;
+  }
+  mem_free(keyed);
+}
+
+/**************** docattrs_delete ****************/
+/* see docattrs.h for description */
+void
+docattrs_delete(docattrs_t *attrs)
+{
+  if (attrs == NULL) {
+    return;
+  }
+  for (int a = 0; a < ATTR_NUM; a++) {
+    mem_free(attrs->columns[a]);
+  }
+  mem_free(attrs);
+}
+
+/* cmp_keyed_asc */
+/* qsort comparison: key ascending, then ranked order. */
+static int
+cmp_keyed_asc(const void *a, const void *b)
+{
+  const keyed_t *ka = a;
+  const keyed_t *kb = b;
+  if (ka->key != kb->key) {
+    return (ka->key > kb->key) ? 1 : -1;
+  }
+  return docscore_cmp(&ka->ds, &kb->ds);
+}
+
+/* cmp_keyed_desc */
+/* qsort comparison: key descending, then ranked order. */
+static int
+cmp_keyed_desc(const void *a, const void *b)
+{
+  const keyed_t *ka = a;
+  const keyed_t *kb = b;
+  if (ka->key != kb->key) {
+    return (ka->key < kb->key) ? 1 : -1;
+  }
+  return docscore_cmp(&ka->ds, &kb->ds);
+}
@@ -0,0 +1,88 @@
+/*
+ * docattrs.h - header file for the querier's 'docattrs' module
+ *
+ * A column store of per-document attributes, each kept in its own
+ * contiguous int array indexed by docID:
+ *   depth   - crawl depth (second line of the page file)
+ *   length  - bytes of page content after the two header lines
+ *   host    - host id, as numbered by the hosts module
+ *   prior   - static prior score, from the optional pageDirectory/.prior
+ *             file of "docID score" lines; 0 for pages not listed
+ *
+ * Predicates such as depth<=2 are applied to a whole array of
+ * candidate documents at once, one tight loop per predicate, so the
+ * compiler can vectorize the comparisons.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __DOCATTRS_H
+#define __DOCATTRS_H
+
+#include <stdbool.h>
+#include "query.h"
+#include "hosts.h"
+
+/* attr_t: the attribute columns. */
+typedef enum attr {
+  ATTR_DEPTH, ATTR_LENGTH, ATTR_HOST, ATTR_PRIOR, ATTR_NUM
+} attr_t;
+
+/* predop_t: comparison operators for predicates. */
+typedef enum predop {
+  PRED_LT, PRED_LE, PRED_EQ, PRED_NE, PRED_GE, PRED_GT
+} predop_t;
+
+/* pred_t: one predicate, "attribute op value". */
+typedef struct pred {
+  attr_t attr;
+  predop_t op;
+  int value;
+} pred_t;
+
+typedef struct docattrs docattrs_t;
+
+/**************** docattrs_load ****************/
+/* Gather the attributes of pages 1..hosts_maxdoc(hosts): depth, length
+ * and host from hosts, which read the page files, and priors from
+ * pageDirectory/.prior. We return a new docattrs_t; caller frees it
+ * with docattrs_delete. Pages that could not be read get depth -1 and
+ * length 0.
+ */
+docattrs_t *docattrs_load(const char *pageDirectory, const hosts_t *hosts);
+
+/**************** docattrs_get ****************/
+/* Return attribute attr of docID; 0 for unknown docIDs. */
+int docattrs_get(const docattrs_t *attrs, const attr_t attr,
+                 const int docID);
+
+/**************** docattrs_parse_attr ****************/
+/* Map "depth", "length", "host" or "prior" to *attr; false otherwise. */
+bool docattrs_parse_attr(const char *name, attr_t *attr);
+
+/**************** docattrs_parse_pred ****************/
+/* Parse a predicate token like "depth<=2" or "length>1000" (operators
+ * < <= = != >= >), into *pred. Returns false if token is not one.
+ */
+bool docattrs_parse_pred(const char *token, pred_t *pred);
+
+/**************** docattrs_filter ****************/
+/* Keep only the documents in docs[0..n-1] that satisfy every predicate,
+ * compacting docs in place without changing their relative order.
+ * Returns the number kept.
+ */
+int docattrs_filter(const docattrs_t *attrs, const pred_t *preds,
+                    const int npreds, docscore_t *docs, const int n);
+
+/**************** docattrs_sort ****************/
+/* Sort docs by attribute attr (descending if descending is true), and
+ * by the usual ranked order (docscore_cmp) among equal attributes.
+ */
+void docattrs_sort(const docattrs_t *attrs, const attr_t attr,
+                   const bool descending, docscore_t *docs, const int n);
+
+/**************** docattrs_delete ****************/
+/* Free the store; NULL is ignored. */
+void docattrs_delete(docattrs_t *attrs);
+
+#endif // __DOCATTRS_H
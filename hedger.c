@@ -0,0 +1,551 @@
+/*
+ * hedger.c - 'hedger' module for the CS50 TSE querier
+ *
+ * see hedger.h for more information.
+ *
+ * The query lines read and not yet printed are jobs in a ring, by
+ * sequence number: those before 'next' have been sent to a replica,
+ * those before 'head' printed. A replica knows the sequence number of
+ * the job it has, so a loser still busy with a job already printed
+ * (whose slot may hold a newer job by now) is never mistaken for a
+ * replica of the newer one.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* poll and kill are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "hedger.h"
+#include "answers.h"
+#include "timing.h"
+#include "mem.h"
+
+/* longest query line, as the querier reads them with fgets */
+#define LINE_MAX_LEN 1024
+
+/* lines read ahead of the answers printed, per replica */
+#define JOBS_PER_REPLICA 4
+
+/* the hedge delay is the percentile of this many recent latencies, and
+ * there is none until this many have been timed */
+#define HEDGE_WINDOW 256
+#define HEDGE_MIN    20
+
+/**************** local types ****************/
+/* job_t: one query line, from reading it to printing its answer. */
+typedef struct job {
+  char line[LINE_MAX_LEN + 1];  // with its newline
+  int len;
+  char *answer;        // the first answer to come; NULL: none yet
+  size_t answerLen;
+  bool error;          // the answer is an error message, for stderr
+  int primary;         // the replica it was sent to first; -1: not yet
+  int hedge;           // ...and second; -1: not hedged
+  double sent;         // when it was sent to the first, in ms
+} job_t;
+
+/* proc_t: one replica process. */
+typedef struct proc {
+  pid_t pid;
+  int in;              // its stdin; we write
+  int out;             // its stdout and stderr; we read
+  long job;            // sequence number of its job; -1: idle
+  bool wanted;         // its answer to that job has not been beaten
+  char *acc;           // output read, not yet a whole answer
+  size_t accLen, accCap;
+  size_t scanned;      // ...of which searched for line ends
+  size_t lineStart;    // ...where its last line starts
+  long answers;        // answers it has given, taken or not
+} proc_t;
+
+/**************** global types ****************/
+struct hedger {
+  int n;
+  proc_t procs[HEDGER_MAX];
+  int percentile;      // 0: never hedge
+  job_t *jobs;         // the ring, of cap jobs
+  int cap;
+  long head, next, tail;  // next to print, to send, and to read
+  char inbuf[4 * LINE_MAX_LEN];  // stdin read, not yet a job
+  int inLen;
+  bool eof;            // stdin is at its end
+  int turn;            // replica to offer a job first
+  double window[HEDGE_WINDOW];  // recent latencies, a ring
+  int nwindow, windowNext;
+  double delay;        // hedge after this many ms; 0: not yet
+  double *latencies;   // every latency timed
+  long nlatencies, latenciesCap;
+  hedgerstats_t stats;
+};
+
+/**************** local functions ****************/
+static void start_proc(proc_t *proc, char **command);
+static void take_lines(hedger_t *hedger);
+static void dispatch(hedger_t *hedger);
+static void send_job(hedger_t *hedger, const int r, const long seq);
+static long due_hedge(const hedger_t *hedger, const double now);
+static double next_deadline(const hedger_t *hedger);
+static void read_output(hedger_t *hedger, const int r);
+static void grow_output(proc_t *proc, const size_t more);
+static bool take_answer(proc_t *proc, size_t *len, bool *error);
+static void finish_job(hedger_t *hedger, const int r, const size_t len,
+                       const bool error);
+static void record_latency(hedger_t *hedger, const double ms);
+static void print_ready(hedger_t *hedger, FILE *out);
+
+/**************** hedger_new ****************/
+/* see hedger.h for description */
+hedger_t *
+hedger_new(const int nreplicas, char **command, const int percentile)
+{
+  if (nreplicas < 1 || nreplicas > HEDGER_MAX || command == NULL) {
+    return NULL;
+  }
+  hedger_t *hedger = mem_calloc_assert(1, sizeof(hedger_t), "hedger_new");
+  hedger->n = nreplicas;
+  hedger->percentile = percentile;
+  hedger->cap = JOBS_PER_REPLICA * nreplicas;
+  hedger->jobs = mem_calloc_assert(hedger->cap, sizeof(job_t), "hedger_new");
+  hedger->latenciesCap = 256;
+  hedger->latencies = mem_malloc_assert(hedger->latenciesCap
+                                        * sizeof(double), "hedger_new");
+  for (int r = 0; r < nreplicas; r++) {
+    start_proc(&hedger->procs[r], command);
+  }
+  return hedger;
+}
+
+/**************** hedger_pid ****************/
+/* see hedger.h for description */
+pid_t
+hedger_pid(const hedger_t *hedger, const int r)
+{
+  return (hedger == NULL || r < 0 || r >= hedger->n)
+    ? 0 : hedger->procs[r].pid;
+}
+
+/**************** hedger_run ****************/
+/* see hedger.h for description */
+void
+hedger_run(hedger_t *hedger, FILE *out)
+{
+  if (hedger == NULL || out == NULL) {
+    return;
+  }
+  struct pollfd fds[HEDGER_MAX + 1];
+  for (;;) {
+    /* printing first frees ring slots for the lines already read */
+    print_ready(hedger, out);
+    take_lines(hedger);
+    dispatch(hedger);
+    if (hedger->eof && hedger->inLen == 0 && hedger->head == hedger->tail) {
+      return;
+    }
+
+    /* stdin while there is room for its lines, in the ring and in the
+     * buffer; every replica's output; and until the next hedge falls
+     * due, if one can be sent then */
+    size_t room = sizeof(hedger->inbuf) - hedger->inLen;
+    bool reading = !hedger->eof && room > 0
+      && hedger->tail - hedger->head < hedger->cap;
+    fds[0] = (struct pollfd) { reading ? STDIN_FILENO : -1, POLLIN, 0 };
+    for (int r = 0; r < hedger->n; r++) {
+      fds[r + 1] = (struct pollfd) { hedger->procs[r].out, POLLIN, 0 };
+    }
+    int timeout = -1;
+    double deadline = next_deadline(hedger);
+    if (deadline > 0) {
+      double wait = deadline - timing_ms();
+      timeout = (wait <= 0) ? 0 : (int) wait + 1;  // poll counts in whole ms
+    }
+    if (poll(fds, hedger->n + 1, timeout) < 0 && errno != EINTR) {
+      fprintf(stderr, "hedger: poll failed\n");
+      exit(2);
+    }
+
+    if (fds[0].revents & (POLLIN | POLLHUP)) {
+      ssize_t got = read(STDIN_FILENO, hedger->inbuf + hedger->inLen, room);
+      if (got > 0) {
+        hedger->inLen += got;
+      } else if (got == 0 || errno != EINTR) {
+        hedger->eof = true;
+      }
+    }
+    for (int r = 0; r < hedger->n; r++) {
+      if (fds[r + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+        read_output(hedger, r);
+      }
+    }
+  }
+}
+
+/**************** hedger_stats ****************/
+/* see hedger.h for description */
+void
+hedger_stats(const hedger_t *hedger, hedgerstats_t *stats)
+{
+  if (hedger == NULL || stats == NULL) {
+    return;
+  }
+  *stats = hedger->stats;
+  stats->msdelay = hedger->delay;
+  stats->p50 = answers_percentile(hedger->latencies, hedger->nlatencies, 50);
+  stats->p95 = answers_percentile(hedger->latencies, hedger->nlatencies, 95);
+  stats->p99 = answers_percentile(hedger->latencies, hedger->nlatencies, 99);
+  stats->max = answers_percentile(hedger->latencies, hedger->nlatencies, 100);
+}
+
+/**************** hedger_delete ****************/
+/* see hedger.h for description */
+void
+hedger_delete(hedger_t *hedger)
+{
+  if (hedger == NULL) {
+    return;
+  }
+  for (int r = 0; r < hedger->n; r++) {
+    close(hedger->procs[r].in);
+  }
+  /* the rest of a loser's answer is dropped; what comes after it (the
+   * querier's statistics, on exit) is passed on */
+  for (int r = 0; r < hedger->n; r++) {
+    proc_t *proc = &hedger->procs[r];
+    fcntl(proc->out, F_SETFL, fcntl(proc->out, F_GETFL) & ~O_NONBLOCK);
+    char buf[4096];
+    ssize_t got;
+    while ((got = read(proc->out, buf, sizeof(buf))) > 0) {
+      if (proc->accLen + got > proc->accCap) {
+        grow_output(proc, got);
+      }
+      memcpy(proc->acc + proc->accLen, buf, got);
+      proc->accLen += got;
+      size_t len;
+      bool error;
+      while (proc->job >= 0 && take_answer(proc, &len, &error)) {
+        memmove(proc->acc, proc->acc + len, proc->accLen - len);
+        proc->accLen -= len;
+        proc->scanned = proc->lineStart = 0;
+        proc->job = -1;
+      }
+    }
+    for (size_t c = 0; proc->job < 0 && c < proc->accLen; c++) {
+      if (proc->acc[c] != '\n' || (c > 0 && proc->acc[c - 1] != '\n')) {
+        fputc(proc->acc[c], stderr);          // all but blank lines
+      }
+    }
+    close(proc->out);
+    waitpid(proc->pid, NULL, 0);
+    mem_free(proc->acc);
+  }
+  mem_free(hedger->jobs);
+  mem_free(hedger->latencies);
+  mem_free(hedger);
+}
+
+/* start_proc */
+/* Run command as a new replica, its output read from proc->out
+ * (non-blocking on our side). Exits on failure.
+ */
+static void
+start_proc(proc_t *proc, char **command)
+{
+  memset(proc, 0, sizeof(*proc));
+  proc->pid = answers_start(command, "hedger", &proc->in, &proc->out);
+  proc->job = -1;
+  fcntl(proc->out, F_SETFL, fcntl(proc->out, F_GETFL) | O_NONBLOCK);
+}
+
+/* take_lines */
+/* Make jobs of the lines read from stdin, while the ring has room.
+ * Lines are cut as the querier's fgets cuts them, and blank ones, which
+ * it answers with nothing, are dropped.
+ */
+static void
+take_lines(hedger_t *hedger)
+{
+  while (hedger->inLen > 0 && hedger->tail - hedger->head < hedger->cap) {
+    int room = (hedger->inLen < LINE_MAX_LEN - 1)
+      ? hedger->inLen : LINE_MAX_LEN - 1;
+    char *nl = memchr(hedger->inbuf, '\n', room);
+    int len = (nl != NULL) ? (int) (nl - hedger->inbuf) + 1 : room;
+    if (nl == NULL && len < LINE_MAX_LEN - 1 && !hedger->eof) {
+      return;                                 // the rest is yet to come
+    }
+    job_t *job = &hedger->jobs[hedger->tail % hedger->cap];
+    memcpy(job->line, hedger->inbuf, len);
+    job->len = len;
+    if (job->line[len - 1] != '\n') {
+      job->line[job->len++] = '\n';           // a whole line to the replica
+    }
+    job->line[job->len] = '\0';
+    memmove(hedger->inbuf, hedger->inbuf + len, hedger->inLen - len);
+    hedger->inLen -= len;
+    if (strspn(job->line, " \t\r\n") == (size_t) job->len) {
+      continue;
+    }
+    job->answer = NULL;
+    job->primary = job->hedge = -1;
+    hedger->tail++;
+  }
+}
+
+/* dispatch */
+/* Give every idle replica a job: a query due to be hedged if there is
+ * one (the oldest), else the next query not yet sent. Replicas are
+ * offered jobs in turn, so the load is spread.
+ */
+static void
+dispatch(hedger_t *hedger)
+{
+  double now = timing_ms();
+  for (int i = 0; i < hedger->n; i++) {
+    int r = (hedger->turn + i) % hedger->n;
+    if (hedger->procs[r].job >= 0) {
+      continue;
+    }
+    long seq = due_hedge(hedger, now);
+    if (seq >= 0) {
+      hedger->jobs[seq % hedger->cap].hedge = r;
+      hedger->stats.hedged++;
+      send_job(hedger, r, seq);
+    } else if (hedger->next < hedger->tail) {
+      job_t *job = &hedger->jobs[hedger->next % hedger->cap];
+      job->primary = r;
+      job->sent = now;
+      send_job(hedger, r, hedger->next++);
+    } else {
+      break;
+    }
+    hedger->turn = (r + 1) % hedger->n;
+  }
+}
+
+/* send_job */
+/* Write job seq's line to replica r, which is idle, so its pipe has
+ * room for it.
+ */
+static void
+send_job(hedger_t *hedger, const int r, const long seq)
+{
+  proc_t *proc = &hedger->procs[r];
+  job_t *job = &hedger->jobs[seq % hedger->cap];
+  if (write(proc->in, job->line, job->len) != job->len) {
+    fprintf(stderr, "hedger: cannot write to replica %d: %s\n", r,
+            strerror(errno));
+    exit(2);
+  }
+  proc->job = seq;
+  proc->wanted = true;
+  hedger->stats.sent[r]++;
+}
+
+/* due_hedge */
+/* Return the sequence number of the oldest job that is due to be
+ * hedged at now: sent, not answered, not hedged, and sent longer ago
+ * than the hedge delay; or -1 if there is none.
+ */
+static long
+due_hedge(const hedger_t *hedger, const double now)
+{
+  if (hedger->delay <= 0) {
+    return -1;
+  }
+  for (long seq = hedger->head; seq < hedger->next; seq++) {
+    const job_t *job = &hedger->jobs[seq % hedger->cap];
+    if (job->answer == NULL && job->hedge < 0
+        && now - job->sent >= hedger->delay) {
+      return seq;
+    }
+  }
+  return -1;
+}
+
+/* next_deadline */
+/* Return when (in ms) the next job not yet due to be hedged falls due,
+ * or 0 if none will. Jobs already due wait for a replica to become
+ * idle, which its output will tell us.
+ */
+static double
+next_deadline(const hedger_t *hedger)
+{
+  if (hedger->delay <= 0) {
+    return 0;
+  }
+  double now = timing_ms(), deadline = 0;
+  for (long seq = hedger->head; seq < hedger->next; seq++) {
+    const job_t *job = &hedger->jobs[seq % hedger->cap];
+    double due = job->sent + hedger->delay;
+    if (job->answer == NULL && job->hedge < 0 && due > now
+        && (deadline == 0 || due < deadline)) {
+      deadline = due;
+    }
+  }
+  return deadline;
+}
+
+/* read_output */
+/* Read what replica r has written, finishing its job if its answer is
+ * whole. Exits if the replica has exited, passing on its last words.
+ */
+static void
+read_output(hedger_t *hedger, const int r)
+{
+  proc_t *proc = &hedger->procs[r];
+  char buf[65536];
+  ssize_t got;
+  while ((got = read(proc->out, buf, sizeof(buf))) > 0) {
+    if (proc->accLen + got > proc->accCap) {
+      grow_output(proc, got);
+    }
+    memcpy(proc->acc + proc->accLen, buf, got);
+    proc->accLen += got;
+  }
+  size_t len;
+  bool error;
+  if (proc->job >= 0 && take_answer(proc, &len, &error)) {
+    finish_job(hedger, r, len, error);
+  } else if (got == 0) {
+    fwrite(proc->acc, 1, proc->accLen, stderr);
+    fprintf(stderr, "hedger: replica %d exited\n", r);
+    exit(2);
+  }
+}
+
+/* grow_output */
+/* Make room in proc's output for more bytes. */
+static void
+grow_output(proc_t *proc, const size_t more)
+{
+  proc->accCap = 2 * (proc->accLen + more);
+  char *bigger = mem_malloc_assert(proc->accCap, "grow_output");
+  memcpy(bigger, proc->acc, proc->accLen);
+  mem_free(proc->acc);
+  proc->acc = bigger;
+}
+
+/* take_answer */
+/* Return true if proc's output holds a whole answer: up to and
+ * including a separator line or an error line. *len is its length.
+ */
+static bool
+take_answer(proc_t *proc, size_t *len, bool *error)
+{
+  for (; proc->scanned < proc->accLen; proc->scanned++) {
+    if (proc->acc[proc->scanned] != '\n') {
+      continue;
+    }
+    const char *line = proc->acc + proc->lineStart;
+    size_t lineLen = proc->scanned - proc->lineStart;
+    proc->lineStart = proc->scanned + 1;
+    if (answers_end(line, lineLen, error)) {
+      *len = ++proc->scanned;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* finish_job */
+/* Replica r's answer to its job is the first len bytes of its output:
+ * if the job has no answer yet, take this one, time it, and cancel the
+ * other replica working on the job; otherwise drop it. Either way, r
+ * is idle again.
+ */
+static void
+finish_job(hedger_t *hedger, const int r, const size_t len, const bool error)
+{
+  proc_t *proc = &hedger->procs[r];
+  long seq = proc->job;
+  job_t *job = &hedger->jobs[seq % hedger->cap];
+  bool timed = (proc->answers++ > 0);        // the first waited for loading
+  if (proc->wanted && seq >= hedger->head && job->answer == NULL) {
+    job->answer = mem_malloc_assert(len, "finish_job");
+    memcpy(job->answer, proc->acc, len);
+    job->answerLen = len;
+    job->error = error;
+    double latency = timing_ms() - job->sent;
+    hedger->stats.queries++;
+    hedger->stats.used[r]++;
+    if (timed) {
+      hedger->stats.msused[r] += latency;
+      record_latency(hedger, latency);
+    }
+    if (r == job->hedge) {
+      hedger->stats.hedgeWins++;
+    }
+    int other = (r == job->primary) ? job->hedge : job->primary;
+    if (other >= 0 && hedger->procs[other].job == seq) {
+      /* a querier cancels the query running on SIGUSR1, and ignores it
+       * between queries */
+      kill(hedger->procs[other].pid, SIGUSR1);
+      hedger->procs[other].wanted = false;
+      hedger->stats.cancelled++;
+    }
+  }
+  memmove(proc->acc, proc->acc + len, proc->accLen - len);
+  proc->accLen -= len;
+  proc->scanned = proc->lineStart = 0;
+  proc->job = -1;
+}
+
+/* record_latency */
+/* Note a latency timed, and set the hedge delay from the recent ones. */
+static void
+record_latency(hedger_t *hedger, const double ms)
+{
+  if (hedger->nlatencies == hedger->latenciesCap) {
+    hedger->latenciesCap *= 2;
+    double *bigger = mem_malloc_assert(hedger->latenciesCap * sizeof(double),
+                                       "record_latency");
+    memcpy(bigger, hedger->latencies, hedger->nlatencies * sizeof(double));
+    mem_free(hedger->latencies);
+    hedger->latencies = bigger;
+  }
+  hedger->latencies[hedger->nlatencies++] = ms;
+
+  hedger->window[hedger->windowNext] = ms;
+  hedger->windowNext = (hedger->windowNext + 1) % HEDGE_WINDOW;
+  if (hedger->nwindow < HEDGE_WINDOW) {
+    hedger->nwindow++;
+  }
+  if (hedger->percentile > 0 && hedger->nwindow >= HEDGE_MIN) {
+    hedger->delay = answers_percentile(hedger->window, hedger->nwindow,
+                               hedger->percentile);
+  }
+}
+
+/* print_ready */
+/* Print the answers that are ready and not waiting on an earlier one:
+ * answers onto out, error messages onto stderr.
+ */
+static void
+print_ready(hedger_t *hedger, FILE *out)
+{
+  bool printed = false;
+  while (hedger->head < hedger->tail) {
+    job_t *job = &hedger->jobs[hedger->head % hedger->cap];
+    if (job->answer == NULL) {
+      break;
+    }
+    fwrite(job->answer, 1, job->answerLen, job->error ? stderr : out);
+    mem_free(job->answer);
+    job->answer = NULL;
+    hedger->head++;
+    printed = true;
+  }
+  if (printed) {
+    fflush(out);
+  }
+}
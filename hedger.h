@@ -0,0 +1,82 @@
+/*
+ * hedger.h - header file for the querier's 'hedger' module
+ *
+ * A front end to several replica processes of the querier, each
+ * answering over a pair of pipes. Query lines are read from stdin and
+ * each is sent to an idle replica; the answers are printed in the
+ * order the lines came in. A replica has one query at a time.
+ *
+ * A query not answered within the chosen percentile of the latencies
+ * observed so far (the p95, say) is hedged: sent to a second, idle
+ * replica as well. The first answer is taken, and the replica still
+ * working on the query is sent SIGUSR1, which makes a querier cancel
+ * the query it is running; its answer, when it comes, is dropped. So a
+ * replica that is slow for a while (page faults, a cold cache) delays
+ * a query by about the percentile, rather than by as long as it is
+ * slow, at the cost of a few percent more queries evaluated.
+ *
+ * An answer ends with the querier's separator line; a rejected query's
+ * answer is its error message (a replica's stderr shares the pipe with
+ * its stdout), which is printed on stderr.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __HEDGER_H
+#define __HEDGER_H
+
+#include <stdio.h>
+#include <sys/types.h>
+
+/* most replicas */
+#define HEDGER_MAX 16
+
+typedef struct hedger hedger_t;
+
+/* hedgerstats_t: what the hedger has done so far. Latencies are in ms,
+ * from sending a query to the first answer; a replica's first answer,
+ * which waits for it to load the index, is not timed. */
+typedef struct hedgerstats {
+  long queries;        // queries answered
+  long hedged;         // ...of which were hedged
+  long hedgeWins;      // ...and answered first by the hedge
+  long cancelled;      // losers sent SIGUSR1
+  double msdelay;      // the hedge delay in use last; 0: none yet
+  double p50, p95, p99, max;  // latencies timed
+  long sent[HEDGER_MAX];      // per replica: queries sent to it
+  long used[HEDGER_MAX];      // ...answers taken from it
+  double msused[HEDGER_MAX];  // ...their latencies timed, summed
+} hedgerstats_t;
+
+/**************** hedger_new ****************/
+/* Start nreplicas (1..HEDGER_MAX) processes running command (a
+ * NULL-terminated argument vector, run with execvp), and hedge queries
+ * after the given percentile (1..99) of the latencies seen; 0: never
+ * hedge. Caller must hedger_delete it. Exits if a process cannot be
+ * started.
+ */
+hedger_t *hedger_new(const int nreplicas, char **command,
+                     const int percentile);
+
+/**************** hedger_pid ****************/
+/* Return the process ID of replica r. */
+pid_t hedger_pid(const hedger_t *hedger, const int r);
+
+/**************** hedger_run ****************/
+/* Answer the query lines of stdin, until its end of file, printing the
+ * answers onto out (and rejected queries' errors onto stderr) in input
+ * order. Exits if a replica exits.
+ */
+void hedger_run(hedger_t *hedger, FILE *out);
+
+/**************** hedger_stats ****************/
+/* Fill *stats with the counts so far. */
+void hedger_stats(const hedger_t *hedger, hedgerstats_t *stats);
+
+/**************** hedger_delete ****************/
+/* Close the replicas' stdin, copy what they print on the way out onto
+ * stderr, wait for them to exit, and free the hedger; NULL is ignored.
+ */
+void hedger_delete(hedger_t *hedger);
+
+#endif // __HEDGER_H
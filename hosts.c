@@ -0,0 +1,315 @@
+/*
+ * hosts.c - 'hosts' module for the CS50 TSE querier
+ *
+ * see hosts.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <limits.h>
+#include "hosts.h"
+#include "bitmap.h"
+#include "hashtable.h"
+#include "mem.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define HOST_MAX 256         // longest host name we keep
+
+/**************** global types ****************/
+struct hosts {
+  int maxdoc;          // docIDs 1..maxdoc were read
+  int *docHost;        // docHost[docID] = host id, or -1
+  int *depth;          // depth[docID], or -1
+  int *length;         // length[docID] of content, in bytes
+  int nhosts;
+  int capHosts;
+  char **names;        // names[id]
+  bitmap_t **bitmaps;  // bitmaps[id] has the docIDs of host id
+};
+
+/**************** local functions ****************/
+static int  host_intern(hosts_t *hosts, hashtable_t *ids, const char *name);
+static void read_page(FILE *fp, char *url, const int len, int *depth,
+                      int *length);
+static int *grow_column(int *column, const int n, const int cap);
+static bool host_matches(const char *host, const char *name, const bool site);
+
+/**************** hosts_load ****************/
+/* see hosts.h for description */
+hosts_t *
+hosts_load(const char *pageDirectory)
+{
+  hosts_t *hosts = mem_calloc_assert(1, sizeof(hosts_t), "hosts_load");
+  if (pageDirectory == NULL) {
+    return hosts;
+  }
+
+  hashtable_t *ids = hashtable_new(64);      // name -> int* host id
+  int capDocs = 64;
+  hosts->docHost = mem_malloc_assert(capDocs * sizeof(int), "hosts_load");
+  hosts->depth = mem_malloc_assert(capDocs * sizeof(int), "hosts_load");
+  hosts->length = mem_malloc_assert(capDocs * sizeof(int), "hosts_load");
+  hosts->docHost[0] = hosts->depth[0] = -1;
+  hosts->length[0] = 0;
+
+  for (int docID = 1; ; docID++) {
+    char filename[PATH_MAX];
+    snprintf(filename, sizeof(filename), "%s/%d", pageDirectory, docID);
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+      break;                 // crawler numbers pages without gaps
+    }
+    char url[1024];
+    char host[HOST_MAX];
+    int id = -1, depth, length;
+    read_page(fp, url, sizeof(url), &depth, &length);
+    if (hosts_parse(url, host, sizeof(host))) {
+      id = host_intern(hosts, ids, host);
+    }
+    fclose(fp);
+
+    if (docID >= capDocs) {
+      capDocs *= 2;
+      hosts->docHost = grow_column(hosts->docHost, docID, capDocs);
+      hosts->depth = grow_column(hosts->depth, docID, capDocs);
+      hosts->length = grow_column(hosts->length, docID, capDocs);
+    }
+    hosts->docHost[docID] = id;
+    hosts->depth[docID] = depth;
+    hosts->length[docID] = length;
+    hosts->maxdoc = docID;
+  }
+  hashtable_delete(ids, mem_free);
+
+  /* one bitmap per host, now that we know how many docs there are */
+  hosts->bitmaps = mem_calloc_assert(hosts->nhosts + 1, sizeof(bitmap_t*),
+                                     "hosts_load");
+  for (int h = 0; h < hosts->nhosts; h++) {
+    hosts->bitmaps[h] = bitmap_new(hosts->maxdoc + 1);
+  }
+  for (int docID = 1; docID <= hosts->maxdoc; docID++) {
+    if (hosts->docHost[docID] >= 0) {
+      bitmap_set(hosts->bitmaps[hosts->docHost[docID]], docID);
+    }
+  }
+  return hosts;
+}
+
+/* read_page */
+/* Read the URL (cut to len-1 characters; "" if none), the depth line
+ * and the content length of the page file open on fp.
+ */
+static void
+read_page(FILE *fp, char *url, const int len, int *depth, int *length)
+{
+  *depth = -1;
+  *length = 0;
+  if (fgets(url, len, fp) == NULL) {
+    url[0] = '\0';
+    return;
+  }
+  int c;
+  if (strchr(url, '\n') == NULL) {
+    while ((c = fgetc(fp)) != EOF && c != '\n') {
+    }                        // the rest of a long URL
+  }
+  if (fscanf(fp, "%d", depth) != 1) {
+    *depth = -1;
+  }
+  while ((c = fgetc(fp)) != EOF && c != '\n') {
+  }
+
+  long start = ftell(fp);
+  if (start >= 0 && fseek(fp, 0, SEEK_END) == 0) {
+    long end = ftell(fp);
+    if (end >= start) {
+      *length = (end - start > INT_MAX) ? INT_MAX : (int) (end - start);
+    }
+  }
+}
+
+/* grow_column */
+/* Return a copy of column's first n entries with room for cap, freeing
+ * column.
+ */
+static int *
+grow_column(int *column, const int n, const int cap)
+{
+  int *bigger = mem_malloc_assert(cap * sizeof(int), "hosts_load");
+  memcpy(bigger, column, n * sizeof(int));
+  mem_free(column);
+  return bigger;
+}
+
+/* host_intern */
+/* Return the id of host name, adding it if new. */
+static int
+host_intern(hosts_t *hosts, hashtable_t *ids, const char *name)
+{
+  int *id = hashtable_find(ids, name);
+  if (id != NULL) {
+    return *id;
+  }
+
+  if (hosts->nhosts == hosts->capHosts) {
+    hosts->capHosts = (hosts->capHosts == 0) ? 8 : 2 * hosts->capHosts;
+    char **bigger = mem_malloc_assert(hosts->capHosts * sizeof(char*),
+                                      "host_intern");
+    if (hosts->nhosts > 0) {
+      memcpy(bigger, hosts->names, hosts->nhosts * sizeof(char*));
+    }
+    mem_free(hosts->names);
+    hosts->names = bigger;
+  }
+
+  char *copy = mem_malloc_assert(strlen(name) + 1, "host_intern");
+  strcpy(copy, name);
+  hosts->names[hosts->nhosts] = copy;
+
+  id = mem_malloc_assert(sizeof(int), "host_intern");
+  *id = hosts->nhosts;
+  hashtable_insert(ids, name, id);
+  return hosts->nhosts++;
+}
+
+/**************** hosts_maxdoc ****************/
+/* see hosts.h for description */
+int
+hosts_maxdoc(const hosts_t *hosts)
+{
+  return (hosts == NULL) ? 0 : hosts->maxdoc;
+}
+
+/**************** hosts_count ****************/
+/* see hosts.h for description */
+int
+hosts_count(const hosts_t *hosts)
+{
+  return (hosts == NULL) ? 0 : hosts->nhosts;
+}
+
+/**************** hosts_id ****************/
+/* see hosts.h for description */
+int
+hosts_id(const hosts_t *hosts, const int docID)
+{
+  if (hosts == NULL || docID <= 0 || docID > hosts->maxdoc) {
+    return -1;
+  }
+  return hosts->docHost[docID];
+}
+
+/**************** hosts_page ****************/
+/* see hosts.h for description */
+void
+hosts_page(const hosts_t *hosts, const int docID, int *depth, int *length)
+{
+  if (hosts == NULL || docID <= 0 || docID > hosts->maxdoc) {
+    *depth = -1;
+    *length = 0;
+    return;
+  }
+  *depth = hosts->depth[docID];
+  *length = hosts->length[docID];
+}
+
+/**************** hosts_name ****************/
+/* see hosts.h for description */
+const char *
+hosts_name(const hosts_t *hosts, const int hostID)
+{
+  if (hosts == NULL || hostID < 0 || hostID >= hosts->nhosts) {
+    return NULL;
+  }
+  return hosts->names[hostID];
+}
+
+/**************** hosts_filter ****************/
+/* see hosts.h for description */
+bitmap_t *
+hosts_filter(const hosts_t *hosts, const char *name, const bool site)
+{
+  bitmap_t *allowed = bitmap_new(hosts_maxdoc(hosts) + 1);
+  if (hosts == NULL || name == NULL) {
+    return allowed;
+  }
+  for (int h = 0; h < hosts->nhosts; h++) {
+    if (host_matches(hosts->names[h], name, site)) {
+      bitmap_or(allowed, hosts->bitmaps[h]);
+    }
+  }
+  return allowed;
+}
+
+/* host_matches */
+/* Does host match the filter name (exactly, or as a subdomain)? */
+static bool
+host_matches(const char *host, const char *name, const bool site)
+{
+  if (strcmp(host, name) == 0) {
+    return true;
+  }
+  if (!site) {
+    return false;
+  }
+  size_t hlen = strlen(host);
+  size_t nlen = strlen(name);
+  return hlen > nlen && host[hlen - nlen - 1] == '.'
+    && strcmp(host + hlen - nlen, name) == 0;
+}
+
+/**************** hosts_parse ****************/
+/* see hosts.h for description */
+bool
+hosts_parse(const char *url, char *buf, const int len)
+{
+  if (url == NULL || buf == NULL || len <= 0) {
+    return false;
+  }
+  const char *start = strstr(url, "://");
+  if (start == NULL) {
+    return false;
+  }
+  start += 3;
+
+  int n = 0;
+  for (const char *p = start; *p != '\0' && *p != '/' && *p != ':'
+         && *p != '?' && *p != '#' && !isspace((unsigned char) *p); p++) {
+    if (n + 1 >= len) {
+      return false;
+    }
+    buf[n++] = (char) tolower((unsigned char) *p);
+  }
+  buf[n] = '\0';
+  return n > 0;
+}
+
+/**************** hosts_delete ****************/
+/* see hosts.h for description */
+void
+hosts_delete(hosts_t *hosts)
+{
+  if (hosts == NULL) {
+    return;
+  }
+  for (int h = 0; h < hosts->nhosts; h++) {
+    mem_free(hosts->names[h]);
+    if (hosts->bitmaps != NULL) {
+      bitmap_delete(hosts->bitmaps[h]);
+    }
+  }
+  mem_free(hosts->names);
+  mem_free(hosts->bitmaps);
+  mem_free(hosts->docHost);
+  mem_free(hosts->depth);
+  mem_free(hosts->length);
+  mem_free(hosts);
+}
@@ -0,0 +1,84 @@
+/*
+ * hosts.h - header file for the querier's 'hosts' module
+ *
+ * Reads the URL (first line) of every page file in a crawler
+ * pageDirectory, gives each distinct host a small integer id, and
+ * builds one docID bitmap per host, so that host: and site: query
+ * filters cost one bit test per candidate document.
+ *
+ * The same pass notes each page's depth and content length, for the
+ * docattrs module, so every page file is opened once at startup.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __HOSTS_H
+#define __HOSTS_H
+
+#include <stdbool.h>
+#include "bitmap.h"
+
+typedef struct hosts hosts_t;
+
+/**************** hosts_load ****************/
+/* Read pageDirectory/1, pageDirectory/2, ... until the first missing
+ * file, recording the host of each page's URL.
+ *
+ * We return:
+ *   a new hosts_t, which the caller frees with hosts_delete; a
+ *   directory with no page files gives an empty (but valid) hosts_t.
+ */
+hosts_t *hosts_load(const char *pageDirectory);
+
+/**************** hosts_maxdoc ****************/
+/* Return the largest docID whose page file was read. */
+int hosts_maxdoc(const hosts_t *hosts);
+
+/**************** hosts_count ****************/
+/* Return the number of distinct hosts. */
+int hosts_count(const hosts_t *hosts);
+
+/**************** hosts_id ****************/
+/* Return the host id (0..hosts_count-1) of docID, or -1 if unknown. */
+int hosts_id(const hosts_t *hosts, const int docID);
+
+/**************** hosts_page ****************/
+/* Set *depth to the crawl depth of docID (second line of its page
+ * file) and *length to the bytes of content after the two header
+ * lines; -1 and 0 for unknown docIDs or unreadable lines.
+ */
+void hosts_page(const hosts_t *hosts, const int docID, int *depth,
+                int *length);
+
+/**************** hosts_name ****************/
+/* Return the name of host id, or NULL if out of range. The string
+ * belongs to the hosts_t.
+ */
+const char *hosts_name(const hosts_t *hosts, const int hostID);
+
+/**************** hosts_filter ****************/
+/* Build the set of documents a host filter allows.
+ *
+ * Caller provides:
+ *   a lowercase host name; site=false matches that host exactly,
+ *   site=true also matches any subdomain of it ("dartmouth.edu"
+ *   matches "www.dartmouth.edu").
+ * We return:
+ *   a new bitmap (caller must bitmap_delete) that is the union of the
+ *   precomputed bitmaps of all matching hosts; empty if none match.
+ */
+bitmap_t *hosts_filter(const hosts_t *hosts, const char *name,
+                       const bool site);
+
+/**************** hosts_delete ****************/
+/* Free everything in hosts; NULL is ignored. */
+void hosts_delete(hosts_t *hosts);
+
+/**************** hosts_parse ****************/
+/* Copy the lowercase host part of url ("http://Host:80/x" -> "host")
+ * into buf of size len. Returns false if url has no "://" or the host
+ * does not fit.
+ */
+bool hosts_parse(const char *url, char *buf, const int len);
+
+#endif // __HOSTS_H
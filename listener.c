@@ -0,0 +1,911 @@
+/*
+ * listener.c - 'listener' module for the CS50 TSE querier
+ *
+ * see listener.h for more information.
+ *
+ * The io_uring loop talks to the kernel through the raw system calls
+ * and the rings they map, with no library. Every submission carries a
+ * tag in its user_data: what it is (accept, receive, send, close, or
+ * the read of stdin) and the socket it is for. A connection is closed,
+ * through the ring too, only once neither a receive nor a send is
+ * pending on it, so no completion can arrive for a socket number that
+ * a later connection has been given.
+ *
+ * Both loops take lines as they arrive, answer each at once, and add
+ * the answer to the connection's output; only once every event of a
+ * round has been handled is that output sent, one send per connection,
+ * so a client that sent several lines gets their answers together.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* syscall, accept4 and MAP_ANONYMOUS are Linux extensions */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <linux/io_uring.h>
+#include "listener.h"
+#include "timing.h"
+#include "mem.h"
+
+/* submission queue entries; the completion queue is twice as long */
+#define RING_ENTRIES 256
+
+/* receive buffers provided to the kernel: how many (a power of 2), how
+ * big, and the group they form */
+#define BUF_COUNT 256
+#define BUF_SIZE  4096
+#define BUF_GROUP 1
+
+/* events taken from epoll per wait, and bytes per receive */
+#define EPOLL_EVENTS 256
+#define RECV_SIZE    65536
+
+/* what a submission or epoll registration is for: a tag, and a socket */
+enum { TAG_ACCEPT = 1, TAG_RECV, TAG_SEND, TAG_CLOSE, TAG_STDIN };
+#define TAG(kind, fd) (((uint64_t) (fd) << 8) | (kind))
+#define TAG_KIND(data) ((int) ((data) & 0xff))
+#define TAG_FD(data)   ((int) ((data) >> 8))
+
+/**************** local types ****************/
+/* conn_t: one client connection. */
+typedef struct conn {
+  int fd;
+  char line[LISTEN_LINEMAX];   // the line being received
+  int lineLen;
+  char *out;           // answers not yet being sent...
+  size_t outLen, outCap;
+  char *send;          // ...and those being sent, which never move
+  size_t sendLen, sendOff, sendCap;
+  bool receiving;      // io_uring: a multishot receive is armed
+  bool sending;        // a send is pending (io_uring), or waits for
+                       // room in the socket (epoll)
+  bool eof;            // the client will send no more
+  bool dead;           // an error: send nothing more either
+  bool listed;         // on the list of connections to see to
+} conn_t;
+
+/**************** global types ****************/
+struct listener {
+  listen_io_t io;
+  int sock;
+  int port;
+  bool stop;
+  conn_t **conns;      // by socket number; NULL: none
+  int maxConns;        // room in conns
+  int *todo;           // sockets with output to send, or to close
+  int ntodo, todoCap;
+  listenstats_t stats;
+  double start;        // when the first connection came; 0: none yet
+  answerfn_t answer;
+  void *arg;
+
+  /* io_uring: the rings, as mapped */
+  int ring;
+  void *sqMap, *cqMap;
+  size_t sqMapLen, cqMapLen;
+  struct io_uring_sqe *sqes;
+  size_t sqesLen;
+  unsigned *sqHead, *sqTail, *sqArray, sqMask, sqEntries;
+  unsigned sqLocal;    // our tail, ahead of *sqTail until submitted
+  unsigned *cqHead, *cqTail, cqMask;
+  struct io_uring_cqe *cqes;
+  struct io_uring_buf_ring *bufRing;  // the provided buffers' ring...
+  size_t bufRingLen;
+  char *bufs;                         // ...and the buffers
+  unsigned short bufTail;
+  char stdinBuf[256];
+
+  /* epoll */
+  int epoll;
+};
+
+/**************** local functions ****************/
+static bool uring_setup(listener_t *listener);
+static void uring_teardown(listener_t *listener);
+static void uring_run(listener_t *listener);
+static void uring_complete(listener_t *listener,
+                           const struct io_uring_cqe *cqe);
+static struct io_uring_sqe *uring_sqe(listener_t *listener);
+static bool uring_enter(listener_t *listener, const unsigned wait);
+static void uring_accept(listener_t *listener);
+static void uring_recv(listener_t *listener, conn_t *conn);
+static void uring_stdin(listener_t *listener);
+static void uring_recycle(listener_t *listener, const int bid);
+static void uring_flush(listener_t *listener);
+static void epoll_run(listener_t *listener);
+static void epoll_flush(listener_t *listener);
+static bool epoll_watch(listener_t *listener, const int op, conn_t *conn);
+static conn_t *conn_new(listener_t *listener, const int fd);
+static void conn_free(listener_t *listener, conn_t *conn);
+static void conn_feed(listener_t *listener, conn_t *conn, const char *data,
+                      const size_t n);
+static void conn_end(listener_t *listener, conn_t *conn, const bool gone);
+static void conn_line(listener_t *listener, conn_t *conn);
+static void conn_list(listener_t *listener, conn_t *conn);
+static bool conn_done(const conn_t *conn);
+static size_t conn_unsent(conn_t *conn);
+
+/**************** listener_new ****************/
+/* see listener.h for description */
+listener_t *
+listener_new(const int port, const listen_io_t io)
+{
+  int sock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sock < 0) {
+    fprintf(stderr, "listener: cannot make a socket: %s\n",
+            strerror(errno));
+    return NULL;
+  }
+  int on = 1;
+  setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0
+      || listen(sock, SOMAXCONN) != 0
+      || getsockname(sock, (struct sockaddr *) &addr, &len) != 0) {
+    fprintf(stderr, "listener: cannot listen on port %d: %s\n", port,
+            strerror(errno));
+    close(sock);
+    return NULL;
+  }
+
+  listener_t *listener = mem_calloc_assert(1, sizeof(listener_t),
+                                           "listener_new");
+  listener->sock = sock;
+  listener->port = ntohs(addr.sin_port);
+  listener->ring = -1;
+  listener->epoll = -1;
+  listener->io = io;
+  if (io == LISTEN_URING && !uring_setup(listener)) {
+    fprintf(stderr, "listener: cannot use io_uring (%s); using epoll\n",
+            strerror(errno));
+    listener->io = LISTEN_EPOLL;
+  }
+  return listener;
+}
+
+/**************** listener_port ****************/
+/* see listener.h for description */
+int
+listener_port(const listener_t *listener)
+{
+  return (listener == NULL) ? 0 : listener->port;
+}
+
+/**************** listener_io ****************/
+/* see listener.h for description */
+listen_io_t
+listener_io(const listener_t *listener)
+{
+  return (listener == NULL) ? LISTEN_EPOLL : listener->io;
+}
+
+/**************** listener_io_name ****************/
+/* see listener.h for description */
+const char *
+listener_io_name(const listen_io_t io)
+{
+  return (io == LISTEN_URING) ? "uring" : "epoll";
+}
+
+/**************** listener_run ****************/
+/* see listener.h for description */
+void
+listener_run(listener_t *listener, answerfn_t answer, void *arg)
+{
+  if (listener == NULL || answer == NULL) {
+    return;
+  }
+  listener->answer = answer;
+  listener->arg = arg;
+  listener->stop = false;
+  if (listener->io == LISTEN_URING) {
+    uring_run(listener);
+  } else {
+    epoll_run(listener);
+  }
+  if (listener->start > 0) {
+    listener->stats.msserving = timing_ms() - listener->start;
+  }
+
+  /* whatever is still open is closed, and its answers dropped */
+  for (int fd = 0; fd < listener->maxConns; fd++) {
+    if (listener->conns[fd] != NULL) {
+      close(fd);
+      conn_free(listener, listener->conns[fd]);
+    }
+  }
+  listener->ntodo = 0;
+}
+
+/**************** listener_stats ****************/
+/* see listener.h for description */
+void
+listener_stats(const listener_t *listener, listenstats_t *stats)
+{
+  if (listener != NULL && stats != NULL) {
+    *stats = listener->stats;
+  }
+}
+
+/**************** listener_delete ****************/
+/* see listener.h for description */
+void
+listener_delete(listener_t *listener)
+{
+  if (listener == NULL) {
+    return;
+  }
+  uring_teardown(listener);
+  if (listener->epoll >= 0) {
+    close(listener->epoll);
+  }
+  close(listener->sock);
+  mem_free(listener->conns);
+  mem_free(listener->todo);
+  mem_free(listener);
+}
+
+/* uring_setup */
+/* Make the ring, map it, and register the receive buffers. Returns
+ * false, with errno set and nothing left behind, if the kernel cannot
+ * do any of it, or lacks the features we need.
+ */
+static bool
+uring_setup(listener_t *listener)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN;
+  int ring = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+  if (ring < 0 && errno == EINVAL) {
+    memset(&params, 0, sizeof(params));      // an older kernel
+    ring = syscall(__NR_io_uring_setup, RING_ENTRIES, &params);
+  }
+  if (ring < 0) {
+    return false;
+  }
+  /* one mapping for both rings (5.4), and reads at the current file
+   * position (5.6), for stdin */
+  unsigned need = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_RW_CUR_POS
+    | IORING_FEAT_NODROP;
+  if ((params.features & need) != need) {
+    close(ring);
+    errno = ENOSYS;
+    return false;
+  }
+  listener->ring = ring;
+
+  listener->sqMapLen = params.sq_off.array
+    + params.sq_entries * sizeof(unsigned);
+  size_t cqLen = params.cq_off.cqes
+    + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (cqLen > listener->sqMapLen) {
+    listener->sqMapLen = cqLen;
+  }
+  listener->sqMap = mmap(NULL, listener->sqMapLen, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+  listener->sqesLen = params.sq_entries * sizeof(struct io_uring_sqe);
+  listener->sqes = mmap(NULL, listener->sqesLen, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+  if (listener->sqMap == MAP_FAILED || listener->sqes == MAP_FAILED) {
+    int saved = errno;
+    uring_teardown(listener);
+    errno = saved;
+    return false;
+  }
+  char *sq = listener->sqMap;
+  listener->sqHead = (unsigned *) (sq + params.sq_off.head);
+  listener->sqTail = (unsigned *) (sq + params.sq_off.tail);
+  listener->sqMask = *(unsigned *) (sq + params.sq_off.ring_mask);
+  listener->sqEntries = *(unsigned *) (sq + params.sq_off.ring_entries);
+  listener->sqArray = (unsigned *) (sq + params.sq_off.array);
+  listener->sqLocal = *listener->sqTail;
+  char *cq = sq;                             // the same mapping
+  listener->cqHead = (unsigned *) (cq + params.cq_off.head);
+  listener->cqTail = (unsigned *) (cq + params.cq_off.tail);
+  listener->cqMask = *(unsigned *) (cq + params.cq_off.ring_mask);
+  listener->cqes = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+  /* the receive buffers, and the ring through which we hand them to the
+   * kernel and take them back (5.19) */
+  listener->bufRingLen = BUF_COUNT * sizeof(struct io_uring_buf);
+  listener->bufRing = mmap(NULL, listener->bufRingLen,
+                           PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (listener->bufRing == MAP_FAILED) {
+    int saved = errno;
+    listener->bufRing = NULL;
+    uring_teardown(listener);
+    errno = saved;
+    return false;
+  }
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (uint64_t) (uintptr_t) listener->bufRing;
+  reg.ring_entries = BUF_COUNT;
+  reg.bgid = BUF_GROUP;
+  if (syscall(__NR_io_uring_register, ring, IORING_REGISTER_PBUF_RING,
+              &reg, 1) != 0) {
+    int saved = errno;
+    uring_teardown(listener);
+    errno = saved;
+    return false;
+  }
+  listener->bufs = mem_malloc_assert((size_t) BUF_COUNT * BUF_SIZE,
+                                     "uring_setup");
+  listener->bufTail = 0;
+  for (int bid = 0; bid < BUF_COUNT; bid++) {
+    uring_recycle(listener, bid);
+  }
+  return true;
+}
+
+/* uring_teardown */
+/* Unmap and close whatever uring_setup made; safe to call again. */
+static void
+uring_teardown(listener_t *listener)
+{
+  if (listener->ring >= 0) {
+    close(listener->ring);                   // cancels what is pending
+    listener->ring = -1;
+  }
+  if (listener->sqMap != NULL && listener->sqMap != MAP_FAILED) {
+    munmap(listener->sqMap, listener->sqMapLen);
+  }
+  if (listener->sqes != NULL && listener->sqes != MAP_FAILED) {
+    munmap(listener->sqes, listener->sqesLen);
+  }
+  if (listener->bufRing != NULL) {
+    munmap(listener->bufRing, listener->bufRingLen);
+  }
+  listener->sqMap = NULL;
+  listener->sqes = NULL;
+  listener->bufRing = NULL;
+  mem_free(listener->bufs);
+  listener->bufs = NULL;
+}
+
+/* uring_run */
+/* The io_uring loop: handle every completion there is, queue the sends
+ * and closes they call for, then submit them all and wait for more
+ * completions in one system call.
+ */
+static void
+uring_run(listener_t *listener)
+{
+  uring_accept(listener);
+  uring_stdin(listener);
+  while (!listener->stop) {
+    if (!uring_enter(listener, 1)) {
+      break;
+    }
+    unsigned head = *listener->cqHead;
+    unsigned tail = __atomic_load_n(listener->cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail && !listener->stop; head++) {
+      uring_complete(listener, &listener->cqes[head & listener->cqMask]);
+      /* let the kernel reuse the slot as soon as we are done with it */
+      __atomic_store_n(listener->cqHead, head + 1, __ATOMIC_RELEASE);
+    }
+    uring_flush(listener);
+  }
+}
+
+/* uring_complete */
+/* Handle one completion. */
+static void
+uring_complete(listener_t *listener, const struct io_uring_cqe *cqe)
+{
+  int fd = TAG_FD(cqe->user_data);
+  conn_t *conn = (fd < listener->maxConns) ? listener->conns[fd] : NULL;
+  bool more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+
+  switch (TAG_KIND(cqe->user_data)) {
+  case TAG_ACCEPT:
+    if (cqe->res >= 0) {
+      uring_recv(listener, conn_new(listener, cqe->res));
+    }
+    if (!more) {
+      uring_accept(listener);                // re-arm
+    }
+    break;
+
+  case TAG_RECV:
+    if (conn == NULL) {
+      break;
+    }
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+      int bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+      if (cqe->res > 0) {
+        conn_feed(listener, conn, listener->bufs + (size_t) bid * BUF_SIZE,
+                  cqe->res);
+      }
+      uring_recycle(listener, bid);
+    }
+    conn->receiving = more;
+    if (cqe->res == 0 || (cqe->res < 0 && cqe->res != -ENOBUFS)) {
+      conn_end(listener, conn, cqe->res < 0);  // the client is done, or gone
+    } else if (!more) {
+      uring_recv(listener, conn);            // re-arm, buffers recycled
+    }
+    conn_list(listener, conn);
+    break;
+
+  case TAG_SEND:
+    if (conn == NULL) {
+      break;
+    }
+    conn->sending = false;
+    if (cqe->res < 0) {
+      conn->dead = true;
+    } else {
+      listener->stats.bytesOut += cqe->res;
+      conn->sendOff += cqe->res;
+    }
+    conn_list(listener, conn);
+    break;
+
+  case TAG_STDIN:
+    if (cqe->res <= 0) {
+      listener->stop = true;
+    } else {
+      uring_stdin(listener);
+    }
+    break;
+
+  default:
+    break;                                   // TAG_CLOSE: nothing to do
+  }
+}
+
+/* uring_sqe */
+/* Return a cleared submission queue entry, submitting what is queued
+ * first if the queue is full.
+ */
+static struct io_uring_sqe *
+uring_sqe(listener_t *listener)
+{
+  unsigned head = __atomic_load_n(listener->sqHead, __ATOMIC_ACQUIRE);
+  if (listener->sqLocal - head >= listener->sqEntries) {
+    uring_enter(listener, 0);
+  }
+  unsigned index = listener->sqLocal & listener->sqMask;
+  struct io_uring_sqe *sqe = &listener->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  listener->sqArray[index] = index;
+  listener->sqLocal++;
+  return sqe;
+}
+
+/* uring_enter */
+/* Submit every queued entry, and wait until at least wait completions
+ * are there. Returns false if the ring has failed.
+ */
+static bool
+uring_enter(listener_t *listener, const unsigned wait)
+{
+  __atomic_store_n(listener->sqTail, listener->sqLocal, __ATOMIC_RELEASE);
+  for (;;) {
+    unsigned head = __atomic_load_n(listener->sqHead, __ATOMIC_ACQUIRE);
+    unsigned pending = listener->sqLocal - head;
+    listener->stats.syscalls++;
+    listener->stats.waits += (wait > 0);
+    if (syscall(__NR_io_uring_enter, listener->ring, pending, wait,
+                wait > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0) >= 0) {
+      return true;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EBUSY || errno == EAGAIN) {
+      return true;               // completions first; we will be back
+    }
+    fprintf(stderr, "listener: io_uring_enter: %s\n", strerror(errno));
+    listener->stop = true;
+    return false;
+  }
+}
+
+/* uring_accept */
+/* Arm a multishot accept on the listening socket (5.19). */
+static void
+uring_accept(listener_t *listener)
+{
+  struct io_uring_sqe *sqe = uring_sqe(listener);
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = listener->sock;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->accept_flags = SOCK_CLOEXEC;
+  sqe->user_data = TAG(TAG_ACCEPT, listener->sock);
+}
+
+/* uring_recv */
+/* Arm a multishot receive on conn (6.0), each completion bringing a
+ * buffer from the provided ring.
+ */
+static void
+uring_recv(listener_t *listener, conn_t *conn)
+{
+  struct io_uring_sqe *sqe = uring_sqe(listener);
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = conn->fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = BUF_GROUP;
+  sqe->user_data = TAG(TAG_RECV, conn->fd);
+  conn->receiving = true;
+}
+
+/* uring_stdin */
+/* Queue a read of stdin, whose end of file stops the loop. */
+static void
+uring_stdin(listener_t *listener)
+{
+  struct io_uring_sqe *sqe = uring_sqe(listener);
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = STDIN_FILENO;
+  sqe->addr = (uint64_t) (uintptr_t) listener->stdinBuf;
+  sqe->len = sizeof(listener->stdinBuf);
+  sqe->off = (uint64_t) -1;                  // the current position
+  sqe->user_data = TAG(TAG_STDIN, STDIN_FILENO);
+}
+
+/* uring_recycle */
+/* Give receive buffer bid back to the kernel. */
+static void
+uring_recycle(listener_t *listener, const int bid)
+{
+  struct io_uring_buf *buf
+    = &listener->bufRing->bufs[listener->bufTail & (BUF_COUNT - 1)];
+  buf->addr = (uint64_t) (uintptr_t) (listener->bufs
+                                      + (size_t) bid * BUF_SIZE);
+  buf->len = BUF_SIZE;
+  buf->bid = bid;
+  listener->bufTail++;
+  __atomic_store_n(&listener->bufRing->tail, listener->bufTail,
+                   __ATOMIC_RELEASE);
+}
+
+/* uring_flush */
+/* For each connection on the list: queue a send of all of its output,
+ * unless one is pending; or, once it is done, close it.
+ */
+static void
+uring_flush(listener_t *listener)
+{
+  for (int t = 0; t < listener->ntodo; t++) {
+    conn_t *conn = listener->conns[listener->todo[t]];
+    conn->listed = false;
+    if (conn_done(conn)) {
+      struct io_uring_sqe *sqe = uring_sqe(listener);
+      sqe->opcode = IORING_OP_CLOSE;
+      sqe->fd = conn->fd;
+      sqe->user_data = TAG(TAG_CLOSE, conn->fd);
+      conn_free(listener, conn);
+    } else if (!conn->sending && !conn->dead && conn_unsent(conn) > 0) {
+      struct io_uring_sqe *sqe = uring_sqe(listener);
+      sqe->opcode = IORING_OP_SEND;
+      sqe->fd = conn->fd;
+      sqe->addr = (uint64_t) (uintptr_t) (conn->send + conn->sendOff);
+      sqe->len = conn_unsent(conn);
+      sqe->msg_flags = MSG_NOSIGNAL;
+      sqe->user_data = TAG(TAG_SEND, conn->fd);
+      conn->sending = true;
+    }
+  }
+  listener->ntodo = 0;
+}
+
+/* epoll_run */
+/* The epoll loop: wait for sockets that are ready, accept, receive and
+ * answer what is there, then send each connection's output.
+ */
+static void
+epoll_run(listener_t *listener)
+{
+  listener->epoll = epoll_create1(EPOLL_CLOEXEC);
+  fcntl(listener->sock, F_SETFL,
+        fcntl(listener->sock, F_GETFL) | O_NONBLOCK);
+  struct epoll_event ev = { EPOLLIN, { .u64 = TAG(TAG_ACCEPT, 0) } };
+  if (listener->epoll < 0
+      || epoll_ctl(listener->epoll, EPOLL_CTL_ADD, listener->sock, &ev) != 0) {
+    fprintf(stderr, "listener: epoll: %s\n", strerror(errno));
+    return;
+  }
+  /* a regular file (or /dev/null) cannot be watched, but is already
+   * at its end as far as serving goes */
+  ev = (struct epoll_event) { EPOLLIN, { .u64 = TAG(TAG_STDIN, 0) } };
+  if (epoll_ctl(listener->epoll, EPOLL_CTL_ADD, STDIN_FILENO, &ev) != 0) {
+    return;
+  }
+
+  struct epoll_event events[EPOLL_EVENTS];
+  char buf[RECV_SIZE];
+  while (!listener->stop) {
+    listener->stats.syscalls++;
+    listener->stats.waits++;
+    int n = epoll_wait(listener->epoll, events, EPOLL_EVENTS, -1);
+    if (n < 0 && errno != EINTR) {
+      fprintf(stderr, "listener: epoll_wait: %s\n", strerror(errno));
+      break;
+    }
+    for (int e = 0; e < n && !listener->stop; e++) {
+      uint64_t data = events[e].data.u64;
+      if (TAG_KIND(data) == TAG_ACCEPT) {
+        int fd;
+        listener->stats.syscalls++;
+        while ((fd = accept4(listener->sock, NULL, NULL,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+          conn_t *conn = conn_new(listener, fd);
+          if (!epoll_watch(listener, EPOLL_CTL_ADD, conn)) {
+            conn->eof = conn->dead = true;
+            conn_list(listener, conn);
+          }
+          listener->stats.syscalls++;
+        }
+        continue;
+      }
+      if (TAG_KIND(data) == TAG_STDIN) {
+        listener->stats.syscalls++;
+        ssize_t got = read(STDIN_FILENO, buf, sizeof(buf));
+        listener->stop = (got == 0 || (got < 0 && errno != EINTR
+                                       && errno != EAGAIN));
+        continue;
+      }
+
+      conn_t *conn = listener->conns[TAG_FD(data)];
+      if ((events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+          && !conn->eof) {
+        listener->stats.syscalls++;
+        ssize_t got = recv(conn->fd, buf, sizeof(buf), 0);
+        if (got > 0) {
+          conn_feed(listener, conn, buf, got);
+        } else if (got == 0 || (errno != EAGAIN && errno != EINTR)) {
+          conn_end(listener, conn, got < 0);
+        }
+      }
+      if (events[e].events & (EPOLLOUT | EPOLLERR)) {
+        conn->sending = false;               // room again
+      }
+      conn_list(listener, conn);
+    }
+    epoll_flush(listener);
+  }
+}
+
+/* epoll_flush */
+/* For each connection on the list: send what the socket takes of its
+ * output, and watch for room if some is left; or, once it is done,
+ * close it.
+ */
+static void
+epoll_flush(listener_t *listener)
+{
+  for (int t = 0; t < listener->ntodo; t++) {
+    conn_t *conn = listener->conns[listener->todo[t]];
+    conn->listed = false;
+    if (!conn->sending && !conn->dead && conn_unsent(conn) > 0) {
+      listener->stats.syscalls++;
+      ssize_t sent = send(conn->fd, conn->send + conn->sendOff,
+                          conn_unsent(conn), MSG_NOSIGNAL);
+      if (sent > 0) {
+        listener->stats.bytesOut += sent;
+        conn->sendOff += sent;
+      } else if (sent < 0 && errno != EAGAIN && errno != EINTR) {
+        conn->dead = true;
+      }
+      /* wait for room to send the rest; or, at end of file, stop
+       * waiting to read */
+      if (conn_unsent(conn) > 0 && !conn->dead) {
+        conn->sending = true;
+        epoll_watch(listener, EPOLL_CTL_MOD, conn);
+      }
+    }
+    if (conn_done(conn)) {
+      listener->stats.syscalls++;
+      close(conn->fd);                       // which unwatches it
+      conn_free(listener, conn);
+    } else if (conn->eof && !conn->sending) {
+      epoll_watch(listener, EPOLL_CTL_MOD, conn);
+    }
+  }
+  listener->ntodo = 0;
+}
+
+/* epoll_watch */
+/* Add (op EPOLL_CTL_ADD) or change conn's registration: for input until
+ * its end of file, and for room to send while it waits for some.
+ */
+static bool
+epoll_watch(listener_t *listener, const int op, conn_t *conn)
+{
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = (conn->eof ? 0 : EPOLLIN) | (conn->sending ? EPOLLOUT : 0);
+  ev.data.u64 = TAG(TAG_RECV, conn->fd);
+  listener->stats.syscalls++;
+  return epoll_ctl(listener->epoll, op, conn->fd, &ev) == 0;
+}
+
+/* conn_new */
+/* Return a new connection for socket fd, in the table. */
+static conn_t *
+conn_new(listener_t *listener, const int fd)
+{
+  if (fd >= listener->maxConns) {
+    int room = (listener->maxConns == 0) ? 64 : listener->maxConns;
+    while (room <= fd) {
+      room *= 2;
+    }
+    conn_t **conns = mem_calloc_assert(room, sizeof(conn_t *), "conn_new");
+    for (int c = 0; c < listener->maxConns; c++) {
+      conns[c] = listener->conns[c];
+    }
+    mem_free(listener->conns);
+    listener->conns = conns;
+    listener->maxConns = room;
+  }
+  conn_t *conn = mem_calloc_assert(1, sizeof(conn_t), "conn_new");
+  conn->fd = fd;
+  listener->conns[fd] = conn;
+  listener->stats.connections++;
+  if (listener->start == 0) {
+    listener->start = timing_ms();
+  }
+  return conn;
+}
+
+/* conn_free */
+/* Take conn out of the table and free it (its socket is closed, or
+ * about to be).
+ */
+static void
+conn_free(listener_t *listener, conn_t *conn)
+{
+  listener->conns[conn->fd] = NULL;
+  mem_free(conn->out);
+  mem_free(conn->send);
+  mem_free(conn);
+}
+
+/* conn_feed */
+/* Take n bytes received on conn, answering each line they complete. */
+static void
+conn_feed(listener_t *listener, conn_t *conn, const char *data,
+          const size_t n)
+{
+  listener->stats.bytesIn += n;
+  for (size_t i = 0; i < n; i++) {
+    conn->line[conn->lineLen++] = data[i];
+    if (data[i] == '\n' || conn->lineLen == LISTEN_LINEMAX - 1) {
+      conn->line[conn->lineLen] = '\0';
+      conn_line(listener, conn);
+      conn->lineLen = 0;
+    }
+  }
+}
+
+/* conn_end */
+/* conn's client will send no more; gone if the connection failed. A
+ * last line without a newline is answered all the same (as fgets
+ * returns one at the end of stdin), unless the client is gone.
+ */
+static void
+conn_end(listener_t *listener, conn_t *conn, const bool gone)
+{
+  conn->eof = true;
+  conn->dead = gone;
+  if (!gone && conn->lineLen > 0) {
+    conn->line[conn->lineLen] = '\0';
+    conn_line(listener, conn);
+    conn->lineLen = 0;
+  }
+}
+
+/* conn_line */
+/* Answer conn->line onto the end of conn's output. */
+static void
+conn_line(listener_t *listener, conn_t *conn)
+{
+  double start = timing_ms();
+  char *answer = NULL;
+  size_t length = 0;
+  FILE *out = open_memstream(&answer, &length);
+  if (out == NULL) {
+    fprintf(stderr, "listener: out of memory\n");
+    exit(2);
+  }
+  listener->answer(listener->arg, conn->line, out);
+  fclose(out);
+
+  if (conn->outLen + length > conn->outCap) {
+    size_t cap = (conn->outCap == 0) ? BUF_SIZE : conn->outCap;
+    while (conn->outLen + length > cap) {
+      cap *= 2;
+    }
+    char *bigger = mem_malloc_assert(cap, "conn_line");
+    memcpy(bigger, conn->out, conn->outLen);
+    mem_free(conn->out);
+    conn->out = bigger;
+    conn->outCap = cap;
+  }
+  memcpy(conn->out + conn->outLen, answer, length);
+  conn->outLen += length;
+  free(answer);                              // from open_memstream
+  listener->stats.queries++;
+  listener->stats.msanswering += timing_ms() - start;
+}
+
+/* conn_list */
+/* Put conn on the list of connections to see to after this round. */
+static void
+conn_list(listener_t *listener, conn_t *conn)
+{
+  if (conn->listed) {
+    return;
+  }
+  if (listener->ntodo == listener->todoCap) {
+    listener->todoCap = (listener->todoCap == 0) ? 64 : 2 * listener->todoCap;
+    int *todo = mem_malloc_assert(listener->todoCap * sizeof(int),
+                                  "conn_list");
+    for (int t = 0; t < listener->ntodo; t++) {
+      todo[t] = listener->todo[t];
+    }
+    mem_free(listener->todo);
+    listener->todo = todo;
+  }
+  listener->todo[listener->ntodo++] = conn->fd;
+  conn->listed = true;
+}
+
+/* conn_done */
+/* Return true if conn may be closed: its client will send no more,
+ * and nothing is left to send it, or nothing can be.
+ */
+static bool
+conn_done(const conn_t *conn)
+{
+  return conn->eof && !conn->receiving && !conn->sending
+    && (conn->dead || (conn->outLen == 0 && conn->sendOff == conn->sendLen));
+}
+
+/* conn_unsent */
+/* Return how many bytes conn has to send from conn->send, first moving
+ * the answers in conn->out there if all of conn->send has gone. The
+ * buffers are swapped, not copied, and conn->send is never written
+ * while a send of it may be pending.
+ */
+static size_t
+conn_unsent(conn_t *conn)
+{
+  if (conn->sendOff == conn->sendLen && conn->outLen > 0) {
+    char *buf = conn->send;
+    size_t cap = conn->sendCap;
+    conn->send = conn->out;
+    conn->sendCap = conn->outCap;
+    conn->sendLen = conn->outLen;
+    conn->sendOff = 0;
+    conn->out = buf;
+    conn->outCap = cap;
+    conn->outLen = 0;
+  }
+  return conn->sendLen - conn->sendOff;
+}
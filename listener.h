@@ -0,0 +1,89 @@
+/*
+ * listener.h - header file for the querier's 'listener' module
+ *
+ * Serves query lines over TCP connections on the loopback interface,
+ * all on the calling thread. A client sends lines on its connection
+ * and gets the answer to each, in order; any number of clients may be
+ * connected at once.
+ *
+ * The event loop runs on io_uring when the kernel has what it needs:
+ * one multishot accept takes every connection, one multishot receive
+ * per connection draws from a ring of buffers provided to the kernel
+ * (so no buffer sits idle waiting on a quiet client), and the sends of
+ * every connection with answers ready are submitted together with the
+ * next wait for events, in one system call. Otherwise, or if asked,
+ * it runs on epoll, where every accept, receive and send is a system
+ * call of its own. Either way the loop counts its system calls.
+ *
+ * Serving stops when stdin reaches end of file.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __LISTENER_H
+#define __LISTENER_H
+
+#include <stdio.h>
+
+/* longest query line; longer ones are split, as fgets would */
+#define LISTEN_LINEMAX 1024
+
+typedef struct listener listener_t;
+
+/* listen_io_t: the event loops. */
+typedef enum listen_io {
+  LISTEN_URING, LISTEN_EPOLL
+} listen_io_t;
+
+/* answerfn_t: answer line, which the function may modify, onto out. */
+typedef void (*answerfn_t)(void *arg, char *line, FILE *out);
+
+/* listenstats_t: what the listener has done so far. */
+typedef struct listenstats {
+  long connections;    // connections accepted
+  long queries;        // lines answered
+  long syscalls;       // system calls made by the loop (not answering)
+  long waits;          // ...of which waits for events
+  long bytesIn;        // bytes received
+  long bytesOut;       // bytes sent
+  double msserving;    // ms from the first connection to stopping
+  double msanswering;  // ...of which answering
+} listenstats_t;
+
+/**************** listener_new ****************/
+/* Listen on 127.0.0.1:port (0: any free port) with the event loop io;
+ * if io_uring cannot be set up, say why on stderr and use epoll.
+ * Returns NULL, having said why, if the socket cannot be. Caller must
+ * listener_delete it.
+ */
+listener_t *listener_new(const int port, const listen_io_t io);
+
+/**************** listener_port ****************/
+/* Return the port listened on. */
+int listener_port(const listener_t *listener);
+
+/**************** listener_io ****************/
+/* Return the event loop in use. */
+listen_io_t listener_io(const listener_t *listener);
+
+/**************** listener_io_name ****************/
+/* Return the name of io: "uring" or "epoll". */
+const char *listener_io_name(const listen_io_t io);
+
+/**************** listener_run ****************/
+/* Accept connections and answer every line received with
+ * answer(arg, line, out), sending what it writes onto out back on the
+ * line's connection, until stdin reaches end of file. Connections
+ * still open are then closed.
+ */
+void listener_run(listener_t *listener, answerfn_t answer, void *arg);
+
+/**************** listener_stats ****************/
+/* Fill *stats with the counts so far. */
+void listener_stats(const listener_t *listener, listenstats_t *stats);
+
+/**************** listener_delete ****************/
+/* Close the socket and free the listener; NULL is ignored. */
+void listener_delete(listener_t *listener);
+
+#endif // __LISTENER_H
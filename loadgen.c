@@ -0,0 +1,793 @@
+/*
+ * loadgen.c - open-loop load generator for the querier
+ *
+ * Starts a pool of querier processes, each talking over a pair of
+ * pipes, and sends them queries at a target rate whether or not earlier
+ * queries have been answered (open loop), so queueing delay shows up in
+ * the latencies instead of slowing the sender down. Arrivals are a
+ * Poisson process at each rate given, or the timestamps recorded in a
+ * trace, replayed at each speed given. Each query goes to the process
+ * with the fewest unanswered queries.
+ *
+ * Latency is measured from when a query was meant to be sent, not from
+ * when it was written: a sender that falls behind would otherwise leave
+ * out exactly the delays it caused ("coordinated omission"). For
+ * comparison, the 99th percentile measured from the write is printed
+ * too. One line per rate gives the latency-vs-throughput curve; a rate
+ * whose achieved throughput falls short of the offered rate is marked
+ * saturated.
+ *
+ * With -connect, it starts no processes: it opens connections to a
+ * querier already serving with -listen, and sends the queries over
+ * those instead.
+ *
+ * Usage:
+ *   ./loadgen [options] queriesFile querier [querier arguments...]
+ *   ./loadgen [options] -connect PORT queriesFile
+ *
+ * queriesFile  - one query per line; with -trace, "seconds query" per
+ *                line, seconds since the start of the recording
+ * querier ...  - the command to run for each process, for example
+ *                ./querier -engine daat pageDirectory indexFilename
+ *
+ * Options:
+ *   -procs N     run N querier processes (default 1)
+ *   -connect P   instead, open N connections to 127.0.0.1:P
+ *   -rate R,...  offer R queries per second, for each R in turn
+ *                (default 10,20,40,80,160)
+ *   -seconds S   offer each rate for S seconds (default 5)
+ *   -trace       replay queriesFile's timestamps instead
+ *   -speed X,... ...at X times the recorded rate, for each X (default 1)
+ *   -drain S     wait at most S seconds for answers after the last
+ *                query is sent (default 30)
+ *   -seed N      seed for the Poisson arrivals (default 1)
+ *
+ * The querier must answer every query line, as the plain query loop
+ * and -workers and -serve do; not with -batch, which reads all of its
+ * input first. An answer ends with the querier's separator line, or
+ * with an error message for a query it rejected. Answers are matched
+ * to queries by their "Query:" line, so a querier that answers out of
+ * order (-lanes) is measured correctly. A querier with -listen reports
+ * rejected queries on its own stderr, not to the client, so with
+ * -connect queriesFile should hold only valid queries.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* fork, pipe, poll, kill and sockets are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "mem.h"
+#include "answers.h"
+#include "timing.h"
+
+/* most processes (or connections), and rates or speeds in one run */
+#define MAX_PROCS 1024
+#define MAX_STEPS 32
+
+/* longest line we read, of queries or of answers */
+#define LINE_MAX_LEN 4096
+
+/* how long a process may take to load its index, in ms */
+#define STARTUP_MS 120000.0
+
+/* a rate is saturated if it achieves less than this share of itself */
+#define SATURATED 0.95
+
+/* local types */
+/* request_t: one query sent, or queued to be sent, to a process. */
+typedef struct request {
+  double intended;     // ms: when it was meant to be sent
+  double sent;         // ms: when its last byte was written; 0: not yet
+  long end;            // offset just past it in the process's input
+  const char *key;     // the query as the querier echoes it
+} request_t;
+
+/* proc_t: one querier process, or connection to one, and what is in
+ * flight to and from it. */
+typedef struct proc {
+  pid_t pid;           // 0: a connection
+  int in;              // its stdin, or the socket; we write
+  int out;             // its stdout and stderr, or the socket; we read
+  char *pending;       // input queued but not yet written
+  long npending, cap;
+  long written;        // bytes of input written in all
+  long queued;         // bytes of input queued in all
+  request_t *fifo;     // requests unanswered, oldest first (a ring)
+  int head, count, fifoCap;
+  char line[LINE_MAX_LEN];  // partial line of output
+  int lineLen;
+  char query[LINE_MAX_LEN]; // the answer being read: its "Query:" line
+} proc_t;
+
+/* query_t: one line of queriesFile. */
+typedef struct query {
+  double at;           // with -trace: seconds into the recording
+  char *text;          // with its newline
+  char *key;           // lowercased, with single spaces: see normalize
+} query_t;
+
+/* step_t: what one rate or speed did. */
+typedef struct step {
+  double offered;      // queries per second sent
+  double achieved;     // queries per second answered
+  int sent, answered;
+  double *latency;     // ms from intended send to answer, per answer
+  double *service;     // ms from actual send to answer
+} step_t;
+
+/* options_t: everything chosen on the command line. */
+typedef struct options {
+  int procs;
+  double rates[MAX_STEPS];   // q/s, or speeds with -trace
+  int nrates;
+  double seconds;
+  bool trace;
+  double drain;
+  uint64_t seed;
+  int port;                  // connect to this port; -1: start processes
+  char *queriesFile;
+  char **command;            // NULL-terminated, for execvp
+} options_t;
+
+/* local functions */
+static void parse_args(const int argc, char *argv[], options_t *opts);
+static int parse_list(const char *list, double *values);
+static void usage(const char *progName);
+static query_t *read_queries(const options_t *opts, int *n_out);
+static void start_proc(proc_t *proc, char **command);
+static void start_conn(proc_t *proc, const int port);
+static void proc_init(proc_t *proc, const pid_t pid, const int in,
+                      const int out);
+static void stop_proc(proc_t *proc);
+static void send_query(proc_t *proc, const query_t *query,
+                       const double intended);
+static bool pump(proc_t *procs, const int nprocs, const double until,
+                 const bool drain, step_t *step);
+static void write_pending(proc_t *proc);
+static void read_answers(proc_t *proc, step_t *step);
+static void normalize(char *dest, const char *src);
+static int outstanding(const proc_t *procs, const int nprocs);
+static double next_exponential(uint64_t *state, const double rate);
+
+/* main */
+/* Start the processes, wait until each has answered a first query,
+ * then run every rate (or speed) in turn and print its line of the
+ * curve.
+ */
+int
+main(const int argc, char *argv[])
+{
+  options_t opts;
+  parse_args(argc, argv, &opts);
+  int nqueries = 0;
+  query_t *queries = read_queries(&opts, &nqueries);
+
+  /* a querier that exits must not kill us */
+  signal(SIGPIPE, SIG_IGN);
+
+  proc_t *procs = mem_calloc_assert(opts.procs, sizeof(proc_t), "main");
+  for (int p = 0; p < opts.procs; p++) {
+    if (opts.port >= 0) {
+      start_conn(&procs[p], opts.port);
+    } else {
+      start_proc(&procs[p], opts.command);
+    }
+  }
+
+  /* warm up: one query each, and wait for the answers */
+  step_t warmup;
+  memset(&warmup, 0, sizeof(warmup));
+  warmup.latency = mem_malloc_assert(opts.procs * sizeof(double), "main");
+  warmup.service = mem_malloc_assert(opts.procs * sizeof(double), "main");
+  double start = timing_ms();
+  for (int p = 0; p < opts.procs; p++) {
+    send_query(&procs[p], &queries[0], start);
+  }
+  if (!pump(procs, opts.procs, start + STARTUP_MS, true, &warmup)) {
+    fprintf(stderr, "loadgen: the queriers did not answer; is the "
+            "command right?\n");
+    exit(2);
+  }
+  mem_free(warmup.latency);
+  mem_free(warmup.service);
+
+  if (opts.port >= 0) {
+    printf("%d connections to port %d", opts.procs, opts.port);
+  } else {
+    printf("%d processes: %s", opts.procs, opts.command[0]);
+    for (int a = 1; opts.command[a] != NULL; a++) {
+      printf(" %s", opts.command[a]);
+    }
+  }
+  printf("\nlatency in ms from the intended send time; p99 also from "
+         "the actual write\n");
+  if (opts.trace) {
+    printf("%6s ", "speed");
+  }
+  printf("%9s %9s %9s %8s %8s %8s %8s %8s %9s\n", "offered", "achieved",
+         "answered", "p50", "p90", "p99", "p99.9", "max", "wrote p99");
+
+  uint64_t rng = opts.seed * 0x9E3779B97F4A7C15ULL + 1;
+  double saturation = 0;
+  for (int s = 0; s < opts.nrates; s++) {
+    double rate = opts.rates[s];
+    double span = opts.trace
+      ? (queries[nqueries - 1].at - queries[0].at) * 1000.0 / rate
+      : opts.seconds * 1000.0;
+    int cap = opts.trace ? nqueries : (int) (rate * opts.seconds * 2) + 16;
+    step_t step;
+    memset(&step, 0, sizeof(step));
+    step.latency = mem_malloc_assert(cap * sizeof(double), "main");
+    step.service = mem_malloc_assert(cap * sizeof(double), "main");
+
+    /* send on schedule, answering as we go */
+    double t0 = timing_ms();
+    double next = opts.trace ? t0 : t0 + next_exponential(&rng, rate);
+    int q = 0;
+    while (step.sent < cap && next <= t0 + span) {
+      pump(procs, opts.procs, next, false, &step);
+      proc_t *best = &procs[0];
+      for (int p = 1; p < opts.procs; p++) {
+        if (procs[p].count < best->count) {
+          best = &procs[p];
+        }
+      }
+      send_query(best, &queries[q], next);
+      step.sent++;
+      if (opts.trace) {
+        if (++q == nqueries) {
+          break;
+        }
+        next = t0 + (queries[q].at - queries[0].at) * 1000.0 / rate;
+      } else {
+        q = (q + 1) % nqueries;
+        next += next_exponential(&rng, rate);
+      }
+    }
+    double sendEnd = timing_ms();
+    bool drained = pump(procs, opts.procs, sendEnd + opts.drain * 1000.0,
+                        true, &step);
+    double elapsed = timing_ms() - t0;
+
+    step.offered = step.sent * 1000.0 / (span > 0 ? span : elapsed);
+    step.achieved = step.answered * 1000.0 / elapsed;
+    bool saturated = !drained || step.achieved < SATURATED * step.offered;
+    if (!saturated && step.offered > saturation) {
+      saturation = step.offered;
+    }
+    if (opts.trace) {
+      printf("%5.2fx ", rate);
+    }
+    printf("%9.1f %9.1f %9d %8.2f %8.2f %8.2f %8.2f %8.2f %9.2f%s\n",
+           step.offered, step.achieved, step.answered,
+           answers_percentile(step.latency, step.answered, 50),
+           answers_percentile(step.latency, step.answered, 90),
+           answers_percentile(step.latency, step.answered, 99),
+           answers_percentile(step.latency, step.answered, 99.9),
+           answers_percentile(step.latency, step.answered, 100),
+           answers_percentile(step.service, step.answered, 99),
+           saturated ? "  saturated" : "");
+    fflush(stdout);
+    mem_free(step.latency);
+    mem_free(step.service);
+    if (!drained) {
+      printf("stopping: %d queries still unanswered after %.0f s\n",
+             outstanding(procs, opts.procs), opts.drain);
+      break;
+    }
+  }
+  printf("highest rate sustained: %.1f queries/s\n", saturation);
+
+  for (int p = 0; p < opts.procs; p++) {
+    stop_proc(&procs[p]);
+  }
+  mem_free(procs);
+  for (int i = 0; i < nqueries; i++) {
+    mem_free(queries[i].text);
+    mem_free(queries[i].key);
+  }
+  mem_free(queries);
+  return 0;
+}
+
+/* parse_args */
+/* Parse the command line into *opts, or print usage and exit. */
+static void
+parse_args(const int argc, char *argv[], options_t *opts)
+{
+  memset(opts, 0, sizeof(*opts));
+  opts->procs = 1;
+  opts->nrates = parse_list("10,20,40,80,160", opts->rates);
+  opts->seconds = 5;
+  opts->drain = 30;
+  opts->seed = 1;
+  opts->port = -1;
+  bool speeds = false;
+
+  /* options come first, and all start with '-' */
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    char extra;
+    long long seed;
+    if (strcmp(argv[i], "-procs") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%d%c", &opts->procs, &extra) != 1
+          || opts->procs < 1 || opts->procs > MAX_PROCS) {
+        fprintf(stderr, "loadgen: -procs needs an integer from 1 to %d\n",
+                MAX_PROCS);
+        usage(argv[0]);
+      }
+    } else if ((strcmp(argv[i], "-rate") == 0
+                || strcmp(argv[i], "-speed") == 0) && i + 1 < argc) {
+      speeds = (argv[i][1] == 's');
+      opts->nrates = parse_list(argv[++i], opts->rates);
+      if (opts->nrates == 0) {
+        fprintf(stderr, "loadgen: %s needs up to %d positive numbers, "
+                "separated by commas\n", argv[i - 1], MAX_STEPS);
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-seconds") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%lf%c", &opts->seconds, &extra) != 1
+          || opts->seconds <= 0) {
+        fprintf(stderr, "loadgen: -seconds needs a positive number\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-drain") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%lf%c", &opts->drain, &extra) != 1
+          || opts->drain <= 0) {
+        fprintf(stderr, "loadgen: -drain needs a positive number\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%lld%c", &seed, &extra) != 1 || seed < 0) {
+        fprintf(stderr, "loadgen: -seed needs a non-negative integer\n");
+        usage(argv[0]);
+      }
+      opts->seed = (uint64_t) seed;
+    } else if (strcmp(argv[i], "-connect") == 0 && i + 1 < argc) {
+      if (sscanf(argv[++i], "%d%c", &opts->port, &extra) != 1
+          || opts->port < 1 || opts->port > 65535) {
+        fprintf(stderr, "loadgen: -connect needs a port from 1 to 65535\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-trace") == 0) {
+      opts->trace = true;
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  if (argc - i < ((opts->port >= 0) ? 1 : 2)
+      || (opts->port >= 0 && argc - i > 1)) {
+    usage(argv[0]);
+  }
+  if (opts->trace && !speeds) {
+    opts->nrates = parse_list("1", opts->rates);
+  } else if (!opts->trace && speeds) {
+    fprintf(stderr, "loadgen: -speed needs -trace\n");
+    usage(argv[0]);
+  }
+  opts->queriesFile = argv[i];
+  opts->command = &argv[i + 1];
+}
+
+/* parse_list */
+/* Parse a comma-separated list of positive numbers into values (room
+ * for MAX_STEPS). Returns how many, or 0 if the list is malformed.
+ */
+static int
+parse_list(const char *list, double *values)
+{
+  int n = 0;
+  const char *p = list;
+  while (n < MAX_STEPS) {
+    char *end;
+    values[n] = strtod(p, &end);
+    if (end == p || !(values[n] > 0) || (*end != ',' && *end != '\0')) {
+      return 0;
+    }
+    n++;
+    if (*end == '\0') {
+      return n;
+    }
+    p = end + 1;
+  }
+  return 0;
+}
+
+/* usage */
+/* Print the usage message and exit non-zero. */
+static void
+usage(const char *progName)
+{
+  fprintf(stderr, "usage: %s [-procs N] [-rate R,...] [-seconds S] "
+          "[-trace [-speed X,...]] [-drain S] [-seed N] queriesFile "
+          "(querier [querier arguments...] | with -connect PORT, "
+          "nothing)\n", progName);
+  exit(1);
+}
+
+/* read_queries */
+/* Read the non-blank lines of opts->queriesFile, with their timestamps
+ * under -trace; exit if there are none or the timestamps are wrong.
+ */
+static query_t *
+read_queries(const options_t *opts, int *n_out)
+{
+  FILE *fp = fopen(opts->queriesFile, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "loadgen: cannot read '%s'\n", opts->queriesFile);
+    exit(1);
+  }
+
+  int n = 0, cap = 64;
+  query_t *queries = mem_malloc_assert(cap * sizeof(query_t),
+                                       "read_queries");
+  char line[LINE_MAX_LEN];
+  int lineno = 0;
+  while (fgets(line, sizeof(line) - 1, fp) != NULL) {
+    lineno++;
+    char *text = line;
+    double at = 0;
+    if (opts->trace) {
+      char *end;
+      at = strtod(line, &end);
+      if (end == line || (n > 0 && at < queries[n - 1].at)) {
+        fprintf(stderr, "loadgen: %s:%d: expected 'seconds query', with "
+                "seconds never decreasing\n", opts->queriesFile, lineno);
+        exit(1);
+      }
+      text = end;
+    }
+    text += strspn(text, " \t");
+    if (*text == '\n' || *text == '\0') {
+      continue;
+    }
+    if (text[strlen(text) - 1] != '\n') {
+      strcat(text, "\n");         // the last line may lack one
+    }
+    if (n == cap) {
+      cap *= 2;
+      query_t *bigger = mem_malloc_assert(cap * sizeof(query_t),
+                                          "read_queries");
+      memcpy(bigger, queries, n * sizeof(query_t));
+      mem_free(queries);
+      queries = bigger;
+    }
+    queries[n].at = at;
+    queries[n].text = mem_malloc_assert(strlen(text) + 1, "read_queries");
+    strcpy(queries[n].text, text);
+    queries[n].key = mem_malloc_assert(strlen(text) + 1, "read_queries");
+    normalize(queries[n].key, text);
+    n++;
+  }
+  fclose(fp);
+
+  if (n == 0) {
+    fprintf(stderr, "loadgen: no queries in '%s'\n", opts->queriesFile);
+    exit(1);
+  }
+  *n_out = n;
+  return queries;
+}
+
+/* start_proc */
+/* Run command as a new process, its stdin fed by proc->in and its
+ * stdout and stderr (where rejected queries are reported) read from
+ * proc->out, both non-blocking on our side. Exits on failure.
+ */
+static void
+start_proc(proc_t *proc, char **command)
+{
+  int in, out;
+  pid_t pid = answers_start(command, "loadgen", &in, &out);
+  proc_init(proc, pid, in, out);
+}
+
+/* start_conn */
+/* Connect to a querier serving on 127.0.0.1:port; the socket is both
+ * proc->in and proc->out. Exits on failure.
+ */
+static void
+start_conn(proc_t *proc, const int port)
+{
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (sock < 0
+      || connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "loadgen: cannot connect to port %d: %s\n", port,
+            strerror(errno));
+    exit(2);
+  }
+  proc_init(proc, 0, sock, sock);
+}
+
+/* proc_init */
+/* Set up proc to write to in and read from out, both made non-blocking
+ * on our side.
+ */
+static void
+proc_init(proc_t *proc, const pid_t pid, const int in, const int out)
+{
+  memset(proc, 0, sizeof(*proc));
+  proc->pid = pid;
+  proc->in = in;
+  proc->out = out;
+  fcntl(proc->in, F_SETFL, fcntl(proc->in, F_GETFL) | O_NONBLOCK);
+  fcntl(proc->out, F_SETFL, fcntl(proc->out, F_GETFL) | O_NONBLOCK);
+  proc->cap = LINE_MAX_LEN;
+  proc->pending = mem_malloc_assert(proc->cap, "start_proc");
+  proc->fifoCap = 64;
+  proc->fifo = mem_malloc_assert(proc->fifoCap * sizeof(request_t),
+                                 "start_proc");
+}
+
+/* stop_proc */
+/* Close the process's input, so it exits, and wait for it; or close
+ * the connection.
+ */
+static void
+stop_proc(proc_t *proc)
+{
+  close(proc->in);
+  if (proc->pid != 0) {
+    close(proc->out);
+    if (proc->count > 0) {
+      kill(proc->pid, SIGTERM);   // it would finish the unanswered first
+    }
+    waitpid(proc->pid, NULL, 0);
+  }
+  mem_free(proc->pending);
+  mem_free(proc->fifo);
+}
+
+/* send_query */
+/* Queue query for the process, as meant to be sent at intended, and
+ * write what the pipe will take now.
+ */
+static void
+send_query(proc_t *proc, const query_t *query, const double intended)
+{
+  const char *text = query->text;
+  long len = strlen(text);
+  if (proc->npending + len > proc->cap) {
+    while (proc->npending + len > proc->cap) {
+      proc->cap *= 2;
+    }
+    char *bigger = mem_malloc_assert(proc->cap, "send_query");
+    memcpy(bigger, proc->pending, proc->npending);
+    mem_free(proc->pending);
+    proc->pending = bigger;
+  }
+  memcpy(proc->pending + proc->npending, text, len);
+  proc->npending += len;
+  proc->queued += len;
+
+  if (proc->count == proc->fifoCap) {
+    /* unroll the ring into a bigger array */
+    request_t *fifo = mem_malloc_assert(2 * proc->fifoCap
+                                        * sizeof(request_t), "send_query");
+    for (int i = 0; i < proc->count; i++) {
+      fifo[i] = proc->fifo[(proc->head + i) % proc->fifoCap];
+    }
+    mem_free(proc->fifo);
+    proc->fifo = fifo;
+    proc->head = 0;
+    proc->fifoCap *= 2;
+  }
+  request_t *req = &proc->fifo[(proc->head + proc->count++) % proc->fifoCap];
+  req->intended = intended;
+  req->sent = 0;
+  req->end = proc->queued;
+  req->key = query->key;
+  write_pending(proc);
+}
+
+/* pump */
+/* Write queued queries and read answers, recording them in step, until
+ * the clock reaches until (in ms) or, if drain and sooner, every query
+ * has been answered. Returns true if every query has been answered.
+ */
+static bool
+pump(proc_t *procs, const int nprocs, const double until, const bool drain,
+     step_t *step)
+{
+  struct pollfd fds[2 * MAX_PROCS];
+  for (;;) {
+    bool done = (outstanding(procs, nprocs) == 0);
+    double now = timing_ms();
+    if ((done && drain) || now >= until) {
+      return done;
+    }
+
+    int nfds = 0;
+    for (int p = 0; p < nprocs; p++) {
+      fds[nfds++] = (struct pollfd) { procs[p].out, POLLIN, 0 };
+      fds[nfds++] = (struct pollfd) { procs[p].npending > 0
+                                      ? procs[p].in : -1, POLLOUT, 0 };
+    }
+    /* poll counts in whole ms; closer than that, we spin */
+    int timeout = (int) (until - now);
+    if (poll(fds, nfds, timeout) < 0 && errno != EINTR) {
+      fprintf(stderr, "loadgen: poll failed\n");
+      exit(2);
+    }
+    for (int p = 0; p < nprocs; p++) {
+      if (fds[2 * p + 1].revents & (POLLOUT | POLLERR)) {
+        write_pending(&procs[p]);
+      }
+      if (fds[2 * p].revents & (POLLIN | POLLHUP)) {
+        read_answers(&procs[p], step);
+      }
+      if (fds[2 * p].revents & POLLHUP && procs[p].count > 0) {
+        fprintf(stderr, "loadgen: a querier exited (or hung up) with "
+                "queries unanswered\n");
+        exit(2);
+      }
+    }
+  }
+}
+
+/* write_pending */
+/* Write as much of the process's queued input as its pipe takes now,
+ * noting when each query has been written in full.
+ */
+static void
+write_pending(proc_t *proc)
+{
+  if (proc->npending == 0) {
+    return;
+  }
+  ssize_t n = write(proc->in, proc->pending, proc->npending);
+  if (n <= 0) {
+    return;                       // full (EAGAIN) or gone (EPIPE)
+  }
+  memmove(proc->pending, proc->pending + n, proc->npending - n);
+  proc->npending -= n;
+  proc->written += n;
+
+  double now = timing_ms();
+  for (int i = 0; i < proc->count; i++) {
+    request_t *req = &proc->fifo[(proc->head + i) % proc->fifoCap];
+    if (req->end > proc->written) {
+      break;
+    }
+    if (req->sent == 0) {
+      req->sent = now;
+    }
+  }
+}
+
+/* read_answers */
+/* Read what the process has written; each separator or error line
+ * completes an unanswered query, whose latencies go in step. That is
+ * the oldest whose text matches the answer's "Query:" line (a querier
+ * with -lanes answers out of order), or failing that, the oldest.
+ */
+static void
+read_answers(proc_t *proc, step_t *step)
+{
+  char buf[65536];
+  ssize_t n;
+  while ((n = read(proc->out, buf, sizeof(buf))) > 0) {
+    double now = timing_ms();
+    for (ssize_t i = 0; i < n; i++) {
+      if (buf[i] != '\n') {
+        if (proc->lineLen < LINE_MAX_LEN - 1) {
+          proc->line[proc->lineLen++] = buf[i];
+        }
+        continue;
+      }
+      int len = proc->lineLen;
+      proc->line[len] = '\0';
+      proc->lineLen = 0;
+      if (strncmp(proc->line, "Query:", 6) == 0) {
+        normalize(proc->query, proc->line + 6);
+        continue;
+      }
+      bool error;
+      if (!answers_end(proc->line, len, &error) || proc->count == 0) {
+        continue;
+      }
+
+      int match = 0;
+      for (int r = 0; r < proc->count; r++) {
+        if (strcmp(proc->fifo[(proc->head + r) % proc->fifoCap].key,
+                   proc->query) == 0) {
+          match = r;
+          break;
+        }
+      }
+      request_t req = proc->fifo[(proc->head + match) % proc->fifoCap];
+      for (int r = match; r > 0; r--) {       // close the gap
+        proc->fifo[(proc->head + r) % proc->fifoCap]
+          = proc->fifo[(proc->head + r - 1) % proc->fifoCap];
+      }
+      proc->head = (proc->head + 1) % proc->fifoCap;
+      proc->count--;
+      proc->query[0] = '\0';
+      step->latency[step->answered] = now - req.intended;
+      step->service[step->answered] = now - (req.sent == 0
+                                             ? req.intended : req.sent);
+      step->answered++;
+    }
+  }
+  if (n == 0 && proc->count > 0) {
+    /* a socket's end of file need not come with POLLHUP */
+    fprintf(stderr, "loadgen: a querier exited (or hung up) with "
+            "queries unanswered\n");
+    exit(2);
+  }
+}
+
+/* normalize */
+/* Copy src into dest (room for as many chars) lowercased, with every
+ * run of whitespace one space, and none at either end.
+ */
+static void
+normalize(char *dest, const char *src)
+{
+  char *d = dest;
+  for (const char *c = src; *c != '\0'; c++) {
+    if (isspace((unsigned char) *c)) {
+      if (d > dest && d[-1] != ' ') {
+        *d++ = ' ';
+      }
+    } else {
+      *d++ = tolower((unsigned char) *c);
+    }
+  }
+  if (d > dest && d[-1] == ' ') {
+    d--;
+  }
+  *d = '\0';
+}
+
+/* outstanding */
+/* Return the number of queries sent and not yet answered. */
+static int
+outstanding(const proc_t *procs, const int nprocs)
+{
+  int n = 0;
+  for (int p = 0; p < nprocs; p++) {
+    n += procs[p].count;
+  }
+  return n;
+}
+
+/* next_exponential */
+/* Return the ms until the next arrival of a Poisson process of rate
+ * arrivals per second, using the xorshift64* generator in *state.
+ */
+static double
+next_exponential(uint64_t *state, const double rate)
+{
+  uint64_t x = *state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  *state = x;
+  double u = ((x * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+  return -log(1.0 - u) * 1000.0 / rate;     // 1 - u is in (0, 1]
+}
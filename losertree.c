@@ -0,0 +1,138 @@
+/*
+ * losertree.c - 'losertree' module for the CS50 TSE querier
+ *
+ * see losertree.h for more information.
+ *
+ * The runs are the leaves of a complete binary tree of m leaves, m the
+ * smallest power of 2 at least k; leaves past k are exhausted runs.
+ * Node n (1 <= n < m) has children 2n and 2n+1, and leaf r is node
+ * m + r. node[n] holds the loser of the match at n, node[0] the winner.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "losertree.h"
+#include "mem.h"
+
+/**************** global types ****************/
+struct losertree {
+  int k;
+  int m;               // leaves: k rounded up to a power of 2
+  int *node;           // m entries; see above
+  bool *done;          // m entries: run exhausted
+  beforefn_t before;
+  void *arg;
+};
+
+/**************** local functions ****************/
+static bool beats(const losertree_t *tree, const int a, const int b);
+
+/**************** losertree_new ****************/
+/* see losertree.h for description */
+losertree_t *
+losertree_new(const int k, const bool empty[], beforefn_t before, void *arg)
+{
+  if (k < 1 || before == NULL) {
+    return NULL;
+  }
+  losertree_t *tree = mem_calloc_assert(1, sizeof(losertree_t),
+                                        "losertree_new");
+  tree->k = k;
+  tree->before = before;
+  tree->arg = arg;
+  tree->m = 1;
+  while (tree->m < k) {
+    tree->m *= 2;
+  }
+  int m = tree->m;
+  tree->node = mem_calloc_assert(m, sizeof(int), "losertree_new");
+  tree->done = mem_calloc_assert(m, sizeof(bool), "losertree_new");
+  for (int r = 0; r < m; r++) {
+    tree->done[r] = (r >= k) || (empty != NULL && empty[r]);
+  }
+
+  /* play every match bottom-up, keeping the winners in a scratch
+   * array laid out like the tree */
+  int *winner = mem_malloc_assert(2 * m * sizeof(int), "losertree_new");
+  for (int r = 0; r < m; r++) {
+    winner[m + r] = r;
+  }
+  for (int n = m - 1; n >= 1; n--) {
+    int a = winner[2 * n], b = winner[2 * n + 1];
+    if (beats(tree, a, b)) {
+      winner[n] = a;
+      tree->node[n] = b;
+    } else {
+      winner[n] = b;
+      tree->node[n] = a;
+    }
+  }
+  tree->node[0] = winner[1];    // with m == 1, the only run
+  mem_free(winner);
+  return tree;
+}
+
+/**************** losertree_top ****************/
+/* see losertree.h for description */
+int
+losertree_top(const losertree_t *tree)
+{
+  if (tree == NULL || tree->done[tree->node[0]]) {
+    return -1;
+  }
+  return tree->node[0];
+}
+
+/**************** losertree_next ****************/
+/* see losertree.h for description */
+void
+losertree_next(losertree_t *tree, const bool exhausted)
+{
+  if (tree == NULL) {
+    return;
+  }
+  int w = tree->node[0];
+  if (exhausted) {
+    tree->done[w] = true;
+  }
+  for (int n = (tree->m + w) / 2; n >= 1; n /= 2) {
+    if (beats(tree, tree->node[n], w)) {
+      int loser = w;
+      w = tree->node[n];
+      tree->node[n] = loser;
+    }
+  }
+  tree->node[0] = w;
+}
+
+/**************** losertree_delete ****************/
+/* see losertree.h for description */
+void
+losertree_delete(losertree_t *tree)
+{
+  if (tree == NULL) {
+    return;
+  }
+  mem_free(tree->node);
+  mem_free(tree->done);
+  mem_free(tree);
+}
+
+/* beats */
+/* Return true if run a wins a match against run b: a is not exhausted,
+ * and b is, or a's item comes first.
+ */
+static bool
+beats(const losertree_t *tree, const int a, const int b)
+{
+  if (tree->done[a]) {
+    return false;
+  }
+  if (tree->done[b]) {
+    return true;
+  }
+  return tree->before(tree->arg, a, b);
+}
@@ -0,0 +1,54 @@
+/*
+ * losertree.h - header file for the querier's 'losertree' module
+ *
+ * A tournament tree of losers, for merging k sorted runs: each internal
+ * node remembers the run that lost the match played there, and the
+ * root the overall winner, so after the winner's run advances only the
+ * matches on its path to the root are replayed: log2(k) comparisons
+ * per item merged, against about 2 log2(k) for a binary heap.
+ *
+ * The tree never sees the items. The caller keeps the runs and a
+ * cursor into each, and supplies a function that compares the items
+ * at two runs' cursors.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __LOSERTREE_H
+#define __LOSERTREE_H
+
+#include <stdbool.h>
+
+typedef struct losertree losertree_t;
+
+/* beforefn_t: true if run a's current item comes out before run b's.
+ * It must be a strict total order (break ties by run number); it is
+ * only asked about runs that are not exhausted.
+ */
+typedef bool (*beforefn_t)(void *arg, const int a, const int b);
+
+/**************** losertree_new ****************/
+/* Return a tree merging k runs (k >= 1), of which those with empty[r]
+ * true have no items (empty may be NULL: none). Caller must
+ * losertree_delete it.
+ */
+losertree_t *losertree_new(const int k, const bool empty[],
+                           beforefn_t before, void *arg);
+
+/**************** losertree_top ****************/
+/* Return the run whose current item comes out next, or -1 once every
+ * run is exhausted.
+ */
+int losertree_top(const losertree_t *tree);
+
+/**************** losertree_next ****************/
+/* The caller has moved the top run's cursor on to its next item, or,
+ * if exhausted is true, past its last: find the new top.
+ */
+void losertree_next(losertree_t *tree, const bool exhausted);
+
+/**************** losertree_delete ****************/
+/* Free the tree; NULL is ignored. */
+void losertree_delete(losertree_t *tree);
+
+#endif // __LOSERTREE_H
@@ -0,0 +1,281 @@
+/*
+ * mux.c - 'mux' module for the CS50 TSE querier
+ *
+ * see mux.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* fileno and poll are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include "daat.h"
+#include "querier.h"
+#include "mux.h"
+#include "timing.h"
+#include "mem.h"
+
+/* each stream is read through a buffer of this many bytes */
+#define INPUT_BUFSIZE  4096
+
+/**************** local types ****************/
+/* input_t: one of -inputs' query streams, and the query it has under
+ * way; a stream has one at a time, so its answers stay in order. */
+typedef struct input {
+  char name[PATH_MAX];
+  int fd;                 // -1 at end of file
+  FILE *out;              // where its answers go
+  char buf[INPUT_BUFSIZE];  // read, not yet taken as a line
+  int nbuf;
+  char line[1024];        // the query under way, which words point into
+  char **words;
+  int nwords;
+  filter_t filter;
+  query_t *query;
+  bitmap_t *allowed;
+  daat_t *daat;           // its evaluation; NULL: no query under way
+  double start;           // when it reached the head of the stream
+  double msown;           // ms spent on it, rather than on other queries
+  int nqueries;           // queries answered
+  long slices;            // ...slices they were evaluated in
+  double mslatency;       // ...ms from the head of the stream to answer
+  double msmaxlatency;
+  double mswait;          // ...of that, ms spent on other streams' queries
+  double msmaxwait;
+} input_t;
+
+/**************** local functions ****************/
+static bool take_line(input_t *in);
+static void mux_begin(const options_t *opts, querier_t *qr, input_t *in,
+                      stats_t *stats);
+static void mux_finish(const options_t *opts, querier_t *qr, input_t *in,
+                       stats_t *stats);
+
+/**************** mux_loop ****************/
+/* see mux.h for description */
+void
+mux_loop(const options_t *opts, querier_t *qr)
+{
+  input_t *inputs = mem_calloc_assert(INPUTS_MAX, sizeof(input_t),
+                                      "mux_loop");
+  int ninputs = 0;
+  for (const char *p = opts->inputs; *p != '\0'; ninputs++) {
+    input_t *in = &inputs[ninputs];
+    size_t len = strcspn(p, ",");
+    snprintf(in->name, sizeof(in->name), "%.*s", (int) len, p);
+    p += len + (p[len] == ',');
+
+    if (strcmp(in->name, "-") == 0) {
+      in->fd = fileno(stdin);
+      in->out = stdout;
+      continue;
+    }
+    /* a FIFO is opened without waiting for a writer */
+    char outName[PATH_MAX + 8];
+    snprintf(outName, sizeof(outName), "%s.out", in->name);
+    in->fd = open(in->name, O_RDONLY | O_NONBLOCK);
+    in->out = (in->fd < 0) ? NULL : fopen(outName, "w");
+    if (in->out == NULL) {
+      fprintf(stderr, "querier: cannot read '%s' or write '%s'\n",
+              in->name, outName);
+      exit(1);
+    }
+  }
+
+  stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+  long slices = 0;
+  for (;;) {
+    /* each stream with nothing under way starts its next line */
+    bool busy = false;
+    for (int i = 0; i < ninputs; i++) {
+      input_t *in = &inputs[i];
+      while (in->daat == NULL && take_line(in)) {
+        mux_begin(opts, qr, in, &stats);
+      }
+      busy = busy || (in->daat != NULL);
+    }
+
+    /* read what has come in, waiting for it only if there is no work */
+    struct pollfd fds[INPUTS_MAX];
+    input_t *polled[INPUTS_MAX];
+    int nfds = 0;
+    for (int i = 0; i < ninputs; i++) {
+      if (inputs[i].fd >= 0 && inputs[i].nbuf < INPUT_BUFSIZE) {
+        fds[nfds] = (struct pollfd) { inputs[i].fd, POLLIN, 0 };
+        polled[nfds++] = &inputs[i];
+      }
+    }
+    if (nfds == 0 && !busy) {
+      break;                      // every stream is at its end
+    }
+    if (nfds > 0 && poll(fds, nfds, busy ? 0 : -1) > 0) {
+      for (int f = 0; f < nfds; f++) {
+        input_t *in = polled[f];
+        if (fds[f].revents == 0) {
+          continue;
+        }
+        ssize_t n = read(in->fd, in->buf + in->nbuf,
+                         INPUT_BUFSIZE - in->nbuf);
+        if (n > 0) {
+          in->nbuf += n;
+        } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+          if (in->fd != fileno(stdin)) {
+            close(in->fd);
+          }
+          in->fd = -1;
+        }
+      }
+    }
+
+    /* one slice of every query under way, in turn */
+    for (int i = 0; i < ninputs; i++) {
+      input_t *in = &inputs[i];
+      if (in->daat == NULL) {
+        continue;
+      }
+      double start = timing_ms();
+      bool done = daat_step(in->daat, opts->slice);
+      double ms = timing_ms() - start;
+      in->msown += ms;
+      stats.msengine[ENGINE_DAAT] += ms;
+      in->slices++;
+      slices++;
+      if (done) {
+        mux_finish(opts, qr, in, &stats);
+      }
+    }
+  }
+
+  for (int i = 0; i < ninputs; i++) {
+    fprintf(inputs[i].out, "\n");
+    if (inputs[i].out != stdout) {
+      fclose(inputs[i].out);
+    }
+  }
+  fflush(stdout);
+  qr->out = stdout;
+  print_stats(opts, qr, &stats);
+  if (opts->slice > 0) {
+    fprintf(stderr, "querier: inputs: %ld slices of about %d postings\n",
+            slices, opts->slice);
+  } else {
+    fprintf(stderr, "querier: inputs: %ld queries, each evaluated to its "
+            "end\n", slices);
+  }
+  for (int i = 0; i < ninputs; i++) {
+    const input_t *in = &inputs[i];
+    int n = in->nqueries;
+    fprintf(stderr, "querier: input %s: %d queries in %ld slices; %.3f ms "
+            "mean latency, %.3f ms max; %.3f ms mean (%.1f%%), %.3f ms max "
+            "waiting on other queries\n", in->name, n, in->slices,
+            n == 0 ? 0.0 : in->mslatency / n, in->msmaxlatency,
+            n == 0 ? 0.0 : in->mswait / n,
+            in->mslatency == 0 ? 0.0 : 100.0 * in->mswait / in->mslatency,
+            in->msmaxwait);
+  }
+  mem_free(inputs);
+}
+
+/* take_line */
+/* Move the next line of in's buffer into in->line, if it has a whole
+ * one: up to a newline, or as much as fits in the line (as fgets
+ * would split it), or whatever is left at the end of the stream.
+ * Returns false if there is none yet.
+ */
+static bool
+take_line(input_t *in)
+{
+  char *newline = memchr(in->buf, '\n', in->nbuf);
+  int len;
+  if (newline != NULL) {
+    len = newline - in->buf + 1;
+  } else if (in->nbuf >= (int) sizeof(in->line) - 1
+             || (in->fd < 0 && in->nbuf > 0)) {
+    len = in->nbuf;
+  } else {
+    return false;
+  }
+  if (len > (int) sizeof(in->line) - 1) {
+    len = sizeof(in->line) - 1;
+  }
+  memcpy(in->line, in->buf, len);
+  in->line[len] = '\0';
+  memmove(in->buf, in->buf + len, in->nbuf - len);
+  in->nbuf -= len;
+  return true;
+}
+
+/* mux_begin */
+/* Read the query in in->line and set up its evaluation, without
+ * visiting any postings yet; or print its error and leave the stream
+ * with nothing under way.
+ */
+static void
+mux_begin(const options_t *opts, querier_t *qr, input_t *in,
+          stats_t *stats)
+{
+  double start = timing_ms();
+  if (!read_query(in->line, &in->words, &in->nwords, &in->filter)) {
+    return;
+  }
+  print_query(in->words, in->nwords, &in->filter, in->out);
+  in->allowed = filter_bitmap(&in->filter, qr->hosts);
+  in->query = query_new(in->words, in->nwords);
+  stats->nqueries++;
+
+  /* as in evaluate_and_print, only a plain top K keeps just K */
+  bool plainRanking = (in->filter.npreds == 0 && !in->filter.sorted
+                       && qr->simhashes == NULL);
+  in->daat = daat_start(qr->postings, in->query, in->allowed,
+                        plainRanking ? opts->topK : 0);
+  in->start = start;
+  in->msown = timing_ms() - start;
+}
+
+/* mux_finish */
+/* Print the answer to in's evaluated query on its output, free the
+ * query, and count its latency: from reaching the head of the stream
+ * to being answered, of which any time not spent on this query itself
+ * was spent waiting on other streams' queries.
+ */
+static void
+mux_finish(const options_t *opts, querier_t *qr, input_t *in,
+           stats_t *stats)
+{
+  double start = timing_ms();
+  docscore_t *docs = NULL;
+  int ndocs = daat_finish(in->daat, &docs);
+  in->daat = NULL;
+  stats->nengine[ENGINE_DAAT]++;
+
+  qr->out = in->out;
+  snippet_query(qr->snipper, in->words, in->nwords);
+  rank_docs(docs, ndocs, opts, qr, &in->filter);
+  fflush(in->out);
+  mem_free(docs);
+  query_delete(in->query);
+  bitmap_delete(in->allowed);
+  mem_free(in->words);
+
+  double end = timing_ms();
+  double latency = end - in->start;
+  double wait = latency - (in->msown + end - start);
+  in->nqueries++;
+  in->mslatency += latency;
+  in->mswait += wait;
+  if (latency > in->msmaxlatency) {
+    in->msmaxlatency = latency;
+  }
+  if (wait > in->msmaxwait) {
+    in->msmaxwait = wait;
+  }
+}
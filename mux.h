@@ -0,0 +1,36 @@
+/*
+ * mux.h - header file for the querier's 'mux' module
+ *
+ * With -inputs, one thread answers the queries of several streams
+ * (files, FIFOs, or stdin) at once, each answered on its own output.
+ * Each stream takes its lines one at a time: a line is read, its query
+ * set up, evaluated by DAAT a slice of postings at a time in turn with
+ * every other stream's query under way, and answered before the
+ * stream's next line is taken. So a cheap query on one stream waits for
+ * at most a slice of each expensive one on the others, rather than for
+ * all of it.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __MUX_H
+#define __MUX_H
+
+#include "querier.h"
+
+/* most query streams */
+#define INPUTS_MAX 16
+
+/**************** mux_loop ****************/
+/* Answer the queries of every stream named in opts->inputs (comma-
+ * separated; "-" is stdin, answered on stdout, and any other F is
+ * answered on F.out), slicing every opts->slice postings (0: each
+ * query to its end), until every stream is at its end. The streams are
+ * polled for input between rounds of slices, and waited for only when
+ * no query is under way. Reports each stream's latency, and its time
+ * spent waiting on the others, on stderr. Exits if a stream cannot be
+ * opened.
+ */
+void mux_loop(const options_t *opts, querier_t *qr);
+
+#endif // __MUX_H
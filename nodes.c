@@ -0,0 +1,272 @@
+/*
+ * nodes.c - 'nodes' module for the CS50 TSE querier
+ *
+ * see nodes.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* cpu_set_t, sched_setaffinity and syscall are Linux extensions */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include "nodes.h"
+#include "mem.h"
+
+/* where the kernel describes the nodes */
+#define NODES_SYSFS "/sys/devices/system/node"
+
+/* kernel node numbers we can name in a memory policy */
+#define NODES_MAXID 1024
+#define MASK_BITS   (8 * sizeof(unsigned long))
+#define MASK_WORDS  (NODES_MAXID / MASK_BITS)
+
+/* longest CPU list we keep */
+#define CPULIST_MAX 256
+
+/**************** local types ****************/
+/* node_t: one node with CPUs. */
+typedef struct node {
+  int id;                      // the kernel's number for it
+  char cpulist[CPULIST_MAX];   // as in sysfs
+  cpu_set_t cpus;
+} node_t;
+
+/* nodes_t: all of them. */
+struct nodes {
+  int n;
+  node_t nodes[NODES_MAX];
+};
+
+/**************** local functions ****************/
+static bool read_line(const char *path, char *buf, const int size);
+static bool parse_list(const char *list, bool (*add)(void *arg, int i),
+                       void *arg);
+static bool add_cpu(void *arg, int cpu);
+static bool add_node(void *arg, int id);
+static bool set_policy(const int mode, const unsigned long *mask);
+
+/**************** nodes_discover ****************/
+/* see nodes.h for description */
+nodes_t *
+nodes_discover(void)
+{
+  nodes_t *nodes = mem_calloc_assert(1, sizeof(nodes_t), "nodes_discover");
+
+  char online[CPULIST_MAX];
+  if (read_line(NODES_SYSFS "/online", online, sizeof(online))) {
+    parse_list(online, add_node, nodes);
+  }
+
+  if (nodes->n == 0) {
+    /* no topology: one node of every online CPU */
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    node_t *node = &nodes->nodes[0];
+    node->id = 0;
+    snprintf(node->cpulist, sizeof(node->cpulist), "0-%ld",
+             (ncpus < 1) ? 0 : ncpus - 1);
+    CPU_ZERO(&node->cpus);
+    for (long c = 0; c < ncpus && c < CPU_SETSIZE; c++) {
+      CPU_SET(c, &node->cpus);
+    }
+    nodes->n = 1;
+  }
+  return nodes;
+}
+
+/**************** nodes_count ****************/
+/* see nodes.h for description */
+int
+nodes_count(const nodes_t *nodes)
+{
+  return (nodes == NULL) ? 1 : nodes->n;
+}
+
+/**************** nodes_id ****************/
+/* see nodes.h for description */
+int
+nodes_id(const nodes_t *nodes, const int node)
+{
+  if (nodes == NULL || node < 0 || node >= nodes->n) {
+    return 0;
+  }
+  return nodes->nodes[node].id;
+}
+
+/**************** nodes_cpus ****************/
+/* see nodes.h for description */
+const char *
+nodes_cpus(const nodes_t *nodes, const int node)
+{
+  if (nodes == NULL || node < 0 || node >= nodes->n) {
+    return "";
+  }
+  return nodes->nodes[node].cpulist;
+}
+
+/**************** nodes_bind ****************/
+/* see nodes.h for description */
+bool
+nodes_bind(const nodes_t *nodes, const int node)
+{
+  if (nodes == NULL || node < 0 || node >= nodes->n) {
+    return false;
+  }
+  const node_t *nd = &nodes->nodes[node];
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &nd->cpus) != 0) {
+    return false;
+  }
+
+  unsigned long mask[MASK_WORDS];
+  memset(mask, 0, sizeof(mask));
+  mask[nd->id / MASK_BITS] |= 1UL << (nd->id % MASK_BITS);
+  set_policy(MPOL_PREFERRED, mask);
+  return true;
+}
+
+/**************** nodes_interleave ****************/
+/* see nodes.h for description */
+bool
+nodes_interleave(const nodes_t *nodes, const bool on)
+{
+  if (nodes == NULL) {
+    return false;
+  }
+  if (!on) {
+    return set_policy(MPOL_DEFAULT, NULL);
+  }
+
+  unsigned long mask[MASK_WORDS];
+  memset(mask, 0, sizeof(mask));
+  for (int i = 0; i < nodes->n; i++) {
+    int id = nodes->nodes[i].id;
+    mask[id / MASK_BITS] |= 1UL << (id % MASK_BITS);
+  }
+  return set_policy(MPOL_INTERLEAVE, mask);
+}
+
+/**************** nodes_delete ****************/
+/* see nodes.h for description */
+void
+nodes_delete(nodes_t *nodes)
+{
+  mem_free(nodes);
+}
+
+/* read_line */
+/* Read the first line of the file at path into buf, without its
+ * newline. Returns false if the file cannot be read.
+ */
+static bool
+read_line(const char *path, char *buf, const int size)
+{
+  FILE *fp = fopen(path, "r");
+  if (fp == NULL) {
+    return false;
+  }
+  bool ok = (fgets(buf, size, fp) != NULL);
+  fclose(fp);
+  if (ok) {
+    buf[strcspn(buf, "\n")] = '\0';
+  }
+  return ok;
+}
+
+/* parse_list */
+/* Call add(arg, i) for every number in a kernel list such as
+ * "0-3,8,10-11", stopping early if add returns false. Returns false if
+ * the list is malformed.
+ */
+static bool
+parse_list(const char *list, bool (*add)(void *arg, int i), void *arg)
+{
+  const char *p = list;
+  while (*p != '\0') {
+    char *end;
+    long lo = strtol(p, &end, 10);
+    if (end == p || lo < 0) {
+      return false;
+    }
+    long hi = lo;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      if (end == p + 1 || hi < lo) {
+        return false;
+      }
+      p = end;
+    }
+    for (long i = lo; i <= hi; i++) {
+      if (!add(arg, (int) i)) {
+        return true;
+      }
+    }
+    if (*p == ',') {
+      p++;
+    } else if (*p != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* add_cpu */
+/* parse_list helper: add cpu to the cpu_set_t arg. */
+static bool
+add_cpu(void *arg, int cpu)
+{
+  if (cpu < CPU_SETSIZE) {
+    CPU_SET(cpu, (cpu_set_t *) arg);
+  }
+  return true;
+}
+
+/* add_node */
+/* parse_list helper: add node id to the nodes_t arg, if it has CPUs.
+ * Returns false once there is no room for more.
+ */
+static bool
+add_node(void *arg, int id)
+{
+  nodes_t *nodes = arg;
+  if (nodes->n == NODES_MAX) {
+    return false;
+  }
+  if (id >= NODES_MAXID) {
+    return true;
+  }
+
+  node_t *node = &nodes->nodes[nodes->n];
+  char path[128];
+  snprintf(path, sizeof(path), NODES_SYSFS "/node%d/cpulist", id);
+  if (!read_line(path, node->cpulist, sizeof(node->cpulist))
+      || node->cpulist[0] == '\0') {
+    return true;                // memory-only node; no workers there
+  }
+  CPU_ZERO(&node->cpus);
+  if (!parse_list(node->cpulist, add_cpu, &node->cpus)
+      || CPU_COUNT(&node->cpus) == 0) {
+    return true;
+  }
+  node->id = id;
+  nodes->n++;
+  return true;
+}
+
+/* set_policy */
+/* Set the calling thread's memory policy to mode over the nodes in mask
+ * (NULL for none). Returns false if the kernel refused.
+ */
+static bool
+set_policy(const int mode, const unsigned long *mask)
+{
+  unsigned long maxnode = (mask == NULL) ? 0 : NODES_MAXID + 1;
+  return syscall(SYS_set_mempolicy, mode, mask, maxnode) == 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * nodes.h - header file for the querier's 'nodes' module
+ *
+ * The machine's NUMA nodes: which CPUs each one has, and how to keep a
+ * thread, and the memory it allocates, on one of them. The topology is
+ * read from /sys/devices/system/node; a machine without it is treated
+ * as one node holding every online CPU.
+ *
+ * Memory placement uses the kernel's memory policy directly (the
+ * set_mempolicy system call), so no NUMA library is needed. Where the
+ * policy cannot be set (a kernel without NUMA support, or a sandbox
+ * that forbids it), threads are still pinned and the kernel's default
+ * first-touch placement applies.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __NODES_H
+#define __NODES_H
+
+#include <stdbool.h>
+
+/* most nodes we handle */
+#define NODES_MAX 64
+
+typedef struct nodes nodes_t;
+
+/**************** nodes_discover ****************/
+/* Return the machine's nodes that have CPUs; caller must nodes_delete
+ * them. Never NULL: without /sys, one node holds every online CPU.
+ */
+nodes_t *nodes_discover(void);
+
+/**************** nodes_count ****************/
+/* Return the number of nodes (at least 1). */
+int nodes_count(const nodes_t *nodes);
+
+/**************** nodes_id ****************/
+/* Return the kernel's number for node (0 <= node < nodes_count). */
+int nodes_id(const nodes_t *nodes, const int node);
+
+/**************** nodes_cpus ****************/
+/* Return node's CPUs, as the kernel lists them (e.g. "0-3,8-11"). */
+const char *nodes_cpus(const nodes_t *nodes, const int node);
+
+/**************** nodes_bind ****************/
+/* Keep the calling thread on node's CPUs, and have the memory it
+ * allocates from now on placed on node. Returns false if the thread
+ * could not be pinned; a memory policy the kernel refuses is ignored,
+ * since first-touch placement from a pinned thread has the same effect
+ * for memory the thread touches first.
+ */
+bool nodes_bind(const nodes_t *nodes, const int node);
+
+/**************** nodes_interleave ****************/
+/* With on, spread the pages the calling thread allocates from now on
+ * round-robin over all nodes; with !on, go back to the default policy.
+ * Returns false if the kernel refused.
+ */
+bool nodes_interleave(const nodes_t *nodes, const bool on);
+
+/**************** nodes_delete ****************/
+/* Free nodes; NULL is ignored. */
+void nodes_delete(nodes_t *nodes);
+
+#endif // __NODES_H
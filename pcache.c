@@ -0,0 +1,394 @@
+/*
+ * pcache.c - 'pcache' module for the CS50 TSE querier
+ *
+ * see pcache.h for more information.
+ *
+ * Admission follows TinyLFU: every request counts towards its block in
+ * a count-min sketch of small saturating counters, which are halved
+ * after every 10 requests per cache slot, so the counts favour recent
+ * use. On a miss with the cache full, CLOCK picks a victim (the next
+ * slot not referenced since the hand last passed it), and the missed
+ * block replaces it only if its count is larger than the victim's.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "pcache.h"
+#include "mem.h"
+
+/* rows of the frequency sketch, and the largest count */
+#define FREQ_ROWS  4
+#define FREQ_MAX   15
+
+/* requests per slot between halvings of the counts */
+#define FREQ_AGING 10
+
+/**************** local types ****************/
+/* slot_t: one decoded block in the cache. */
+typedef struct slot {
+  clist_t *owner;      // list the block belongs to; NULL if free
+  int block;           // ...and its number there
+  bool ref;            // used since the CLOCK hand last passed
+  plist_t list;        // the decoded block; arrays hold PCACHE_BLOCK
+} slot_t;
+
+/**************** global types ****************/
+struct pcache {
+  int capacity;
+  int used;            // slots filled at least once
+  slot_t *slots;
+  int hand;            // CLOCK hand
+  slot_t scratch;      // a block decoded but not admitted
+  uint8_t *freq;       // FREQ_ROWS rows of width counters
+  int width;           // a power of 2
+  long requests;       // since the counts were last halved
+  pcachestats_t stats;
+};
+
+/**************** local functions ****************/
+static void decode_block(const clist_t *clist, const int block,
+                         plist_t *out);
+static int encode_varint(uint8_t *p, unsigned int value);
+static void slot_alloc(slot_t *slot);
+static int pick_victim(pcache_t *cache);
+static uint64_t block_hash(const clist_t *clist, const int block);
+static void freq_add(pcache_t *cache, const uint64_t h);
+static int freq_get(const pcache_t *cache, const uint64_t h);
+
+/**************** pcache_new ****************/
+/* see pcache.h for description */
+pcache_t *
+pcache_new(const int capacity)
+{
+  pcache_t *cache = mem_calloc_assert(1, sizeof(pcache_t), "pcache_new");
+  cache->capacity = (capacity > 0) ? capacity : 1;
+  cache->slots = mem_calloc_assert(cache->capacity, sizeof(slot_t),
+                                   "pcache_new");
+  slot_alloc(&cache->scratch);
+
+  /* about 2 counters per slot in each row */
+  cache->width = 64;
+  while (cache->width < 2 * cache->capacity) {
+    cache->width *= 2;
+  }
+  cache->freq = mem_calloc_assert(FREQ_ROWS * cache->width, sizeof(uint8_t),
+                                  "pcache_new");
+  cache->stats.capacity = cache->capacity;
+  return cache;
+}
+
+/**************** clist_new ****************/
+/* see pcache.h for description */
+clist_t *
+clist_new(const plist_t *list, pcache_t *cache, const int id)
+{
+  clist_t *clist = mem_calloc_assert(1, sizeof(clist_t), "clist_new");
+  clist->id = id;
+  clist->n = list->n;
+  clist->nblocks = (list->n + PCACHE_BLOCK - 1) / PCACHE_BLOCK;
+  clist->cache = cache;
+  int nb = clist->nblocks;
+  clist->first = mem_malloc_assert((nb + 1) * sizeof(int), "clist_new");
+  clist->offsets = mem_malloc_assert((nb + 1) * sizeof(int), "clist_new");
+  clist->slots = mem_malloc_assert((nb + 1) * sizeof(int), "clist_new");
+
+  /* at most 5 bytes per varint, two per posting */
+  uint8_t *bytes = mem_malloc_assert(10 * (size_t) list->n + 1, "clist_new");
+  int used = 0;
+  for (int b = 0; b < nb; b++) {
+    int start = b * PCACHE_BLOCK;
+    int end = (start + PCACHE_BLOCK < list->n) ? start + PCACHE_BLOCK
+                                               : list->n;
+    clist->first[b] = list->docs[start];
+    clist->offsets[b] = used;
+    clist->slots[b] = -1;
+    for (int i = start + 1; i < end; i++) {
+      used += encode_varint(bytes + used, list->docs[i] - list->docs[i-1]);
+    }
+    for (int i = start; i < end; i++) {
+      used += encode_varint(bytes + used, list->counts[i]);
+    }
+  }
+  clist->offsets[nb] = used;
+
+  /* keep only what was used */
+  clist->bytes = mem_malloc_assert(used + 1, "clist_new");
+  memcpy(clist->bytes, bytes, used);
+  mem_free(bytes);
+
+  cache->stats.rawBytes += 2 * sizeof(int) * (long) list->n;
+  cache->stats.packedBytes += used + 3 * sizeof(int) * (long) nb;
+  return clist;
+}
+
+/**************** clist_block_of ****************/
+/* see pcache.h for description */
+int
+clist_block_of(const clist_t *clist, const int docID)
+{
+  int lo = 0, hi = clist->nblocks;      // first[lo] <= docID < first[hi]
+  while (hi - lo > 1) {
+    int mid = lo + (hi - lo) / 2;
+    if (clist->first[mid] <= docID) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/**************** pcache_get ****************/
+/* see pcache.h for description */
+const plist_t *
+pcache_get(clist_t *clist, const int block)
+{
+  pcache_t *cache = clist->cache;
+  uint64_t h = block_hash(clist, block);
+  freq_add(cache, h);
+
+  int s = clist->slots[block];
+  if (s >= 0) {
+    cache->stats.hits++;
+    cache->slots[s].ref = true;
+    return &cache->slots[s].list;
+  }
+  cache->stats.misses++;
+
+  /* a free slot takes any block; else the block must be more popular
+   * than the victim */
+  slot_t *slot = NULL;
+  if (cache->used < cache->capacity) {
+    s = cache->used++;
+    slot = &cache->slots[s];
+    slot_alloc(slot);
+  } else {
+    s = pick_victim(cache);
+    slot = &cache->slots[s];
+    if (slot->owner != NULL) {
+      if (freq_get(cache, h)
+          <= freq_get(cache, block_hash(slot->owner, slot->block))) {
+        cache->stats.rejected++;
+        decode_block(clist, block, &cache->scratch.list);
+        return &cache->scratch.list;
+      }
+      slot->owner->slots[slot->block] = -1;
+      cache->stats.evicted++;
+    }
+  }
+
+  cache->stats.admitted++;
+  slot->owner = clist;
+  slot->block = block;
+  slot->ref = false;
+  clist->slots[block] = s;
+  decode_block(clist, block, &slot->list);
+  return &slot->list;
+}
+
+/**************** pcache_decode ****************/
+/* see pcache.h for description */
+void
+pcache_decode(clist_t *clist, plist_t *out)
+{
+  out->n = 0;
+  for (int b = 0; b < clist->nblocks; b++) {
+    const plist_t *block = pcache_get(clist, b);
+    memcpy(out->docs + out->n, block->docs, block->n * sizeof(int));
+    memcpy(out->counts + out->n, block->counts, block->n * sizeof(int));
+    out->n += block->n;
+  }
+}
+
+/**************** pcache_stats ****************/
+/* see pcache.h for description */
+void
+pcache_stats(const pcache_t *cache, pcachestats_t *stats)
+{
+  if (cache == NULL || stats == NULL) {
+    return;
+  }
+  *stats = cache->stats;
+  stats->used = 0;
+  for (int s = 0; s < cache->used; s++) {
+    stats->used += (cache->slots[s].owner != NULL);
+  }
+}
+
+/**************** clist_delete ****************/
+/* see pcache.h for description */
+void
+clist_delete(clist_t *clist)
+{
+  if (clist == NULL) {
+    return;
+  }
+  for (int b = 0; b < clist->nblocks; b++) {
+    if (clist->slots[b] >= 0) {
+      clist->cache->slots[clist->slots[b]].owner = NULL;
+    }
+  }
+  mem_free(clist->first);
+  mem_free(clist->offsets);
+  mem_free(clist->slots);
+  mem_free(clist->bytes);
+  mem_free(clist);
+}
+
+/**************** pcache_delete ****************/
+/* see pcache.h for description */
+void
+pcache_delete(pcache_t *cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+  for (int s = 0; s < cache->used; s++) {
+    mem_free(cache->slots[s].list.docs);
+    mem_free(cache->slots[s].list.counts);
+  }
+  mem_free(cache->scratch.list.docs);
+  mem_free(cache->scratch.list.counts);
+  mem_free(cache->slots);
+  mem_free(cache->freq);
+  mem_free(cache);
+}
+
+/* decode_block */
+/* Decode block number block of clist into out. */
+static void
+decode_block(const clist_t *clist, const int block, plist_t *out)
+{
+  int start = block * PCACHE_BLOCK;
+  int n = (clist->n - start < PCACHE_BLOCK) ? clist->n - start
+                                            : PCACHE_BLOCK;
+  const uint8_t *p = clist->bytes + clist->offsets[block];
+  int doc = clist->first[block];
+  out->docs[0] = doc;
+  for (int i = 0; i < 2 * n - 1; i++) {
+    unsigned int value = 0;
+    int shift = 0;
+    uint8_t byte;
+    do {
+      byte = *p++;
+      value |= (unsigned int) (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    /* n - 1 deltas, then n counts */
+    if (i < n - 1) {
+      doc += value;
+      out->docs[i + 1] = doc;
+    } else {
+      out->counts[i - (n - 1)] = value;
+    }
+  }
+  out->n = n;
+}
+
+/* encode_varint */
+/* Write value at p, 7 bits per byte, low bits first, with the high bit
+ * of every byte but the last set. Returns the bytes written.
+ */
+static int
+encode_varint(uint8_t *p, unsigned int value)
+{
+  int n = 0;
+  while (value >= 0x80) {
+    p[n++] = (uint8_t) (value | 0x80);
+    value >>= 7;
+  }
+  p[n++] = (uint8_t) value;
+  return n;
+}
+
+/* slot_alloc */
+/* Give slot arrays for a block. */
+static void
+slot_alloc(slot_t *slot)
+{
+  slot->owner = NULL;
+  slot->list.n = 0;
+  slot->list.docs = mem_malloc_assert(PCACHE_BLOCK * sizeof(int),
+                                      "slot_alloc");
+  slot->list.counts = mem_malloc_assert(PCACHE_BLOCK * sizeof(int),
+                                        "slot_alloc");
+}
+
+/* pick_victim */
+/* Advance the CLOCK hand to the first free or unreferenced slot,
+ * clearing the references it passes, and return that slot.
+ */
+static int
+pick_victim(pcache_t *cache)
+{
+  while (true) {
+    slot_t *slot = &cache->slots[cache->hand];
+    int s = cache->hand;
+    cache->hand = (cache->hand + 1) % cache->capacity;
+    if (slot->owner == NULL || !slot->ref) {
+      return s;
+    }
+    slot->ref = false;
+  }
+}
+
+/* block_hash */
+/* Mix a block's key (list id, block number) into 64 bits (the murmur3
+ * finalizer). */
+static uint64_t
+block_hash(const clist_t *clist, const int block)
+{
+  uint64_t h = ((uint64_t) (uint32_t) clist->id << 32) | (uint32_t) block;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/* freq_add */
+/* Count one request for the block hashed to h: increment its smallest
+ * counters (conservative update), and halve every counter once enough
+ * requests have been counted.
+ */
+static void
+freq_add(pcache_t *cache, const uint64_t h)
+{
+  int min = freq_get(cache, h);
+  if (min < FREQ_MAX) {
+    for (int r = 0; r < FREQ_ROWS; r++) {
+      uint8_t *c = &cache->freq[r * cache->width
+                                + ((h >> (16 * r)) & (cache->width - 1))];
+      if (*c == min) {
+        (*c)++;
+      }
+    }
+  }
+  if (++cache->requests >= (long) FREQ_AGING * cache->capacity) {
+    for (int i = 0; i < FREQ_ROWS * cache->width; i++) {
+      cache->freq[i] >>= 1;
+    }
+    cache->requests = 0;
+  }
+}
+
+/* freq_get */
+/* Return the estimated recent requests for the block hashed to h. */
+static int
+freq_get(const pcache_t *cache, const uint64_t h)
+{
+  int min = FREQ_MAX;
+  for (int r = 0; r < FREQ_ROWS; r++) {
+    int c = cache->freq[r * cache->width
+                        + ((h >> (16 * r)) & (cache->width - 1))];
+    min = (c < min) ? c : min;
+  }
+  return min;
+}
@@ -0,0 +1,103 @@
+/*
+ * pcache.h - header file for the querier's 'pcache' module
+ *
+ * Compressed posting lists and a cache of decoded posting blocks.
+ *
+ * A compressed list (clist_t) cuts a posting list into blocks of
+ * PCACHE_BLOCK postings and stores each block as variable-byte deltas
+ * between docIDs, then variable-byte counts; a skip table holds the
+ * first docID of every block, so an evaluator can tell which blocks can
+ * hold a docID without decoding any.
+ *
+ * Decoded blocks are kept in a bounded cache (pcache_t) keyed by list
+ * and block number, so a hot block is decoded once rather than for
+ * every query. When the cache is full, a block is admitted only if it
+ * has been used more often, recently, than the block it would evict
+ * (TinyLFU admission, with CLOCK choosing the candidate for eviction),
+ * so a long scan of cold blocks cannot flush the hot ones.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __PCACHE_H
+#define __PCACHE_H
+
+#include <stdint.h>
+#include "postings.h"
+
+/* postings per block */
+#define PCACHE_BLOCK 128
+
+typedef struct pcache pcache_t;
+
+/* clist_t: a compressed posting list (see postings.h for the typedef). */
+struct clist {
+  int id;              // tells lists apart in the cache
+  int n;               // postings
+  int nblocks;
+  int *first;          // first docID of each block
+  int *offsets;        // start of each block in bytes[]; nblocks+1 of them
+  uint8_t *bytes;      // the encoded blocks
+  int *slots;          // cache slot holding each block, or -1
+  pcache_t *cache;     // where the list's decoded blocks are kept
+};
+
+/* pcachestats_t: what the cache has done so far. */
+typedef struct pcachestats {
+  int capacity;        // blocks the cache can hold
+  int used;            // ...and holds now
+  long hits;           // block requests served from the cache
+  long misses;         // ...that had to decode the block
+  long admitted;       // missed blocks kept in the cache
+  long rejected;       // ...and decoded but not kept
+  long evicted;        // blocks dropped to make room
+  long rawBytes;       // bytes the lists take as plain arrays
+  long packedBytes;    // ...and compressed
+} pcachestats_t;
+
+/**************** pcache_new ****************/
+/* Return a new cache of up to capacity decoded blocks; caller must
+ * pcache_delete it, after deleting the lists that use it.
+ */
+pcache_t *pcache_new(const int capacity);
+
+/**************** clist_new ****************/
+/* Compress list into a new clist_t, whose blocks will be cached in
+ * cache under id (which must differ for every list of the cache).
+ * Caller frees it with clist_delete.
+ */
+clist_t *clist_new(const plist_t *list, pcache_t *cache, const int id);
+
+/**************** clist_block_of ****************/
+/* Return the block of clist that would hold docID: the last block whose
+ * first docID is at most docID, or 0.
+ */
+int clist_block_of(const clist_t *clist, const int docID);
+
+/**************** pcache_get ****************/
+/* Return block number block of clist, decoded. The list belongs to the
+ * cache: it stays valid only until the next pcache_get on that cache.
+ */
+const plist_t *pcache_get(clist_t *clist, const int block);
+
+/**************** pcache_decode ****************/
+/* Decode all of clist, block by block through the cache, into out,
+ * whose arrays must have room for clist->n postings.
+ */
+void pcache_decode(clist_t *clist, plist_t *out);
+
+/**************** pcache_stats ****************/
+/* Fill *stats with the cache's counts so far. */
+void pcache_stats(const pcache_t *cache, pcachestats_t *stats);
+
+/**************** clist_delete ****************/
+/* Free a compressed list; its cached blocks are dropped. NULL is
+ * ignored.
+ */
+void clist_delete(clist_t *clist);
+
+/**************** pcache_delete ****************/
+/* Free the cache; NULL is ignored. */
+void pcache_delete(pcache_t *cache);
+
+#endif // __PCACHE_H
@@ -0,0 +1,484 @@
+/*
+ * postings.c - 'postings' module for the CS50 TSE querier
+ *
+ * see postings.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include "postings.h"
+#include "pcache.h"
+#include "hashtable.h"
+#include "file.h"
+#include "mem.h"
+
+/**************** global types ****************/
+struct postings {
+  hashtable_t *terms;  // word -> term_t*
+  int maxdoc;          // largest docID seen
+  pcache_t *cache;     // decoded blocks; NULL unless compressed
+};
+
+/* pair_t: one posting, used while loading and sorting. */
+typedef struct pair {
+  int docID;
+  int count;
+} pair_t;
+
+/* tier_arg_t: parameters passed through hashtable_iterate. */
+typedef struct tier_arg {
+  double fraction;
+  int minPostings;
+} tier_arg_t;
+
+/* bloom_arg_t: parameters passed through hashtable_iterate. */
+typedef struct bloom_arg {
+  int minPostings;
+  int bitsPerKey;
+} bloom_arg_t;
+
+/* iterate_arg_t: the caller's function, passed through hashtable_iterate. */
+typedef struct iterate_arg {
+  void *arg;
+  void (*itemfunc)(void *arg, const char *word, term_t *term);
+} iterate_arg_t;
+
+/* compress_arg_t: state passed through hashtable_iterate. */
+typedef struct compress_arg {
+  pcache_t *cache;
+  int nextID;
+} compress_arg_t;
+
+/**************** local functions ****************/
+static bool read_postings(FILE *fp, pair_t **pairs, int *npairs);
+static int  cmp_pair_docID(const void *a, const void *b);
+static int  cmp_int_desc(const void *a, const void *b);
+static void plist_alloc(plist_t *list, const int n);
+static void plist_free(plist_t *list);
+static void iterate_helper(void *arg, const char *key, void *item);
+static void tier_helper(void *arg, const char *key, void *item);
+static void bloom_helper(void *arg, const char *key, void *item);
+static void sketch_helper(void *arg, const char *key, void *item);
+static void compress_helper(void *arg, const char *key, void *item);
+static void term_delete(void *item);
+
+/**************** postings_load ****************/
+/* see postings.h for description */
+postings_t *
+postings_load(FILE *fp)
+{
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  /* one word per line; size the table from the number of lines */
+  int nlines = file_numLines(fp);
+  postings_t *postings = mem_malloc_assert(sizeof(postings_t),
+                                           "postings_load");
+  postings->terms = hashtable_new(nlines > 0 ? nlines : 1);
+  postings->maxdoc = 0;
+  postings->cache = NULL;
+  if (postings->terms == NULL) {
+    mem_free(postings);
+    return NULL;
+  }
+
+  char *word;
+  while ((word = file_readWord(fp)) != NULL) {
+    pair_t *pairs = NULL;
+    int npairs = 0;
+    if (!read_postings(fp, &pairs, &npairs)) {
+      fprintf(stderr, "postings: bad postings for '%s'; skipped\n", word);
+      mem_free(pairs);
+      mem_free(word);
+      continue;
+    }
+
+    qsort(pairs, npairs, sizeof(pair_t), cmp_pair_docID);
+
+    term_t *term = mem_calloc_assert(1, sizeof(term_t), "postings_load term");
+    plist_alloc(&term->full, npairs);
+    for (int i = 0; i < npairs; i++) {
+      term->full.docs[i] = pairs[i].docID;
+      term->full.counts[i] = pairs[i].count;
+    }
+    if (npairs > 0 && pairs[npairs-1].docID > postings->maxdoc) {
+      postings->maxdoc = pairs[npairs-1].docID;
+    }
+    mem_free(pairs);
+
+    if (!hashtable_insert(postings->terms, word, term)) {
+      fprintf(stderr, "postings: duplicate word '%s'; skipped\n", word);
+      term_delete(term);
+    }
+    mem_free(word);
+  }
+  return postings;
+}
+
+/* read_postings */
+/* Read (docID, count) pairs up to the end of the current line into a
+ * new array. Returns false if a pair is malformed or non-positive.
+ */
+static bool
+read_postings(FILE *fp, pair_t **pairs, int *npairs)
+{
+  int cap = 16;
+  int n = 0;
+  pair_t *array = mem_malloc_assert(cap * sizeof(pair_t), "read_postings");
+
+  int c;
+  while ((c = fgetc(fp)) != EOF && c != '\n') {
+    if (c == ' ' || c == '\t' || c == '\r') {
+      continue;
+    }
+    ungetc(c, fp);
+    if (!isdigit(c)) {
+      break;                  // no newline before the next word
+    }
+
+    int docID, count;
+    if (fscanf(fp, "%d %d", &docID, &count) != 2
+        || docID <= 0 || count <= 0) {
+      /* discard the rest of the line */
+      while ((c = fgetc(fp)) != EOF && c != '\n') {
+      }
+      *pairs = array;
+      *npairs = n;
+      return false;
+    }
+    if (n == cap) {
+      cap *= 2;
+      pair_t *bigger = mem_malloc_assert(cap * sizeof(pair_t),
+                                         "read_postings");
+      memcpy(bigger, array, n * sizeof(pair_t));
+      mem_free(array);
+      array = bigger;
+    }
+    array[n].docID = docID;
+    array[n].count = count;
+    n++;
+  }
+
+  *pairs = array;
+  *npairs = n;
+  return true;
+}
+
+/**************** postings_find ****************/
+/* see postings.h for description */
+term_t *
+postings_find(postings_t *postings, const char *word)
+{
+  if (postings == NULL || word == NULL) {
+    return NULL;
+  }
+  return hashtable_find(postings->terms, word);
+}
+
+/**************** postings_iterate ****************/
+/* see postings.h for description */
+void
+postings_iterate(postings_t *postings, void *arg,
+                 void (*itemfunc)(void *arg, const char *word, term_t *term))
+{
+  if (postings == NULL || itemfunc == NULL) {
+    return;
+  }
+  iterate_arg_t ia = { arg, itemfunc };
+  hashtable_iterate(postings->terms, &ia, iterate_helper);
+}
+
+/* iterate_helper */
+/* Pass one term on to the caller's function. */
+static void
+iterate_helper(void *arg, const char *key, void *item)
+{
+  iterate_arg_t *ia = arg;
+  ia->itemfunc(ia->arg, key, item);
+}
+
+/**************** postings_maxdoc ****************/
+/* see postings.h for description */
+int
+postings_maxdoc(postings_t *postings)
+{
+  return (postings == NULL) ? 0 : postings->maxdoc;
+}
+
+/**************** postings_tier ****************/
+/* see postings.h for description */
+void
+postings_tier(postings_t *postings, const double fraction,
+              const int minPostings)
+{
+  if (postings == NULL) {
+    return;
+  }
+  tier_arg_t arg = { fraction, minPostings };
+  hashtable_iterate(postings->terms, &arg, tier_helper);
+}
+
+/* tier_helper */
+/* Split one term's full list into tier 1 and tier 2. */
+static void
+tier_helper(void *arg, const char *key, void *item)
+{
+  (void) key;                 // unused
+  tier_arg_t *ta = arg;
+  term_t *term = item;
+  const plist_t *full = &term->full;
+
+  plist_free(&term->tier1);
+  plist_free(&term->tier2);
+  term->tier2max = 0;
+
+  /* how many postings does tier 1 want? */
+  int want = (int) (ta->fraction * full->n + 0.999999);
+  if (want < ta->minPostings) {
+    want = ta->minPostings;
+  }
+
+  /* find the count threshold: the want'th largest count */
+  int threshold = 0;
+  if (want < full->n) {
+    int *sorted = mem_malloc_assert(full->n * sizeof(int), "tier_helper");
+    memcpy(sorted, full->counts, full->n * sizeof(int));
+    qsort(sorted, full->n, sizeof(int), cmp_int_desc);
+    threshold = sorted[want-1];
+    mem_free(sorted);
+  }
+
+  int n1 = 0;
+  for (int i = 0; i < full->n; i++) {
+    if (full->counts[i] >= threshold) {
+      n1++;
+    }
+  }
+  plist_alloc(&term->tier1, n1);
+  plist_alloc(&term->tier2, full->n - n1);
+
+  int i1 = 0, i2 = 0;
+  for (int i = 0; i < full->n; i++) {
+    if (full->counts[i] >= threshold) {
+      term->tier1.docs[i1] = full->docs[i];
+      term->tier1.counts[i1++] = full->counts[i];
+    } else {
+      term->tier2.docs[i2] = full->docs[i];
+      term->tier2.counts[i2++] = full->counts[i];
+      if (full->counts[i] > term->tier2max) {
+        term->tier2max = full->counts[i];
+      }
+    }
+  }
+}
+
+/**************** postings_bloom ****************/
+/* see postings.h for description */
+void
+postings_bloom(postings_t *postings, const int minPostings,
+               const int bitsPerKey)
+{
+  if (postings == NULL) {
+    return;
+  }
+  bloom_arg_t arg = { minPostings, bitsPerKey };
+  hashtable_iterate(postings->terms, &arg, bloom_helper);
+}
+
+/* bloom_helper */
+/* (Re)build one term's Bloom filter, if its list is long enough. */
+static void
+bloom_helper(void *arg, const char *key, void *item)
+{
+  (void) key;                 // unused
+  bloom_arg_t *ba = arg;
+  term_t *term = item;
+
+  bloom_delete(term->bloom);
+  term->bloom = NULL;
+  if (term->full.n < ba->minPostings) {
+    return;
+  }
+  term->bloom = bloom_new(term->full.n, ba->bitsPerKey);
+  for (int i = 0; i < term->full.n; i++) {
+    bloom_add(term->bloom, term->full.docs[i]);
+  }
+}
+
+/**************** postings_sketch ****************/
+/* see postings.h for description */
+void
+postings_sketch(postings_t *postings)
+{
+  if (postings != NULL) {
+    hashtable_iterate(postings->terms, NULL, sketch_helper);
+  }
+}
+
+/* sketch_helper */
+/* Build one term's sketch. */
+static void
+sketch_helper(void *arg, const char *key, void *item)
+{
+  (void) arg;                 // unused
+  (void) key;                 // unused
+  term_t *term = item;
+  if (term->sketch == NULL) {
+    term->sketch = mem_malloc_assert(sizeof(sketch_t), "sketch_helper");
+  }
+  sketch_build(term->sketch, term->full.docs, term->full.n);
+}
+
+/**************** postings_compress ****************/
+/* see postings.h for description */
+void
+postings_compress(postings_t *postings, const int cacheBlocks)
+{
+  if (postings == NULL || postings->cache != NULL) {
+    return;
+  }
+  postings->cache = pcache_new(cacheBlocks);
+  compress_arg_t arg = { postings->cache, 0 };
+  hashtable_iterate(postings->terms, &arg, compress_helper);
+}
+
+/* compress_helper */
+/* Compress one term's full list and free its plain arrays. */
+static void
+compress_helper(void *arg, const char *key, void *item)
+{
+  (void) key;                 // unused
+  compress_arg_t *ca = arg;
+  term_t *term = item;
+  term->packed = clist_new(&term->full, ca->cache, ca->nextID++);
+  int n = term->full.n;
+  plist_free(&term->full);
+  term->full.n = n;
+}
+
+/**************** postings_cache ****************/
+/* see postings.h for description */
+pcache_t *
+postings_cache(postings_t *postings)
+{
+  return (postings == NULL) ? NULL : postings->cache;
+}
+
+/**************** postings_seek ****************/
+/* see postings.h for description */
+int
+postings_seek(const plist_t *list, const int from, const int docID)
+{
+  int n = list->n;
+  const int *docs = list->docs;
+  if (from >= n || docs[from] >= docID) {
+    return from;
+  }
+
+  /* gallop: docs[lo] < docID; double the step until we pass it */
+  int lo = from;
+  int step = 1;
+  int hi = from + step;
+  while (hi < n && docs[hi] < docID) {
+    lo = hi;
+    step *= 2;
+    hi = lo + step;
+  }
+  if (hi > n) {
+    hi = n;
+  }
+
+  /* binary search in (lo, hi]: docs[lo] < docID <= docs[hi] */
+  while (lo + 1 < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (docs[mid] < docID) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return hi;
+}
+
+/**************** postings_delete ****************/
+/* see postings.h for description */
+void
+postings_delete(postings_t *postings)
+{
+  if (postings == NULL) {
+    return;
+  }
+  hashtable_delete(postings->terms, term_delete);
+  pcache_delete(postings->cache);
+  mem_free(postings);
+}
+
+/* term_delete */
+/* Free a term_t and its lists; used by hashtable_delete. */
+static void
+term_delete(void *item)
+{
+  term_t *term = item;
+  if (term != NULL) {
+    plist_free(&term->full);
+    plist_free(&term->tier1);
+    plist_free(&term->tier2);
+    bloom_delete(term->bloom);
+    mem_free(term->sketch);
+    clist_delete(term->packed);
+    mem_free(term);
+  }
+}
+
+/* plist_alloc */
+/* Allocate arrays for n postings; an empty list has NULL arrays. */
+static void
+plist_alloc(plist_t *list, const int n)
+{
+  list->n = n;
+  if (n == 0) {
+    list->docs = NULL;
+    list->counts = NULL;
+    return;
+  }
+  list->docs = mem_malloc_assert(n * sizeof(int), "plist_alloc");
+  list->counts = mem_malloc_assert(n * sizeof(int), "plist_alloc");
+}
+
+/* plist_free */
+/* Free the arrays of a list and mark it empty. */
+static void
+plist_free(plist_t *list)
+{
+  mem_free(list->docs);
+  mem_free(list->counts);
+  list->docs = NULL;
+  list->counts = NULL;
+  list->n = 0;
+}
+
+/* cmp_pair_docID */
+/* qsort comparison: pair_t by docID ascending. */
+static int
+cmp_pair_docID(const void *a, const void *b)
+{
+  const pair_t *pa = a;
+  const pair_t *pb = b;
+  return (pa->docID > pb->docID) - (pa->docID < pb->docID);
+}
+
+/* cmp_int_desc */
+/* qsort comparison: ints descending. */
+static int
+cmp_int_desc(const void *a, const void *b)
+{
+  const int *ia = a;
+  const int *ib = b;
+  return (*ib > *ia) - (*ib < *ia);
+}
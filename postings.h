@@ -0,0 +1,135 @@
+/*
+ * postings.h - header file for the querier's 'postings' module
+ *
+ * The index_t used by the querier stores each word's postings in a
+ * counters_t, which has no order and can only be walked through a
+ * callback. This module reads the same index file into flat arrays
+ * sorted by docID, which the faster evaluation paths need.
+ *
+ * Each term's postings may also be split into two tiers: tier 1 holds
+ * the highest-count postings and tier 2 the rest, so that a top-K query
+ * can often be answered from tier 1 alone.
+ *
+ * Long lists may also get a Bloom filter of their docIDs, which the AND
+ * evaluators test before probing the list, and every list may get a
+ * sketch, from which the querier estimates how words overlap.
+ *
+ * Finally the lists may be compressed (see pcache.h): each term then
+ * keeps only a compressed copy of its full list, decoded block by block
+ * through a cache shared by all terms.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __POSTINGS_H
+#define __POSTINGS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "bloom.h"
+#include "sketch.h"
+
+/* plist_t: a posting list, as parallel arrays sorted by docID. */
+typedef struct plist {
+  int n;               // number of postings
+  int *docs;           // docIDs, strictly ascending
+  int *counts;         // count of the word in docs[i]
+} plist_t;
+
+/* compressed lists and their cache; see pcache.h */
+typedef struct clist clist_t;
+typedef struct pcache pcache_t;
+
+/* term_t: everything we know about one word. */
+typedef struct term {
+  plist_t full;        // all postings for the word; only full.n is
+                       // kept once compressed (see postings_compress)
+  plist_t tier1;       // highest-count postings (empty until tiered)
+  plist_t tier2;       // all remaining postings
+  int tier2max;        // largest count in tier2; 0 if tier2 is empty
+  bloom_t *bloom;      // docIDs of full, or NULL (see postings_bloom)
+  sketch_t *sketch;    // sketch of full, or NULL (see postings_sketch)
+  clist_t *packed;     // full, compressed, or NULL (postings_compress)
+} term_t;
+
+typedef struct postings postings_t;
+
+/**************** postings_load ****************/
+/* Read an index file in the Indexer's format,
+ *   word docID count [docID count]...
+ * one word per line, into sorted posting lists.
+ *
+ * Caller provides:
+ *   an open, readable index file.
+ * We return:
+ *   a new postings_t, which the caller frees with postings_delete,
+ *   or NULL on error. Malformed lines are skipped with a warning.
+ */
+postings_t *postings_load(FILE *fp);
+
+/**************** postings_find ****************/
+/* Return the term_t for word, or NULL if the word is not indexed. */
+term_t *postings_find(postings_t *postings, const char *word);
+
+/**************** postings_iterate ****************/
+/* Call itemfunc(arg, word, term) once for every term, in no particular
+ * order.
+ */
+void postings_iterate(postings_t *postings, void *arg,
+                      void (*itemfunc)(void *arg, const char *word,
+                                       term_t *term));
+
+/**************** postings_maxdoc ****************/
+/* Return the largest docID appearing in any posting list. */
+int postings_maxdoc(postings_t *postings);
+
+/**************** postings_tier ****************/
+/* Split every term into tier 1 and tier 2.
+ *
+ * Tier 1 keeps the ceil(fraction * n) highest-count postings of each
+ * term, but at least minPostings of them; postings tied with the
+ * smallest count kept are also kept, so every tier-2 count is strictly
+ * smaller than every tier-1 count. Both tiers stay sorted by docID.
+ * Calling it again re-splits with the new parameters.
+ */
+void postings_tier(postings_t *postings, const double fraction,
+                   const int minPostings);
+
+/**************** postings_bloom ****************/
+/* Build a Bloom filter of bitsPerKey bits per posting for every term
+ * with at least minPostings postings; shorter lists are cheap to probe
+ * anyway. Calling it again rebuilds the filters.
+ */
+void postings_bloom(postings_t *postings, const int minPostings,
+                    const int bitsPerKey);
+
+/**************** postings_sketch ****************/
+/* Build the KMV sketch (see sketch.h) of every term's postings. */
+void postings_sketch(postings_t *postings);
+
+/**************** postings_compress ****************/
+/* Compress every term's full list (see pcache.h) and free the plain
+ * arrays, keeping full.n; the blocks are decoded through a new cache of
+ * cacheBlocks blocks. Tiers, Bloom filters and sketches are built from
+ * the plain arrays, so build them first. Only the block engine (and so
+ * batches) reads compressed lists; the document-at-a-time engine needs
+ * the plain arrays.
+ */
+void postings_compress(postings_t *postings, const int cacheBlocks);
+
+/**************** postings_cache ****************/
+/* Return the cache of decoded blocks, or NULL if not compressed. */
+pcache_t *postings_cache(postings_t *postings);
+
+/**************** postings_seek ****************/
+/* Return the smallest position p >= from with list->docs[p] >= docID,
+ * or list->n if there is none. Uses galloping search, so a sequence
+ * of seeks with increasing docIDs costs O(log gap) each.
+ */
+int postings_seek(const plist_t *list, const int from, const int docID);
+
+/**************** postings_delete ****************/
+/* Free everything allocated by postings_load; NULL is ignored. */
+void postings_delete(postings_t *postings);
+
+#endif // __POSTINGS_H
@@ -4,50 +4,249 @@
  * The querier reads the index produced by the Indexer and the page files
  * produced by the Crawler, then interactively answers search queries
  * entered on stdin. It supports words and the operators "and" and "or",
- * where "and" has higher precedence than "or".
+ * where "and" has higher precedence than "or". A query may also carry
+ * host:name or site:name terms, which restrict the results to pages on
+ * that host (site: also allows its subdomains).
  *
  * Usage:
- *   ./querier pageDirectory indexFilename
+ *   ./querier [options] pageDirectory indexFilename
+ *   ./querier [options] -serve indexesFile
  *
  * pageDirectory  - directory produced by crawler (contains .crawler and
  *                  files named 1,2,3,...)
  * indexFilename  - index file produced by indexer.
  *
+ * Options:
+ *   -k K       print only the top K results of each query
+ *   -tiered    with -k, answer from tier 1 of the postings when the
+ *              top K is provably correct, else fall back to the full
+ *              index; reports how often tier 1 sufficed on exit
+ *   -collapse  show only the best-ranked page of each group of
+ *              near-duplicates, using pageDirectory/.simhash (written
+ *              by the simhasher program)
+ *   -snippets  print a short query-biased snippet under each result
+ *   -engine E  evaluate with E: "taat" (term at a time, the default),
+ *              "daat" (document at a time), "block" (block at a time,
+ *              on sorted arrays), or "auto" (chosen per query by its
+ *              shape)
+ *   -stats     report per-engine query counts and evaluation time on exit
+ *   -bloom     build Bloom filters of long posting lists at startup, and
+ *              test them before probing those lists in AND evaluation
+ *   -plan      build a sketch of every posting list at startup, and use
+ *              the estimated overlaps to order each andsequence's
+ *              intersections and (with -engine auto) pick the engine
+ *   -batch     read every query first, then answer them in order,
+ *              evaluating each distinct andsequence and each repeated
+ *              query only once; reports the work shared on exit
+ *              (-engine is ignored)
+ *   -compressed  keep the sorted postings compressed, decoding blocks
+ *              of them through a bounded cache; reports the memory
+ *              saved and the cache's hit rate on exit (not with
+ *              -engine daat)
+ *   -cache N   with -compressed, cache N decoded blocks (default 4096)
+ *   -nofast    evaluate one-word and two-word queries with TAAT's
+ *              general loop too, rather than their fast paths (for
+ *              comparison)
+ *   -threads N use up to N threads to sort very large result sets
+ *              (default: the number of online processors)
+ *   -stream    print each result as soon as it is provably final, and
+ *              the count of results after them
+ *   -workers N answer queries on N threads, printing the answers in
+ *              input order
+ *   -lanes S   of those, keep S for queries whose words' postings total
+ *              more than -slowcost C (default 4096) and the rest for
+ *              cheaper ones, printing answers as they finish
+ *   -numa M    pin the workers to NUMA nodes, with the index replicated
+ *              on every node (M = "replicate") or spread over them
+ *              ("interleave")
+ *   -timeout MS  cancel any query still running after MS milliseconds
+ *   -shadow E  on a background thread, evaluate a sample of the queries
+ *              again with engine E and with TAAT's counters, compare
+ *              the rankings, and report mismatches and relative times
+ *   -sample P  with -shadow, compare P percent of queries (default 10)
+ *   -inputs F,...  read queries from each of the files (or FIFOs) F
+ *              ("-": stdin) at once, answering each on F.out (stdout),
+ *              and evaluating them all on one thread (with -engine
+ *              daat), taking turns every -slice N postings (default
+ *              1024; 0: each query to its end); reports each input's
+ *              latency, and its time spent waiting on the others
+ *   -listen P  answer the queries that clients send over TCP connections
+ *              to port P of 127.0.0.1 (0: any free port, which is
+ *              printed), on this one thread, until stdin reaches end
+ *              of file; reports the system calls made per query
+ *   -io L      with -listen, run the event loop on L: "uring"
+ *              (io_uring, the default, if the kernel allows) or
+ *              "epoll"
+ *   -replicas N  run N copies of this querier (with the other options
+ *              given), send each query to one, and print the answers in
+ *              input order; a query not answered within the -hedge P
+ *              percentile (default 95; 0: never) of the latencies seen
+ *              is sent to a second copy too, the first answer taken and
+ *              the other copy's query cancelled; reports the hedges and
+ *              latencies
+ *   -serve F   serve every index listed in file F (see below)
+ *   -budget KB with -serve, cache at most KB kilobytes of answers
+ *              (default 65536)
+ *
+ * With -serve, one querier hosts several indexes, each line of F naming
+ * one: "name pageDirectory indexFilename [quotaKB]". A query line
+ * starting "@name" is answered from that index, any other from the
+ * first. The indexes share the worker threads (-workers, by default
+ * one per processor) and a cache of whole answers, in which each index
+ * is guaranteed quotaKB (by default, an equal share of the budget).
+ * The line "!reload name" loads that index again, in the background:
+ * queries are answered from the old copy until the new one is ready.
+ * A query starting "@*", or "@name,name,...", is federated: evaluated
+ * on each of those indexes in parallel, and answered with one ranked
+ * list, scores normalized per index and duplicate URLs dropped.
+ *
+ * A query is also cancelled when SIGINT arrives while it runs (SIGINT
+ * between queries still ends the querier), and when nobody is left to
+ * read the output; the querier then stops reading queries. SIGUSR1
+ * cancels the query running, if any, and is otherwise ignored, so a
+ * front end (-replicas) can cancel a query without racing its end.
+ *
  * Riti Singh, November 2025
  */
 
+/* fileno and sigaction are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
-#include <unistd.h>     // isatty
+#include <unistd.h>     // isatty, sysconf
 #include <limits.h>     // PATH_MAX
+#include <pthread.h>
+#include <signal.h>
 
 #include "counters.h"
 #include "index.h"
 #include "mem.h"
-
-#ifndef PATH_MAX
-#define PATH_MAX 4096
-#endif
-
-/* fileno is POSIX, not in the C11 standard header, so declare it here. */
-int fileno(FILE *stream);
+#include "query.h"
+#include "postings.h"
+#include "tiers.h"
+#include "bitmap.h"
+#include "hosts.h"
+#include "docattrs.h"
+#include "simhash.h"
+#include "snippet.h"
+#include "daat.h"
+#include "blocks.h"
+#include "batch.h"
+#include "pcache.h"
+#include "radix.h"
+#include "nodes.h"
+#include "workers.h"
+#include "cancel.h"
+#include "shadow.h"
+#include "listener.h"
+#include "hedger.h"
+#include "answers.h"
+#include "querier.h"
+#include "serve.h"
+#include "mux.h"
+#include "timing.h"
+
+/* tier 1 keeps this fraction of each term's postings, but at least
+ * TIER1_MIN of them (see postings_tier) */
+#define TIER1_FRACTION 0.10
+#define TIER1_MIN      16
+
+/* -bloom filters lists of at least BLOOM_MIN postings, with BLOOM_BITS
+ * bits per posting (see postings_bloom) */
+#define BLOOM_MIN      64
+#define BLOOM_BITS     16
+
+/* -compressed caches this many decoded blocks by default (see pcache.h) */
+#define PCACHE_BLOCKS  4096
+
+/* the host filters of one query, as a key for batch.h */
+#define FILTER_KEYMAX  (MAX_FILTERS * (FILTER_NAMEMAX + 3))
+
+/* with -lanes, the workers' two queues, and the estimated cost (in
+ * postings) above which a query goes to the slow lane by default */
+#define LANE_FAST      0
+#define LANE_SLOW      1
+#define LANE_COST      4096
+
+/* with -serve, answers are cached in this many KB by default */
+#define SERVE_BUDGET   65536
+
+/* -shadow compares this percentage of queries by default */
+#define SHADOW_PERCENT 10
+
+/* -inputs by default lets a query visit this many postings before
+ * moving on to the next */
+#define SLICE_POSTINGS 1024
+
+/* -replicas hedges after this percentile of the latencies by default */
+#define HEDGE_PERCENT  95
+
+/* -engine auto uses TAAT only for queries with at most this many postings */
+#define AUTO_TAAT_POSTINGS 64
+
+/* the fast paths ask the cancel token every this many postings (a
+ * power of 2) */
+#define SHAPE_CHECK 1024
+
+/* names of the engine_t, shape_t and numa_t values (see querier.h) */
+static const char *engineNames[] = { "taat", "daat", "block", "auto" };
+static const char *shapeNames[] = { "one-word", "two-word and",
+                                    "two-word or" };
+static const char *numaNames[] = { "off", "replicate", "interleave" };
 
 /* local types */
-/* docscore_t: pair of docID and its score for ranking. */
-typedef struct docscore {
-  int docID;
-  int score;
-} docscore_t;
+/* shadowing_t: what -shadow's evaluators read: the querier's data,
+ * without the parts each answering thread has of its own. */
+typedef struct shadowing {
+  options_t opts;         // the querier's, with the engine compared
+  querier_t qr;           // no snippets, batch, stream, output or token
+} shadowing_t;
+
+/* loader_t: helper struct for loading a replica on its own node. */
+typedef struct loader {
+  const options_t *opts;
+  const nodes_t *nodes;
+  int node;
+  replica_t *replica;
+} loader_t;
+
+/* result_t: a set of results that may still be borrowed from the index.
+ * A word's counters are used in place until something would modify
+ * them; only then are they copied (copy-on-write).
+ */
+typedef struct result {
+  counters_t *ctrs;        // NULL: no documents
+  bool owned;              // ctrs is ours to modify and delete
+} result_t;
+
+/* filter_copy_t: helper struct for copying through a docID filter,
+ * optionally intersecting with other on the way. */
+typedef struct filter_copy {
+  counters_t *dest;
+  counters_t *other;       // NULL: copy counts as they are
+  const bloom_t *bloom;    // other's docIDs, or NULL
+  const bitmap_t *allowed; // NULL: all documents
+} filter_copy_t;
 
 /* two_counters_t: helper struct passed into counters_iterate. */
 typedef struct two_counters {
   counters_t *a;
   counters_t *b;
+  const bloom_t *bloom;    // b's docIDs, or NULL
 } two_counters_t;
 
+/* pending_t: a query read in batch mode, waiting to be answered. */
+typedef struct pending {
+  char *line;          // the words point into this copy of the line
+  char **words;
+  int nwords;
+  filter_t filter;
+} pending_t;
+
 /* collect_arg_t: helper to build an array of docscore_t. */
 typedef struct collect_arg {
   docscore_t *array;   // array into which we write
@@ -56,131 +255,825 @@ typedef struct collect_arg {
 
 /* function prototypes */
 /* command-line handling */
-static void parse_args(const int argc, char *argv[],
-                       char **pageDirectory, char **indexFilename);
+static void parse_args(const int argc, char *argv[], options_t *opts);
+static void usage(const char *progName);
 
 /* main loop helpers */
-static void prompt(void);
-static void query_loop(const char *pageDirectory, index_t *index);
+static void query_loop(const options_t *opts, querier_t *qr);
+static void batch_loop(const options_t *opts, querier_t *qr);
+static void listen_loop(const options_t *opts, querier_t *qr);
+static void hedge_loop(const options_t *opts, const int argc, char *argv[]);
+static void worker_loop(const options_t *opts, const querier_t *qr,
+                        const nodes_t *nodes, const replica_t *replicas,
+                        const int nreplicas);
+static void worker_start(void *arg);
+static void worker_answer(void *arg, char *line, FILE *out);
+static long line_cost(postings_t *postings, const char *line);
+static void index_term(void *arg, const char *word, term_t *term);
+static void *load_on_node(void *arg);
+static int shadow_reference(void *arg, char **words, const int nwords,
+                            const bitmap_t *allowed, docscore_t **docs_out);
+static int shadow_candidate(void *arg, char **words, const int nwords,
+                            const bitmap_t *allowed, docscore_t **docs_out);
+static void on_interrupt(int sig);
+static void on_cancel(int sig);
+static void evaluate_and_print(const options_t *opts, querier_t *qr,
+                               char **words, const int nwords,
+                               const filter_t *filter, stats_t *stats);
+static void print_cancelled(const querier_t *qr);
+static engine_t choose_engine(const options_t *opts, const querier_t *qr,
+                              const query_t *query);
+static bool plan_costs(postings_t *postings, const query_t *query,
+                       double *taat_out, double *block_out);
 
 /* parsing and syntax checking */
 static bool tokenize_and_validate(char *line, char ***words_out,
                                   int *nwords_out);
 static bool validate_tokens(char **words, const int nwords);
 static bool is_operator(const char *word);
+static bool extract_filters(char *line, filter_t *filter);
+static bool add_host_filter(filter_t *filter, const char *term);
+static void filter_key(const filter_t *filter, char *key, const size_t size);
 
 /* query evaluation */
-static counters_t *evaluate_query(index_t *index, char **words,
-                                  const int nwords);
-static counters_t *evaluate_andsequence(index_t *index, char **words,
-                                        const int nwords, const int start,
-                                        int *end_out);
+static shape_t query_shape(char **words, const int nwords);
+static int evaluate_shape(const querier_t *qr, const shape_t shape,
+                          char **words, const int nwords,
+                          const bitmap_t *allowed, cancel_t *cancel,
+                          docscore_t **docs_out);
+static int collect_word(const querier_t *qr, const char *word,
+                        const bitmap_t *allowed, const bool sorted,
+                        cancel_t *cancel, docscore_t **docs_out);
+static bool stop_every(cancel_t *cancel, int *steps);
+static int docscore_cmp_docID(const void *a, const void *b);
+static result_t evaluate_query(index_t *index, postings_t *postings,
+                               char **words, const int nwords,
+                               const bitmap_t *allowed, cancel_t *cancel);
+static result_t evaluate_andsequence(index_t *index, postings_t *postings,
+                                     char **words, const int nwords,
+                                     const int start,
+                                     const bitmap_t *allowed,
+                                     cancel_t *cancel, int *end_out);
+static void plan_andsequence(postings_t *postings, char **words,
+                             int *wordIdx, const int n);
 
 /* counters utilities */
-static void counters_intersect(counters_t *dest, counters_t *src);
+static void counters_intersect(counters_t *dest, counters_t *src,
+                               const bloom_t *bloom);
 static void counters_union(counters_t *dest, counters_t *src);
 
 /* iterate helpers for counters */
 static void intersect_helper(void *arg, const int key, int count);
 static void union_helper(void *arg, const int key, int count);
-static void copy_helper(void *arg, const int key, int count);
-static void zero_helper(void *arg, const int key, int count);
+static result_t result_copy(counters_t *src, counters_t *other,
+                            const bloom_t *bloom, const bitmap_t *allowed);
+static void result_release(result_t *result);
+static void filter_copy_helper(void *arg, const int key, int count);
 
 /* ranking and printing */
-static void rank_and_print(counters_t *results, const char *pageDirectory);
+static void rank_and_print(counters_t *results, const options_t *opts,
+                           const querier_t *qr, const filter_t *filter);
+static void print_result(const docscore_t *ds, const options_t *opts,
+                         const querier_t *qr);
+static void print_ranked(const docscore_t *docs, const int n,
+                         const int hidden, const options_t *opts,
+                         const querier_t *qr);
+static int collect_results(counters_t *results, docscore_t **docs_out);
 static void count_nonzero(void *arg, const int key, int count);
 static void collect_nonzero(void *arg, const int key, int count);
-static int  cmp_docscore_desc(const void *a, const void *b);
-
-/* reading URL from page files */
-static char *get_url(const char *pageDirectory, const int docID);
 
 /* main */
 /* Parse arguments, load the index, and start the query loop. */
 int
 main(const int argc, char *argv[])
 {
-  char *pageDirectory = NULL;
-  char *indexFilename = NULL;
+  options_t opts;
+  parse_args(argc, argv, &opts);
+
+  /* a closed pipe should fail our writes, not kill us, and SIGINT
+   * cancels the query running (see on_interrupt) */
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
+  action.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &action, NULL);
+  action.sa_handler = on_interrupt;
+  action.sa_flags = SA_RESTART;
+  sigaction(SIGINT, &action, NULL);
+  action.sa_handler = on_cancel;
+  sigaction(SIGUSR1, &action, NULL);
+
+  if (opts.replicas > 0) {
+    hedge_loop(&opts, argc, argv);
+    return 0;
+  }
+
+  if (opts.serveFile != NULL) {
+    serve_loop(&opts);
+    return 0;
+  }
 
-  parse_args(argc, argv, &pageDirectory, &indexFilename);
+  /* -numa replicate loads one copy of the index per node, each on a
+   * thread of that node, so the pages land in that node's memory;
+   * -numa interleave loads one copy spread over all nodes */
+  nodes_t *nodes = (opts.numa == NUMA_OFF) ? NULL : nodes_discover();
+  int nreplicas = (opts.numa == NUMA_REPLICATE) ? nodes_count(nodes) : 1;
+  replica_t replicas[NODES_MAX];
+  if (opts.numa == NUMA_REPLICATE) {
+    pthread_t tids[NODES_MAX];
+    loader_t loaders[NODES_MAX];
+    for (int r = 0; r < nreplicas; r++) {
+      loaders[r] = (loader_t) { &opts, nodes, r, &replicas[r] };
+      if (pthread_create(&tids[r], NULL, load_on_node, &loaders[r]) != 0) {
+        fprintf(stderr, "querier: cannot start threads\n");
+        exit(2);
+      }
+    }
+    for (int r = 0; r < nreplicas; r++) {
+      pthread_join(tids[r], NULL);
+    }
+  } else {
+    if (opts.numa == NUMA_INTERLEAVE && !nodes_interleave(nodes, true)) {
+      fprintf(stderr, "querier: cannot interleave memory; using the "
+              "default placement\n");
+    }
+    if (!load_replica(&opts, &replicas[0])) {
+      exit(2);
+    }
+  }
+  index_t *index = replicas[0].index;
+  postings_t *postings = replicas[0].postings;
+
+  /* host of every page, for host:/site: filters */
+  hosts_t *hosts = hosts_load(opts.pageDirectory);
+  docattrs_t *attrs = docattrs_load(opts.pageDirectory, hosts);
+  if (opts.numa == NUMA_INTERLEAVE) {
+    nodes_interleave(nodes, false);
+  }
+
+  /* near-duplicate fingerprints, computed offline by simhasher */
+  simhashes_t *simhashes = NULL;
+  if (opts.collapse) {
+    char filename[PATH_MAX];
+    snprintf(filename, sizeof(filename), "%s/%s", opts.pageDirectory,
+             SIMHASH_FILENAME);
+    simhashes = simhash_load(filename);
+    if (simhashes == NULL) {
+      fprintf(stderr, "querier: cannot read '%s'; run simhasher first\n",
+              filename);
+      exit(2);
+    }
+  }
 
+  snipper_t *snipper = NULL;
+  if (opts.snippets) {
+    snipper = snippet_new(opts.pageDirectory, SNIPPET_CACHE);
+  }
+
+  stream_t stream;
+  memset(&stream, 0, sizeof(stream));
+  cancel_t *cancel = cancel_new(opts.timeoutMs, fileno(stdout));
+  querier_t qr = { index, postings, hosts, attrs, simhashes, snipper, NULL,
+                   opts.stream ? &stream : NULL, stdout, cancel, NULL, NULL };
+
+  /* -shadow re-evaluates a sample of the queries on a thread of its
+   * own, with the counters and with the engine compared */
+  shadowing_t shadowing = { opts, qr };
+  if (opts.shadow) {
+    shadowing.opts.engine = opts.shadowEngine;
+    shadowing.qr.snipper = NULL;
+    shadowing.qr.stream = NULL;
+    shadowing.qr.out = NULL;
+    shadowing.qr.cancel = NULL;
+    evaluator_t reference = { "counters", shadow_reference, &shadowing };
+    evaluator_t candidate = { engineNames[opts.shadowEngine],
+                              shadow_candidate, &shadowing };
+    qr.shadow = shadow_new(&reference, &candidate, opts.samplePercent,
+                           opts.topK, stderr);
+    if (qr.shadow == NULL) {
+      fprintf(stderr, "querier: cannot start threads\n");
+      exit(2);
+    }
+  }
+  if (opts.workers > 0) {
+    worker_loop(&opts, &qr, nodes, replicas, nreplicas);
+  } else if (opts.inputs != NULL) {
+    mux_loop(&opts, &qr);
+  } else if (opts.listenPort >= 0) {
+    listen_loop(&opts, &qr);
+  } else if (opts.batch) {
+    qr.batch = batch_new(postings);
+    batch_loop(&opts, &qr);
+  } else {
+    query_loop(&opts, &qr);
+  }
+
+  batch_delete(qr.batch);
+  shadow_delete(qr.shadow);
+  snippet_delete(snipper);
+  simhash_delete(simhashes);
+  docattrs_delete(attrs);
+  hosts_delete(hosts);
+  for (int r = 0; r < nreplicas; r++) {
+    postings_delete(replicas[r].postings);
+    index_delete(replicas[r].index);
+  }
+  nodes_delete(nodes);
+  cancel_delete(cancel);
+  return 0;
+}
+
+/* on_interrupt */
+/* SIGINT handler: cancel the queries running; with none running, die
+ * of the signal as the querier always did.
+ */
+static void
+on_interrupt(int sig)
+{
+  if (!cancel_interrupt()) {
+    signal(sig, SIG_DFL);
+    raise(sig);
+  }
+}
+
+/* on_cancel */
+/* SIGUSR1 handler: cancel the queries running, if any. */
+static void
+on_cancel(int sig)
+{
+  cancel_interrupt();
+}
+
+/**************** output_gone ****************/
+/* see querier.h for description */
+bool
+output_gone(void)
+{
+  if (ferror(stdout)) {
+    cancel_hangup();
+  }
+  return cancel_hungup();
+}
+
+/* line_cost */
+/* Estimate the cost of answering query line, before it is parsed: the
+ * total length of its words' posting lists. Filter terms and operators
+ * cost nothing; so do words not in the index, and anything that the
+ * parser will reject.
+ */
+static long
+line_cost(postings_t *postings, const char *line)
+{
+  long cost = 0;
+  const char *p = line;
+  while (*p != '\0') {
+    p += strspn(p, " \t\r\n");
+    size_t len = strcspn(p, " \t\r\n");
+    char word[256];
+    bool plain = (len > 0 && len < sizeof(word));
+    for (size_t c = 0; plain && c < len; c++) {
+      plain = isalpha((unsigned char) p[c]);
+      word[c] = tolower((unsigned char) p[c]);
+    }
+    if (plain) {
+      word[len] = '\0';
+    }
+    if (plain && strcmp(word, "and") != 0 && strcmp(word, "or") != 0) {
+      term_t *term = postings_find(postings, word);
+      cost += (term == NULL) ? 0 : term->full.n;
+    }
+    p += len;
+  }
+  return cost;
+}
+
+/**************** load_replica ****************/
+/* see querier.h for description */
+bool
+load_replica(const options_t *opts, replica_t *replica)
+{
+  double start = timing_ms();
   index_t *index = index_new(256);
   if (index == NULL) {
     fprintf(stderr, "querier: cannot allocate index\n");
-    exit(2);
+    return false;
   }
 
-  FILE *fp = fopen(indexFilename, "r");
+  FILE *fp = fopen(opts->indexFilename, "r");
   if (fp == NULL) {
-    fprintf(stderr, "querier: cannot open index file '%s'\n", indexFilename);
+    fprintf(stderr, "querier: cannot open index file '%s'\n",
+            opts->indexFilename);
     index_delete(index);
-    exit(2);
+    return false;
   }
-  int status = index_load(fp, index); 
-  fclose(fp);
 
-  if (status != 0) {
-    fprintf(stderr, "querier: errors encountered while loading index file\n");
+  /* tiers, Bloom filters, batches, streaming and the other engines
+   * (answering, or in shadow) need docID-sorted postings, and -lanes
+   * their lengths; the counters are then built from the postings, so
+   * the file is read once either way */
+  postings_t *postings = NULL;
+  if (opts->tiered || opts->bloom || opts->plan || opts->batch
+      || opts->compressed || opts->stream || opts->engine != ENGINE_TAAT
+      || opts->shadow || opts->lanes > 0) {
+    postings = postings_load(fp);
+    fclose(fp);
+    if (postings == NULL) {
+      fprintf(stderr, "querier: cannot load postings from '%s'\n",
+              opts->indexFilename);
+      index_delete(index);
+      return false;
+    }
+    postings_iterate(postings, index, index_term);
+    if (opts->tiered || opts->stream) {
+      postings_tier(postings, TIER1_FRACTION, TIER1_MIN);
+    }
+    if (opts->bloom) {
+      postings_bloom(postings, BLOOM_MIN, BLOOM_BITS);
+    }
+    if (opts->plan) {
+      postings_sketch(postings);
+    }
+    if (opts->compressed) {
+      postings_compress(postings, opts->cacheBlocks);  // last: drops arrays
+    }
+  } else {
+    int status = index_load(fp, index);
+    fclose(fp);
+    if (status != 0) {
+      fprintf(stderr, "querier: errors encountered while loading index file\n");
+    }
   }
 
-  query_loop(pageDirectory, index);
+  replica->index = index;
+  replica->postings = postings;
+  replica->msload = timing_ms() - start;
+  return true;
+}
 
-  index_delete(index);
-  return 0;
+/* index_term */
+/* Add one term's postings to the index (arg), as index_load would have
+ * read them from the file: in docID order.
+ */
+static void
+index_term(void *arg, const char *word, term_t *term)
+{
+  index_t *index = arg;
+  if (term->full.n == 0) {
+    return;
+  }
+  index_add(index, word, term->full.docs[0]);   // makes its counters
+  counters_t *counts = index_find(index, word);
+  for (int i = 0; i < term->full.n; i++) {
+    counters_set(counts, term->full.docs[i], term->full.counts[i]);
+  }
+}
+
+/* load_on_node */
+/* Thread body: pin to the loader's node, then load its replica there.
+ * arg is a loader_t.
+ */
+static void *
+load_on_node(void *arg)
+{
+  loader_t *loader = arg;
+  if (!nodes_bind(loader->nodes, loader->node)) {
+    fprintf(stderr, "querier: cannot run on node %d\n",
+            nodes_id(loader->nodes, loader->node));
+  }
+  if (!load_replica(loader->opts, loader->replica)) {
+    exit(2);
+  }
+  return NULL;
 }
 
 /* parse_args */
-/* Parse and validate the command-line arguments.
+/* Parse and validate the command-line arguments into *opts.
  *
  * We expect:
- *   ./querier pageDirectory indexFilename
+ *   ./querier [options] pageDirectory indexFilename
  *
  * We exit non-zero if:
- *   - wrong number of arguments
+ *   - wrong number of arguments, or an unknown or malformed option
  *   - pageDirectory is not a crawler-produced directory
  *   - indexFilename is not readable
  */
 static void
-parse_args(const int argc, char *argv[],
-           char **pageDirectory, char **indexFilename)
+parse_args(const int argc, char *argv[], options_t *opts)
 {
-  if (argv == NULL || pageDirectory == NULL || indexFilename == NULL) {
+  if (argv == NULL || opts == NULL) {
     fprintf(stderr, "querier: parse_args got NULL parameter\n");
     exit(1);
   }
 
-  if (argc != 3) {
-    fprintf(stderr, "usage: %s pageDirectory indexFilename\n", argv[0]);
-    exit(1);
+  opts->pageDirectory = NULL;
+  opts->indexFilename = NULL;
+  opts->topK = 0;
+  opts->tiered = false;
+  opts->collapse = false;
+  opts->snippets = false;
+  opts->engine = ENGINE_TAAT;
+  opts->stats = false;
+  opts->bloom = false;
+  opts->plan = false;
+  opts->batch = false;
+  opts->compressed = false;
+  opts->cacheBlocks = 0;
+  opts->nofast = false;
+  opts->stream = false;
+  opts->workers = 0;
+  opts->numa = NUMA_OFF;
+  opts->lanes = 0;
+  opts->slowCost = 0;
+  opts->timeoutMs = 0;
+  opts->serveFile = NULL;
+  opts->budgetKB = 0;
+  opts->shadow = false;
+  opts->shadowEngine = ENGINE_TAAT;
+  opts->samplePercent = 0;
+  opts->inputs = NULL;
+  opts->slice = -1;
+  opts->listenPort = -1;
+  opts->listenIO = LISTEN_URING;
+  bool ioGiven = false;
+  opts->replicas = 0;
+  opts->hedgePercent = -1;
+  opts->threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  if (opts->threads < 1) {
+    opts->threads = 1;
   }
 
-  *pageDirectory = argv[1];
-  *indexFilename = argv[2];
+  /* options come first, and all start with '-' */
+  int i = 1;
+  for (; i < argc && argv[i][0] == '-'; i++) {
+    if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->topK, &extra) != 1
+          || opts->topK <= 0) {
+        fprintf(stderr, "querier: -k needs a positive integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-tiered") == 0) {
+      opts->tiered = true;
+    } else if (strcmp(argv[i], "-collapse") == 0) {
+      opts->collapse = true;
+    } else if (strcmp(argv[i], "-snippets") == 0) {
+      opts->snippets = true;
+    } else if (strcmp(argv[i], "-engine") == 0 && i + 1 < argc) {
+      i++;
+      int e = 0;
+      while (e <= ENGINE_AUTO && strcmp(argv[i], engineNames[e]) != 0) {
+        e++;
+      }
+      if (e > ENGINE_AUTO) {
+        fprintf(stderr, "querier: -engine must be taat, daat, block or "
+                "auto\n");
+        usage(argv[0]);
+      }
+      opts->engine = e;
+    } else if (strcmp(argv[i], "-stats") == 0) {
+      opts->stats = true;
+    } else if (strcmp(argv[i], "-bloom") == 0) {
+      opts->bloom = true;
+    } else if (strcmp(argv[i], "-plan") == 0) {
+      opts->plan = true;
+    } else if (strcmp(argv[i], "-batch") == 0) {
+      opts->batch = true;
+    } else if (strcmp(argv[i], "-compressed") == 0) {
+      opts->compressed = true;
+    } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->threads, &extra) != 1
+          || opts->threads <= 0) {
+        fprintf(stderr, "querier: -threads needs a positive integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-nofast") == 0) {
+      opts->nofast = true;
+    } else if (strcmp(argv[i], "-stream") == 0) {
+      opts->stream = true;
+    } else if (strcmp(argv[i], "-workers") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->workers, &extra) != 1
+          || opts->workers <= 0 || opts->workers > WORKERS_MAX) {
+        fprintf(stderr, "querier: -workers needs an integer from 1 to %d\n",
+                WORKERS_MAX);
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-lanes") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->lanes, &extra) != 1
+          || opts->lanes <= 0) {
+        fprintf(stderr, "querier: -lanes needs a positive integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-slowcost") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->slowCost, &extra) != 1
+          || opts->slowCost < 0) {
+        fprintf(stderr, "querier: -slowcost needs a non-negative "
+                "integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-numa") == 0 && i + 1 < argc) {
+      i++;
+      int m = NUMA_REPLICATE;
+      while (m <= NUMA_INTERLEAVE && strcmp(argv[i], numaNames[m]) != 0) {
+        m++;
+      }
+      if (m > NUMA_INTERLEAVE) {
+        fprintf(stderr, "querier: -numa must be replicate or interleave\n");
+        usage(argv[0]);
+      }
+      opts->numa = m;
+    } else if (strcmp(argv[i], "-timeout") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->timeoutMs, &extra) != 1
+          || opts->timeoutMs <= 0) {
+        fprintf(stderr, "querier: -timeout needs a positive integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-serve") == 0 && i + 1 < argc) {
+      opts->serveFile = argv[++i];
+    } else if (strcmp(argv[i], "-budget") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->budgetKB, &extra) != 1
+          || opts->budgetKB <= 0) {
+        fprintf(stderr, "querier: -budget needs a positive integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-shadow") == 0 && i + 1 < argc) {
+      i++;
+      int e = 0;
+      while (e <= ENGINE_AUTO && strcmp(argv[i], engineNames[e]) != 0) {
+        e++;
+      }
+      if (e > ENGINE_AUTO) {
+        fprintf(stderr, "querier: -shadow must be taat, daat, block or "
+                "auto\n");
+        usage(argv[0]);
+      }
+      opts->shadow = true;
+      opts->shadowEngine = e;
+    } else if (strcmp(argv[i], "-sample") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->samplePercent, &extra) != 1
+          || opts->samplePercent < 1 || opts->samplePercent > 100) {
+        fprintf(stderr, "querier: -sample needs an integer from 1 to 100\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-inputs") == 0 && i + 1 < argc) {
+      opts->inputs = argv[++i];
+      int n = 1;
+      for (const char *c = opts->inputs; *c != '\0'; c++) {
+        n += (*c == ',');
+      }
+      if (n > INPUTS_MAX || opts->inputs[0] == '\0'
+          || strstr(opts->inputs, ",,") != NULL
+          || opts->inputs[0] == ','
+          || opts->inputs[strlen(opts->inputs) - 1] == ',') {
+        fprintf(stderr, "querier: -inputs needs 1 to %d names, separated "
+                "by commas\n", INPUTS_MAX);
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-slice") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->slice, &extra) != 1
+          || opts->slice < 0) {
+        fprintf(stderr, "querier: -slice needs a non-negative integer\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-listen") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->listenPort, &extra) != 1
+          || opts->listenPort < 0 || opts->listenPort > 65535) {
+        fprintf(stderr, "querier: -listen needs a port from 0 to 65535\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-io") == 0 && i + 1 < argc) {
+      i++;
+      if (strcmp(argv[i], listener_io_name(LISTEN_URING)) == 0) {
+        opts->listenIO = LISTEN_URING;
+      } else if (strcmp(argv[i], listener_io_name(LISTEN_EPOLL)) == 0) {
+        opts->listenIO = LISTEN_EPOLL;
+      } else {
+        fprintf(stderr, "querier: -io must be uring or epoll\n");
+        usage(argv[0]);
+      }
+      ioGiven = true;
+    } else if (strcmp(argv[i], "-replicas") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->replicas, &extra) != 1
+          || opts->replicas < 1 || opts->replicas > HEDGER_MAX) {
+        fprintf(stderr, "querier: -replicas needs an integer from 1 to %d\n",
+                HEDGER_MAX);
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-hedge") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->hedgePercent, &extra) != 1
+          || opts->hedgePercent < 0 || opts->hedgePercent > 99) {
+        fprintf(stderr, "querier: -hedge needs an integer from 0 to 99\n");
+        usage(argv[0]);
+      }
+    } else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc) {
+      char extra;
+      if (sscanf(argv[++i], "%d%c", &opts->cacheBlocks, &extra) != 1
+          || opts->cacheBlocks <= 0) {
+        fprintf(stderr, "querier: -cache needs a positive integer\n");
+        usage(argv[0]);
+      }
+    } else {
+      usage(argv[0]);
+    }
+  }
 
+  if (argc - i != ((opts->serveFile == NULL) ? 2 : 0)) {
+    usage(argv[0]);
+  }
+  if (opts->budgetKB > 0 && opts->serveFile == NULL) {
+    fprintf(stderr, "querier: -budget requires -serve\n");
+    usage(argv[0]);
+  }
+  if (opts->serveFile != NULL) {
+    if (opts->numa != NUMA_OFF || opts->batch || opts->stream
+        || opts->compressed) {
+      fprintf(stderr, "querier: -serve cannot be used with -numa, -batch, "
+              "-stream or -compressed\n");
+      usage(argv[0]);
+    }
+    if (opts->budgetKB == 0) {
+      opts->budgetKB = SERVE_BUDGET;
+    }
+    if (opts->workers == 0) {
+      long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+      opts->workers = (ncpus < 1) ? 1 : (ncpus > WORKERS_MAX) ? WORKERS_MAX
+        : (int) ncpus;
+    }
+  }
+  if (opts->samplePercent > 0 && !opts->shadow) {
+    fprintf(stderr, "querier: -sample requires -shadow\n");
+    usage(argv[0]);
+  }
+  if (opts->shadow) {
+    if (opts->serveFile != NULL || opts->batch || opts->stream
+        || opts->compressed) {
+      fprintf(stderr, "querier: -shadow cannot be used with -serve, -batch, "
+              "-stream or -compressed\n");
+      usage(argv[0]);
+    }
+    if (opts->samplePercent == 0) {
+      opts->samplePercent = SHADOW_PERCENT;
+    }
+  }
+  if (opts->tiered && opts->topK == 0) {
+    fprintf(stderr, "querier: -tiered requires -k\n");
+    usage(argv[0]);
+  }
+  if (opts->cacheBlocks > 0 && !opts->compressed) {
+    fprintf(stderr, "querier: -cache requires -compressed\n");
+    usage(argv[0]);
+  }
+  if (opts->cacheBlocks == 0) {
+    opts->cacheBlocks = PCACHE_BLOCKS;
+  }
+  if (opts->numa != NUMA_OFF && opts->workers == 0) {
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    opts->workers = (ncpus < 1) ? 1 : (ncpus > WORKERS_MAX) ? WORKERS_MAX
+      : (int) ncpus;
+  }
+  if (opts->slowCost > 0 && opts->lanes == 0) {
+    fprintf(stderr, "querier: -slowcost requires -lanes\n");
+    usage(argv[0]);
+  }
+  if (opts->lanes > 0) {
+    if (opts->lanes >= opts->workers || opts->numa != NUMA_OFF
+        || opts->serveFile != NULL) {
+      fprintf(stderr, "querier: -lanes needs -workers greater than it, and "
+              "cannot be used with -numa or -serve\n");
+      usage(argv[0]);
+    }
+    if (opts->slowCost == 0) {
+      opts->slowCost = LANE_COST;
+    }
+  }
+  if (opts->slice >= 0 && opts->inputs == NULL) {
+    fprintf(stderr, "querier: -slice requires -inputs\n");
+    usage(argv[0]);
+  }
+  if (opts->inputs != NULL) {
+    if (opts->workers > 0 || opts->serveFile != NULL || opts->batch
+        || opts->stream || opts->compressed || opts->tiered
+        || opts->shadow || opts->timeoutMs > 0) {
+      fprintf(stderr, "querier: -inputs cannot be used with -workers, "
+              "-numa, -serve, -batch, -stream, -compressed, -tiered, "
+              "-shadow or -timeout\n");
+      usage(argv[0]);
+    }
+    if (opts->engine == ENGINE_BLOCK || opts->engine == ENGINE_AUTO) {
+      fprintf(stderr, "querier: -inputs evaluates with -engine daat\n");
+      usage(argv[0]);
+    }
+    opts->engine = ENGINE_DAAT;       // the engine that can take turns
+    if (opts->slice < 0) {
+      opts->slice = SLICE_POSTINGS;
+    }
+  }
+  if (opts->hedgePercent >= 0 && opts->replicas == 0) {
+    fprintf(stderr, "querier: -hedge requires -replicas\n");
+    usage(argv[0]);
+  }
+  if (opts->replicas > 0) {
+    if (opts->workers > 0 || opts->serveFile != NULL || opts->batch
+        || opts->stream || opts->inputs != NULL || opts->listenPort >= 0) {
+      fprintf(stderr, "querier: -replicas cannot be used with -workers, "
+              "-numa, -serve, -batch, -stream, -inputs or -listen\n");
+      usage(argv[0]);
+    }
+    if (opts->hedgePercent < 0) {
+      opts->hedgePercent = HEDGE_PERCENT;
+    }
+  }
+  if (ioGiven && opts->listenPort < 0) {
+    fprintf(stderr, "querier: -io requires -listen\n");
+    usage(argv[0]);
+  }
+  if (opts->listenPort >= 0 && (opts->workers > 0 || opts->serveFile != NULL
+                                || opts->batch || opts->stream
+                                || opts->inputs != NULL)) {
+    fprintf(stderr, "querier: -listen cannot be used with -workers, -numa, "
+            "-serve, -batch, -stream or -inputs\n");
+    usage(argv[0]);
+  }
+  if (opts->workers > 0 && (opts->batch || opts->stream
+                            || opts->compressed)) {
+    fprintf(stderr, "querier: -workers and -numa cannot be used with "
+            "-batch, -stream or -compressed\n");
+    usage(argv[0]);
+  }
+  if (opts->compressed && opts->engine == ENGINE_DAAT && !opts->batch) {
+    fprintf(stderr, "querier: -engine daat cannot read -compressed "
+            "postings\n");
+    usage(argv[0]);
+  }
+
+  if (opts->serveFile != NULL) {
+    return;                   // the indexes are checked by read_config
+  }
+  opts->pageDirectory = argv[i];
+  opts->indexFilename = argv[i+1];
+  if (!valid_files(opts->pageDirectory, opts->indexFilename)) {
+    exit(1);
+  }
+}
+
+/**************** valid_files ****************/
+/* see querier.h for description */
+bool
+valid_files(const char *pageDirectory, const char *indexFilename)
+{
   // validate pageDirectory by checking for pageDirectory/.crawler
   char crawlerPath[PATH_MAX];
-  snprintf(crawlerPath, sizeof(crawlerPath), "%s/.crawler", *pageDirectory);
+  snprintf(crawlerPath, sizeof(crawlerPath), "%s/.crawler", pageDirectory);
   FILE *cp = fopen(crawlerPath, "r");
   if (cp == NULL) {
     fprintf(stderr, "querier: '%s' is not a crawler directory\n",
-            *pageDirectory);
-    exit(1);
+            pageDirectory);
+    return false;
   }
   fclose(cp);
 
   // validate index file can be read
-  FILE *ip = fopen(*indexFilename, "r");
+  FILE *ip = fopen(indexFilename, "r");
   if (ip == NULL) {
-    fprintf(stderr, "querier: cannot read index file '%s'\n", *indexFilename);
-    exit(1);
+    fprintf(stderr, "querier: cannot read index file '%s'\n",
+            indexFilename);
+    return false;
   }
   fclose(ip);
+  return true;
 }
 
-/* prompt */
-/* Print a prompt only if stdin is a terminal (interactive use). */
+/* usage */
+/* Print the usage message and exit non-zero. */
 static void
+usage(const char *progName)
+{
+  fprintf(stderr, "usage: %s [-k K] [-tiered] [-collapse] [-snippets] "
+          "[-engine taat|daat|block|auto] [-stats] [-bloom] [-plan] "
+          "[-batch] [-compressed] [-cache N] [-nofast] [-threads N] "
+          "[-stream] [-workers N [-lanes S [-slowcost C]]] "
+          "[-numa replicate|interleave] "
+          "[-timeout MS] [-shadow taat|daat|block|auto [-sample PCT]] "
+          "[-budget KB] [-inputs F,... [-slice N]] "
+          "[-listen PORT [-io uring|epoll]] [-replicas N [-hedge P]] "
+          "(pageDirectory indexFilename | -serve indexesFile)\n",
+          progName);
+  exit(1);
+}
+
+/**************** prompt ****************/
+/* see querier.h for description */
+void
 prompt(void)
 {
   if (isatty(fileno(stdin))) {
@@ -194,53 +1087,809 @@ prompt(void)
  * validate the syntax, evaluate the query, and print ranked results.
  */
 static void
-query_loop(const char *pageDirectory, index_t *index)
+query_loop(const options_t *opts, querier_t *qr)
 {
-  if (pageDirectory == NULL || index == NULL) {
+  if (opts == NULL || qr == NULL || qr->index == NULL) {
     fprintf(stderr, "querier: query_loop got NULL parameter\n");
     return;
   }
 
-  char line[1024];
-
-  prompt();
-  while (fgets(line, sizeof(line), stdin) != NULL) {
-
-    char **words = NULL;
-    int nwords = 0;
+  char line[1024];
+  stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+
+  prompt();
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    char **words = NULL;
+    int nwords = 0;
+    filter_t filter;
+
+    if (read_query(line, &words, &nwords, &filter)) {
+      print_query(words, nwords, &filter, stdout);
+      answer_query(opts, qr, words, nwords, &filter, &stats);
+      mem_free(words);
+    }
+    fflush(stdout);               // a program on a pipe waits for it
+    if (output_gone()) {
+      break;
+    }
+    prompt();
+  }
+
+  printf("\n");
+  print_stats(opts, qr, &stats);
+}
+
+/* batch_loop */
+/* Read every query from stdin first (printing any errors as we go),
+ * register them all with the batch, then answer them in order. The
+ * output is the same as query_loop's, without prompts.
+ */
+static void
+batch_loop(const options_t *opts, querier_t *qr)
+{
+  char line[1024];
+  stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+
+  int npending = 0, cap = 64;
+  pending_t *pending = mem_malloc_assert(cap * sizeof(pending_t),
+                                         "batch_loop");
+  while (fgets(line, sizeof(line), stdin) != NULL) {
+    if (npending == cap) {
+      cap *= 2;
+      pending_t *bigger = mem_malloc_assert(cap * sizeof(pending_t),
+                                            "batch_loop");
+      memcpy(bigger, pending, npending * sizeof(pending_t));
+      mem_free(pending);
+      pending = bigger;
+    }
+    pending_t *p = &pending[npending];
+    p->line = mem_malloc_assert(strlen(line) + 1, "batch_loop");
+    strcpy(p->line, line);
+    if (read_query(p->line, &p->words, &p->nwords, &p->filter)) {
+      npending++;
+    } else {
+      mem_free(p->line);
+    }
+  }
+
+  /* count what the queries have in common */
+  for (int i = 0; i < npending; i++) {
+    char key[FILTER_KEYMAX];
+    filter_key(&pending[i].filter, key, sizeof(key));
+    query_t *query = query_new(pending[i].words, pending[i].nwords);
+    batch_plan(qr->batch, query, key);
+    query_delete(query);
+  }
+
+  for (int i = 0; i < npending; i++) {
+    pending_t *p = &pending[i];
+    if (!output_gone()) {
+      print_query(p->words, p->nwords, &p->filter, stdout);
+      answer_query(opts, qr, p->words, p->nwords, &p->filter, &stats);
+    }
+    mem_free(p->words);
+    mem_free(p->line);
+  }
+  mem_free(pending);
+
+  printf("\n");
+  print_stats(opts, qr, &stats);
+}
+
+/* listen_loop */
+/* With -listen: answer the query lines that clients send over TCP, on
+ * this thread, until stdin reaches end of file. Each line is answered
+ * as worker_answer would (so a connection gets what stdout would
+ * have), with no output watched for a hangup: a client that goes away
+ * just stops getting answers. Nothing goes to stdout; the listener's
+ * counts go to stderr.
+ */
+static void
+listen_loop(const options_t *opts, querier_t *qr)
+{
+  listener_t *listener = listener_new(opts->listenPort, opts->listenIO);
+  if (listener == NULL) {
+    exit(2);
+  }
+  const char *io = listener_io_name(listener_io(listener));
+  fprintf(stderr, "querier: listening on port %d (%s)\n",
+          listener_port(listener), io);
+
+  worker_t worker;
+  memset(&worker, 0, sizeof(worker));
+  worker.opts = opts;
+  worker.qr = *qr;
+  worker.qr.cancel = cancel_new(opts->timeoutMs, -1);
+  listener_run(listener, worker_answer, &worker);
+
+  listenstats_t ls;
+  listener_stats(listener, &ls);
+  print_stats(opts, qr, &worker.stats);
+  fprintf(stderr, "querier: listen (%s): %ld connections, %ld queries, "
+          "%ld system calls (%.2f per query, %ld waits), %ld bytes in, "
+          "%ld out; %.3f ms serving, %.3f ms answering\n", io,
+          ls.connections, ls.queries, ls.syscalls,
+          ls.queries == 0 ? 0.0 : (double) ls.syscalls / ls.queries,
+          ls.waits, ls.bytesIn, ls.bytesOut, ls.msserving, ls.msanswering);
+  cancel_delete(worker.qr.cancel);
+  listener_delete(listener);
+}
+
+/* hedge_loop */
+/* With -replicas: run opts->replicas copies of this querier, with the
+ * same command line less -replicas and -hedge, and answer stdin's
+ * queries through them (see hedger.h). Each copy loads the index for
+ * itself; this process loads nothing.
+ */
+static void
+hedge_loop(const options_t *opts, const int argc, char *argv[])
+{
+  char **command = mem_calloc_assert(argc + 1, sizeof(char *), "hedge_loop");
+  int n = 0;
+  for (int a = 0; a < argc; a++) {
+    if (a > 0 && (strcmp(argv[a], "-replicas") == 0
+                  || strcmp(argv[a], "-hedge") == 0)) {
+      a++;                    // and its value
+    } else {
+      command[n++] = argv[a];
+    }
+  }
+  command[n] = NULL;
+
+  hedger_t *hedger = hedger_new(opts->replicas, command, opts->hedgePercent);
+  for (int r = 0; r < opts->replicas; r++) {
+    fprintf(stderr, "querier: replica %d is process %d\n", r,
+            (int) hedger_pid(hedger, r));
+  }
+  hedger_run(hedger, stdout);
+  printf("\n");
+  fflush(stdout);
+
+  hedgerstats_t hs;
+  hedger_stats(hedger, &hs);
+  char after[64] = "never";
+  if (opts->hedgePercent > 0) {
+    snprintf(after, sizeof(after), "after the p%d (last %.3f ms)",
+             opts->hedgePercent, hs.msdelay);
+  }
+  fprintf(stderr, "querier: replicas: %d processes, %ld queries, %ld hedged "
+          "(%.1f%%) %s, %ld won by the hedge, %ld cancelled; latency p50 "
+          "%.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+          opts->replicas, hs.queries, hs.hedged,
+          hs.queries == 0 ? 0.0 : 100.0 * hs.hedged / hs.queries, after,
+          hs.hedgeWins, hs.cancelled, hs.p50, hs.p95, hs.p99, hs.max);
+  for (int r = 0; r < opts->replicas; r++) {
+    fprintf(stderr, "querier: replica %d: %ld queries sent, %ld answers "
+            "taken\n", r, hs.sent[r], hs.used[r]);
+  }
+  hedger_delete(hedger);
+  mem_free(command);
+}
+
+/* worker_loop */
+/* Read queries from stdin and answer them on opts->workers threads,
+ * printing the answers in the order the queries came in. With -numa,
+ * worker w runs on node w % (number of nodes) and reads that node's
+ * replica (the only one, with -numa interleave); otherwise workers run
+ * anywhere and share replicas[0]. Each worker has its own snippet
+ * cache and statistics, added up at the end.
+ */
+static void
+worker_loop(const options_t *opts, const querier_t *qr,
+            const nodes_t *nodes, const replica_t *replicas,
+            const int nreplicas)
+{
+  int nnodes = (nodes == NULL) ? 1 : nodes_count(nodes);
+  int nworkers = opts->workers;
+  worker_t *workers = mem_calloc_assert(nworkers, sizeof(worker_t),
+                                        "worker_loop");
+  void *ctxs[WORKERS_MAX];
+  int queueOf[WORKERS_MAX];
+  for (int w = 0; w < nworkers; w++) {
+    worker_t *worker = &workers[w];
+    const replica_t *replica = &replicas[(nreplicas == 1) ? 0 : w % nnodes];
+    worker->opts = opts;
+    worker->nodes = nodes;
+    worker->node = w % nnodes;
+    worker->qr = *qr;
+    worker->qr.index = replica->index;
+    worker->qr.postings = replica->postings;
+    worker->qr.snipper = opts->snippets
+      ? snippet_new(opts->pageDirectory, SNIPPET_CACHE) : NULL;
+    worker->qr.cancel = cancel_new(opts->timeoutMs, fileno(stdout));
+    queueOf[w] = worker->node;
+    if (opts->lanes > 0) {
+      queueOf[w] = (w < nworkers - opts->lanes) ? LANE_FAST : LANE_SLOW;
+    }
+    ctxs[w] = worker;
+  }
+  /* a node with no worker gets no queue */
+  int nqueues = (nworkers < nnodes) ? nworkers : nnodes;
+  if (opts->lanes > 0) {
+    nqueues = 2;
+  }
+  workers_t *pool = workers_new(nworkers, nqueues, queueOf, ctxs,
+                                (nodes == NULL) ? NULL : worker_start,
+                                worker_answer);
+  /* in lanes, a cheap query's answer need not wait for an earlier
+   * expensive one's */
+  workers_output(pool, stdout, opts->lanes == 0);
+
+  bool interactive = isatty(fileno(stdin));
+  int window = interactive ? 0 : WORKERS_WINDOW * nworkers;
+  char line[1024];
+  prompt();
+  while (fgets(line, sizeof(line), stdin) != NULL && !output_gone()) {
+    if (opts->lanes > 0) {
+      int lane = (line_cost(qr->postings, line) > opts->slowCost)
+        ? LANE_SLOW : LANE_FAST;
+      workers_submit_to(pool, lane, line);
+    } else {
+      workers_submit(pool, line);
+    }
+    workers_drain(pool, window, stdout);
+    prompt();
+  }
+  workers_drain(pool, 0, stdout);
+  printf("\n");
+
+  for (int q = 0; q < nqueues; q++) {
+    workerstats_t ws;
+    workers_stats(pool, q, &ws);
+    if (opts->lanes > 0) {
+      fprintf(stderr, "querier: %s lane:", (q == LANE_FAST) ? "fast" : "slow");
+    } else if (nodes == NULL) {
+      fprintf(stderr, "querier: workers:");
+    } else {
+      fprintf(stderr, "querier: node %d (cpus %s):", nodes_id(nodes, q),
+              nodes_cpus(nodes, q));
+    }
+    fprintf(stderr, " %d workers, %ld queries, %.3f ms answering, "
+            "%.3f ms mean latency", ws.nworkers, ws.jobs, ws.msbusy,
+            ws.jobs == 0 ? 0.0 : ws.mslatency / ws.jobs);
+    if (opts->numa == NUMA_REPLICATE) {
+      fprintf(stderr, "; replica loaded in %.1f ms", replicas[q].msload);
+    }
+    fprintf(stderr, "\n");
+  }
+  if (opts->numa == NUMA_INTERLEAVE) {
+    fprintf(stderr, "querier: index interleaved over %d nodes, loaded in "
+            "%.1f ms\n", nnodes, replicas[0].msload);
+  }
+  workers_delete(pool);
+
+  stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+  querier_t report = *qr;
+  report.snipper = NULL;      // each worker had its own; see below
+  long hits = 0, misses = 0;
+  for (int w = 0; w < nworkers; w++) {
+    stats_add(&stats, &workers[w].stats);
+    if (workers[w].qr.snipper != NULL) {
+      int h, m;
+      snippet_stats(workers[w].qr.snipper, &h, &m);
+      hits += h;
+      misses += m;
+      snippet_delete(workers[w].qr.snipper);
+    }
+    cancel_delete(workers[w].qr.cancel);
+  }
+  print_stats(opts, &report, &stats);
+  if (opts->snippets) {
+    fprintf(stderr, "querier: snippet caches: %ld hits, %ld misses\n",
+            hits, misses);
+  }
+  mem_free(workers);
+}
+
+/* worker_start */
+/* Pin a worker's thread to its node. arg is a worker_t. */
+static void
+worker_start(void *arg)
+{
+  worker_t *worker = arg;
+  if (!nodes_bind(worker->nodes, worker->node)) {
+    fprintf(stderr, "querier: cannot run a worker on node %d\n",
+            nodes_id(worker->nodes, worker->node));
+  }
+}
+
+/* worker_answer */
+/* Answer one line of input onto out, as query_loop would on stdout.
+ * arg is the worker_t of the thread.
+ */
+static void
+worker_answer(void *arg, char *line, FILE *out)
+{
+  worker_t *worker = arg;
+  char **words = NULL;
+  int nwords = 0;
+  filter_t filter;
+
+  worker->qr.out = out;
+  if (read_query(line, &words, &nwords, &filter)) {
+    print_query(words, nwords, &filter, out);
+    answer_query(worker->opts, &worker->qr, words, nwords, &filter,
+                 &worker->stats);
+    mem_free(words);
+  }
+}
+
+/* shadow_reference */
+/* evalfn_t for -shadow's reference: TAAT's general loop over the
+ * index's counters, with no sorted postings, fast paths or Bloom
+ * filters. arg is the shadowing_t.
+ */
+static int
+shadow_reference(void *arg, char **words, const int nwords,
+                 const bitmap_t *allowed, docscore_t **docs_out)
+{
+  shadowing_t *shadowing = arg;
+  result_t results = evaluate_query(shadowing->qr.index, NULL, words, nwords,
+                                    allowed, NULL);
+  int n = collect_results(results.ctrs, docs_out);
+  result_release(&results);
+  return n;
+}
+
+/* shadow_candidate */
+/* evalfn_t for the engine -shadow compares: evaluate as
+ * evaluate_and_print would with -engine set to it, stopping short of
+ * the ranking. arg is the shadowing_t.
+ */
+static int
+shadow_candidate(void *arg, char **words, const int nwords,
+                 const bitmap_t *allowed, docscore_t **docs_out)
+{
+  shadowing_t *shadowing = arg;
+  const options_t *opts = &shadowing->opts;
+  const querier_t *qr = &shadowing->qr;
+  query_t *query = query_new(words, nwords);
+  int n = 0;
+  *docs_out = NULL;
+
+  engine_t engine = choose_engine(opts, qr, query);
+  if (engine == ENGINE_DAAT) {
+    n = daat_evaluate(qr->postings, query, allowed, opts->topK, NULL,
+                      docs_out);
+  } else if (engine == ENGINE_BLOCK) {
+    n = blocks_evaluate(qr->postings, query, allowed, NULL, docs_out);
+  } else {
+    shape_t shape = opts->nofast ? SHAPE_GENERIC : query_shape(words, nwords);
+    if (shape != SHAPE_GENERIC) {
+      n = evaluate_shape(qr, shape, words, nwords, allowed, NULL, docs_out);
+    } else {
+      result_t results = evaluate_query(qr->index, qr->postings, words,
+                                        nwords, allowed, NULL);
+      n = collect_results(results.ctrs, docs_out);
+      result_release(&results);
+    }
+  }
+  query_delete(query);
+  return n;
+}
+
+/**************** stats_add ****************/
+/* see querier.h for description */
+void
+stats_add(stats_t *dest, const stats_t *src)
+{
+  dest->nqueries += src->nqueries;
+  dest->ntier1 += src->ntier1;
+  for (int e = 0; e < NUM_ENGINES; e++) {
+    dest->nengine[e] += src->nengine[e];
+    dest->msengine[e] += src->msengine[e];
+  }
+  dest->msbatch += src->msbatch;
+  for (int f = 0; f < NUM_SHAPES; f++) {
+    dest->nshape[f] += src->nshape[f];
+  }
+  for (int r = 0; r < CANCEL_REASONS; r++) {
+    dest->ncancelled[r] += src->ncancelled[r];
+  }
+  dest->mscancel += src->mscancel;
+}
+
+/**************** read_query ****************/
+/* see querier.h for description */
+bool
+read_query(char *line, char ***words_out, int *nwords_out, filter_t *filter)
+{
+  char **words = NULL;
+  int nwords = 0;
+
+  if (!extract_filters(line, filter)) {
+    /* bad filter term; error already printed */
+    return false;
+  }
+
+  if (!tokenize_and_validate(line, &words, &nwords)) {
+    /* invalid query; error already printed */
+    if (words != NULL) {
+      mem_free(words);
+    }
+    return false;
+  }
+
+  if (nwords == 0) {
+    /* blank line (or only filters); nothing to do */
+    if (filter->echo[0] != '\0') {
+      fprintf(stderr, "Error: filters need at least one word\n");
+    }
+    mem_free(words);
+    return false;
+  }
+
+  *words_out = words;
+  *nwords_out = nwords;
+  return true;
+}
+
+/**************** print_query ****************/
+/* see querier.h for description */
+void
+print_query(char **words, const int nwords, const filter_t *filter,
+            FILE *out)
+{
+  fprintf(out, "Query:");
+  for (int i = 0; i < nwords; i++) {
+    fprintf(out, " %s", words[i]);
+  }
+  fprintf(out, "%s\n", filter->echo);
+}
+
+/**************** answer_query ****************/
+/* see querier.h for description */
+void
+answer_query(const options_t *opts, querier_t *qr, char **words,
+             const int nwords, const filter_t *filter, stats_t *stats)
+{
+  cancel_start(qr->cancel);
+  evaluate_and_print(opts, qr, words, nwords, filter, stats);
+  if (shadow_sample(qr->shadow)) {
+    bitmap_t *allowed = filter_bitmap(filter, qr->hosts);
+    shadow_submit(qr->shadow, words, nwords, allowed);
+    bitmap_delete(allowed);
+  }
+  cancel_reason_t reason = cancel_reason(qr->cancel);
+  if (reason != CANCEL_NONE) {
+    stats->ncancelled[reason]++;
+    stats->mscancel += cancel_latency(qr->cancel);
+  }
+  cancel_finish(qr->cancel);
+}
+
+/* evaluate_and_print */
+/* Evaluate one validated query and print its ranked results.
+ *
+ * With -tiered, tier 1 is tried first; otherwise (or if tier 1 cannot
+ * prove its answer) the query goes to the batch, with -batch, or else
+ * to the engine chosen for it.
+ *
+ * With -stream, the leading results tier 1 proves final are printed
+ * before any of that; the rest follow once the query is evaluated, and
+ * the count comes last. Tier 1 alone never answers then, since only the
+ * full evaluation knows the count.
+ *
+ * The engines check qr->cancel as they go, and stop early if it says
+ * so; their results are then dropped, and the query reported cancelled.
+ */
+static void
+evaluate_and_print(const options_t *opts, querier_t *qr, char **words,
+                   const int nwords, const filter_t *filter, stats_t *stats)
+{
+  snippet_query(qr->snipper, words, nwords);
+
+  /* the documents the filters allow; NULL means all */
+  bitmap_t *allowed = filter_bitmap(filter, qr->hosts);
+  query_t *query = query_new(words, nwords);
+  stats->nqueries++;
+
+  /* predicates, attribute sorts and collapsing all change which
+   * documents make the top K, after evaluation */
+  bool plainRanking = (filter->npreds == 0 && !filter->sorted
+                       && qr->simhashes == NULL);
+
+  /* tier 1's proof is about score order, so only plain rankings */
+  if (qr->stream != NULL) {
+    qr->stream->printed = 0;
+    qr->stream->start = timing_ms();
+    qr->stream->first = 0;
+    if (plainRanking) {
+      docscore_t *docs = NULL;
+      int nfinal = tiers_final(qr->postings, query, allowed, &docs);
+      if (opts->topK > 0 && nfinal > opts->topK) {
+        nfinal = opts->topK;
+      }
+      for (int i = 0; i < nfinal && !cancel_check(qr->cancel); i++) {
+        print_result(&docs[i], opts, qr);
+        qr->stream->printed = i + 1;
+      }
+      mem_free(docs);
+    }
+  } else if (opts->tiered && plainRanking) {
+    docscore_t *docs = NULL;
+    int ndocs = 0;
+    if (tiers_topk(qr->postings, query, allowed, opts->topK,
+                   &docs, &ndocs)) {
+      print_ranked(docs, ndocs, 0, opts, qr);
+      mem_free(docs);
+      stats->ntier1++;
+      query_delete(query);
+      bitmap_delete(allowed);
+      return;
+    }
+  }
+
+  /* in a batch, the batch shares work with the other queries */
+  if (qr->batch != NULL) {
+    char key[FILTER_KEYMAX];
+    filter_key(filter, key, sizeof(key));
+    double start = timing_ms();
+    docscore_t *docs = NULL;
+    int ndocs = batch_evaluate(qr->batch, query, key, allowed, &docs);
+    stats->msbatch += timing_ms() - start;
+    if (cancel_check(qr->cancel)) {
+      print_cancelled(qr);
+    } else {
+      rank_docs(docs, ndocs, opts, qr, filter);
+    }
+    mem_free(docs);
+    query_delete(query);
+    bitmap_delete(allowed);
+    return;
+  }
+
+  engine_t engine = choose_engine(opts, qr, query);
+  double start = timing_ms();
+  if (engine == ENGINE_DAAT) {
+    /* with a plain top-K, DAAT only ever keeps K results (but a stream
+     * needs them all, to count them) */
+    int k = (plainRanking && qr->stream == NULL) ? opts->topK : 0;
+    docscore_t *docs = NULL;
+    int ndocs = daat_evaluate(qr->postings, query, allowed, k, qr->cancel,
+                              &docs);
+    stats->msengine[engine] += timing_ms() - start;
+    if (cancel_check(qr->cancel)) {
+      print_cancelled(qr);
+    } else {
+      rank_docs(docs, ndocs, opts, qr, filter);
+    }
+    mem_free(docs);
+  } else if (engine == ENGINE_BLOCK) {
+    docscore_t *docs = NULL;
+    int ndocs = blocks_evaluate(qr->postings, query, allowed, qr->cancel,
+                                &docs);
+    stats->msengine[engine] += timing_ms() - start;
+    if (cancel_check(qr->cancel)) {
+      print_cancelled(qr);
+    } else {
+      rank_docs(docs, ndocs, opts, qr, filter);
+    }
+    mem_free(docs);
+  } else {
+    /* the commonest shapes skip the general loop and its counters */
+    shape_t shape = opts->nofast ? SHAPE_GENERIC : query_shape(words, nwords);
+    if (shape != SHAPE_GENERIC) {
+      docscore_t *docs = NULL;
+      int ndocs = evaluate_shape(qr, shape, words, nwords, allowed,
+                                 qr->cancel, &docs);
+      stats->msengine[engine] += timing_ms() - start;
+      stats->nshape[shape]++;
+      if (cancel_check(qr->cancel)) {
+        print_cancelled(qr);
+      } else {
+        rank_docs(docs, ndocs, opts, qr, filter);
+      }
+      mem_free(docs);
+    } else {
+      result_t results = evaluate_query(qr->index, qr->postings, words,
+                                        nwords, allowed, qr->cancel);
+      stats->msengine[engine] += timing_ms() - start;
+      if (cancel_check(qr->cancel)) {
+        print_cancelled(qr);
+      } else {
+        rank_and_print(results.ctrs, opts, qr, filter);
+      }
+      result_release(&results);
+    }
+  }
+  stats->nengine[engine]++;
+
+  query_delete(query);
+  bitmap_delete(allowed);
+}
+
+/* choose_engine */
+/* Return the engine to evaluate query with. For -engine auto: TAAT's
+ * counters are cheap only while they stay tiny, so small queries use
+ * TAAT and anything with more than AUTO_TAAT_POSTINGS postings in
+ * total, or with "or" (where TAAT builds and unions one intermediate
+ * set per andsequence), uses the block engine, the fastest of the
+ * others in make bench. With -plan, the engine whose estimated work
+ * (see plan_costs) is smaller is used instead.
+ */
+static engine_t
+choose_engine(const options_t *opts, const querier_t *qr,
+              const query_t *query)
+{
+  if (opts->engine != ENGINE_AUTO) {
+    return opts->engine;
+  }
+  if (qr->postings == NULL) {
+    return ENGINE_TAAT;
+  }
+  double taatCost, blockCost;
+  if (plan_costs(qr->postings, query, &taatCost, &blockCost)) {
+    return (taatCost <= blockCost) ? ENGINE_TAAT : ENGINE_BLOCK;
+  }
+  if (query->nseqs > 1) {
+    return ENGINE_BLOCK;
+  }
+
+  int total = 0;
+  for (int s = 0; s < query->nseqs; s++) {
+    for (int t = 0; t < query->seqs[s].nterms; t++) {
+      term_t *term = postings_find(qr->postings, query->seqs[s].terms[t]);
+      total += (term == NULL) ? 0 : term->full.n;
+    }
+  }
+  return (total > AUTO_TAAT_POSTINGS) ? ENGINE_BLOCK : ENGINE_TAAT;
+}
 
-    if (!tokenize_and_validate(line, &words, &nwords)) {
-      /* invalid query; error already printed */
-      if (words != NULL) {
-        mem_free(words);
+/* plan_costs */
+/* Estimate, from the words' sketches, the work TAAT and the block
+ * engine would do on query, in postings touched. TAAT walks the
+ * borrowed first list once and, since counters are lists, each probe
+ * of the next word costs about that word's length; the block engine
+ * merges each pair of lists once. For speed the estimate intersects
+ * shortest list first rather than planning the order.
+ * Returns false if the words have no sketches.
+ */
+static bool
+plan_costs(postings_t *postings, const query_t *query,
+           double *taat_out, double *block_out)
+{
+  double taat = 0, block = 0;
+  double taatUnion = 0;       // TAAT's union so far
+  for (int s = 0; s < query->nseqs; s++) {
+    const andseq_t *andseq = &query->seqs[s];
+    int n = andseq->nterms;
+    const sketch_t *sketches[n];
+    bool empty = (n == 0);
+    for (int t = 0; t < n; t++) {
+      term_t *term = postings_find(postings, andseq->terms[t]);
+      if (term != NULL && term->sketch == NULL) {
+        return false;
       }
-      prompt();
-      continue;
+      if (term == NULL) {
+        empty = true;         // no matches, no work
+        break;
+      }
+      /* insertion sort, shortest first */
+      int u = t;
+      for (; u > 0 && sketches[u-1]->size > term->sketch->size; u--) {
+        sketches[u] = sketches[u-1];
+      }
+      sketches[u] = term->sketch;
     }
-
-    if (nwords == 0) {
-      /* blank line; nothing to do */
-      mem_free(words);
-      prompt();
+    if (empty) {
       continue;
     }
 
-    /* print cleaned query */
-    printf("Query:");
-    for (int i = 0; i < nwords; i++) {
-      printf(" %s", words[i]);
+    double size = sketches[0]->size;
+    for (int t = 1; t < n && size > 0; t++) {
+      taat += size * sketches[t]->size / 2.0;
+      block += size + sketches[t]->size;
+      size = sketch_and(sketches, t + 1);
     }
-    printf("\n");
-
-    counters_t *results = evaluate_query(index, words, nwords);
-    rank_and_print(results, pageDirectory);
 
-    counters_delete(results);
-    mem_free(words);
-    prompt();
+    /* each union probes TAAT's running union for every new document */
+    taat += taatUnion * size / 2.0;
+    block += size + taatUnion;
+    taatUnion += size;
   }
+  *taat_out = taat;
+  *block_out = block;
+  return true;
+}
 
-  printf("\n");
+/**************** print_stats ****************/
+/* see querier.h for description */
+void
+print_stats(const options_t *opts, const querier_t *qr, const stats_t *stats)
+{
+  if (qr->shadow != NULL) {
+    shadowstats_t ss;
+    shadow_drain(qr->shadow);
+    shadow_stats(qr->shadow, &ss);
+    fprintf(stderr, "querier: shadow %s: compared %ld of %ld queries (%ld "
+            "sampled but dropped), %ld mismatches; %.3f ms against %.3f ms "
+            "for the counters on average (%.2fx)\n",
+            engineNames[opts->shadowEngine], ss.compared, ss.offered,
+            ss.dropped, ss.mismatches,
+            ss.compared == 0 ? 0.0 : ss.mscandidate / ss.compared,
+            ss.compared == 0 ? 0.0 : ss.msreference / ss.compared,
+            ss.msreference == 0 ? 0.0 : ss.mscandidate / ss.msreference);
+  }
+  int ncancelled = 0;
+  for (int r = 0; r < CANCEL_REASONS; r++) {
+    ncancelled += stats->ncancelled[r];
+  }
+  if (opts->timeoutMs > 0 || ncancelled > 0) {
+    fprintf(stderr, "querier: cancelled %d of %d queries (%d %s, %d %s, "
+            "%d %s), %.3f ms on average from cancellation to stopping\n",
+            ncancelled, stats->nqueries,
+            stats->ncancelled[CANCEL_TIMEOUT], cancel_name(CANCEL_TIMEOUT),
+            stats->ncancelled[CANCEL_INTERRUPT],
+            cancel_name(CANCEL_INTERRUPT),
+            stats->ncancelled[CANCEL_HANGUP], cancel_name(CANCEL_HANGUP),
+            ncancelled == 0 ? 0.0 : stats->mscancel / ncancelled);
+  }
+  if (qr->stream != NULL) {
+    const stream_t *st = qr->stream;
+    fprintf(stderr, "querier: stream: %ld of %ld results printed before "
+            "evaluation (%.1f%%)\n", st->nearly, st->nresults,
+            st->nresults == 0 ? 0.0 : 100.0 * st->nearly / st->nresults);
+    fprintf(stderr, "querier: stream: first result after %.3f ms, last "
+            "after %.3f ms (mean of %d queries)\n", st->nqueries == 0 ? 0.0
+            : st->msfirst / st->nqueries, st->nqueries == 0 ? 0.0
+            : st->mslast / st->nqueries, st->nqueries);
+  }
+  if (opts->tiered) {
+    fprintf(stderr, "querier: tier 1 alone answered %d of %d queries "
+            "(%.1f%%)\n", stats->ntier1, stats->nqueries,
+            stats->nqueries == 0 ? 0.0
+            : 100.0 * stats->ntier1 / stats->nqueries);
+  }
+  if (qr->snipper != NULL) {
+    int hits, misses;
+    snippet_stats(qr->snipper, &hits, &misses);
+    fprintf(stderr, "querier: snippet cache: %d hits, %d misses\n",
+            hits, misses);
+  }
+  if (qr->batch != NULL) {
+    batchstats_t bs;
+    batch_stats(qr->batch, &bs);
+    fprintf(stderr, "querier: batch: %d queries, %d answered by an "
+            "identical earlier query\n", bs.nqueries, bs.queryRepeats);
+    fprintf(stderr, "querier: batch: %d of %d andsequences evaluated, "
+            "%d of %d word lookups went to the index\n", bs.seqEvaluated,
+            bs.seqUses, bs.wordsLoaded, bs.wordUses);
+    fprintf(stderr, "querier: batch: %ld postings read, %ld more shared "
+            "(%.3f ms evaluating)\n", bs.postingsRead, bs.postingsSaved,
+            stats->msbatch);
+  }
+  pcache_t *cache = postings_cache(qr->postings);
+  if (cache != NULL) {
+    pcachestats_t cs;
+    pcache_stats(cache, &cs);
+    long requests = cs.hits + cs.misses;
+    fprintf(stderr, "querier: compressed postings: %ld bytes (%.1f%% of "
+            "%ld)\n", cs.packedBytes, cs.rawBytes == 0 ? 0.0
+            : 100.0 * cs.packedBytes / cs.rawBytes, cs.rawBytes);
+    fprintf(stderr, "querier: block cache: %ld hits, %ld misses (%.1f%% "
+            "hit rate); %ld admitted, %ld rejected, %ld evicted; "
+            "%d of %d blocks used\n", cs.hits, cs.misses,
+            requests == 0 ? 0.0 : 100.0 * cs.hits / requests, cs.admitted,
+            cs.rejected, cs.evicted, cs.used, cs.capacity);
+  }
+  if (opts->stats) {
+    for (int e = 0; e < NUM_ENGINES; e++) {
+      fprintf(stderr, "querier: engine %s: %d queries, %.3f ms evaluating"
+              " (%.1f us/query)\n", engineNames[e], stats->nengine[e],
+              stats->msengine[e], stats->nengine[e] == 0 ? 0.0
+              : 1000.0 * stats->msengine[e] / stats->nengine[e]);
+    }
+    fprintf(stderr, "querier: taat fast paths:");
+    for (int f = 0; f < NUM_SHAPES; f++) {
+      fprintf(stderr, "%s %d %s", f == 0 ? "" : ",", stats->nshape[f],
+              shapeNames[f]);
+    }
+    fprintf(stderr, " queries\n");
+  }
 }
 
 /* tokenize_and_validate */
@@ -364,42 +2013,355 @@ is_operator(const char *word)
   return (strcmp(word, "and") == 0 || strcmp(word, "or") == 0);
 }
 
+/* extract_filters */
+/* Find the non-word terms in line, record them (lowercased) in *filter,
+ * and blank them out of line so that the tokenizer sees only words and
+ * operators. The terms are:
+ *   host:name, site:name  - host filters; names may hold letters,
+ *                           digits, '.' and '-'
+ *   attr<op>value         - attribute predicate, like depth<=2
+ *   sort:attr, sort:-attr - order by attribute, ascending/descending
+ * Prints an error and returns false on a malformed term.
+ */
+static bool
+extract_filters(char *line, filter_t *filter)
+{
+  filter->n = 0;
+  filter->npreds = 0;
+  filter->sorted = false;
+  filter->echo[0] = '\0';
+  if (line == NULL) {
+    return true;
+  }
+
+  char *p = line;
+  while (*p != '\0') {
+    while (isspace((unsigned char) *p)) {
+      p++;
+    }
+    char *token = p;
+    while (*p != '\0' && !isspace((unsigned char) *p)) {
+      p++;
+    }
+    int tokenLen = p - token;
+
+    /* filter terms are the tokens holding ':' or a comparison */
+    bool special = false;
+    for (int i = 0; i < tokenLen; i++) {
+      if (strchr(":<>=!", token[i]) != NULL) {
+        special = true;
+      }
+    }
+    if (!special) {
+      continue;
+    }
+
+    char term[FILTER_NAMEMAX];
+    if (tokenLen >= FILTER_NAMEMAX) {
+      fprintf(stderr, "Error: query term too long\n");
+      return false;
+    }
+    for (int i = 0; i < tokenLen; i++) {
+      term[i] = (char) tolower((unsigned char) token[i]);
+    }
+    term[tokenLen] = '\0';
+
+    /* a predicate starts with an attribute's name; other tokens holding
+     * a comparison are left for the tokenizer to reject */
+    size_t opAt = strcspn(term, "<>=!");
+    char op = term[opAt];
+    attr_t attr;
+    term[opAt] = '\0';
+    bool predicate = (op != '\0' && docattrs_parse_attr(term, &attr));
+    term[opAt] = op;
+
+    if (strncmp(term, "host:", 5) == 0 || strncmp(term, "site:", 5) == 0) {
+      if (!add_host_filter(filter, term)) {
+        return false;
+      }
+    } else if (strncmp(term, "sort:", 5) == 0) {
+      const char *name = term + 5;
+      filter->sortDesc = (*name == '-');
+      if (filter->sortDesc) {
+        name++;
+      }
+      if (!docattrs_parse_attr(name, &filter->sortAttr)) {
+        fprintf(stderr, "Error: unknown sort attribute '%s'\n", name);
+        return false;
+      }
+      filter->sorted = true;
+    } else if (predicate) {
+      if (filter->npreds == MAX_PREDS) {
+        fprintf(stderr, "Error: too many predicates\n");
+        return false;
+      }
+      if (!docattrs_parse_pred(term, &filter->preds[filter->npreds])) {
+        fprintf(stderr, "Error: bad predicate '%s'\n", term);
+        return false;
+      }
+      filter->npreds++;
+    } else {
+      continue;                 // leave it for the tokenizer to reject
+    }
+
+    /* remember it for printing the cleaned query */
+    size_t used = strlen(filter->echo);
+    snprintf(filter->echo + used, sizeof(filter->echo) - used, " %s", term);
+    memset(token, ' ', tokenLen);
+  }
+  return true;
+}
+
+/* add_host_filter */
+/* Record a lowercased "host:name" or "site:name" term in *filter. */
+static bool
+add_host_filter(filter_t *filter, const char *term)
+{
+  const char *name = term + 5;
+  if (filter->n == MAX_FILTERS || *name == '\0') {
+    fprintf(stderr, "Error: too many or empty host filters\n");
+    return false;
+  }
+  for (const char *c = name; *c != '\0'; c++) {
+    if (!isalnum((unsigned char) *c) && *c != '.' && *c != '-') {
+      fprintf(stderr, "Error: bad character '%c' in host filter\n", *c);
+      return false;
+    }
+  }
+  strcpy(filter->names[filter->n], name);
+  filter->site[filter->n] = (term[0] == 's');
+  filter->n++;
+  return true;
+}
+
+/**************** filter_bitmap ****************/
+/* see querier.h for description */
+bitmap_t *
+filter_bitmap(const filter_t *filter, const hosts_t *hosts)
+{
+  if (filter->n == 0) {
+    return NULL;
+  }
+  bitmap_t *allowed = hosts_filter(hosts, filter->names[0], filter->site[0]);
+  for (int f = 1; f < filter->n; f++) {
+    bitmap_t *more = hosts_filter(hosts, filter->names[f], filter->site[f]);
+    bitmap_or(allowed, more);
+    bitmap_delete(more);
+  }
+  return allowed;
+}
+
+/* filter_key */
+/* Write into key a string naming the host filters of filter ("" if
+ * none), for telling batch.h which queries allow the same documents.
+ */
+static void
+filter_key(const filter_t *filter, char *key, const size_t size)
+{
+  key[0] = '\0';
+  size_t used = 0;
+  for (int f = 0; f < filter->n && used < size; f++) {
+    used += snprintf(key + used, size - used, "%c:%s ",
+                     filter->site[f] ? 's' : 'h', filter->names[f]);
+  }
+}
+
+/* query_shape */
+/* Return the fast-path shape of a validated query: one word, two words
+ * and'ed ("a b" or "a and b"), two words or'ed, or SHAPE_GENERIC.
+ */
+static shape_t
+query_shape(char **words, const int nwords)
+{
+  if (nwords == 1) {
+    return SHAPE_ONE;
+  }
+  if (nwords == 2) {
+    return SHAPE_AND2;
+  }
+  if (nwords == 3 && strcmp(words[1], "and") == 0) {
+    return SHAPE_AND2;
+  }
+  if (nwords == 3 && strcmp(words[1], "or") == 0) {
+    return SHAPE_OR2;
+  }
+  return SHAPE_GENERIC;
+}
+
+/* evaluate_shape */
+/* Evaluate a query of one of the fast-path shapes straight into a new
+ * array of results (any order; caller frees with mem_free), returning
+ * their number. Scores are as evaluate_query's: a word's count, the
+ * min of two and'ed counts, the sum of two or'ed counts. Only allowed
+ * documents (all if allowed is NULL) are collected. If cancel (NULL:
+ * never) says stop, the results are cut short.
+ */
+static int
+evaluate_shape(const querier_t *qr, const shape_t shape, char **words,
+               const int nwords, const bitmap_t *allowed, cancel_t *cancel,
+               docscore_t **docs_out)
+{
+  if (shape == SHAPE_ONE) {
+    return collect_word(qr, words[0], allowed, false, cancel, docs_out);
+  }
+
+  docscore_t *a, *b;
+  int na = collect_word(qr, words[0], allowed, true, cancel, &a);
+  int nb = cancel_check(cancel)
+    ? collect_word(qr, NULL, allowed, true, NULL, &b)     // none
+    : collect_word(qr, words[nwords - 1], allowed, true, cancel, &b);
+  int i = 0, j = 0, n = 0, steps = 0;
+  if (shape == SHAPE_AND2) {
+    /* merge into a itself: n never passes i */
+    while (i < na && j < nb && !stop_every(cancel, &steps)) {
+      int adoc = a[i].docID, bdoc = b[j].docID;
+      if (adoc == bdoc) {
+        a[n].docID = adoc;
+        a[n++].score = (a[i].score < b[j].score) ? a[i].score : b[j].score;
+      }
+      i += (adoc <= bdoc);
+      j += (bdoc <= adoc);
+    }
+    mem_free(b);
+    *docs_out = a;
+    return n;
+  }
+
+  docscore_t *docs = mem_malloc_assert((na + nb + 1) * sizeof(docscore_t),
+                                       "evaluate_shape");
+  while (i < na && j < nb && !stop_every(cancel, &steps)) {
+    int adoc = a[i].docID, bdoc = b[j].docID;
+    int takea = (adoc <= bdoc), takeb = (bdoc <= adoc);
+    docs[n].docID = takea ? adoc : bdoc;
+    docs[n++].score = (takea ? a[i].score : 0) + (takeb ? b[j].score : 0);
+    i += takea;
+    j += takeb;
+  }
+  if (!cancel_check(cancel)) {
+    for (; i < na; i++) {
+      docs[n++] = a[i];
+    }
+    for (; j < nb; j++) {
+      docs[n++] = b[j];
+    }
+  }
+  mem_free(a);
+  mem_free(b);
+  *docs_out = docs;
+  return n;
+}
+
+/* collect_word */
+/* Collect the allowed documents of word, with their counts, into a new
+ * array (caller frees with mem_free), sorted by docID if sorted is
+ * true; return their number. Reads the word's sorted posting array
+ * when the postings are loaded (and not compressed), else its counters.
+ * If cancel (NULL: never) says stop, the results are cut short; a NULL
+ * word has none.
+ */
+static int
+collect_word(const querier_t *qr, const char *word, const bitmap_t *allowed,
+             const bool sorted, cancel_t *cancel, docscore_t **docs_out)
+{
+  term_t *term = postings_find(qr->postings, word);
+  if (term != NULL && term->packed == NULL) {
+    const plist_t *list = &term->full;
+    docscore_t *docs = mem_malloc_assert((list->n + 1) * sizeof(docscore_t),
+                                         "collect_word");
+    int n = 0, steps = 0;
+    for (int i = 0; i < list->n && !stop_every(cancel, &steps); i++) {
+      docs[n].docID = list->docs[i];
+      docs[n].score = list->counts[i];
+      n += (allowed == NULL || bitmap_test(allowed, list->docs[i]));
+    }
+    *docs_out = docs;
+    return n;
+  }
+
+  counters_t *ctrs = (word == NULL) ? NULL : index_find(qr->index, word);
+  int total = 0;
+  counters_iterate(ctrs, &total, count_nonzero);
+  docscore_t *docs = mem_malloc_assert((total + 1) * sizeof(docscore_t),
+                                       "collect_word");
+  collect_arg_t arg = { docs, 0 };
+  counters_iterate(ctrs, &arg, collect_nonzero);
+
+  int n = 0, steps = 0;
+  for (int i = 0; i < total && !stop_every(cancel, &steps); i++) {
+    docs[n] = docs[i];
+    n += (allowed == NULL || bitmap_test(allowed, docs[i].docID));
+  }
+  if (sorted && !cancel_check(cancel)) {
+    qsort(docs, n, sizeof(docscore_t), docscore_cmp_docID);
+  }
+  *docs_out = docs;
+  return n;
+}
+
+/* stop_every */
+/* Return true if cancel says stop, asking it only on every SHAPE_CHECK'th
+ * call, as counted in *steps.
+ */
+static bool
+stop_every(cancel_t *cancel, int *steps)
+{
+  return (++*steps & (SHAPE_CHECK - 1)) == 0 && cancel_check(cancel);
+}
+
+/* docscore_cmp_docID */
+/* qsort comparison for docscore_t: docID ascending. */
+static int
+docscore_cmp_docID(const void *a, const void *b)
+{
+  const docscore_t *da = a;
+  const docscore_t *db = b;
+  return (da->docID > db->docID) - (da->docID < db->docID);
+}
+
 /* evaluate_query */
 /* Evaluate a full query with AND precedence over OR.
  *
  * query ::= andsequence { "or" andsequence }*
  *
  * For each andsequence we compute intersection, then we union
- * all andsequence results together.
+ * all andsequence results together. If allowed is not NULL, only the
+ * documents in it are considered at all.
+ *
+ * The result may be borrowed from the index (a one-word query);
+ * release it with result_release. postings, if not NULL, supplies the
+ * words' Bloom filters. cancel is checked before every word; if it
+ * stops us, the result is not the query's.
  */
-static counters_t *
-evaluate_query(index_t *index, char **words, const int nwords)
+static result_t
+evaluate_query(index_t *index, postings_t *postings, char **words,
+               const int nwords, const bitmap_t *allowed, cancel_t *cancel)
 {
+  result_t orResult = { NULL, false };
   if (index == NULL || words == NULL) {
     fprintf(stderr, "querier: evaluate_query got NULL parameter\n");
-    return counters_new();
-  }
-
-  counters_t *orResult = counters_new();
-  if (orResult == NULL) {
-    fprintf(stderr, "querier: cannot allocate counters in evaluate_query\n");
-    exit(2);
+    return orResult;
   }
-  bool haveOrResult = false;
 
   int i = 0;
-  while (i < nwords) {
+  while (i < nwords && !cancel_check(cancel)) {
     int end = 0;
-    counters_t *andResult = evaluate_andsequence(index, words, nwords,
-                                                 i, &end);
+    result_t andResult = evaluate_andsequence(index, postings, words, nwords,
+                                              i, allowed, cancel, &end);
 
-    if (!haveOrResult) {
-      counters_delete(orResult);
+    if (orResult.ctrs == NULL) {
       orResult = andResult;
-      haveOrResult = true;
-    } else {
-      counters_union(orResult, andResult);
-      counters_delete(andResult);
+    } else if (andResult.ctrs != NULL) {
+      /* union into a side we own; copy only if we own neither */
+      if (!orResult.owned && andResult.owned) {
+        result_t swap = orResult;
+        orResult = andResult;
+        andResult = swap;
+      }
+      if (!orResult.owned) {
+        orResult = result_copy(orResult.ctrs, NULL, NULL, NULL);
+      }
+      counters_union(orResult.ctrs, andResult.ctrs);
+      result_release(&andResult);
     }
 
     i = end;
@@ -408,9 +2370,6 @@ evaluate_query(index_t *index, char **words, const int nwords)
     }
   }
 
-  if (!haveOrResult) {
-    /* no words somehow; keep empty result */
-  }
   return orResult;
 }
 
@@ -422,41 +2381,59 @@ evaluate_query(index_t *index, char **words, const int nwords)
  *
  * On return, *end_out is set to index of first token after this
  * andsequence (either an "or" or nwords).
+ *
+ * The first word's counters are borrowed from the index, not copied.
+ * The first intersection builds our own copy holding only the
+ * documents in both words (and allowed by the filter), so every later
+ * intersection works in place on that smaller set. A single word is
+ * copied only to apply a filter. With sketches (-plan) the words are
+ * intersected in the order plan_andsequence chooses, not as written.
+ *
+ * Each probe of a word's counters first asks the word's Bloom filter,
+ * if it has one, and skips the probe when the document is certainly
+ * not there.
  */
-static counters_t *
-evaluate_andsequence(index_t *index, char **words,
-                     const int nwords, const int start, int *end_out)
+static result_t
+evaluate_andsequence(index_t *index, postings_t *postings, char **words,
+                     const int nwords, const int start,
+                     const bitmap_t *allowed, cancel_t *cancel, int *end_out)
 {
-  counters_t *result = NULL;
-  int i = start;
+  result_t result = { NULL, false };
 
+  /* find the words, skipping explicit "and"s */
+  int wordIdx[nwords - start];
+  int n = 0;
+  int i = start;
   while (i < nwords && strcmp(words[i], "or") != 0) {
-    if (strcmp(words[i], "and") == 0) {
-      i++;   // skip explicit "and"
-      continue;
+    if (strcmp(words[i], "and") != 0) {
+      wordIdx[n++] = i;
     }
-
-    /* words[i] is a real word. */
-    counters_t *wordCtrs = index_find(index, words[i]);   // may be NULL
-
-    if (result == NULL) {
-      result = counters_new();
-      if (wordCtrs != NULL) {
-        counters_iterate(wordCtrs, result, copy_helper);
-      }
+    i++;
+  }
+  plan_andsequence(postings, words, wordIdx, n);
+
+  for (int w = 0; w < n && !cancel_check(cancel); w++) {
+    char *word = words[wordIdx[w]];
+    counters_t *wordCtrs = index_find(index, word);   // may be NULL
+    term_t *term = postings_find(postings, word);
+    const bloom_t *bloom = (term == NULL) ? NULL : term->bloom;
+
+    if (w == 0) {
+      result.ctrs = wordCtrs;
+    } else if (result.ctrs == NULL) {
+      /* already empty; stays empty */
+    } else if (wordCtrs == NULL) {
+      /* intersect with empty set => nothing left. */
+      result_release(&result);
+    } else if (!result.owned) {
+      result = result_copy(result.ctrs, wordCtrs, bloom, allowed);
     } else {
-      if (wordCtrs == NULL) {
-        /* intersect with empty set => everything becomes zero. */
-        counters_iterate(result, result, zero_helper);
-      } else {
-        counters_intersect(result, wordCtrs);
-      }
+      counters_intersect(result.ctrs, wordCtrs, bloom);
     }
-    i++;
   }
 
-  if (result == NULL) {
-    result = counters_new();
+  if (result.ctrs != NULL && !result.owned && allowed != NULL) {
+    result = result_copy(result.ctrs, NULL, NULL, allowed);
   }
 
   if (end_out != NULL) {
@@ -465,18 +2442,81 @@ evaluate_andsequence(index_t *index, char **words,
   return result;
 }
 
+/* plan_andsequence */
+/* If the words have sketches, reorder the n word positions in wordIdx
+ * into the order sketch_order plans: the result of the first
+ * intersection, which we must copy, is then as small as we can guess,
+ * and so is everything after it. Words not in the index go first.
+ */
+static void
+plan_andsequence(postings_t *postings, char **words, int *wordIdx,
+                 const int n)
+{
+  if (postings == NULL || n < 2) {
+    return;
+  }
+  const sketch_t *sketches[n];
+  int written[n];
+  int order[n];
+  for (int w = 0; w < n; w++) {
+    term_t *term = postings_find(postings, words[wordIdx[w]]);
+    if (term != NULL && term->sketch == NULL) {
+      return;                 // no sketches: keep the query's order
+    }
+    sketches[w] = (term == NULL) ? NULL : term->sketch;
+    written[w] = wordIdx[w];
+  }
+  sketch_order(sketches, n, order);
+  for (int w = 0; w < n; w++) {
+    wordIdx[w] = written[order[w]];
+  }
+}
+
+/* result_copy */
+/* Return a new owned result holding the documents of src that allowed
+ * (if not NULL) permits and, if other is not NULL, that also appear in
+ * other, with the min of the two counts. bloom, if not NULL, is a Bloom
+ * filter of other's docIDs.
+ */
+static result_t
+result_copy(counters_t *src, counters_t *other, const bloom_t *bloom,
+            const bitmap_t *allowed)
+{
+  result_t result = { counters_new(), true };
+  if (result.ctrs == NULL) {
+    fprintf(stderr, "querier: cannot allocate counters in result_copy\n");
+    exit(2);
+  }
+  filter_copy_t fc = { result.ctrs, other, bloom, allowed };
+  counters_iterate(src, &fc, filter_copy_helper);
+  return result;
+}
+
+/* result_release */
+/* Delete result's counters if we own them; either way it becomes empty. */
+static void
+result_release(result_t *result)
+{
+  if (result->owned) {
+    counters_delete(result->ctrs);
+  }
+  result->ctrs = NULL;
+  result->owned = false;
+}
+
 /* counters_intersect */
 /* Modify dest in-place to become the intersection of dest and src.
  * For each docID in dest:
  *   newScore = min(dest[docID], src[docID])
+ * bloom, if not NULL, is a Bloom filter of src's docIDs.
  */
 static void
-counters_intersect(counters_t *dest, counters_t *src)
+counters_intersect(counters_t *dest, counters_t *src, const bloom_t *bloom)
 {
   if (dest == NULL || src == NULL) {
     return;
   }
-  two_counters_t pair = { dest, src };
+  two_counters_t pair = { dest, src, bloom };
   counters_iterate(dest, &pair, intersect_helper);
 }
 
@@ -500,7 +2540,10 @@ static void
 intersect_helper(void *arg, const int key, int count)
 {
   two_counters_t *pair = arg;
-  int other = counters_get(pair->b, key);
+  int other = 0;
+  if (pair->bloom == NULL || bloom_test(pair->bloom, key)) {
+    other = counters_get(pair->b, key);
+  }
   int newCount = (count < other) ? count : other;
   counters_set(pair->a, key, newCount);
 }
@@ -515,73 +2558,224 @@ union_helper(void *arg, const int key, int count)
   counters_set(dest, key, old + count);
 }
 
-/* copy_helper */
-/* Helper used to copy all entries from one counters into another. */
-static void
-copy_helper(void *arg, const int key, int count)
-{
-  counters_t *dest = arg;
-  counters_set(dest, key, count);
-}
-
-/* zero_helper */
-/* Helper used to set all counts in a counters to zero. */
+/* filter_copy_helper */
+/* Helper for result_copy: copy one entry if the filter allows it and,
+ * when intersecting, if other has it too. */
 static void
-zero_helper(void *arg, const int key, int count)
+filter_copy_helper(void *arg, const int key, int count)
 {
-  (void) count;      // unused
-  counters_t *dest = arg;
-  counters_set(dest, key, 0);
+  filter_copy_t *fc = arg;
+  if (fc->allowed != NULL && !bitmap_test(fc->allowed, key)) {
+    return;
+  }
+  if (fc->other != NULL) {
+    int other = 0;
+    if (fc->bloom == NULL || bloom_test(fc->bloom, key)) {
+      other = counters_get(fc->other, key);
+    }
+    count = (count < other) ? count : other;
+  }
+  if (count > 0) {
+    counters_set(fc->dest, key, count);
+  }
 }
 
 /* rank_and_print */
 /* Rank the results (counters) by score and print them.
  * If there are no matches, print "No documents match."
+ *
+ * Between collecting and sorting, the query's attribute predicates
+ * are applied to the whole candidate array; a sort: term replaces the
+ * score order with attribute order. After sorting, near-duplicates
+ * are collapsed (with -collapse), examining only as many results as it
+ * takes to fill the page that will be printed.
  */
 static void
-rank_and_print(counters_t *results, const char *pageDirectory)
+rank_and_print(counters_t *results, const options_t *opts,
+               const querier_t *qr, const filter_t *filter)
 {
-  if (results == NULL || pageDirectory == NULL) {
+  if (opts == NULL) {
     fprintf(stderr, "querier: rank_and_print got NULL parameter\n");
     return;
   }
 
-  int n = 0;
-  counters_iterate(results, &n, count_nonzero);
+  /* NULL results: nothing matched */
+  docscore_t *docs = NULL;
+  int n = collect_results(results, &docs);
 
   if (n == 0) {
-    printf("No documents match.\n");
-    printf("-----------------------------------------------\n");
+    print_ranked(NULL, 0, 0, opts, qr);
     return;
   }
 
+  rank_docs(docs, n, opts, qr, filter);
+
+  mem_free(docs);
+}
+
+/* collect_results */
+/* Collect the documents of results (NULL: none) with non-zero scores
+ * into a new array, in no particular order, in *docs_out (NULL if
+ * none; caller frees with mem_free); return their number.
+ */
+static int
+collect_results(counters_t *results, docscore_t **docs_out)
+{
+  int n = 0;
+  counters_iterate(results, &n, count_nonzero);
+  *docs_out = NULL;
+  if (n == 0) {
+    return 0;
+  }
+
   docscore_t *docs = mem_malloc(n * sizeof(docscore_t));
   if (docs == NULL) {
-    fprintf(stderr, "querier: out of memory in rank_and_print\n");
+    fprintf(stderr, "querier: out of memory in collect_results\n");
     exit(2);
   }
 
   collect_arg_t arg = { docs, 0 };
   counters_iterate(results, &arg, collect_nonzero);
+  *docs_out = docs;
+  return n;
+}
+
+/**************** rank_docs ****************/
+/* see querier.h for description */
+void
+rank_docs(docscore_t *docs, int n, const options_t *opts,
+          const querier_t *qr, const filter_t *filter)
+{
+  n = docattrs_filter(qr->attrs, filter->preds, filter->npreds, docs, n);
+  if (filter->sorted) {
+    docattrs_sort(qr->attrs, filter->sortAttr, filter->sortDesc, docs, n);
+  } else if (!radix_sort(docs, n, opts->threads, qr->cancel)) {
+    print_cancelled(qr);
+    return;
+  }
+
+  int hidden = 0;
+  if (qr->simhashes != NULL) {
+    int want = (opts->topK > 0) ? opts->topK : n;
+    n = simhash_collapse(qr->simhashes, docs, n, want, &hidden);
+  }
+
+  print_ranked(docs, n, hidden, opts, qr);
+}
 
-  qsort(docs, n, sizeof(docscore_t), cmp_docscore_desc);
+/* print_ranked */
+/* Print onto qr->out n already-ranked results, or only the first opts->topK of
+ * them when -k was given, and how many near-duplicates were hidden (if
+ * any).
+ *
+ * With -stream there is no header: the results -stream printed before
+ * evaluation are skipped, the others printed (each flushed at once),
+ * and the count follows them.
+ */
+static void
+print_ranked(const docscore_t *docs, const int n, const int hidden,
+             const options_t *opts, const querier_t *qr)
+{
+  if (qr->ranking != NULL) {
+    /* part of a federated query: keep what we would show */
+    int shown = (opts->topK > 0 && opts->topK < n) ? opts->topK : n;
+    ranking_t *ranking = qr->ranking;
+    ranking->docs = mem_malloc_assert((shown + 1) * sizeof(docscore_t),
+                                      "print_ranked");
+    if (shown > 0) {
+      memcpy(ranking->docs, docs, shown * sizeof(docscore_t));
+    }
+    ranking->n = shown;
+    ranking->hidden = hidden;
+    return;
+  }
+  if (n == 0) {
+    fprintf(qr->out, "No documents match.\n");
+    fprintf(qr->out, "%s\n", ANSWERS_SEPARATOR);
+    return;
+  }
 
-  printf("Matches %d documents (ranked):\n", n);
-  for (int i = 0; i < n; i++) {
-    int id = docs[i].docID;
-    int score = docs[i].score;
-    char *url = get_url(pageDirectory, id);
+  int shown = n;
+  if (opts->topK > 0 && opts->topK < n) {
+    shown = opts->topK;
+  }
 
-    if (url == NULL) {
-      printf("score %3d  doc %3d: (no-url)\n", score, id);
+  stream_t *st = qr->stream;
+  if (st == NULL) {
+    if (opts->topK > 0) {
+      fprintf(qr->out, "Top %d documents (ranked):\n", shown);
+    } else {
+      fprintf(qr->out, "Matches %d documents (ranked):\n", n);
+    }
+  }
+  for (int i = (st == NULL) ? 0 : st->printed; i < shown; i++) {
+    if (cancel_check(qr->cancel)) {
+      print_cancelled(qr);    // a URL at a time, so check each one
+      return;
+    }
+    print_result(&docs[i], opts, qr);
+  }
+  if (st != NULL) {
+    if (opts->topK > 0) {
+      fprintf(qr->out, "Top %d of %d documents (ranked).\n", shown, n);
     } else {
-      printf("score %3d  doc %3d: %s\n", score, id, url);
-      mem_free(url);
+      fprintf(qr->out, "Matched %d documents (ranked).\n", n);
     }
+    st->nqueries++;
+    st->nearly += st->printed;
+    st->nresults += shown;
+    st->msfirst += st->first - st->start;
+    st->mslast += timing_ms() - st->start;
+  }
+  if (hidden > 0) {
+    fprintf(qr->out, "(%d near-duplicate documents hidden)\n", hidden);
   }
-  printf("-----------------------------------------------\n");
+  fprintf(qr->out, "%s\n", ANSWERS_SEPARATOR);
+}
 
-  mem_free(docs);
+/* print_cancelled */
+/* Say why the query stopped, in place of the rest of its results. */
+static void
+print_cancelled(const querier_t *qr)
+{
+  if (qr->ranking != NULL) {
+    qr->ranking->cancelled = true;
+    return;
+  }
+  fprintf(qr->out, "Query cancelled (%s).\n",
+          cancel_name(cancel_reason(qr->cancel)));
+  fprintf(qr->out, "%s\n", ANSWERS_SEPARATOR);
+}
+
+/* print_result */
+/* Print one result with the URL of its page (and a snippet with
+ * -snippets). With -stream the line is flushed at once, and the time
+ * of the query's first one is noted.
+ */
+static void
+print_result(const docscore_t *ds, const options_t *opts,
+             const querier_t *qr)
+{
+  int id = ds->docID;
+  int score = ds->score;
+  char *url = get_url(opts->pageDirectory, id);
+
+  if (url == NULL) {
+    fprintf(qr->out, "score %3d  doc %3d: (no-url)\n", score, id);
+  } else {
+    fprintf(qr->out, "score %3d  doc %3d: %s\n", score, id, url);
+    mem_free(url);
+  }
+  if (qr->snipper != NULL) {
+    const char *snippet = snippet_get(qr->snipper, id);
+    fprintf(qr->out, "      %s\n", (snippet == NULL) ? "(no snippet)" : snippet);
+  }
+  if (qr->stream != NULL) {
+    fflush(qr->out);
+    if (qr->stream->first == 0) {
+      qr->stream->first = timing_ms();
+    }
+  }
 }
 
 /* count_nonzero */
@@ -610,23 +2804,9 @@ collect_nonzero(void *arg, const int key, int count)
   ca->index++;
 }
 
-/* cmp_docscore_desc */
-/* qsort comparison: sort docscore_t by score, descending. */
-static int
-cmp_docscore_desc(const void *a, const void *b)
-{
-  const docscore_t *da = a;
-  const docscore_t *db = b;
-  return db->score - da->score;
-}
-
-/* get_url */
-/* Given pageDirectory and docID, open the corresponding file and
- * return a newly-allocated string containing the URL (first line).
- * Caller must free the returned string with mem_free.
- * Returns NULL on error.
- */
-static char *
+/**************** get_url ****************/
+/* see querier.h for description */
+char *
 get_url(const char *pageDirectory, const int docID)
 {
   if (pageDirectory == NULL || docID <= 0) {
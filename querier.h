@@ -0,0 +1,261 @@
+/*
+ * querier.h - header file for the querier's own modules
+ *
+ * The options, loaded data and per-query state that querier.c answers
+ * queries with, and the parts of its query loop (reading, answering
+ * and reporting on a query) that the modules running other loops over
+ * the same answering code share with it.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __QUERIER_H
+#define __QUERIER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <limits.h>     // PATH_MAX
+#include "index.h"
+#include "query.h"
+#include "postings.h"
+#include "hosts.h"
+#include "docattrs.h"
+#include "simhash.h"
+#include "snippet.h"
+#include "batch.h"
+#include "nodes.h"
+#include "cancel.h"
+#include "shadow.h"
+#include "listener.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+/* limits on host:/site: filters and predicates in one query */
+#define MAX_FILTERS    8
+#define MAX_PREDS      8
+#define FILTER_NAMEMAX 256
+
+/* how many recent snippets to cache */
+#define SNIPPET_CACHE  512
+
+/* with -workers, at most this many queries per worker wait to be
+ * printed, unless stdin is a terminal (then one at a time) */
+#define WORKERS_WINDOW 4
+
+/* with -serve, at most this many indexes */
+#define HOSTED_MAX     16
+
+/* engine_t: the evaluation engines; ENGINE_AUTO picks one per query. */
+typedef enum engine {
+  ENGINE_TAAT, ENGINE_DAAT, ENGINE_BLOCK, ENGINE_AUTO
+} engine_t;
+#define NUM_ENGINES 3
+
+/* shape_t: query shapes TAAT evaluates with a dedicated fast path. */
+typedef enum shape {
+  SHAPE_ONE, SHAPE_AND2, SHAPE_OR2, SHAPE_GENERIC
+} shape_t;
+#define NUM_SHAPES 3
+
+/* numa_t: where -numa puts the index data of each NUMA node. */
+typedef enum numa {
+  NUMA_OFF, NUMA_REPLICATE, NUMA_INTERLEAVE
+} numa_t;
+
+/* options_t: everything chosen on the command line. */
+typedef struct options {
+  char *pageDirectory;
+  char *indexFilename;
+  int topK;            // print at most topK results; 0 means all
+  bool tiered;         // try tier 1 before the full index (needs topK)
+  bool collapse;       // hide near-duplicate results
+  bool snippets;       // print a snippet under each result
+  engine_t engine;     // evaluation engine
+  bool stats;          // report statistics on exit
+  bool bloom;          // Bloom filters on long posting lists
+  bool plan;           // plan queries from posting-list sketches
+  bool batch;          // read all queries, then answer them sharing work
+  bool compressed;     // compressed postings behind a block cache
+  int cacheBlocks;     // ...of this many decoded blocks
+  bool nofast;         // no fast paths for common query shapes
+  int threads;         // threads for sorting large result sets
+  bool stream;         // print results as soon as they are final
+  int workers;         // threads answering queries; 0: the main thread
+  int lanes;           // ...of which this many answer costly queries
+  int slowCost;        // ...those of more postings than this
+  numa_t numa;         // NUMA placement of index data and workers
+  int timeoutMs;       // cancel queries running longer; 0: no limit
+  char *serveFile;     // the indexes to serve; NULL: just the one given
+  int budgetKB;        // with -serve, KB of answers to cache
+  bool shadow;         // compare an engine with the counters, in shadow
+  engine_t shadowEngine;  // ...this one
+  int samplePercent;   // ...on this percentage of queries
+  char *inputs;        // comma-separated query streams; NULL: stdin
+  int slice;           // ...taking turns every this many postings
+  int listenPort;      // serve clients on this port; -1: read stdin
+  listen_io_t listenIO;  // ...with this event loop
+  int replicas;        // front end to this many copies; 0: none
+  int hedgePercent;    // ...hedging after this percentile; 0: never
+} options_t;
+
+/* stream_t: with -stream, the current query's progress, and totals. */
+typedef struct stream {
+  int printed;         // results of this query printed before evaluation
+  double start;        // when this query started, in ms
+  double first;        // when its first result was printed, or 0
+  int nqueries;        // queries that matched something
+  long nearly;         // ...results printed before evaluation
+  long nresults;       // ...results printed in all
+  double msfirst;      // ...total ms to their first result
+  double mslast;       // ...total ms to their last
+} stream_t;
+
+/* ranking_t: one index's share of a federated query: the results
+ * print_ranked would have printed, kept instead. */
+typedef struct ranking {
+  docscore_t *docs;    // the results it would show, best first
+  int n;
+  int hidden;          // near-duplicates hidden
+  bool cancelled;
+} ranking_t;
+
+/* querier_t: the loaded data that every query is evaluated against. */
+typedef struct querier {
+  index_t *index;
+  postings_t *postings;   // sorted postings; NULL unless a mode needs them
+  hosts_t *hosts;         // host of every page, with per-host bitmaps
+  docattrs_t *attrs;      // per-page attribute columns
+  simhashes_t *simhashes; // page fingerprints; NULL unless -collapse
+  snipper_t *snipper;     // snippet maker; NULL unless -snippets
+  batch_t *batch;         // shared work of the batch; NULL unless -batch
+  stream_t *stream;       // streaming progress; NULL unless -stream
+  FILE *out;              // where results go: stdout, or a worker's buffer
+  cancel_t *cancel;       // this thread's token for cancelling queries
+  ranking_t *ranking;     // where results go instead, if not NULL
+  shadow_t *shadow;       // -shadow's comparisons; NULL unless -shadow
+} querier_t;
+
+/* replica_t: the index data one NUMA node's workers read (with -numa
+ * replicate; otherwise there is one, shared by all). */
+typedef struct replica {
+  index_t *index;
+  postings_t *postings;   // sorted postings; NULL unless a mode needs them
+  double msload;          // ms taken to load it
+} replica_t;
+
+/* filter_t: the non-word terms of one query: host filters, attribute
+ * predicates, and the sort order. */
+typedef struct filter {
+  int n;                     // host filters
+  char names[MAX_FILTERS][FILTER_NAMEMAX];
+  bool site[MAX_FILTERS];    // site: (subdomains too) rather than host:
+  int npreds;                // attribute predicates, all must hold
+  pred_t preds[MAX_PREDS];
+  bool sorted;               // sort:attr given
+  attr_t sortAttr;
+  bool sortDesc;             // sort:-attr
+  char echo[FILTER_NAMEMAX * 2];  // the terms, for the "Query:" line
+} filter_t;
+
+/* stats_t: counts and timings, reported on exit. */
+typedef struct stats {
+  int nqueries;                  // queries evaluated
+  int ntier1;                    // ...of which tier 1 alone answered
+  int nengine[NUM_ENGINES];      // ...evaluated by each engine
+  double msengine[NUM_ENGINES];  // milliseconds spent in each engine
+  double msbatch;                // milliseconds spent in batch_evaluate
+  int nshape[NUM_SHAPES];        // TAAT queries taking each fast path
+  int ncancelled[CANCEL_REASONS];  // queries cancelled, by reason
+  double mscancel;               // ms from cancellation to stopping
+} stats_t;
+
+/* worker_t: one -workers thread's own state. */
+typedef struct worker {
+  const options_t *opts;
+  const nodes_t *nodes;   // NULL: not pinned
+  int node;
+  querier_t qr;           // its node's replica, its own snippet cache
+  stats_t stats;
+  struct server *server;  // with -serve, the indexes (serve.h); else NULL
+  snipper_t *snippers[HOSTED_MAX];  // with -serve, one per index...
+  int snipGen[HOSTED_MAX];          // ...for this generation of it
+} worker_t;
+
+/**************** prompt ****************/
+/* Print a prompt only if stdin is a terminal (interactive use). */
+void prompt(void);
+
+/**************** output_gone ****************/
+/* Return true once nobody reads our output: a write to stdout failed
+ * (with SIGPIPE ignored, writing to a closed pipe fails with EPIPE), or
+ * a cancellation check saw the other end hang up.
+ */
+bool output_gone(void);
+
+/**************** valid_files ****************/
+/* Return true if pageDirectory was made by the crawler and
+ * indexFilename is readable; otherwise say which is wrong.
+ */
+bool valid_files(const char *pageDirectory, const char *indexFilename);
+
+/**************** load_replica ****************/
+/* Load the index, and the sorted postings if the options need them,
+ * into *replica. Returns false, having said why, on failure.
+ */
+bool load_replica(const options_t *opts, replica_t *replica);
+
+/**************** read_query ****************/
+/* Extract the filters from line, then clean, tokenize and validate
+ * the words left. Returns true, with *words_out (which the caller
+ * frees) pointing into line, if there is a query to answer; otherwise
+ * prints any error and returns false.
+ */
+bool read_query(char *line, char ***words_out, int *nwords_out,
+                filter_t *filter);
+
+/**************** print_query ****************/
+/* Print the cleaned query, with its filter terms, onto out. */
+void print_query(char **words, const int nwords, const filter_t *filter,
+                 FILE *out);
+
+/**************** filter_bitmap ****************/
+/* Return a new bitmap of the documents allowed by the filter terms
+ * (the union over all of them), or NULL if there are no filter terms.
+ */
+bitmap_t *filter_bitmap(const filter_t *filter, const hosts_t *hosts);
+
+/**************** answer_query ****************/
+/* Evaluate one validated query and print its ranked results, or as many
+ * of them as come before the query is cancelled; count cancellations.
+ * With -shadow, a sampled query is then handed to the shadow thread.
+ */
+void answer_query(const options_t *opts, querier_t *qr, char **words,
+                  const int nwords, const filter_t *filter, stats_t *stats);
+
+/**************** rank_docs ****************/
+/* Filter, sort, collapse and print an array of candidate results, in
+ * any order; the array is reordered in place.
+ */
+void rank_docs(docscore_t *docs, int n, const options_t *opts,
+               const querier_t *qr, const filter_t *filter);
+
+/**************** stats_add ****************/
+/* Add the counts and timings of src to dest. */
+void stats_add(stats_t *dest, const stats_t *src);
+
+/**************** print_stats ****************/
+/* Print the statistics the options asked for, on stderr. */
+void print_stats(const options_t *opts, const querier_t *qr,
+                 const stats_t *stats);
+
+/**************** get_url ****************/
+/* Given pageDirectory and docID, open the corresponding file and
+ * return a newly-allocated string containing the URL (first line).
+ * Caller must free the returned string with mem_free.
+ * Returns NULL on error.
+ */
+char *get_url(const char *pageDirectory, const int docID);
+
+#endif // __QUERIER_H
@@ -0,0 +1,79 @@
+/*
+ * query.c - 'query' module for the CS50 TSE querier
+ *
+ * see query.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "query.h"
+#include "mem.h"
+
+/**************** query_new ****************/
+/* see query.h for description */
+query_t *
+query_new(char **words, const int nwords)
+{
+  if (words == NULL || nwords < 0) {
+    return NULL;
+  }
+
+  query_t *query = mem_malloc_assert(sizeof(query_t), "query_new");
+
+  /* there are at most (nwords+1)/2 andsequences and nwords terms */
+  query->nseqs = 0;
+  query->seqs = mem_malloc_assert(sizeof(andseq_t) * (nwords/2 + 1),
+                                  "query_new seqs");
+  char **terms = mem_malloc_assert(sizeof(char*) * (nwords + 1),
+                                   "query_new terms");
+  query->terms = terms;
+
+  andseq_t *seq = NULL;
+  int nterms = 0;
+  for (int i = 0; i < nwords; i++) {
+    if (strcmp(words[i], "or") == 0) {
+      seq = NULL;                 // next word starts a new andsequence
+      continue;
+    }
+    if (strcmp(words[i], "and") == 0) {
+      continue;
+    }
+    if (seq == NULL) {
+      seq = &query->seqs[query->nseqs++];
+      seq->nterms = 0;
+      seq->terms = &terms[nterms];
+    }
+    terms[nterms++] = words[i];
+    seq->nterms++;
+  }
+  return query;
+}
+
+/**************** query_delete ****************/
+/* see query.h for description */
+void
+query_delete(query_t *query)
+{
+  if (query == NULL) {
+    return;
+  }
+  mem_free(query->terms);
+  mem_free(query->seqs);
+  mem_free(query);
+}
+
+/**************** docscore_cmp ****************/
+/* see query.h for description */
+int
+docscore_cmp(const void *a, const void *b)
+{
+  const docscore_t *da = a;
+  const docscore_t *db = b;
+  if (da->score != db->score) {
+    return (db->score > da->score) ? 1 : -1;
+  }
+  return (da->docID > db->docID) - (da->docID < db->docID);
+}
@@ -0,0 +1,56 @@
+/*
+ * query.h - header file for the querier's 'query' module
+ *
+ * A query_t is the parsed form of a validated query: a list of
+ * andsequences, each a list of words, where the andsequences are
+ * combined with "or". The module also defines docscore_t, the
+ * (docID, score) pair used everywhere results are ranked.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __QUERY_H
+#define __QUERY_H
+
+/* docscore_t: pair of docID and its score for ranking. */
+typedef struct docscore {
+  int docID;
+  int score;
+} docscore_t;
+
+/* andseq_t: one andsequence; the words are implicitly and'ed. */
+typedef struct andseq {
+  int nterms;
+  char **terms;        // points into the caller's words
+} andseq_t;
+
+/* query_t: andsequences that are or'ed together. */
+typedef struct query {
+  int nseqs;
+  andseq_t *seqs;
+  char **terms;        // storage shared by all andsequences
+} query_t;
+
+/**************** query_new ****************/
+/* Group a validated token array into andsequences.
+ *
+ * Caller provides:
+ *   words and nwords as produced by the querier's tokenizer; the
+ *   tokens must already have passed syntax validation.
+ * We return:
+ *   a new query_t, which the caller must free with query_delete.
+ *   The query keeps pointers into words, so words must outlive it.
+ */
+query_t *query_new(char **words, const int nwords);
+
+/**************** query_delete ****************/
+/* Free a query_t created by query_new; NULL is ignored. */
+void query_delete(query_t *query);
+
+/**************** docscore_cmp ****************/
+/* qsort comparison for docscore_t: score descending, then docID
+ * ascending, so that the ranked order is fully deterministic.
+ */
+int docscore_cmp(const void *a, const void *b);
+
+#endif // __QUERY_H
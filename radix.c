@@ -0,0 +1,226 @@
+/*
+ * radix.c - 'radix' module for the CS50 TSE querier
+ *
+ * see radix.h for more information.
+ *
+ * A key holds, high to low, the score with its sign bit flipped (so
+ * that signed order becomes unsigned order) and then complemented (so
+ * higher scores come first), and the docID with its sign bit flipped.
+ * Every pass distributes the keys by one byte, least significant first;
+ * a pass is skipped when one bucket would receive every key.
+ *
+ * With several threads, thread t owns slice t of the array. In each
+ * pass every thread counts the bytes of its slice; after a barrier,
+ * thread 0 turns the counts into each thread's starting position in
+ * each bucket (bucket by bucket, thread by thread, which keeps equal
+ * bytes in their old order); after another barrier every thread
+ * scatters its slice, and a last barrier ends the pass.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* pthread_barrier_t is POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "radix.h"
+#include "mem.h"
+
+/* bits sorted per pass */
+#define RADIX_BITS    8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+#define RADIX_PASSES  (64 / RADIX_BITS)
+
+/**************** local types ****************/
+/* sort_t: the state all threads of one sort share. */
+typedef struct sort {
+  int n;
+  int nthreads;
+  docscore_t *docs;
+  uint64_t *keys[2];       // the keys, and room to scatter them
+  long (*counts)[RADIX_BUCKETS];  // per thread: counts, then positions
+  bool skip;               // this pass would not move anything
+  cancel_t *cancel;        // checked by thread 0 before every pass
+  bool stop;               // ...and it said stop
+  pthread_barrier_t barrier;
+} sort_t;
+
+/* worker_t: one thread's part of a sort. */
+typedef struct worker {
+  sort_t *sort;
+  int id;
+} worker_t;
+
+/**************** local functions ****************/
+static void *sort_slice(void *arg);
+static void sort_wait(sort_t *sort);
+static inline uint64_t pack_key(const docscore_t ds);
+static inline docscore_t unpack_key(const uint64_t key);
+
+/**************** radix_sort ****************/
+/* see radix.h for description */
+bool
+radix_sort(docscore_t *docs, const int n, const int nthreads,
+           cancel_t *cancel)
+{
+  if (docs == NULL || n < 2) {
+    return true;
+  }
+  if (n < RADIX_MIN) {
+    qsort(docs, n, sizeof(docscore_t), docscore_cmp);
+    return true;
+  }
+
+  int threads = (nthreads < 1) ? 1 : nthreads;
+  if (threads > RADIX_MAXTHREADS) {
+    threads = RADIX_MAXTHREADS;
+  }
+  if (n < RADIX_PARALLEL_MIN) {
+    threads = 1;
+  }
+
+  long counts[RADIX_MAXTHREADS][RADIX_BUCKETS];
+  sort_t sort;
+  sort.n = n;
+  sort.nthreads = threads;
+  sort.docs = docs;
+  sort.keys[0] = mem_malloc_assert(n * sizeof(uint64_t), "radix_sort");
+  sort.keys[1] = mem_malloc_assert(n * sizeof(uint64_t), "radix_sort");
+  sort.counts = counts;
+  sort.skip = false;
+  sort.cancel = cancel;
+  sort.stop = false;
+
+  worker_t workers[RADIX_MAXTHREADS];
+  for (int t = 0; t < threads; t++) {
+    workers[t].sort = &sort;
+    workers[t].id = t;
+  }
+
+  if (threads == 1) {
+    sort_slice(&workers[0]);
+  } else {
+    pthread_t tids[RADIX_MAXTHREADS];
+    pthread_barrier_init(&sort.barrier, NULL, threads);
+    for (int t = 1; t < threads; t++) {
+      if (pthread_create(&tids[t], NULL, sort_slice, &workers[t]) != 0) {
+        fprintf(stderr, "radix_sort: cannot start threads\n");
+        exit(2);
+      }
+    }
+    sort_slice(&workers[0]);
+    for (int t = 1; t < threads; t++) {
+      pthread_join(tids[t], NULL);
+    }
+    pthread_barrier_destroy(&sort.barrier);
+  }
+
+  mem_free(sort.keys[0]);
+  mem_free(sort.keys[1]);
+  return !sort.stop;
+}
+
+/* sort_slice */
+/* One thread's work (see the top of this file): pack its slice of the
+ * results into keys, take part in every pass, and unpack its slice of
+ * the sorted keys. If the sort is cancelled, every thread leaves at the
+ * same pass and nothing is unpacked. arg is a worker_t.
+ */
+static void *
+sort_slice(void *arg)
+{
+  worker_t *worker = arg;
+  sort_t *sort = worker->sort;
+  int id = worker->id;
+  long lo = (long) sort->n * id / sort->nthreads;
+  long hi = (long) sort->n * (id + 1) / sort->nthreads;
+  long *counts = sort->counts[id];
+
+  uint64_t *src = sort->keys[0];
+  uint64_t *dst = sort->keys[1];
+  for (long i = lo; i < hi; i++) {
+    src[i] = pack_key(sort->docs[i]);
+  }
+
+  for (int pass = 0; pass < RADIX_PASSES; pass++) {
+    int shift = pass * RADIX_BITS;
+    for (int b = 0; b < RADIX_BUCKETS; b++) {
+      counts[b] = 0;
+    }
+    for (long i = lo; i < hi; i++) {
+      counts[(src[i] >> shift) & (RADIX_BUCKETS - 1)]++;
+    }
+    sort_wait(sort);
+
+    if (id == 0) {
+      long pos = 0;
+      sort->skip = false;
+      sort->stop = cancel_check(sort->cancel);
+      for (int b = 0; b < RADIX_BUCKETS; b++) {
+        long bucket = pos;
+        for (int t = 0; t < sort->nthreads; t++) {
+          long count = sort->counts[t][b];
+          sort->counts[t][b] = pos;
+          pos += count;
+        }
+        /* every thread's keys, not one's, must share the byte */
+        sort->skip = sort->skip || (pos - bucket == sort->n);
+      }
+    }
+    sort_wait(sort);
+
+    if (sort->stop) {
+      return NULL;            // every thread sees it after the barrier
+    }
+    if (sort->skip) {
+      continue;               // nothing moves; nothing to wait for
+    }
+    for (long i = lo; i < hi; i++) {
+      dst[counts[(src[i] >> shift) & (RADIX_BUCKETS - 1)]++] = src[i];
+    }
+    sort_wait(sort);
+    uint64_t *swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  for (long i = lo; i < hi; i++) {
+    sort->docs[i] = unpack_key(src[i]);
+  }
+  return NULL;
+}
+
+/* sort_wait */
+/* Wait until every thread of the sort gets here. */
+static void
+sort_wait(sort_t *sort)
+{
+  if (sort->nthreads > 1) {
+    pthread_barrier_wait(&sort->barrier);
+  }
+}
+
+/* pack_key */
+/* Pack a result into a key whose unsigned order is the ranked order. */
+static inline uint64_t
+pack_key(const docscore_t ds)
+{
+  uint32_t score = ~((uint32_t) ds.score ^ 0x80000000u);
+  uint32_t docID = (uint32_t) ds.docID ^ 0x80000000u;
+  return ((uint64_t) score << 32) | docID;
+}
+
+/* unpack_key */
+/* Recover the result packed by pack_key. */
+static inline docscore_t
+unpack_key(const uint64_t key)
+{
+  docscore_t ds;
+  ds.score = (int) (~(uint32_t) (key >> 32) ^ 0x80000000u);
+  ds.docID = (int) ((uint32_t) key ^ 0x80000000u);
+  return ds;
+}
@@ -0,0 +1,45 @@
+/*
+ * radix.h - header file for the querier's 'radix' module
+ *
+ * Sorts results into ranked order — score descending, then docID
+ * ascending, exactly as docscore_cmp — with an LSD radix sort instead
+ * of qsort and its comparator callback. Each (score, docID) pair is
+ * packed into one 64-bit key whose unsigned order is the ranked order;
+ * the keys are sorted a byte at a time, skipping bytes that all keys
+ * share (with small scores and docIDs most of them), and unpacked.
+ *
+ * Large arrays are sorted by several threads: each counts and then
+ * scatters its own slice of the keys, and the slices' counts are
+ * combined in thread order, so the sort stays stable and the result is
+ * the same for any number of threads.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __RADIX_H
+#define __RADIX_H
+
+#include <stdbool.h>
+#include "query.h"
+#include "cancel.h"
+
+/* below this many results qsort is faster */
+#define RADIX_MIN 256
+
+/* below this many results one thread is faster */
+#define RADIX_PARALLEL_MIN (1 << 16)
+
+/* most threads radix_sort will use */
+#define RADIX_MAXTHREADS 16
+
+/**************** radix_sort ****************/
+/* Sort the n results in docs into docscore_cmp order, using up to
+ * nthreads threads (at most RADIX_MAXTHREADS, and only when n is at
+ * least RADIX_PARALLEL_MIN). cancel (NULL: never stop) is checked
+ * before every pass; returns false, leaving docs as they were, if it
+ * stopped the sort. Exits if out of memory.
+ */
+bool radix_sort(docscore_t *docs, const int n, const int nthreads,
+                cancel_t *cancel);
+
+#endif // __RADIX_H
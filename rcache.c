@@ -0,0 +1,340 @@
+/*
+ * rcache.c - 'rcache' module for the CS50 TSE querier
+ *
+ * see rcache.h for more information.
+ *
+ * Answers live on one hash table, keyed by (part, key), and on their
+ * part's LRU list. One mutex guards everything; answers are copied in
+ * and out under it, which is cheap next to evaluating a query. An
+ * answer's size counts its key, its text and its entry.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "rcache.h"
+#include "mem.h"
+
+/* hash buckets to start with; doubled when entries outnumber them */
+#define RCACHE_BUCKETS 1024
+
+/**************** local types ****************/
+/* entry_t: one cached answer. */
+typedef struct entry {
+  int part;
+  char *key;
+  char *answer;
+  size_t length;
+  size_t size;             // bytes charged to the part
+  unsigned long hash;
+  struct entry *chain;     // next in the same bucket
+  struct entry *prev, *next;   // part's LRU list; head is most recent
+} entry_t;
+
+/* part_t: one index's share of the cache. */
+typedef struct part {
+  entry_t *head, *tail;
+  rcachestats_t stats;
+} part_t;
+
+/**************** global types ****************/
+struct rcache {
+  size_t budget;
+  size_t bytes;            // in all parts
+  int nparts;
+  part_t parts[RCACHE_PARTS];
+  int nentries;
+  int nbuckets;
+  entry_t **buckets;
+  pthread_mutex_t lock;
+};
+
+/**************** local functions ****************/
+static entry_t *find(const rcache_t *cache, const int part, const char *key,
+                     const unsigned long hash);
+static void evict(rcache_t *cache, entry_t *entry);
+static void grow(rcache_t *cache);
+static unsigned long hash_key(const int part, const char *key);
+static void lru_unlink(part_t *part, entry_t *entry);
+static void lru_push(part_t *part, entry_t *entry);
+
+/**************** rcache_new ****************/
+/* see rcache.h for description */
+rcache_t *
+rcache_new(const size_t budget, const int nparts, const size_t quotas[])
+{
+  if (nparts < 1 || nparts > RCACHE_PARTS || quotas == NULL) {
+    return NULL;
+  }
+  size_t assigned = 0;
+  int shares = 0;
+  for (int p = 0; p < nparts; p++) {
+    assigned += quotas[p];
+    shares += (quotas[p] == 0);
+  }
+  if (assigned > budget) {
+    return NULL;
+  }
+
+  rcache_t *cache = mem_calloc_assert(1, sizeof(rcache_t), "rcache_new");
+  cache->budget = budget;
+  cache->nparts = nparts;
+  for (int p = 0; p < nparts; p++) {
+    cache->parts[p].stats.quota = (quotas[p] != 0) ? quotas[p]
+      : (budget - assigned) / shares;
+  }
+  cache->nbuckets = RCACHE_BUCKETS;
+  cache->buckets = mem_calloc_assert(cache->nbuckets, sizeof(entry_t *),
+                                     "rcache_new");
+  pthread_mutex_init(&cache->lock, NULL);
+  return cache;
+}
+
+/**************** rcache_get ****************/
+/* see rcache.h for description */
+bool
+rcache_get(rcache_t *cache, const int part, const char *key, FILE *out)
+{
+  if (cache == NULL || part < 0 || part >= cache->nparts || key == NULL) {
+    return false;
+  }
+  pthread_mutex_lock(&cache->lock);
+  part_t *pt = &cache->parts[part];
+  entry_t *entry = find(cache, part, key, hash_key(part, key));
+  if (entry != NULL) {
+    pt->stats.hits++;
+    lru_unlink(pt, entry);
+    lru_push(pt, entry);
+    fwrite(entry->answer, 1, entry->length, out);
+  } else {
+    pt->stats.misses++;
+  }
+  pthread_mutex_unlock(&cache->lock);
+  return entry != NULL;
+}
+
+/**************** rcache_put ****************/
+/* see rcache.h for description */
+void
+rcache_put(rcache_t *cache, const int part, const char *key,
+           const char *answer, const size_t length)
+{
+  if (cache == NULL || part < 0 || part >= cache->nparts || key == NULL
+      || answer == NULL) {
+    return;
+  }
+  size_t keylen = strlen(key);
+  size_t size = sizeof(entry_t) + keylen + 1 + length;
+  unsigned long hash = hash_key(part, key);
+
+  pthread_mutex_lock(&cache->lock);
+  part_t *pt = &cache->parts[part];
+  entry_t *old = find(cache, part, key, hash);
+  if (old != NULL) {
+    evict(cache, old);
+    pt->stats.evicted--;          // replaced, not evicted
+  }
+  if (size > pt->stats.quota) {
+    pt->stats.rejected++;
+    pthread_mutex_unlock(&cache->lock);
+    return;
+  }
+
+  /* make room, from the part furthest over its quota; the part adding
+   * counts as holding the new answer already */
+  while (cache->bytes + size > cache->budget) {
+    part_t *victim = NULL;
+    long worst = 0;
+    for (int p = 0; p < cache->nparts; p++) {
+      part_t *q = &cache->parts[p];
+      long over = (long) q->stats.bytes + (q == pt ? (long) size : 0)
+        - (long) q->stats.quota;
+      if (q->tail != NULL && (victim == NULL || over > worst)) {
+        victim = q;
+        worst = over;
+      }
+    }
+    evict(cache, victim->tail);   // bytes > 0, so some part has entries
+  }
+
+  entry_t *entry = mem_malloc_assert(sizeof(entry_t), "rcache_put");
+  entry->part = part;
+  entry->key = mem_malloc_assert(keylen + 1, "rcache_put");
+  memcpy(entry->key, key, keylen + 1);
+  entry->answer = mem_malloc_assert(length + 1, "rcache_put");
+  memcpy(entry->answer, answer, length);
+  entry->answer[length] = '\0';
+  entry->length = length;
+  entry->size = size;
+  entry->hash = hash;
+
+  int b = hash % cache->nbuckets;
+  entry->chain = cache->buckets[b];
+  cache->buckets[b] = entry;
+  lru_push(pt, entry);
+  pt->stats.entries++;
+  pt->stats.bytes += size;
+  cache->bytes += size;
+  if (++cache->nentries > cache->nbuckets) {
+    grow(cache);
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+/**************** rcache_drop ****************/
+/* see rcache.h for description */
+void
+rcache_drop(rcache_t *cache, const int part)
+{
+  if (cache == NULL || part < 0 || part >= cache->nparts) {
+    return;
+  }
+  pthread_mutex_lock(&cache->lock);
+  part_t *pt = &cache->parts[part];
+  long evicted = pt->stats.evicted;
+  while (pt->tail != NULL) {
+    evict(cache, pt->tail);
+  }
+  pt->stats.evicted = evicted;    // dropped, not evicted
+  pthread_mutex_unlock(&cache->lock);
+}
+
+/**************** rcache_stats ****************/
+/* see rcache.h for description */
+void
+rcache_stats(rcache_t *cache, const int part, rcachestats_t *stats)
+{
+  if (cache == NULL || part < 0 || part >= cache->nparts || stats == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&cache->lock);
+  *stats = cache->parts[part].stats;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+/**************** rcache_delete ****************/
+/* see rcache.h for description */
+void
+rcache_delete(rcache_t *cache)
+{
+  if (cache == NULL) {
+    return;
+  }
+  for (int p = 0; p < cache->nparts; p++) {
+    while (cache->parts[p].tail != NULL) {
+      evict(cache, cache->parts[p].tail);
+    }
+  }
+  pthread_mutex_destroy(&cache->lock);
+  mem_free(cache->buckets);
+  mem_free(cache);
+}
+
+/* find */
+/* Return the entry of part under key, whose hash is hash, or NULL. */
+static entry_t *
+find(const rcache_t *cache, const int part, const char *key,
+     const unsigned long hash)
+{
+  for (entry_t *e = cache->buckets[hash % cache->nbuckets]; e != NULL;
+       e = e->chain) {
+    if (e->hash == hash && e->part == part && strcmp(e->key, key) == 0) {
+      return e;
+    }
+  }
+  return NULL;
+}
+
+/* evict */
+/* Take entry out of the table and its part's list, and free it. */
+static void
+evict(rcache_t *cache, entry_t *entry)
+{
+  entry_t **link = &cache->buckets[entry->hash % cache->nbuckets];
+  while (*link != entry) {
+    link = &(*link)->chain;
+  }
+  *link = entry->chain;
+
+  part_t *pt = &cache->parts[entry->part];
+  lru_unlink(pt, entry);
+  pt->stats.entries--;
+  pt->stats.bytes -= entry->size;
+  pt->stats.evicted++;
+  cache->bytes -= entry->size;
+  cache->nentries--;
+  mem_free(entry->key);
+  mem_free(entry->answer);
+  mem_free(entry);
+}
+
+/* grow */
+/* Double the hash buckets, rehashing every entry. */
+static void
+grow(rcache_t *cache)
+{
+  int nbuckets = 2 * cache->nbuckets;
+  entry_t **buckets = mem_calloc_assert(nbuckets, sizeof(entry_t *),
+                                        "rcache_put");
+  for (int b = 0; b < cache->nbuckets; b++) {
+    entry_t *e = cache->buckets[b];
+    while (e != NULL) {
+      entry_t *next = e->chain;
+      e->chain = buckets[e->hash % nbuckets];
+      buckets[e->hash % nbuckets] = e;
+      e = next;
+    }
+  }
+  mem_free(cache->buckets);
+  cache->buckets = buckets;
+  cache->nbuckets = nbuckets;
+}
+
+/* hash_key */
+/* djb2 string hash, seeded with the part. */
+static unsigned long
+hash_key(const int part, const char *key)
+{
+  unsigned long h = 5381 + part;
+  for (const char *c = key; *c != '\0'; c++) {
+    h = h * 33 + (unsigned char) *c;
+  }
+  return h;
+}
+
+/* lru_unlink */
+/* Take entry off its part's LRU list. */
+static void
+lru_unlink(part_t *part, entry_t *entry)
+{
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+  } else {
+    part->head = entry->next;
+  }
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+  } else {
+    part->tail = entry->prev;
+  }
+}
+
+/* lru_push */
+/* Put entry at the front (most recent end) of its part's LRU list. */
+static void
+lru_push(part_t *part, entry_t *entry)
+{
+  entry->prev = NULL;
+  entry->next = part->head;
+  if (part->head != NULL) {
+    part->head->prev = entry;
+  }
+  part->head = entry;
+  if (part->tail == NULL) {
+    part->tail = entry;
+  }
+}
@@ -0,0 +1,79 @@
+/*
+ * rcache.h - header file for the querier's 'rcache' module
+ *
+ * A cache of whole answers (the text printed for a query), shared by
+ * all the indexes a serving querier hosts and by all its workers, and
+ * safe to use from any thread.
+ *
+ * The cache holds at most a global budget of bytes, divided among its
+ * parts (one per index) by quota. A part may grow past its quota while
+ * the budget has room; when an answer does not fit, the least recently
+ * used answers of the part furthest over its quota (which may be the
+ * one adding) are evicted until it does. So a busy index can borrow
+ * the memory an idle one is not using, but never keeps another index
+ * below its quota.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __RCACHE_H
+#define __RCACHE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* most parts in one cache */
+#define RCACHE_PARTS 64
+
+typedef struct rcache rcache_t;
+
+/* rcachestats_t: what one part of the cache holds and has done. */
+typedef struct rcachestats {
+  size_t quota;        // bytes the part is guaranteed
+  size_t bytes;        // bytes its answers take now, keys included
+  int entries;         // answers it holds now
+  long hits;           // lookups answered from the cache
+  long misses;         // ...and not
+  long evicted;        // answers dropped to make room
+  long rejected;       // answers too large to cache
+} rcachestats_t;
+
+/**************** rcache_new ****************/
+/* Return a new cache of budget bytes in nparts parts (1..RCACHE_PARTS);
+ * part p is guaranteed quotas[p] bytes. A quota of 0 gets an equal
+ * share of what the other quotas leave of the budget. Returns NULL if
+ * the quotas add up to more than the budget. Caller must rcache_delete
+ * the cache.
+ */
+rcache_t *rcache_new(const size_t budget, const int nparts,
+                     const size_t quotas[]);
+
+/**************** rcache_get ****************/
+/* If part holds an answer under key, write it onto out and return
+ * true; else return false.
+ */
+bool rcache_get(rcache_t *cache, const int part, const char *key,
+                FILE *out);
+
+/**************** rcache_put ****************/
+/* Keep a copy of the length bytes of answer in part, under key,
+ * replacing any answer already there. Answers larger than the part's
+ * quota are not kept.
+ */
+void rcache_put(rcache_t *cache, const int part, const char *key,
+                const char *answer, const size_t length);
+
+/**************** rcache_drop ****************/
+/* Drop every answer of part (say, because its index was reloaded). */
+void rcache_drop(rcache_t *cache, const int part);
+
+/**************** rcache_stats ****************/
+/* Fill *stats with part's counts so far. */
+void rcache_stats(rcache_t *cache, const int part, rcachestats_t *stats);
+
+/**************** rcache_delete ****************/
+/* Free the cache and its answers; NULL is ignored. */
+void rcache_delete(rcache_t *cache);
+
+#endif // __RCACHE_H
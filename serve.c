@@ -0,0 +1,715 @@
+/*
+ * serve.c - 'serve' module for the CS50 TSE querier
+ *
+ * see serve.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* fileno and open_memstream are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <unistd.h>     // isatty
+#include <pthread.h>
+#include "workers.h"
+#include "hashtable.h"
+#include "rcache.h"
+#include "losertree.h"
+#include "answers.h"
+#include "querier.h"
+#include "serve.h"
+#include "mem.h"
+
+/* served indexes have names at most this long */
+#define HOSTED_NAMEMAX 64
+
+/**************** local types ****************/
+/* corpus_t: everything loaded for one index of -serve; a reload
+ * replaces it as a whole. */
+typedef struct corpus {
+  replica_t replica;
+  hosts_t *hosts;
+  docattrs_t *attrs;
+  simhashes_t *simhashes; // NULL unless -collapse
+  int refs;               // queries reading it now
+} corpus_t;
+
+/* hosted_t: one index served with -serve. */
+typedef struct hosted {
+  char name[HOSTED_NAMEMAX];
+  char pageDirectory[PATH_MAX];
+  char indexFilename[PATH_MAX];
+  options_t opts;         // the querier's, with this index's files
+  size_t quota;           // bytes of the answer cache it is guaranteed
+  corpus_t *corpus;       // the current copy
+  int generation;         // times reloaded
+  bool reloading;
+} hosted_t;
+
+/* server_t: the indexes served with -serve, and what they share. */
+typedef struct server {
+  int n;
+  hosted_t hosted[HOSTED_MAX];
+  rcache_t *cache;        // answers, one part per index
+  pthread_mutex_t lock;   // guards corpus, generation, refs, reloading
+} server_t;
+
+/* federate_t: one index's part in a federated query, evaluated on a
+ * thread of its own. */
+typedef struct federate {
+  const options_t *opts;  // the index's
+  int h;                  // which index
+  corpus_t *corpus;       // the copy it reads
+  querier_t qr;
+  stats_t stats;
+  char **words;
+  int nwords;
+  const filter_t *filter;
+  ranking_t ranking;
+  int next;               // merge cursor into ranking.docs
+} federate_t;
+
+/**************** local functions ****************/
+static void read_config(const options_t *opts, server_t *server);
+static int find_hosted(const server_t *server, const char *name);
+static corpus_t *load_corpus(const options_t *opts);
+static void corpus_delete(corpus_t *corpus);
+static void serve_answer(void *arg, char *line, FILE *out);
+static int select_hosted(const server_t *server, const char *names,
+                         const size_t len, int *targets);
+static void serve_reload(server_t *server, const int h, FILE *out);
+static corpus_t *corpus_acquire(server_t *server, const int h,
+                                int *generation_out);
+static void corpus_release(server_t *server, const int h, corpus_t *corpus);
+static snipper_t *worker_snipper(worker_t *worker, const int h,
+                                 const int generation);
+static void serve_federated(worker_t *worker, const int *targets,
+                            const int ntargets, char **words,
+                            const int nwords, const filter_t *filter,
+                            FILE *out);
+static void *federate_one(void *arg);
+static bool federate_before(void *arg, const int a, const int b);
+
+/**************** serve_loop ****************/
+/* see serve.h for description */
+void
+serve_loop(const options_t *opts)
+{
+  server_t *server = mem_calloc_assert(1, sizeof(server_t), "serve_loop");
+  pthread_mutex_init(&server->lock, NULL);
+  read_config(opts, server);
+
+  size_t quotas[HOSTED_MAX];
+  for (int h = 0; h < server->n; h++) {
+    hosted_t *hosted = &server->hosted[h];
+    hosted->corpus = load_corpus(&hosted->opts);
+    if (hosted->corpus == NULL) {
+      exit(2);
+    }
+    quotas[h] = hosted->quota;
+    fprintf(stderr, "querier: serving '%s' from %s (loaded in %.1f ms)\n",
+            hosted->name, hosted->pageDirectory,
+            hosted->corpus->replica.msload);
+  }
+  server->cache = rcache_new((size_t) opts->budgetKB * 1024, server->n,
+                             quotas);
+  if (server->cache == NULL) {
+    fprintf(stderr, "querier: the quotas in '%s' add up to more than "
+            "-budget %d\n", opts->serveFile, opts->budgetKB);
+    exit(1);
+  }
+
+  int nworkers = opts->workers;
+  worker_t *workers = mem_calloc_assert(nworkers, sizeof(worker_t),
+                                        "serve_loop");
+  void *ctxs[WORKERS_MAX];
+  for (int w = 0; w < nworkers; w++) {
+    workers[w].opts = opts;
+    workers[w].server = server;
+    workers[w].qr.cancel = cancel_new(opts->timeoutMs, fileno(stdout));
+    ctxs[w] = &workers[w];
+  }
+  workers_t *pool = workers_new(nworkers, 1, NULL, ctxs, NULL,
+                                serve_answer);
+  workers_output(pool, stdout, true);
+
+  bool interactive = isatty(fileno(stdin));
+  int window = interactive ? 0 : WORKERS_WINDOW * nworkers;
+  char line[1024];
+  prompt();
+  while (fgets(line, sizeof(line), stdin) != NULL && !output_gone()) {
+    workers_submit(pool, line);
+    workers_drain(pool, window, stdout);
+    prompt();
+  }
+  workers_drain(pool, 0, stdout);
+  printf("\n");
+  workers_delete(pool);
+
+  stats_t stats;
+  memset(&stats, 0, sizeof(stats));
+  for (int w = 0; w < nworkers; w++) {
+    stats_add(&stats, &workers[w].stats);
+    for (int h = 0; h < server->n; h++) {
+      snippet_delete(workers[w].snippers[h]);
+    }
+    cancel_delete(workers[w].qr.cancel);
+  }
+  for (int h = 0; h < server->n; h++) {
+    rcachestats_t cs;
+    rcache_stats(server->cache, h, &cs);
+    fprintf(stderr, "querier: index '%s': %ld queries, %ld answered from "
+            "the cache; %zu of %zu KB cached in %d answers, %ld evicted; "
+            "reloaded %d times\n", server->hosted[h].name,
+            cs.hits + cs.misses, cs.hits, cs.bytes / 1024, cs.quota / 1024,
+            cs.entries, cs.evicted, server->hosted[h].generation);
+    corpus_delete(server->hosted[h].corpus);
+  }
+  querier_t report;
+  memset(&report, 0, sizeof(report));
+  print_stats(opts, &report, &stats);
+
+  rcache_delete(server->cache);
+  pthread_mutex_destroy(&server->lock);
+  mem_free(server);
+  mem_free(workers);
+}
+
+/* read_config */
+/* Read the indexes to serve from opts->serveFile into server: one per
+ * line, "name pageDirectory indexFilename [quotaKB]"; blank lines and
+ * lines starting with '#' are skipped. Exits if the file is wrong.
+ */
+static void
+read_config(const options_t *opts, server_t *server)
+{
+  FILE *fp = fopen(opts->serveFile, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "querier: cannot read '%s'\n", opts->serveFile);
+    exit(1);
+  }
+
+  char line[3 * PATH_MAX];
+  int lineno = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    lineno++;
+    char *p = line + strspn(line, " \t");
+    if (*p == '#' || *p == '\n' || *p == '\0') {
+      continue;
+    }
+    if (server->n == HOSTED_MAX) {
+      fprintf(stderr, "querier: %s:%d: more than %d indexes\n",
+              opts->serveFile, lineno, HOSTED_MAX);
+      exit(1);
+    }
+
+    hosted_t *hosted = &server->hosted[server->n];
+    char name[PATH_MAX];
+    int quotaKB = 0;
+    char extra[2];
+    int nfields = sscanf(p, "%4095s %4095s %4095s %d %1s", name,
+                         hosted->pageDirectory, hosted->indexFilename,
+                         &quotaKB, extra);
+    if (nfields < 3 || nfields > 4 || quotaKB < 0) {
+      fprintf(stderr, "querier: %s:%d: expected 'name pageDirectory "
+              "indexFilename [quotaKB]'\n", opts->serveFile, lineno);
+      exit(1);
+    }
+    if (strlen(name) >= HOSTED_NAMEMAX || find_hosted(server, name) >= 0) {
+      fprintf(stderr, "querier: %s:%d: index name '%s' is too long or "
+              "used twice\n", opts->serveFile, lineno, name);
+      exit(1);
+    }
+    if (!valid_files(hosted->pageDirectory, hosted->indexFilename)) {
+      exit(1);
+    }
+    strcpy(hosted->name, name);
+    hosted->quota = (size_t) quotaKB * 1024;
+    hosted->opts = *opts;
+    hosted->opts.pageDirectory = hosted->pageDirectory;
+    hosted->opts.indexFilename = hosted->indexFilename;
+    server->n++;
+  }
+  fclose(fp);
+
+  if (server->n == 0) {
+    fprintf(stderr, "querier: no indexes in '%s'\n", opts->serveFile);
+    exit(1);
+  }
+}
+
+/* find_hosted */
+/* Return the number of the index called name, or -1. */
+static int
+find_hosted(const server_t *server, const char *name)
+{
+  for (int h = 0; h < server->n; h++) {
+    if (strcmp(server->hosted[h].name, name) == 0) {
+      return h;
+    }
+  }
+  return -1;
+}
+
+/* load_corpus */
+/* Load everything the options need to answer queries from one index.
+ * Returns NULL, having said why, on failure.
+ */
+static corpus_t *
+load_corpus(const options_t *opts)
+{
+  corpus_t *corpus = mem_calloc_assert(1, sizeof(corpus_t), "load_corpus");
+  if (!load_replica(opts, &corpus->replica)) {
+    mem_free(corpus);
+    return NULL;
+  }
+  corpus->hosts = hosts_load(opts->pageDirectory);
+  corpus->attrs = docattrs_load(opts->pageDirectory, corpus->hosts);
+  if (opts->collapse) {
+    char filename[PATH_MAX];
+    snprintf(filename, sizeof(filename), "%s/%s", opts->pageDirectory,
+             SIMHASH_FILENAME);
+    corpus->simhashes = simhash_load(filename);
+    if (corpus->simhashes == NULL) {
+      fprintf(stderr, "querier: cannot read '%s'; run simhasher first\n",
+              filename);
+      corpus_delete(corpus);
+      return NULL;
+    }
+  }
+  return corpus;
+}
+
+/* corpus_delete */
+/* Free everything load_corpus loaded; NULL is ignored. */
+static void
+corpus_delete(corpus_t *corpus)
+{
+  if (corpus == NULL) {
+    return;
+  }
+  simhash_delete(corpus->simhashes);
+  docattrs_delete(corpus->attrs);
+  hosts_delete(corpus->hosts);
+  postings_delete(corpus->replica.postings);
+  index_delete(corpus->replica.index);
+  mem_free(corpus);
+}
+
+/* serve_answer */
+/* Answer one line of input onto out, with -serve: "!reload name"
+ * reloads an index; "@name query" answers the query from that index;
+ * any other line is a query for the first index. The answer comes from
+ * the cache if that index's current copy has answered the same query
+ * before. arg is the worker_t of the thread.
+ */
+static void
+serve_answer(void *arg, char *line, FILE *out)
+{
+  worker_t *worker = arg;
+  server_t *server = worker->server;
+  char *p = line + strspn(line, " \t");
+
+  /* which index */
+  bool reload = (strncmp(p, "!reload", 7) == 0
+                 && isspace((unsigned char) p[7]));
+  bool named = reload || *p == '@';
+  if (reload) {
+    p += 7 + strspn(p + 7, " \t");
+  } else if (named) {
+    p++;
+  }
+  int targets[HOSTED_MAX] = { 0 };
+  int ntargets = 1;
+  bool federated = false;
+  if (named) {
+    size_t len = strcspn(p, " \t\n");
+    federated = (memchr(p, ',', len) != NULL || (len == 1 && *p == '*'));
+    ntargets = select_hosted(server, p, len, targets);
+    if (ntargets < 0) {
+      return;
+    }
+    if (reload && federated) {
+      fprintf(stderr, "Error: reload one index at a time\n");
+      return;
+    }
+    p += len;
+  }
+  int h = targets[0];
+  if (reload) {
+    serve_reload(server, h, out);
+    return;
+  }
+
+  char **words = NULL;
+  int nwords = 0;
+  filter_t filter;
+  if (!read_query(p, &words, &nwords, &filter)) {
+    return;
+  }
+  if (federated) {
+    if (filter.sorted) {
+      fprintf(stderr, "Error: sort: cannot order results across "
+              "indexes\n");
+    } else {
+      print_query(words, nwords, &filter, out);
+      serve_federated(worker, targets, ntargets, words, nwords, &filter,
+                      out);
+    }
+    mem_free(words);
+    return;
+  }
+
+  /* pin the index's current copy while we read it */
+  hosted_t *hosted = &server->hosted[h];
+  int generation;
+  corpus_t *corpus = corpus_acquire(server, h, &generation);
+
+  /* the cleaned query, with the copy's generation, is the cache key */
+  char *echo = NULL;
+  size_t echoLen = 0;
+  FILE *fp = open_memstream(&echo, &echoLen);
+  fprintf(fp, "%d ", generation);
+  print_query(words, nwords, &filter, fp);
+  fclose(fp);
+  char *query = strchr(echo, ' ') + 1;
+  fputs(query, out);
+
+  if (!rcache_get(server->cache, h, echo, out)) {
+    querier_t *qr = &worker->qr;
+    qr->index = corpus->replica.index;
+    qr->postings = corpus->replica.postings;
+    qr->hosts = corpus->hosts;
+    qr->attrs = corpus->attrs;
+    qr->simhashes = corpus->simhashes;
+    qr->snipper = worker_snipper(worker, h, generation);
+
+    char *answer = NULL;
+    size_t length = 0;
+    qr->out = open_memstream(&answer, &length);
+    answer_query(&hosted->opts, qr, words, nwords, &filter,
+                 &worker->stats);
+    fclose(qr->out);
+    fwrite(answer, 1, length, out);
+    if (cancel_reason(qr->cancel) == CANCEL_NONE) {
+      rcache_put(server->cache, h, echo, answer, length);
+    }
+    free(answer);             // from open_memstream
+  }
+  free(echo);
+  mem_free(words);
+  corpus_release(server, h, corpus);
+}
+
+/* select_hosted */
+/* Fill targets with the indexes named by the len characters at names:
+ * one name, several separated by commas, or "*" for all. Returns how
+ * many, or -1 (having said why) if a name is unknown.
+ */
+static int
+select_hosted(const server_t *server, const char *names, const size_t len,
+              int *targets)
+{
+  if (len == 1 && *names == '*') {
+    for (int h = 0; h < server->n; h++) {
+      targets[h] = h;
+    }
+    return server->n;
+  }
+
+  int n = 0;
+  const char *end = names + len;
+  for (const char *p = names; p <= end; ) {
+    const char *comma = memchr(p, ',', end - p);
+    size_t nameLen = (comma == NULL) ? (size_t) (end - p)
+      : (size_t) (comma - p);
+    char name[HOSTED_NAMEMAX];
+    snprintf(name, sizeof(name), "%.*s", (int) nameLen, p);
+    int h = (nameLen < HOSTED_NAMEMAX) ? find_hosted(server, name) : -1;
+    if (h < 0) {
+      fprintf(stderr, "Error: no index named '%.*s'\n", (int) nameLen, p);
+      return -1;
+    }
+    bool seen = false;
+    for (int t = 0; t < n && !seen; t++) {
+      seen = (targets[t] == h);
+    }
+    if (!seen) {
+      targets[n++] = h;
+    }
+    p += nameLen + 1;
+  }
+  return n;
+}
+
+/* serve_reload */
+/* Load index h again and swap the new copy in, printing the outcome
+ * onto out. Queries already reading the old copy finish with it, and
+ * the last of them frees it; its cached answers are dropped.
+ */
+static void
+serve_reload(server_t *server, const int h, FILE *out)
+{
+  hosted_t *hosted = &server->hosted[h];
+  pthread_mutex_lock(&server->lock);
+  bool busy = hosted->reloading;
+  hosted->reloading = true;
+  pthread_mutex_unlock(&server->lock);
+  if (busy) {
+    fprintf(out, "Index '%s' is already being reloaded.\n", hosted->name);
+    return;
+  }
+
+  corpus_t *corpus = load_corpus(&hosted->opts);
+  pthread_mutex_lock(&server->lock);
+  corpus_t *old = NULL;
+  if (corpus != NULL) {
+    old = hosted->corpus;
+    hosted->corpus = corpus;
+    hosted->generation++;
+  }
+  hosted->reloading = false;
+  int generation = hosted->generation;
+  bool idle = (old != NULL && old->refs == 0);
+  pthread_mutex_unlock(&server->lock);
+
+  if (corpus == NULL) {
+    fprintf(out, "Index '%s' could not be reloaded; still serving the "
+            "old copy.\n", hosted->name);
+    return;
+  }
+  rcache_drop(server->cache, h);
+  if (idle) {
+    corpus_delete(old);
+  }
+  fprintf(out, "Reloaded index '%s' (generation %d) in %.1f ms.\n",
+          hosted->name, generation, corpus->replica.msload);
+}
+
+/* corpus_acquire */
+/* Return index h's current copy, which stays valid (even if the index
+ * is reloaded) until corpus_release; its generation goes in
+ * *generation_out.
+ */
+static corpus_t *
+corpus_acquire(server_t *server, const int h, int *generation_out)
+{
+  pthread_mutex_lock(&server->lock);
+  corpus_t *corpus = server->hosted[h].corpus;
+  *generation_out = server->hosted[h].generation;
+  corpus->refs++;
+  pthread_mutex_unlock(&server->lock);
+  return corpus;
+}
+
+/* corpus_release */
+/* Done reading corpus, a copy of index h; free it if it has been
+ * replaced by a reload and we were its last reader.
+ */
+static void
+corpus_release(server_t *server, const int h, corpus_t *corpus)
+{
+  pthread_mutex_lock(&server->lock);
+  bool retired = (--corpus->refs == 0 && corpus != server->hosted[h].corpus);
+  pthread_mutex_unlock(&server->lock);
+  if (retired) {
+    corpus_delete(corpus);
+  }
+}
+
+/* worker_snipper */
+/* Return the worker's snippet maker for index h, made anew if the
+ * index has been reloaded since (the pages may be new); NULL unless
+ * -snippets.
+ */
+static snipper_t *
+worker_snipper(worker_t *worker, const int h, const int generation)
+{
+  const hosted_t *hosted = &worker->server->hosted[h];
+  if (hosted->opts.snippets && (worker->snippers[h] == NULL
+                                || worker->snipGen[h] != generation)) {
+    snippet_delete(worker->snippers[h]);
+    worker->snippers[h] = snippet_new(hosted->pageDirectory, SNIPPET_CACHE);
+    worker->snipGen[h] = generation;
+  }
+  return worker->snippers[h];
+}
+
+/* serve_federated */
+/* Answer a federated query onto out: evaluate it on each of the
+ * ntargets indexes in parallel, each keeping its own ranking (its top
+ * K, with -k), then merge the rankings with a loser tree. Scores are
+ * normalized by the best score of each index, so every index's best
+ * result scores 1; ties go to the index listed first. A URL found in
+ * several indexes is shown once, at its best place.
+ */
+static void
+serve_federated(worker_t *worker, const int *targets, const int ntargets,
+                char **words, const int nwords, const filter_t *filter,
+                FILE *out)
+{
+  server_t *server = worker->server;
+  federate_t parts[HOSTED_MAX];
+  pthread_t tids[HOSTED_MAX];
+  bool started[HOSTED_MAX] = { false };
+  int generations[HOSTED_MAX];
+
+  for (int t = 0; t < ntargets; t++) {
+    federate_t *part = &parts[t];
+    memset(part, 0, sizeof(*part));
+    part->h = targets[t];
+    part->opts = &server->hosted[part->h].opts;
+    part->corpus = corpus_acquire(server, part->h, &generations[t]);
+    part->qr.index = part->corpus->replica.index;
+    part->qr.postings = part->corpus->replica.postings;
+    part->qr.hosts = part->corpus->hosts;
+    part->qr.attrs = part->corpus->attrs;
+    part->qr.simhashes = part->corpus->simhashes;
+    part->qr.cancel = cancel_new(worker->opts->timeoutMs, fileno(stdout));
+    part->qr.ranking = &part->ranking;
+    part->words = words;
+    part->nwords = nwords;
+    part->filter = filter;
+  }
+  /* the first index on this thread, the others on their own */
+  for (int t = 1; t < ntargets; t++) {
+    started[t] = (pthread_create(&tids[t], NULL, federate_one,
+                                 &parts[t]) == 0);
+    if (!started[t]) {
+      federate_one(&parts[t]);
+    }
+  }
+  federate_one(&parts[0]);
+  for (int t = 1; t < ntargets; t++) {
+    if (started[t]) {
+      pthread_join(tids[t], NULL);
+    }
+  }
+
+  cancel_reason_t reason = CANCEL_NONE;
+  bool empty[HOSTED_MAX];
+  int hidden = 0;
+  for (int t = 0; t < ntargets; t++) {
+    stats_add(&worker->stats, &parts[t].stats);
+    if (parts[t].ranking.cancelled) {
+      reason = cancel_reason(parts[t].qr.cancel);
+    }
+    empty[t] = (parts[t].ranking.n == 0);
+    hidden += parts[t].ranking.hidden;
+  }
+
+  if (reason != CANCEL_NONE) {
+    fprintf(out, "Query cancelled (%s).\n", cancel_name(reason));
+    fprintf(out, "%s\n", ANSWERS_SEPARATOR);
+  } else {
+    /* merge, keeping the first (best) result with each URL */
+    int topK = worker->opts->topK;
+    int cap = 0;
+    for (int t = 0; t < ntargets; t++) {
+      cap += parts[t].ranking.n;
+    }
+    federate_t **from = mem_malloc_assert((cap + 1) * sizeof(federate_t *),
+                                          "serve_federated");
+    docscore_t *docs = mem_malloc_assert((cap + 1) * sizeof(docscore_t),
+                                         "serve_federated");
+    char **urls = mem_malloc_assert((cap + 1) * sizeof(char *),
+                                    "serve_federated");
+    hashtable_t *seen = hashtable_new(2 * cap + 1);
+    int n = 0, duplicates = 0;
+    losertree_t *tree = losertree_new(ntargets, empty, federate_before,
+                                      parts);
+    int t;
+    while ((topK == 0 || n < topK) && (t = losertree_top(tree)) >= 0) {
+      federate_t *part = &parts[t];
+      const docscore_t *ds = &part->ranking.docs[part->next++];
+      char *url = get_url(part->opts->pageDirectory, ds->docID);
+      if (url != NULL && !hashtable_insert(seen, url, "")) {
+        duplicates++;
+        mem_free(url);
+      } else {
+        from[n] = part;
+        docs[n] = *ds;
+        urls[n++] = url;
+      }
+      losertree_next(tree, part->next == part->ranking.n);
+    }
+    losertree_delete(tree);
+    hashtable_delete(seen, NULL);
+
+    if (n == 0) {
+      fprintf(out, "No documents match.\n");
+    } else if (topK > 0) {
+      fprintf(out, "Top %d documents from %d indexes (ranked):\n", n,
+              ntargets);
+    } else {
+      fprintf(out, "Matches %d documents from %d indexes (ranked):\n", n,
+              ntargets);
+    }
+    for (int i = 0; i < n; i++) {
+      int h = from[i]->h;
+      fprintf(out, "score %.3f  %s doc %3d: %s\n",
+              (double) docs[i].score / from[i]->ranking.docs[0].score,
+              server->hosted[h].name, docs[i].docID,
+              (urls[i] == NULL) ? "(no-url)" : urls[i]);
+      mem_free(urls[i]);
+      if (from[i]->opts->snippets) {
+        int g = generations[from[i] - parts];
+        snipper_t *snipper = worker_snipper(worker, h, g);
+        snippet_query(snipper, words, nwords);
+        const char *snippet = snippet_get(snipper, docs[i].docID);
+        fprintf(out, "      %s\n", (snippet == NULL) ? "(no snippet)"
+                : snippet);
+      }
+    }
+    if (duplicates > 0) {
+      fprintf(out, "(%d duplicate URLs hidden)\n", duplicates);
+    }
+    if (hidden > 0) {
+      fprintf(out, "(%d near-duplicate documents hidden)\n", hidden);
+    }
+    fprintf(out, "%s\n", ANSWERS_SEPARATOR);
+    mem_free(from);
+    mem_free(docs);
+    mem_free(urls);
+  }
+
+  for (int t = 0; t < ntargets; t++) {
+    mem_free(parts[t].ranking.docs);
+    cancel_delete(parts[t].qr.cancel);
+    corpus_release(server, parts[t].h, parts[t].corpus);
+  }
+}
+
+/* federate_one */
+/* Thread body: evaluate a federated query on one index, keeping its
+ * ranking. arg is a federate_t.
+ */
+static void *
+federate_one(void *arg)
+{
+  federate_t *part = arg;
+  answer_query(part->opts, &part->qr, part->words, part->nwords,
+               part->filter, &part->stats);
+  return NULL;
+}
+
+/* federate_before */
+/* beforefn_t for merging federated rankings: true if the next result
+ * of part a has a higher normalized score than part b's, or the same
+ * and a comes first. Compares a/A with b/B as a*B with b*A, so equal
+ * fractions tie exactly. arg is the array of federate_t.
+ */
+static bool
+federate_before(void *arg, const int a, const int b)
+{
+  const federate_t *parts = arg;
+  const ranking_t *ra = &parts[a].ranking, *rb = &parts[b].ranking;
+  long sa = (long) ra->docs[parts[a].next].score * rb->docs[0].score;
+  long sb = (long) rb->docs[parts[b].next].score * ra->docs[0].score;
+  return (sa != sb) ? sa > sb : a < b;
+}
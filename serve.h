@@ -0,0 +1,34 @@
+/*
+ * serve.h - header file for the querier's 'serve' module
+ *
+ * With -serve, one querier hosts several indexes, listed in a file,
+ * one per line: "name pageDirectory indexFilename [quotaKB]". A query
+ * line starting "@name" is answered from that index, any other from
+ * the first. The indexes share the worker threads and a cache of whole
+ * answers (see rcache.h), in which each index is guaranteed its quota.
+ * "!reload name" loads an index again while queries go on being
+ * answered from the old copy, which the last query reading it frees.
+ * A query starting "@*" or "@name,name,..." is federated: evaluated on
+ * each of those indexes in parallel, and answered with one ranked list
+ * (merged with a loser tree, see losertree.h), scores normalized per
+ * index and duplicate URLs dropped.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __SERVE_H
+#define __SERVE_H
+
+#include <stdio.h>
+#include "querier.h"
+
+/**************** serve_loop ****************/
+/* With -serve: load every index listed in opts->serveFile, then answer
+ * queries from stdin on opts->workers threads, each from the index it
+ * names, through the shared answer cache; print the answers in the
+ * order the queries came in, and each index's counts at the end.
+ * Exits if the file is wrong or an index cannot be loaded.
+ */
+void serve_loop(const options_t *opts);
+
+#endif // __SERVE_H
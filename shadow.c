@@ -0,0 +1,333 @@
+/*
+ * shadow.c - 'shadow' module for the CS50 TSE querier
+ *
+ * see shadow.h for more information.
+ *
+ * Submitted queries wait in a ring of SHADOW_QUEUE jobs, guarded with
+ * the counts by one mutex; the thread takes a job, evaluates and
+ * compares it with the mutex released, and signals when the ring is
+ * empty. The two evaluators take turns going first, so neither always
+ * runs on caches the other has warmed.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* flockfile is POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "shadow.h"
+#include "timing.h"
+#include "mem.h"
+
+/**************** local types ****************/
+/* job_t: one query submitted for comparison. */
+typedef struct job {
+  char **words;        // pointing into text
+  int nwords;
+  char *text;          // the words, each '\0'-terminated
+  bitmap_t *allowed;   // NULL: all documents
+} job_t;
+
+/* ranked_t: one evaluator's ranking of a job, and the time it took. */
+typedef struct ranked {
+  docscore_t *docs;
+  int n;
+  double ms;
+} ranked_t;
+
+/**************** global types ****************/
+struct shadow {
+  evaluator_t reference;
+  evaluator_t candidate;
+  int percent;
+  int topK;
+  FILE *log;
+  int credit;              // sampling: percent added per query
+  job_t jobs[SHADOW_QUEUE];    // a ring
+  int head, count;
+  bool busy;               // the thread is comparing a job
+  bool stop;
+  shadowstats_t stats;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t ready;    // signalled when a job is queued, or stop
+  pthread_cond_t idle;     // signalled when the ring empties
+};
+
+/**************** local functions ****************/
+static void *shadow_run(void *arg);
+static bool compare(shadow_t *shadow, const job_t *job);
+static void rank(const evaluator_t *evaluator, const job_t *job,
+                 ranked_t *ranked);
+static void job_free(job_t *job);
+
+/**************** shadow_new ****************/
+/* see shadow.h for description */
+shadow_t *
+shadow_new(const evaluator_t *reference, const evaluator_t *candidate,
+           const int percent, const int topK, FILE *log)
+{
+  if (reference == NULL || candidate == NULL || reference->evaluate == NULL
+      || candidate->evaluate == NULL || percent < 1 || percent > 100
+      || topK < 0 || log == NULL) {
+    return NULL;
+  }
+  shadow_t *shadow = mem_calloc_assert(1, sizeof(shadow_t), "shadow_new");
+  shadow->reference = *reference;
+  shadow->candidate = *candidate;
+  shadow->percent = percent;
+  shadow->topK = topK;
+  shadow->log = log;
+  pthread_mutex_init(&shadow->lock, NULL);
+  pthread_cond_init(&shadow->ready, NULL);
+  pthread_cond_init(&shadow->idle, NULL);
+  if (pthread_create(&shadow->thread, NULL, shadow_run, shadow) != 0) {
+    pthread_cond_destroy(&shadow->idle);
+    pthread_cond_destroy(&shadow->ready);
+    pthread_mutex_destroy(&shadow->lock);
+    mem_free(shadow);
+    return NULL;
+  }
+  return shadow;
+}
+
+/**************** shadow_sample ****************/
+/* see shadow.h for description */
+bool
+shadow_sample(shadow_t *shadow)
+{
+  if (shadow == NULL) {
+    return false;
+  }
+  pthread_mutex_lock(&shadow->lock);
+  shadow->stats.offered++;
+  shadow->credit += shadow->percent;
+  bool sampled = (shadow->credit >= 100);
+  if (sampled) {
+    shadow->credit -= 100;
+    shadow->stats.sampled++;
+  }
+  pthread_mutex_unlock(&shadow->lock);
+  return sampled;
+}
+
+/**************** shadow_submit ****************/
+/* see shadow.h for description */
+void
+shadow_submit(shadow_t *shadow, char **words, const int nwords,
+              const bitmap_t *allowed)
+{
+  if (shadow == NULL || words == NULL || nwords < 1) {
+    return;
+  }
+
+  /* copy outside the lock; most of the time there is room */
+  job_t job;
+  size_t length = 0;
+  for (int w = 0; w < nwords; w++) {
+    length += strlen(words[w]) + 1;
+  }
+  job.text = mem_malloc_assert(length, "shadow_submit");
+  job.words = mem_malloc_assert(nwords * sizeof(char *), "shadow_submit");
+  job.nwords = nwords;
+  char *p = job.text;
+  for (int w = 0; w < nwords; w++) {
+    strcpy(p, words[w]);
+    job.words[w] = p;
+    p += strlen(p) + 1;
+  }
+  job.allowed = NULL;
+  if (allowed != NULL) {
+    job.allowed = bitmap_new(allowed->nbits);
+    bitmap_or(job.allowed, allowed);
+  }
+
+  pthread_mutex_lock(&shadow->lock);
+  bool queued = (shadow->count < SHADOW_QUEUE);
+  if (queued) {
+    shadow->jobs[(shadow->head + shadow->count++) % SHADOW_QUEUE] = job;
+    pthread_cond_signal(&shadow->ready);
+  } else {
+    shadow->stats.dropped++;
+  }
+  pthread_mutex_unlock(&shadow->lock);
+  if (!queued) {
+    job_free(&job);
+  }
+}
+
+/**************** shadow_drain ****************/
+/* see shadow.h for description */
+void
+shadow_drain(shadow_t *shadow)
+{
+  if (shadow == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&shadow->lock);
+  while (shadow->count > 0 || shadow->busy) {
+    pthread_cond_wait(&shadow->idle, &shadow->lock);
+  }
+  pthread_mutex_unlock(&shadow->lock);
+}
+
+/**************** shadow_stats ****************/
+/* see shadow.h for description */
+void
+shadow_stats(shadow_t *shadow, shadowstats_t *stats)
+{
+  if (shadow == NULL || stats == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&shadow->lock);
+  *stats = shadow->stats;
+  pthread_mutex_unlock(&shadow->lock);
+}
+
+/**************** shadow_delete ****************/
+/* see shadow.h for description */
+void
+shadow_delete(shadow_t *shadow)
+{
+  if (shadow == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&shadow->lock);
+  shadow->stop = true;
+  pthread_cond_signal(&shadow->ready);
+  pthread_mutex_unlock(&shadow->lock);
+  pthread_join(shadow->thread, NULL);
+
+  pthread_cond_destroy(&shadow->idle);
+  pthread_cond_destroy(&shadow->ready);
+  pthread_mutex_destroy(&shadow->lock);
+  mem_free(shadow);
+}
+
+/* shadow_run */
+/* Thread body: compare queued jobs until stopped with none left. */
+static void *
+shadow_run(void *arg)
+{
+  shadow_t *shadow = arg;
+  pthread_mutex_lock(&shadow->lock);
+  for (;;) {
+    while (shadow->count == 0 && !shadow->stop) {
+      pthread_cond_wait(&shadow->ready, &shadow->lock);
+    }
+    if (shadow->count == 0) {
+      break;                      // stopped, and nothing left
+    }
+    job_t job = shadow->jobs[shadow->head];
+    shadow->head = (shadow->head + 1) % SHADOW_QUEUE;
+    shadow->count--;
+    shadow->busy = true;
+    pthread_mutex_unlock(&shadow->lock);
+
+    compare(shadow, &job);
+    job_free(&job);
+
+    pthread_mutex_lock(&shadow->lock);
+    shadow->busy = false;
+    if (shadow->count == 0) {
+      pthread_cond_broadcast(&shadow->idle);
+    }
+  }
+  pthread_mutex_unlock(&shadow->lock);
+  return NULL;
+}
+
+/* compare */
+/* Rank job with both evaluators, count it, and describe any difference
+ * on the log. Returns true if the rankings agree.
+ */
+static bool
+compare(shadow_t *shadow, const job_t *job)
+{
+  ranked_t ref, cand;
+  pthread_mutex_lock(&shadow->lock);
+  bool referenceFirst = (shadow->stats.compared % 2 == 0);
+  pthread_mutex_unlock(&shadow->lock);
+  if (referenceFirst) {
+    rank(&shadow->reference, job, &ref);
+    rank(&shadow->candidate, job, &cand);
+  } else {
+    rank(&shadow->candidate, job, &cand);
+    rank(&shadow->reference, job, &ref);
+  }
+
+  /* with top K, only the first K matter, not how many matched */
+  int k = shadow->topK;
+  int nref = (k > 0 && ref.n > k) ? k : ref.n;
+  int ncand = (k > 0 && cand.n > k) ? k : cand.n;
+  int at = 0;
+  while (at < nref && at < ncand
+         && ref.docs[at].docID == cand.docs[at].docID
+         && ref.docs[at].score == cand.docs[at].score) {
+    at++;
+  }
+  bool agree = (at == nref && at == ncand);
+
+  if (!agree) {
+    char rdoc[64] = "none", cdoc[64] = "none";
+    if (at < nref) {
+      snprintf(rdoc, sizeof(rdoc), "doc %d score %d", ref.docs[at].docID,
+               ref.docs[at].score);
+    }
+    if (at < ncand) {
+      snprintf(cdoc, sizeof(cdoc), "doc %d score %d", cand.docs[at].docID,
+               cand.docs[at].score);
+    }
+    flockfile(shadow->log);
+    fprintf(shadow->log, "querier: shadow mismatch on '");
+    for (int w = 0; w < job->nwords; w++) {
+      fprintf(shadow->log, "%s%s", (w > 0) ? " " : "", job->words[w]);
+    }
+    fprintf(shadow->log, "': %s has %d results, %s %d; at rank %d, %s "
+            "against %s\n", shadow->reference.name, ref.n,
+            shadow->candidate.name, cand.n, at + 1, rdoc, cdoc);
+    funlockfile(shadow->log);
+  }
+
+  pthread_mutex_lock(&shadow->lock);
+  shadow->stats.compared++;
+  shadow->stats.mismatches += !agree;
+  shadow->stats.msreference += ref.ms;
+  shadow->stats.mscandidate += cand.ms;
+  pthread_mutex_unlock(&shadow->lock);
+  mem_free(ref.docs);
+  mem_free(cand.docs);
+  return agree;
+}
+
+/* rank */
+/* Evaluate job with evaluator and sort the results into ranked order,
+ * timing both.
+ */
+static void
+rank(const evaluator_t *evaluator, const job_t *job, ranked_t *ranked)
+{
+  double start = timing_ms();
+  ranked->docs = NULL;
+  ranked->n = evaluator->evaluate(evaluator->arg, job->words, job->nwords,
+                                  job->allowed, &ranked->docs);
+  if (ranked->n > 0) {
+    qsort(ranked->docs, ranked->n, sizeof(docscore_t), docscore_cmp);
+  }
+  ranked->ms = timing_ms() - start;
+}
+
+/* job_free */
+/* Free what a job holds. */
+static void
+job_free(job_t *job)
+{
+  mem_free(job->words);
+  mem_free(job->text);
+  bitmap_delete(job->allowed);
+}
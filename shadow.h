@@ -0,0 +1,98 @@
+/*
+ * shadow.h - header file for the querier's 'shadow' module
+ *
+ * Shadow evaluation: for a sample of the queries answered, a
+ * background thread evaluates the query again with two evaluators, a
+ * reference and a candidate, compares the two rankings, and keeps
+ * count of mismatches and of the time each evaluator took. The answer
+ * already given is never touched, and a query offered while the
+ * thread is behind is dropped rather than waited for, so shadowing
+ * costs the answering threads only a copy of the query.
+ *
+ * An evaluator is a function and its own data; the module neither
+ * knows nor cares how it finds the documents.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __SHADOW_H
+#define __SHADOW_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "query.h"
+#include "bitmap.h"
+
+/* queries waiting for the shadow thread; more are dropped */
+#define SHADOW_QUEUE 64
+
+typedef struct shadow shadow_t;
+
+/* evalfn_t: return the number of documents matching the validated
+ * query words[0..nwords-1] among allowed (NULL: all), with a new array
+ * of them and their scores, in any order, in *docs_out (the caller
+ * mem_frees it). arg is the evaluator's own data. It is called on the
+ * shadow thread while queries are answered on others, so it may only
+ * read what they share.
+ */
+typedef int (*evalfn_t)(void *arg, char **words, const int nwords,
+                        const bitmap_t *allowed, docscore_t **docs_out);
+
+/* evaluator_t: a named evaluator. */
+typedef struct evaluator {
+  const char *name;
+  evalfn_t evaluate;
+  void *arg;
+} evaluator_t;
+
+/* shadowstats_t: what the shadow has done so far. */
+typedef struct shadowstats {
+  long offered;        // queries answered
+  long sampled;        // ...chosen for comparison
+  long dropped;        // ...of which the queue had no room for
+  long compared;       // ...compared
+  long mismatches;     // ...whose rankings differed
+  double msreference;  // total ms in the reference, ranking included
+  double mscandidate;  // ...and in the candidate
+} shadowstats_t;
+
+/**************** shadow_new ****************/
+/* Return a shadow comparing candidate with reference on percent
+ * (1..100) of the queries, over each ranking's first topK results (0:
+ * all of them, and their number), and start its thread. Each mismatch
+ * is described on log. Returns NULL if the thread cannot start. Caller
+ * must shadow_delete it.
+ */
+shadow_t *shadow_new(const evaluator_t *reference,
+                     const evaluator_t *candidate, const int percent,
+                     const int topK, FILE *log);
+
+/**************** shadow_sample ****************/
+/* Count a query answered, and return true if it is one to compare:
+ * exactly percent in every 100, evenly spread. Any thread may call it.
+ */
+bool shadow_sample(shadow_t *shadow);
+
+/**************** shadow_submit ****************/
+/* Queue copies of a sampled query and of allowed (NULL: all) for
+ * comparison, or drop them if SHADOW_QUEUE queries are waiting. Any
+ * thread may call it.
+ */
+void shadow_submit(shadow_t *shadow, char **words, const int nwords,
+                   const bitmap_t *allowed);
+
+/**************** shadow_drain ****************/
+/* Wait until every query submitted has been compared. */
+void shadow_drain(shadow_t *shadow);
+
+/**************** shadow_stats ****************/
+/* Fill *stats with the counts so far. */
+void shadow_stats(shadow_t *shadow, shadowstats_t *stats);
+
+/**************** shadow_delete ****************/
+/* Compare whatever is queued, stop the thread, and free the shadow;
+ * NULL is ignored.
+ */
+void shadow_delete(shadow_t *shadow);
+
+#endif // __SHADOW_H
@@ -0,0 +1,293 @@
+/*
+ * simhash.c - 'simhash' module for the CS50 TSE querier
+ *
+ * see simhash.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include "simhash.h"
+#include "mem.h"
+
+#define BAND_BITS (64 / SIMHASH_BANDS)
+
+/**************** global types ****************/
+struct simhashes {
+  int maxdoc;
+  uint64_t *hash;      // hash[docID]
+  bool *has;           // has[docID]: was a fingerprint given?
+};
+
+/**************** local functions ****************/
+static uint64_t hash_word(const char *word, const int len);
+static uint64_t hash_mix(uint64_t h);
+static uint64_t band_of(const uint64_t hash, const int band);
+static int      band_slot(const uint64_t key, const int band, const int mask);
+
+/**************** simhash_text ****************/
+/* see simhash.h for description */
+uint64_t
+simhash_text(const char *text)
+{
+  int weights[64] = { 0 };
+  char word[64];
+  uint64_t prev = 0;           // hash of the previous word
+  bool havePrev = false;
+
+  if (text == NULL) {
+    return 0;
+  }
+
+  const char *p = text;
+  while (*p != '\0') {
+    if (*p == '<') {
+      /* skip markup */
+      while (*p != '\0' && *p != '>') {
+        p++;
+      }
+      if (*p == '>') {
+        p++;
+      }
+      continue;
+    }
+    if (!isalpha((unsigned char) *p)) {
+      p++;
+      continue;
+    }
+
+    int len = 0;
+    while (isalpha((unsigned char) *p)) {
+      if (len < (int) sizeof(word)) {
+        word[len] = (char) tolower((unsigned char) *p);
+      }
+      len++;
+      p++;
+    }
+    if (len < 3) {
+      continue;
+    }
+    if (len > (int) sizeof(word)) {
+      len = sizeof(word);
+    }
+
+    /* each pair of consecutive words (a shingle) votes +1/-1 on each
+     * bit of its hash; pairs capture word order, which single words,
+     * dominated by the most common ones, do not */
+    uint64_t h = hash_word(word, len);
+    if (havePrev) {
+      uint64_t shingle = hash_mix(prev * 31 + h);
+      for (int b = 0; b < 64; b++) {
+        weights[b] += ((shingle >> b) & 1) ? 1 : -1;
+      }
+    }
+    prev = h;
+    havePrev = true;
+  }
+
+  uint64_t fingerprint = 0;
+  for (int b = 0; b < 64; b++) {
+    if (weights[b] > 0) {
+      fingerprint |= (uint64_t) 1 << b;
+    }
+  }
+  return fingerprint;
+}
+
+/* hash_word */
+/* 64-bit FNV-1a of the word, mixed so the bits are well spread even
+ * for short words.
+ */
+static uint64_t
+hash_word(const char *word, const int len)
+{
+  uint64_t h = 1469598103934665603ULL;
+  for (int i = 0; i < len; i++) {
+    h ^= (unsigned char) word[i];
+    h *= 1099511628211ULL;
+  }
+  return hash_mix(h);
+}
+
+/* hash_mix */
+/* Finalizer from MurmurHash3: every input bit affects every output bit. */
+static uint64_t
+hash_mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**************** simhash_load ****************/
+/* see simhash.h for description */
+simhashes_t *
+simhash_load(const char *filename)
+{
+  FILE *fp = (filename == NULL) ? NULL : fopen(filename, "r");
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  simhashes_t *hashes = mem_malloc_assert(sizeof(simhashes_t), "simhash_load");
+  int cap = 64;
+  hashes->maxdoc = 0;
+  hashes->hash = mem_calloc_assert(cap, sizeof(uint64_t), "simhash_load");
+  hashes->has = mem_calloc_assert(cap, sizeof(bool), "simhash_load");
+
+  int docID;
+  uint64_t fingerprint;
+  while (fscanf(fp, "%d %" SCNx64, &docID, &fingerprint) == 2) {
+    if (docID <= 0) {
+      continue;
+    }
+    if (docID >= cap) {
+      int newcap = cap;
+      while (docID >= newcap) {
+        newcap *= 2;
+      }
+      uint64_t *hash = mem_calloc_assert(newcap, sizeof(uint64_t),
+                                         "simhash_load");
+      bool *has = mem_calloc_assert(newcap, sizeof(bool), "simhash_load");
+      memcpy(hash, hashes->hash, cap * sizeof(uint64_t));
+      memcpy(has, hashes->has, cap * sizeof(bool));
+      mem_free(hashes->hash);
+      mem_free(hashes->has);
+      hashes->hash = hash;
+      hashes->has = has;
+      cap = newcap;
+    }
+    hashes->hash[docID] = fingerprint;
+    hashes->has[docID] = true;
+    if (docID > hashes->maxdoc) {
+      hashes->maxdoc = docID;
+    }
+  }
+  fclose(fp);
+  return hashes;
+}
+
+/**************** simhash_collapse ****************/
+/* see simhash.h for description
+ *
+ * Each kept fingerprint is entered in SIMHASH_BANDS small hash tables,
+ * one per band, keyed by the band's bits. A new document only needs to
+ * be compared (by popcount of the xor) with kept documents that share
+ * one of its bands, which for distinct pages is almost never.
+ */
+int
+simhash_collapse(const simhashes_t *hashes, docscore_t *docs,
+                 const int n, const int want, int *hidden_out)
+{
+  if (hidden_out != NULL) {
+    *hidden_out = 0;
+  }
+  if (hashes == NULL || docs == NULL || n <= 0) {
+    return (n < want) ? n : want;
+  }
+
+  int maxKept = (n < want) ? n : want;
+  int size = 16;
+  while (size < 2 * maxKept) {
+    size *= 2;
+  }
+  int mask = size - 1;
+
+  int *heads[SIMHASH_BANDS];
+  int *next[SIMHASH_BANDS];
+  for (int b = 0; b < SIMHASH_BANDS; b++) {
+    heads[b] = mem_malloc_assert(size * sizeof(int), "simhash_collapse");
+    memset(heads[b], -1, size * sizeof(int));
+    next[b] = mem_malloc_assert((maxKept + 1) * sizeof(int),
+                                "simhash_collapse");
+  }
+  uint64_t *keptHash = mem_malloc_assert((maxKept + 1) * sizeof(uint64_t),
+                                         "simhash_collapse");
+
+  int kept = 0;       // documents kept so far
+  int nhashed = 0;    // ...of which have a fingerprint in the tables
+  int hidden = 0;
+  for (int i = 0; i < n && kept < want; i++) {
+    int docID = docs[i].docID;
+    if (docID <= 0 || docID > hashes->maxdoc || !hashes->has[docID]) {
+      docs[kept++] = docs[i];
+      continue;
+    }
+
+    uint64_t h = hashes->hash[docID];
+    bool duplicate = false;
+    for (int b = 0; b < SIMHASH_BANDS && !duplicate; b++) {
+      uint64_t key = band_of(h, b);
+      for (int r = heads[b][band_slot(key, b, mask)]; r >= 0;
+           r = next[b][r]) {
+        if (band_of(keptHash[r], b) == key
+            && __builtin_popcountll(keptHash[r] ^ h) <= SIMHASH_MAXDIST) {
+          duplicate = true;
+          break;
+        }
+      }
+    }
+    if (duplicate) {
+      hidden++;
+      continue;
+    }
+
+    keptHash[nhashed] = h;
+    for (int b = 0; b < SIMHASH_BANDS; b++) {
+      int slot = band_slot(band_of(h, b), b, mask);
+      next[b][nhashed] = heads[b][slot];
+      heads[b][slot] = nhashed;
+    }
+    nhashed++;
+    docs[kept++] = docs[i];
+  }
+
+  for (int b = 0; b < SIMHASH_BANDS; b++) {
+    mem_free(heads[b]);
+    mem_free(next[b]);
+  }
+  mem_free(keptHash);
+
+  if (hidden_out != NULL) {
+    *hidden_out = hidden;
+  }
+  return kept;
+}
+
+/* band_of */
+/* Return the bits of band number band of hash. */
+static uint64_t
+band_of(const uint64_t hash, const int band)
+{
+  return (hash >> (band * BAND_BITS)) & (((uint64_t) 1 << BAND_BITS) - 1);
+}
+
+/* band_slot */
+/* Hash a band key into a table slot. */
+static int
+band_slot(const uint64_t key, const int band, const int mask)
+{
+  uint64_t x = (key + (uint64_t) band) * 0x9e3779b97f4a7c15ULL;
+  return (int) ((x >> 32) & (uint64_t) mask);
+}
+
+/**************** simhash_delete ****************/
+/* see simhash.h for description */
+void
+simhash_delete(simhashes_t *hashes)
+{
+  if (hashes != NULL) {
+    mem_free(hashes->hash);
+    mem_free(hashes->has);
+    mem_free(hashes);
+  }
+}
@@ -0,0 +1,64 @@
+/*
+ * simhash.h - header file for the querier's 'simhash' module
+ *
+ * A 64-bit SimHash fingerprint summarizes the words of a page so that
+ * near-duplicate pages (mirrors, copies with small edits) have
+ * fingerprints differing in only a few bits. The simhasher program
+ * computes one per page, offline, into pageDirectory/.simhash; the
+ * querier loads that file and collapses near-duplicate results.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __SIMHASH_H
+#define __SIMHASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "query.h"
+
+/* pages whose fingerprints differ in at most this many bits are
+ * near-duplicates; fingerprints are split into SIMHASH_MAXDIST+1 bands,
+ * so two near-duplicates always agree exactly on at least one band */
+#define SIMHASH_MAXDIST 3
+#define SIMHASH_BANDS   (SIMHASH_MAXDIST + 1)
+
+/* name of the sidecar file inside pageDirectory */
+#define SIMHASH_FILENAME ".simhash"
+
+typedef struct simhashes simhashes_t;
+
+/**************** simhash_text ****************/
+/* Return the SimHash of the words in text, using each pair of
+ * consecutive words as a feature. Words are runs of letters, lowercased,
+ * of at least three letters (as the Indexer normalizes them); anything
+ * between '<' and '>' is markup and is skipped.
+ */
+uint64_t simhash_text(const char *text);
+
+/**************** simhash_load ****************/
+/* Read a sidecar file of "docID hexFingerprint" lines.
+ * We return a new simhashes_t (caller frees with simhash_delete), or
+ * NULL if the file cannot be read.
+ */
+simhashes_t *simhash_load(const char *filename);
+
+/**************** simhash_collapse ****************/
+/* Walk ranked docs[0..n-1] in order and drop every document that is a
+ * near-duplicate of one already kept, so each group keeps its best-ranked
+ * member. Stops once want documents are kept, so the work is O(k) for a
+ * displayed page of k results. Kept documents are compacted to the
+ * front of docs in their original order.
+ *
+ * Returns the number kept; *hidden_out (if not NULL) gets the number
+ * dropped among the documents examined. Documents with no fingerprint
+ * are always kept.
+ */
+int simhash_collapse(const simhashes_t *hashes, docscore_t *docs,
+                     const int n, const int want, int *hidden_out);
+
+/**************** simhash_delete ****************/
+/* Free the fingerprints; NULL is ignored. */
+void simhash_delete(simhashes_t *hashes);
+
+#endif // __SIMHASH_H
@@ -0,0 +1,78 @@
+/*
+ * simhasher.c - compute SimHash fingerprints for a crawler pageDirectory
+ *
+ * Reads pageDirectory/1, pageDirectory/2, ... until the first missing
+ * file and writes one "docID fingerprint" line per page (fingerprint in
+ * hex) to pageDirectory/.simhash, or to outputFile if given. Run it
+ * once after crawling; the querier's -collapse option reads the file.
+ *
+ * Usage:
+ *   ./simhasher pageDirectory [outputFile]
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <limits.h>
+#include "simhash.h"
+#include "file.h"
+#include "mem.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+/* main */
+/* Fingerprint every page and write the sidecar file. */
+int
+main(const int argc, char *argv[])
+{
+  if (argc != 2 && argc != 3) {
+    fprintf(stderr, "usage: %s pageDirectory [outputFile]\n", argv[0]);
+    exit(1);
+  }
+  const char *pageDirectory = argv[1];
+
+  char outName[PATH_MAX];
+  if (argc == 3) {
+    snprintf(outName, sizeof(outName), "%s", argv[2]);
+  } else {
+    snprintf(outName, sizeof(outName), "%s/%s", pageDirectory,
+             SIMHASH_FILENAME);
+  }
+
+  FILE *out = fopen(outName, "w");
+  if (out == NULL) {
+    fprintf(stderr, "simhasher: cannot write '%s'\n", outName);
+    exit(2);
+  }
+
+  int docID;
+  for (docID = 1; ; docID++) {
+    char filename[PATH_MAX];
+    snprintf(filename, sizeof(filename), "%s/%d", pageDirectory, docID);
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+      break;
+    }
+
+    /* skip the URL and depth lines; fingerprint the HTML */
+    char *line = file_readLine(fp);
+    mem_free(line);
+    line = file_readLine(fp);
+    mem_free(line);
+    char *html = file_readFile(fp);
+    fclose(fp);
+
+    fprintf(out, "%d %016" PRIx64 "\n", docID, simhash_text(html));
+    mem_free(html);
+  }
+  fclose(out);
+
+  printf("simhasher: fingerprinted %d pages into %s\n", docID - 1, outName);
+  return 0;
+}
@@ -0,0 +1,325 @@
+/*
+ * sketch.c - 'sketch' module for the CS50 TSE querier
+ *
+ * see sketch.h for more information.
+ *
+ * Estimates merge the sketches: the SKETCH_K smallest distinct values
+ * over all of them are the sketch of the union, and a value among them
+ * that is in a set is certainly in that set's sketch, so counting the
+ * values found in every sketch gives the Jaccard similarity of the
+ * sets. If the K'th smallest union value is h (as a fraction of the
+ * hash range), the union has about (K - 1) / h elements.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "sketch.h"
+#include "mem.h"
+
+/**************** local functions ****************/
+static uint32_t hash_doc(const int docID);
+static int cmp_uint32(const void *a, const void *b);
+static void estimate(const sketch_t *const sketches[], const int n,
+                     double *inter_out, double *union_out);
+static void contained(const sketch_t *const sketches[], const int n,
+                      int *sampled_out, int *hits_out);
+static bool has_value(const sketch_t *sketch, const uint32_t value);
+
+/**************** sketch_build ****************/
+/* see sketch.h for description */
+void
+sketch_build(sketch_t *sketch, const int *docs, const int n)
+{
+  sketch->size = n;
+  sketch->n = 0;
+  if (n <= 0) {
+    return;
+  }
+
+  uint32_t *hashes = mem_malloc_assert(n * sizeof(uint32_t), "sketch_build");
+  for (int i = 0; i < n; i++) {
+    hashes[i] = hash_doc(docs[i]);
+  }
+  qsort(hashes, n, sizeof(uint32_t), cmp_uint32);
+  sketch->n = (n < SKETCH_K) ? n : SKETCH_K;
+  for (int i = 0; i < sketch->n; i++) {
+    sketch->mins[i] = hashes[i];
+  }
+  mem_free(hashes);
+}
+
+/**************** sketch_and ****************/
+/* see sketch.h for description */
+double
+sketch_and(const sketch_t *const sketches[], const int n)
+{
+  double interSize, unionSize;
+  estimate(sketches, n, &interSize, &unionSize);
+  return interSize;
+}
+
+/**************** sketch_or ****************/
+/* see sketch.h for description */
+double
+sketch_or(const sketch_t *const sketches[], const int n)
+{
+  double interSize, unionSize;
+  estimate(sketches, n, &interSize, &unionSize);
+  return unionSize;
+}
+
+/* estimate */
+/* Estimate the intersection and union sizes of the n sets. */
+static void
+estimate(const sketch_t *const sketches[], const int n,
+         double *inter_out, double *union_out)
+{
+  *inter_out = *union_out = 0;
+  if (n <= 0) {
+    return;
+  }
+
+  int minsize = sketches[0]->size, maxsize = 0;
+  double sumsize = 0;
+  bool whole = true;              // every set is kept whole
+  for (int s = 0; s < n; s++) {
+    int size = sketches[s]->size;
+    minsize = (size < minsize) ? size : minsize;
+    maxsize = (size > maxsize) ? size : maxsize;
+    sumsize += size;
+    whole = whole && (sketches[s]->n == size);
+  }
+  if (n == 1) {
+    *inter_out = *union_out = minsize;
+    return;
+  }
+
+  /* merge the sketches, smallest value first, stopping after K distinct
+   * values unless the sets are all whole */
+  int pos[n];
+  for (int s = 0; s < n; s++) {
+    pos[s] = 0;
+  }
+  int distinct = 0;               // union values seen
+  int common = 0;                 // ...of which in every set
+  uint32_t last = 0;
+  while (whole || distinct < SKETCH_K) {
+    bool any = false;
+    uint32_t min = 0;
+    for (int s = 0; s < n; s++) {
+      if (pos[s] < sketches[s]->n
+          && (!any || sketches[s]->mins[pos[s]] < min)) {
+        min = sketches[s]->mins[pos[s]];
+        any = true;
+      }
+    }
+    if (!any) {
+      break;
+    }
+    int in = 0;
+    for (int s = 0; s < n; s++) {
+      if (pos[s] < sketches[s]->n && sketches[s]->mins[pos[s]] == min) {
+        pos[s]++;
+        in++;
+      }
+    }
+    distinct++;
+    common += (in == n);
+    last = min;
+  }
+
+  if (whole || distinct == 0) {
+    *inter_out = common;
+    *union_out = distinct;
+    return;
+  }
+  double unionSize = (SKETCH_K - 1) / (((double) last + 1) / 4294967296.0);
+  if (unionSize < maxsize) {
+    unionSize = maxsize;
+  }
+  if (unionSize > sumsize) {
+    unionSize = sumsize;
+  }
+  double interSize = unionSize * common / distinct;
+
+  /* when the sets differ a lot in size, the smallest set's sketch makes
+   * a better sample: below every other sketch's K'th value, membership
+   * in the other sets is known exactly */
+  int sampled, hits;
+  contained(sketches, n, &sampled, &hits);
+  if (sampled > 0 && hits >= common) {
+    interSize = (double) minsize * hits / sampled;
+  }
+
+  *inter_out = (interSize < minsize) ? interSize : minsize;
+  *union_out = unionSize;
+}
+
+/* contained */
+/* Count, in *sampled_out, the values of the smallest set's sketch that
+ * are no larger than the K'th value of every other (not whole) sketch,
+ * and in *hits_out how many of those are in every other sketch.
+ */
+static void
+contained(const sketch_t *const sketches[], const int n,
+          int *sampled_out, int *hits_out)
+{
+  int small = 0;
+  for (int s = 1; s < n; s++) {
+    if (sketches[s]->size < sketches[small]->size) {
+      small = s;
+    }
+  }
+  uint32_t limit = UINT32_MAX;
+  for (int s = 0; s < n; s++) {
+    const sketch_t *sk = sketches[s];
+    if (s != small && sk->n < sk->size && sk->mins[sk->n - 1] < limit) {
+      limit = sk->mins[sk->n - 1];
+    }
+  }
+
+  int sampled = 0, hits = 0;
+  const sketch_t *sk = sketches[small];
+  for (int i = 0; i < sk->n && sk->mins[i] <= limit; i++) {
+    sampled++;
+    bool all = true;
+    for (int s = 0; s < n && all; s++) {
+      all = (s == small) || has_value(sketches[s], sk->mins[i]);
+    }
+    hits += all;
+  }
+  *sampled_out = sampled;
+  *hits_out = hits;
+}
+
+/* has_value */
+/* Return true if value is kept in sketch (binary search). */
+static bool
+has_value(const sketch_t *sketch, const uint32_t value)
+{
+  int lo = 0, hi = sketch->n;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (sketch->mins[mid] < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < sketch->n && sketch->mins[lo] == value;
+}
+
+/**************** sketch_order ****************/
+/* see sketch.h for description */
+void
+sketch_order(const sketch_t *const sketches[], const int n, int order[])
+{
+  bool used[n > 0 ? n : 1];
+  int norder = 0;
+  for (int i = 0; i < n; i++) {
+    used[i] = false;
+  }
+
+  /* an empty set empties the intersection: do it first */
+  for (int i = 0; i < n; i++) {
+    if (sketches[i] == NULL || sketches[i]->size == 0) {
+      order[norder++] = i;
+      used[i] = true;
+    }
+  }
+  if (norder > 0 || n < 2) {
+    for (int i = 0; i < n; i++) {
+      if (!used[i]) {
+        order[norder++] = i;
+      }
+    }
+    return;
+  }
+
+  /* a pair intersects to the same set either way: no estimates needed */
+  if (n == 2) {
+    bool swap = sketches[1]->size < sketches[0]->size;
+    order[0] = swap ? 1 : 0;
+    order[1] = swap ? 0 : 1;
+    return;
+  }
+
+  /* the pair with the smallest intersection, smaller set first */
+  const sketch_t *chosen[n];
+  int besti = 0, bestj = 1;
+  double best = -1;
+  for (int i = 0; i < n; i++) {
+    for (int j = i + 1; j < n; j++) {
+      const sketch_t *pair[2] = { sketches[i], sketches[j] };
+      double est = sketch_and(pair, 2);
+      int size = sketches[i]->size + sketches[j]->size;
+      int bestsize = sketches[besti]->size + sketches[bestj]->size;
+      if (best < 0 || est < best || (est == best && size < bestsize)) {
+        best = est;
+        besti = i;
+        bestj = j;
+      }
+    }
+  }
+  if (sketches[bestj]->size < sketches[besti]->size) {
+    int swap = besti;
+    besti = bestj;
+    bestj = swap;
+  }
+  order[norder] = besti;
+  chosen[norder++] = sketches[besti];
+  order[norder] = bestj;
+  chosen[norder++] = sketches[bestj];
+  used[besti] = used[bestj] = true;
+
+  /* then whichever set leaves the smallest intersection */
+  while (norder < n) {
+    int bestt = -1;
+    best = -1;
+    for (int t = 0; t < n; t++) {
+      if (used[t]) {
+        continue;
+      }
+      chosen[norder] = sketches[t];
+      double est = sketch_and(chosen, norder + 1);
+      if (best < 0 || est < best
+          || (est == best && sketches[t]->size < sketches[bestt]->size)) {
+        best = est;
+        bestt = t;
+      }
+    }
+    order[norder] = bestt;
+    chosen[norder++] = sketches[bestt];
+    used[bestt] = true;
+  }
+}
+
+/* hash_doc */
+/* Hash a docID to 32 bits (the murmur3 finalizer: a bijection, so
+ * distinct docIDs never collide).
+ */
+static uint32_t
+hash_doc(const int docID)
+{
+  uint32_t h = (uint32_t) docID;
+  h ^= h >> 16;
+  h *= 0x85ebca6bU;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35U;
+  h ^= h >> 16;
+  return h;
+}
+
+/* cmp_uint32 */
+/* qsort comparison: uint32_t ascending. */
+static int
+cmp_uint32(const void *a, const void *b)
+{
+  const uint32_t *ua = a;
+  const uint32_t *ub = b;
+  return (*ua > *ub) - (*ua < *ub);
+}
@@ -0,0 +1,58 @@
+/*
+ * sketch.h - header file for the querier's 'sketch' module
+ *
+ * KMV ("k minimum values") sketches of docID sets. A sketch keeps the
+ * SKETCH_K smallest hash values of a set's docIDs; from the sketches
+ * alone we can estimate, in microseconds, how large the intersection
+ * or union of several sets is, which lets the querier plan the order
+ * of an andsequence's intersections and choose an engine before doing
+ * any real work. Sets with fewer than SKETCH_K docIDs are kept whole,
+ * so their estimates are exact.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __SKETCH_H
+#define __SKETCH_H
+
+#include <stdint.h>
+
+/* hash values kept per set */
+#define SKETCH_K 128
+
+typedef struct sketch {
+  int size;                    // exact size of the set
+  int n;                       // values kept: min(size, SKETCH_K)
+  uint32_t mins[SKETCH_K];     // the n smallest hashes, ascending
+} sketch_t;
+
+/**************** sketch_build ****************/
+/* Fill sketch from the n docIDs in docs (distinct, in any order). */
+void sketch_build(sketch_t *sketch, const int *docs, const int n);
+
+/**************** sketch_and ****************/
+/* Estimate the size of the intersection of the n sets sketched in
+ * sketches[]. Exact when every set is smaller than SKETCH_K; never
+ * more than the smallest set. With n == 1, the set's size.
+ */
+double sketch_and(const sketch_t *const sketches[], const int n);
+
+/**************** sketch_or ****************/
+/* Estimate the size of the union of the n sets sketched in sketches[].
+ * Exact when every set is smaller than SKETCH_K; never less than the
+ * largest set.
+ */
+double sketch_or(const sketch_t *const sketches[], const int n);
+
+/**************** sketch_order ****************/
+/* Plan an intersection of the n sets in sketches[]: fill order[] with
+ * 0..n-1 so that intersecting in that order keeps the intermediate
+ * results small. The first two are the pair with the smallest
+ * estimated intersection; each next set is the one that leaves the
+ * smallest estimate. Ties go to the smaller set, then the earlier one.
+ * NULL sketches stand for empty sets and come first.
+ */
+void sketch_order(const sketch_t *const sketches[], const int n,
+                  int order[]);
+
+#endif // __SKETCH_H
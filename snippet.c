@@ -0,0 +1,542 @@
+/*
+ * snippet.c - 'snippet' module for the CS50 TSE querier
+ *
+ * see snippet.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* mmap, open and fstat are POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "snippet.h"
+#include "mem.h"
+
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
+#define MAX_TERMS   16        // query words a snippet looks for
+#define MAX_HITS    256       // word occurrences remembered per page
+#define SNIPPET_MAX 512       // longest snippet text, including brackets
+#define KEY_MAX     1024      // longest cache key
+
+/**************** local types ****************/
+/* hit_t: one occurrence of a query word in the page. */
+typedef struct hit {
+  int pos;             // offset into the HTML
+  int term;            // which query word
+} hit_t;
+
+/* entry_t: one cached snippet, on the LRU list and a hash chain. */
+typedef struct entry {
+  char *key;
+  char *snippet;       // NULL if the page could not be read
+  int prev, next;      // LRU list; head is most recent
+  int chain;           // next entry in the same hash bucket
+} entry_t;
+
+/**************** global types ****************/
+struct snipper {
+  char *pageDirectory;
+  int nterms;
+  char *terms[MAX_TERMS];
+  int termLen[MAX_TERMS];
+  char termKey[KEY_MAX];       // the terms, joined, for cache keys
+
+  int capacity;                // cache entries
+  int used;
+  entry_t *entries;
+  int nbuckets;
+  int *buckets;                // hash bucket -> first entry, or -1
+  int head, tail;              // LRU list ends, or -1
+  int hits, misses;
+};
+
+/**************** local functions ****************/
+static char *make_snippet(snipper_t *snipper, const int docID);
+static int   find_hits(const snipper_t *snipper, const char *text,
+                       const int len, hit_t *hits);
+static bool  match_at(const snipper_t *snipper, const char *text,
+                      const int len, const int pos, int *term);
+static int   best_window(const hit_t *hits, const int nhits);
+static char *render(const char *text, const int len, const int start,
+                    const hit_t *hits, const int nhits,
+                    const snipper_t *snipper);
+static unsigned long hash_key(const char *key);
+static void  lru_unlink(snipper_t *snipper, const int e);
+static void  lru_push(snipper_t *snipper, const int e);
+static void  chain_remove(snipper_t *snipper, const int e);
+
+/**************** snippet_new ****************/
+/* see snippet.h for description */
+snipper_t *
+snippet_new(const char *pageDirectory, const int cacheSize)
+{
+  snipper_t *snipper = mem_calloc_assert(1, sizeof(snipper_t), "snippet_new");
+  snipper->pageDirectory = mem_malloc_assert(strlen(pageDirectory) + 1,
+                                             "snippet_new");
+  strcpy(snipper->pageDirectory, pageDirectory);
+
+  snipper->capacity = (cacheSize > 0) ? cacheSize : 1;
+  snipper->entries = mem_calloc_assert(snipper->capacity, sizeof(entry_t),
+                                       "snippet_new");
+  snipper->nbuckets = 2 * snipper->capacity + 1;
+  snipper->buckets = mem_malloc_assert(snipper->nbuckets * sizeof(int),
+                                       "snippet_new");
+  for (int b = 0; b < snipper->nbuckets; b++) {
+    snipper->buckets[b] = -1;
+  }
+  snipper->head = snipper->tail = -1;
+  return snipper;
+}
+
+/**************** snippet_query ****************/
+/* see snippet.h for description */
+void
+snippet_query(snipper_t *snipper, char **words, const int nwords)
+{
+  if (snipper == NULL) {
+    return;
+  }
+  for (int t = 0; t < snipper->nterms; t++) {
+    mem_free(snipper->terms[t]);
+  }
+  snipper->nterms = 0;
+  snipper->termKey[0] = '\0';
+
+  for (int i = 0; i < nwords && snipper->nterms < MAX_TERMS; i++) {
+    if (strcmp(words[i], "and") == 0 || strcmp(words[i], "or") == 0) {
+      continue;
+    }
+    bool seen = false;
+    for (int t = 0; t < snipper->nterms && !seen; t++) {
+      seen = (strcmp(snipper->terms[t], words[i]) == 0);
+    }
+    if (seen) {
+      continue;
+    }
+    int t = snipper->nterms++;
+    snipper->termLen[t] = strlen(words[i]);
+    snipper->terms[t] = mem_malloc_assert(snipper->termLen[t] + 1,
+                                          "snippet_query");
+    strcpy(snipper->terms[t], words[i]);
+
+    size_t used = strlen(snipper->termKey);
+    snprintf(snipper->termKey + used, sizeof(snipper->termKey) - used,
+             " %s", words[i]);
+  }
+}
+
+/**************** snippet_get ****************/
+/* see snippet.h for description */
+const char *
+snippet_get(snipper_t *snipper, const int docID)
+{
+  if (snipper == NULL || docID <= 0) {
+    return NULL;
+  }
+
+  char key[KEY_MAX + 16];
+  snprintf(key, sizeof(key), "%d%s", docID, snipper->termKey);
+  int bucket = hash_key(key) % snipper->nbuckets;
+
+  for (int e = snipper->buckets[bucket]; e >= 0;
+       e = snipper->entries[e].chain) {
+    if (strcmp(snipper->entries[e].key, key) == 0) {
+      snipper->hits++;
+      lru_unlink(snipper, e);
+      lru_push(snipper, e);
+      return snipper->entries[e].snippet;
+    }
+  }
+  snipper->misses++;
+
+  /* take a free entry, or evict the least recently used one */
+  int e;
+  if (snipper->used < snipper->capacity) {
+    e = snipper->used++;
+  } else {
+    e = snipper->tail;
+    lru_unlink(snipper, e);
+    chain_remove(snipper, e);
+    mem_free(snipper->entries[e].key);
+    mem_free(snipper->entries[e].snippet);
+  }
+
+  entry_t *entry = &snipper->entries[e];
+  entry->key = mem_malloc_assert(strlen(key) + 1, "snippet_get");
+  strcpy(entry->key, key);
+  entry->snippet = make_snippet(snipper, docID);
+  entry->chain = snipper->buckets[bucket];
+  snipper->buckets[bucket] = e;
+  lru_push(snipper, e);
+  return entry->snippet;
+}
+
+/* make_snippet */
+/* Map the page file, find the query words in its HTML, and render the
+ * best window. Returns a new string, or NULL if the page is unreadable.
+ */
+static char *
+make_snippet(snipper_t *snipper, const int docID)
+{
+  char filename[PATH_MAX];
+  snprintf(filename, sizeof(filename), "%s/%d", snipper->pageDirectory,
+           docID);
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  size_t size = st.st_size;
+  char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  /* the HTML starts after the URL and depth lines */
+  const char *text = map;
+  const char *end = map + size;
+  for (int line = 0; line < 2 && text < end; line++) {
+    const char *nl = memchr(text, '\n', end - text);
+    text = (nl == NULL) ? end : nl + 1;
+  }
+  int len = end - text;
+  if (len > SNIPPET_BUDGET) {
+    len = SNIPPET_BUDGET;
+  }
+
+  hit_t hits[MAX_HITS];
+  int nhits = find_hits(snipper, text, len, hits);
+  int start = best_window(hits, nhits);
+  char *snippet = render(text, len, start, hits, nhits, snipper);
+
+  munmap(map, size);
+  return snippet;
+}
+
+/* find_hits */
+/* Record where the query words occur as whole words in text[0..len-1],
+ * up to MAX_HITS of them, in increasing position.
+ *
+ * Candidates are the positions holding the first letter of some query
+ * word, in either case; with SSE2 we test 16 bytes against every first
+ * letter at once and only verify the positions that match.
+ */
+static int
+find_hits(const snipper_t *snipper, const char *text, const int len,
+          hit_t *hits)
+{
+  if (snipper->nterms == 0) {
+    return 0;
+  }
+
+  /* the distinct first letters of the query words */
+  bool isFirst[256] = { false };
+  for (int t = 0; t < snipper->nterms; t++) {
+    isFirst[(unsigned char) snipper->terms[t][0]] = true;
+  }
+
+  int nhits = 0;
+  int pos = 0;
+#ifdef __SSE2__
+  __m128i fold = _mm_set1_epi8(0x20);        // 'A'|0x20 == 'a'
+  __m128i wanted[MAX_TERMS];
+  int nfirsts = 0;
+  for (int c = 'a'; c <= 'z'; c++) {
+    if (isFirst[c]) {
+      wanted[nfirsts++] = _mm_set1_epi8((char) c);
+    }
+  }
+  for (; pos + 16 <= len && nhits < MAX_HITS; pos += 16) {
+    __m128i chunk = _mm_or_si128(
+      _mm_loadu_si128((const __m128i *) (text + pos)), fold);
+    __m128i any = _mm_cmpeq_epi8(chunk, wanted[0]);
+    for (int f = 1; f < nfirsts; f++) {
+      any = _mm_or_si128(any, _mm_cmpeq_epi8(chunk, wanted[f]));
+    }
+    unsigned mask = (unsigned) _mm_movemask_epi8(any);
+    while (mask != 0 && nhits < MAX_HITS) {
+      int at = pos + __builtin_ctz(mask);
+      mask &= mask - 1;
+      int term;
+      if (match_at(snipper, text, len, at, &term)) {
+        hits[nhits].pos = at;
+        hits[nhits].term = term;
+        nhits++;
+      }
+    }
+  }
+#endif
+  /* the tail (or everything, without SSE2), one byte at a time */
+  for (; pos < len && nhits < MAX_HITS; pos++) {
+    unsigned char c = (unsigned char) (text[pos] | 0x20);
+    int term;
+    if (isFirst[c] && match_at(snipper, text, len, pos, &term)) {
+      hits[nhits].pos = pos;
+      hits[nhits].term = term;
+      nhits++;
+    }
+  }
+  return nhits;
+}
+
+/* match_at */
+/* Is there a whole query word, in any case, starting at text[pos]? */
+static bool
+match_at(const snipper_t *snipper, const char *text, const int len,
+         const int pos, int *term)
+{
+  if (pos > 0 && isalpha((unsigned char) text[pos-1])) {
+    return false;
+  }
+  for (int t = 0; t < snipper->nterms; t++) {
+    int n = snipper->termLen[t];
+    if (pos + n > len
+        || (pos + n < len && isalpha((unsigned char) text[pos+n]))) {
+      continue;
+    }
+    int i = 0;
+    while (i < n && tolower((unsigned char) text[pos+i]) == snipper->terms[t][i]) {
+      i++;
+    }
+    if (i == n) {
+      *term = t;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* best_window */
+/* Return the start of the SNIPPET_WINDOW-byte window that holds the most
+ * distinct query words (the earliest, on ties), or 0 if there are no
+ * hits. A sliding window over the hits, so O(nhits * nterms).
+ */
+static int
+best_window(const hit_t *hits, const int nhits)
+{
+  int inWindow[MAX_TERMS] = { 0 };
+  int distinct = 0;
+  int best = 0, bestStart = 0;
+
+  int lo = 0;
+  for (int hi = 0; hi < nhits; hi++) {
+    if (inWindow[hits[hi].term]++ == 0) {
+      distinct++;
+    }
+    while (hits[hi].pos - hits[lo].pos >= SNIPPET_WINDOW) {
+      if (--inWindow[hits[lo].term] == 0) {
+        distinct--;
+      }
+      lo++;
+    }
+    if (distinct > best) {
+      best = distinct;
+      bestStart = hits[lo].pos;
+    }
+  }
+
+  /* show a little context before the first word */
+  bestStart -= SNIPPET_WINDOW / 4;
+  return (bestStart < 0) ? 0 : bestStart;
+}
+
+/* render */
+/* Copy SNIPPET_WINDOW bytes of text from start, dropping markup and
+ * extra whitespace and bracketing the query words, into a new string.
+ */
+static char *
+render(const char *text, const int len, const int start,
+       const hit_t *hits, const int nhits, const snipper_t *snipper)
+{
+  char *out = mem_malloc_assert(SNIPPET_MAX + 1, "render");
+  int n = 0;
+
+  /* are we starting inside a tag? look back for '<' or '>' */
+  bool inTag = false;
+  for (int p = start - 1; p >= 0 && p >= start - 256; p--) {
+    if (text[p] == '>') {
+      break;
+    }
+    if (text[p] == '<') {
+      inTag = true;
+      break;
+    }
+  }
+  /* and don't start in the middle of a word */
+  int p = start;
+  while (p > 0 && p < len && isalpha((unsigned char) text[p-1])) {
+    p++;
+  }
+
+  int h = 0;
+  int end = (start + SNIPPET_WINDOW < len) ? start + SNIPPET_WINDOW : len;
+  bool space = false;
+  while (p < end && n < SNIPPET_MAX - 2) {
+    char c = text[p];
+    if (inTag) {
+      inTag = (c != '>');
+      p++;
+      continue;
+    }
+    if (c == '<') {
+      inTag = true;
+      space = true;             // a tag separates words
+      p++;
+      continue;
+    }
+    if (isspace((unsigned char) c)) {
+      space = true;
+      p++;
+      continue;
+    }
+    if (space && n > 0) {
+      out[n++] = ' ';
+    }
+    space = false;
+
+    while (h < nhits && hits[h].pos < p) {
+      h++;
+    }
+    if (h < nhits && hits[h].pos == p) {
+      int wlen = snipper->termLen[hits[h].term];
+      if (n + wlen + 2 > SNIPPET_MAX) {
+        break;
+      }
+      out[n++] = '[';
+      memcpy(out + n, text + p, wlen);
+      n += wlen;
+      out[n++] = ']';
+      p += wlen;
+      continue;
+    }
+    out[n++] = c;
+    p++;
+  }
+
+  /* don't end in the middle of a word either */
+  if (p < len && isalpha((unsigned char) text[p])) {
+    int cut = n;
+    while (cut > 0 && out[cut-1] != ' ') {
+      cut--;
+    }
+    if (cut > 0) {
+      n = cut - 1;
+    }
+  }
+  out[n] = '\0';
+  return out;
+}
+
+/**************** snippet_stats ****************/
+/* see snippet.h for description */
+void
+snippet_stats(const snipper_t *snipper, int *hits, int *misses)
+{
+  *hits = (snipper == NULL) ? 0 : snipper->hits;
+  *misses = (snipper == NULL) ? 0 : snipper->misses;
+}
+
+/**************** snippet_delete ****************/
+/* see snippet.h for description */
+void
+snippet_delete(snipper_t *snipper)
+{
+  if (snipper == NULL) {
+    return;
+  }
+  for (int e = 0; e < snipper->used; e++) {
+    mem_free(snipper->entries[e].key);
+    mem_free(snipper->entries[e].snippet);
+  }
+  for (int t = 0; t < snipper->nterms; t++) {
+    mem_free(snipper->terms[t]);
+  }
+  mem_free(snipper->entries);
+  mem_free(snipper->buckets);
+  mem_free(snipper->pageDirectory);
+  mem_free(snipper);
+}
+
+/* hash_key */
+/* djb2 string hash. */
+static unsigned long
+hash_key(const char *key)
+{
+  unsigned long h = 5381;
+  for (const char *c = key; *c != '\0'; c++) {
+    h = h * 33 + (unsigned char) *c;
+  }
+  return h;
+}
+
+/* lru_unlink */
+/* Take entry e off the LRU list. */
+static void
+lru_unlink(snipper_t *snipper, const int e)
+{
+  entry_t *entry = &snipper->entries[e];
+  if (entry->prev >= 0) {
+    snipper->entries[entry->prev].next = entry->next;
+  } else {
+    snipper->head = entry->next;
+  }
+  if (entry->next >= 0) {
+    snipper->entries[entry->next].prev = entry->prev;
+  } else {
+    snipper->tail = entry->prev;
+  }
+}
+
+/* lru_push */
+/* Put entry e at the front (most recent end) of the LRU list. */
+static void
+lru_push(snipper_t *snipper, const int e)
+{
+  entry_t *entry = &snipper->entries[e];
+  entry->prev = -1;
+  entry->next = snipper->head;
+  if (snipper->head >= 0) {
+    snipper->entries[snipper->head].prev = e;
+  }
+  snipper->head = e;
+  if (snipper->tail < 0) {
+    snipper->tail = e;
+  }
+}
+
+/* chain_remove */
+/* Take entry e out of its hash bucket's chain. */
+static void
+chain_remove(snipper_t *snipper, const int e)
+{
+  int bucket = hash_key(snipper->entries[e].key) % snipper->nbuckets;
+  int *link = &snipper->buckets[bucket];
+  while (*link >= 0 && *link != e) {
+    link = &snipper->entries[*link].chain;
+  }
+  if (*link == e) {
+    *link = snipper->entries[e].chain;
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ * snippet.h - header file for the querier's 'snippet' module
+ *
+ * Builds a short, query-biased snippet for a result page: the page
+ * file is mapped into memory, at most SNIPPET_BUDGET bytes of its HTML
+ * are scanned for the query's words (16 bytes at a time with SSE2 where
+ * available), and the window holding the most distinct query words is
+ * printed without markup, with the words in [brackets]. Recent
+ * snippets are kept in an LRU cache keyed by docID and query words.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __SNIPPET_H
+#define __SNIPPET_H
+
+/* bytes of HTML scanned per page, at most */
+#define SNIPPET_BUDGET (64 * 1024)
+
+/* bytes of raw HTML the snippet window covers */
+#define SNIPPET_WINDOW 160
+
+typedef struct snipper snipper_t;
+
+/**************** snippet_new ****************/
+/* Return a new snippet maker for pages in pageDirectory, caching up to
+ * cacheSize snippets; caller frees it with snippet_delete.
+ */
+snipper_t *snippet_new(const char *pageDirectory, const int cacheSize);
+
+/**************** snippet_query ****************/
+/* Set the words that the following snippets are biased toward;
+ * operators ("and", "or") are ignored. The words are copied.
+ */
+void snippet_query(snipper_t *snipper, char **words, const int nwords);
+
+/**************** snippet_get ****************/
+/* Return the snippet of page docID for the current query words, or NULL
+ * if the page cannot be read. The string belongs to the cache and stays
+ * valid until the next call to snippet_get or snippet_delete.
+ */
+const char *snippet_get(snipper_t *snipper, const int docID);
+
+/**************** snippet_stats ****************/
+/* Report the cache's hits and misses so far. */
+void snippet_stats(const snipper_t *snipper, int *hits, int *misses);
+
+/**************** snippet_delete ****************/
+/* Free the snippet maker and its cache; NULL is ignored. */
+void snippet_delete(snipper_t *snipper);
+
+#endif // __SNIPPET_H
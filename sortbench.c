@@ -0,0 +1,115 @@
+/*
+ * sortbench.c - compare the querier's ways of ranking results
+ *
+ * For result sets of growing size, with docIDs in random order and
+ * small, skewed scores like real ones, times qsort with docscore_cmp,
+ * radix_sort on one thread, and radix_sort on the given number of
+ * threads, and checks that all three give the same order. make bench
+ * runs it.
+ *
+ * Usage:
+ *   ./sortbench [maxResults [threads]]
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "query.h"
+#include "radix.h"
+#include "timing.h"
+#include "mem.h"
+
+/* local functions */
+static void fill(docscore_t *docs, const int n);
+
+/* main */
+/* Time the three sorts for 1000, 4000, 16000, ... results, up to
+ * maxResults.
+ */
+int
+main(const int argc, char *argv[])
+{
+  int maxResults = 4096000;
+  int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+  char extra;
+  if (argc > 3
+      || (argc > 1 && (sscanf(argv[1], "%d%c", &maxResults, &extra) != 1
+                       || maxResults < 1))
+      || (argc > 2 && (sscanf(argv[2], "%d%c", &threads, &extra) != 1
+                       || threads < 1))) {
+    fprintf(stderr, "usage: %s [maxResults [threads]]\n", argv[0]);
+    exit(1);
+  }
+
+  printf("%10s %12s %12s %12s  (ms; %d threads)\n", "results", "qsort",
+         "radix 1", "radix N", threads);
+  for (long n = 1000; n <= maxResults; n *= 4) {
+    docscore_t *input = mem_malloc_assert(n * sizeof(docscore_t), "main");
+    docscore_t *docs[3];
+    fill(input, n);
+    for (int s = 0; s < 3; s++) {
+      docs[s] = mem_malloc_assert(n * sizeof(docscore_t), "main");
+      memcpy(docs[s], input, n * sizeof(docscore_t));
+    }
+
+    double ms[3];
+    double start = timing_ms();
+    qsort(docs[0], n, sizeof(docscore_t), docscore_cmp);
+    ms[0] = timing_ms() - start;
+    start = timing_ms();
+    radix_sort(docs[1], n, 1, NULL);
+    ms[1] = timing_ms() - start;
+    start = timing_ms();
+    radix_sort(docs[2], n, threads, NULL);
+    ms[2] = timing_ms() - start;
+
+    printf("%10ld %12.3f %12.3f %12.3f\n", n, ms[0], ms[1], ms[2]);
+    if (memcmp(docs[0], docs[1], n * sizeof(docscore_t)) != 0
+        || memcmp(docs[0], docs[2], n * sizeof(docscore_t)) != 0) {
+      fprintf(stderr, "sortbench: sorts disagree at %ld results\n", n);
+      exit(2);
+    }
+    for (int s = 0; s < 3; s++) {
+      mem_free(docs[s]);
+    }
+    mem_free(input);
+  }
+  return 0;
+}
+
+/* fill */
+/* Fill docs with docIDs 1..n in random order, each with a score from
+ * 1 up, halving in frequency with every step (a fixed seed, so runs
+ * compare).
+ */
+static void
+fill(docscore_t *docs, const int n)
+{
+  uint64_t x = 88172645463325252ULL;      // xorshift64 state
+  for (int i = 0; i < n; i++) {
+    docs[i].docID = i + 1;
+  }
+  for (int i = n - 1; i > 0; i--) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    int j = (int) (x % (uint64_t) (i + 1));
+    int swap = docs[i].docID;
+    docs[i].docID = docs[j].docID;
+    docs[j].docID = swap;
+  }
+  for (int i = 0; i < n; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    int score = 1;
+    for (uint64_t bits = x; (bits & 1) && score < 64; bits >>= 1) {
+      score++;
+    }
+    docs[i].score = score;
+  }
+}
@@ -4,6 +4,7 @@
 set -e
 
 Q=./querier
+SH=./simhasher
 
 # common shared paths?
 PDIR=/cs50/shared/tse/output/letters-1
@@ -76,3 +77,358 @@ grep -i "bad character" "$TMP/syntax.out" >/dev/null
 grep -i "cannot be first" "$TMP/syntax.out" >/dev/null
 grep -i "cannot be last" "$TMP/syntax.out" >/dev/null
 grep -i "cannot be adjacent" "$TMP/syntax.out" >/dev/null
+
+# top-k, and tier 1 must give exactly the same top-k as the full index
+echo "== top-k and tiers =="
+$Q -k 3 "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/topk.out" 2>&1
+$Q -k 3 -tiered "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/tiered.out" 2> "$TMP/tiered.err"
+grep '^Top' "$TMP/topk.out" >/dev/null
+cmp "$TMP/topk.out" "$TMP/tiered.out"
+grep -i "tier 1 alone answered" "$TMP/tiered.err" >/dev/null
+set +e
+$Q -tiered "$PDIR" "$IDX" < /dev/null > "$TMP/tierednok.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/tierednok.out" >/dev/null
+
+# host:/site: filters keep only pages on that host, in the same order
+echo "== host filters =="
+HOST=$(head -1 "$PDIR/1" | sed -E 's|^[a-z]+://([^/:]+).*|\1|')
+echo "hello or world" > "$TMP/nofilt.txt"
+echo "hello or world host:$HOST" > "$TMP/filt.txt"
+$Q "$PDIR" "$IDX" < "$TMP/nofilt.txt" 2>&1 | grep '^score' | grep "//$HOST[/:]" > "$TMP/post.out" || true
+$Q "$PDIR" "$IDX" < "$TMP/filt.txt" 2>&1 | grep '^score' > "$TMP/filt.out" || true
+cmp "$TMP/post.out" "$TMP/filt.out"
+echo "hello host:b@d" > "$TMP/badfilt.txt"
+$Q "$PDIR" "$IDX" < "$TMP/badfilt.txt" > "$TMP/badfilt.out" 2>&1
+grep -i "bad character" "$TMP/badfilt.out" >/dev/null
+
+# attribute predicates: every result must satisfy depth<=1
+echo "== attribute predicates =="
+echo "hello or world depth<=1" > "$TMP/pred.txt"
+$Q "$PDIR" "$IDX" < "$TMP/pred.txt" > "$TMP/pred.out" 2>&1
+grep '^Query: hello or world depth<=1' "$TMP/pred.out" >/dev/null
+for id in $(grep '^score' "$TMP/pred.out" | sed -E 's/.*doc +([0-9]+):.*/\1/'); do
+  [[ $(sed -n 2p "$PDIR/$id") -le 1 ]] || { echo "doc $id has depth > 1"; exit 1; }
+done
+echo "hello depth<<1" > "$TMP/badpred.txt"
+$Q "$PDIR" "$IDX" < "$TMP/badpred.txt" > "$TMP/badpred.out" 2>&1
+grep -i "bad predicate" "$TMP/badpred.out" >/dev/null
+# a comparison after a word that is not an attribute is a bad character
+echo "hello!" > "$TMP/typo.txt"
+$Q "$PDIR" "$IDX" < "$TMP/typo.txt" > "$TMP/typo.out" 2>&1
+grep -i "bad character '!'" "$TMP/typo.out" >/dev/null
+
+# near-duplicate collapsing: shown + hidden must add up to all matches
+echo "== near-duplicates =="
+cp -r "$PDIR" "$TMP/pages"
+$SH "$TMP/pages" > /dev/null
+[[ -s "$TMP/pages/.simhash" ]] || { echo "simhasher wrote nothing"; exit 1; }
+$Q "$TMP/pages" "$IDX" < "$TMP/nofilt.txt" > "$TMP/all.out" 2>&1
+$Q -collapse "$TMP/pages" "$IDX" < "$TMP/nofilt.txt" > "$TMP/collapse.out" 2>&1
+ALL=$(grep -c '^score' "$TMP/all.out" || true)
+SHOWN=$(grep -c '^score' "$TMP/collapse.out" || true)
+HIDDEN=$(sed -nE 's/^\(([0-9]+) near-duplicate.*/\1/p' "$TMP/collapse.out")
+[[ $((SHOWN + ${HIDDEN:-0})) -eq $ALL ]] || { echo "collapse lost documents"; exit 1; }
+set +e
+$Q -collapse "$PDIR" "$IDX" < /dev/null > "$TMP/nosim.out" 2>&1
+set -e
+[[ -f "$PDIR/.simhash" ]] || grep -i "run simhasher" "$TMP/nosim.out" >/dev/null
+
+# snippets: one indented line under each result, with the word bracketed
+echo "== snippets =="
+echo "hello" > "$TMP/snip.txt"
+$Q -k 3 -snippets "$PDIR" "$IDX" < "$TMP/snip.txt" > "$TMP/snip.out" 2> "$TMP/snip.err"
+[[ $(grep -c '^score' "$TMP/snip.out") -eq $(grep -c '^      ' "$TMP/snip.out") ]]
+grep -i '^      .*\[hello\]' "$TMP/snip.out" >/dev/null
+grep "snippet cache" "$TMP/snip.err" >/dev/null
+
+# evaluation engines: DAAT and block must print exactly what TAAT prints
+echo "== engines =="
+$Q -engine daat "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/daat.out" 2>&1
+cmp "$TMP/basic.out" "$TMP/daat.out"
+$Q -k 3 -engine daat "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/daatk.out" 2>&1
+cmp "$TMP/topk.out" "$TMP/daatk.out"
+$Q -engine block "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/block.out" 2>&1
+cmp "$TMP/basic.out" "$TMP/block.out"
+$Q -engine auto -stats "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/auto.out" 2> "$TMP/auto.err"
+cmp "$TMP/basic.out" "$TMP/auto.out"
+grep "engine block:" "$TMP/auto.err" >/dev/null
+set +e
+$Q -engine fast "$PDIR" "$IDX" < /dev/null > "$TMP/badengine.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badengine.out" >/dev/null
+
+# Bloom filters may only skip probes, never change results
+echo "== bloom filters =="
+$Q -bloom "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/bloom.out" 2>&1
+cmp "$TMP/basic.out" "$TMP/bloom.out"
+$Q -bloom -engine block "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/bloomblock.out" 2>&1
+cmp "$TMP/basic.out" "$TMP/bloomblock.out"
+
+# planning reorders intersections but must not change results
+echo "== planning =="
+cat > "$TMP/plan.txt" <<'PLAN'
+world and hello
+hello world and goodbye
+goodbye or world hello
+PLAN
+$Q "$PDIR" "$IDX" < "$TMP/plan.txt" > "$TMP/noplan.out" 2>&1
+for engine in taat block auto; do
+  $Q -plan -engine $engine "$PDIR" "$IDX" < "$TMP/plan.txt" > "$TMP/plan.out" 2>&1
+  cmp "$TMP/noplan.out" "$TMP/plan.out"
+done
+
+# a batch shares work between queries but must print the same results
+echo "== batch =="
+cat "$TMP/q.txt" "$TMP/plan.txt" "$TMP/q.txt" > "$TMP/batch.txt"
+echo "world and hello host:$HOST" >> "$TMP/batch.txt"
+echo "hello and world" >> "$TMP/batch.txt"
+$Q "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/stream.out" 2> /dev/null
+$Q -batch "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/batch.out" 2> "$TMP/batch.err"
+cmp "$TMP/stream.out" "$TMP/batch.out"
+$Q -k 3 "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/stream.out" 2> /dev/null
+$Q -k 3 -tiered -batch "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/batch.out" 2> /dev/null
+cmp "$TMP/stream.out" "$TMP/batch.out"
+grep "answered by an identical earlier query" "$TMP/batch.err" >/dev/null
+
+# compressed postings decode through the block cache to the same results,
+# however small the cache
+echo "== compressed postings =="
+for cache in 1 4096; do
+  $Q -compressed -cache $cache -engine block "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/packed.out" 2> "$TMP/packed.err"
+  $Q "$PDIR" "$IDX" < "$TMP/batch.txt" 2> /dev/null | cmp - "$TMP/packed.out"
+done
+grep "block cache:.*hit rate" "$TMP/packed.err" >/dev/null
+$Q -compressed -batch -bloom "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/packed.out" 2> /dev/null
+$Q "$PDIR" "$IDX" < "$TMP/batch.txt" 2> /dev/null | cmp - "$TMP/packed.out"
+set +e
+$Q -compressed -engine daat "$PDIR" "$IDX" < /dev/null > "$TMP/packeddaat.out" 2>&1
+$Q -cache 16 "$PDIR" "$IDX" < /dev/null > "$TMP/cachealone.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/packeddaat.out" >/dev/null
+grep -E '^usage:' "$TMP/cachealone.out" >/dev/null
+
+# the fast paths for one- and two-word queries must match the general loop
+echo "== fast paths =="
+cat > "$TMP/shapes.txt" <<SHAPES
+hello
+hello world
+hello and world
+hello or world
+world or world
+hello world goodbye
+hello or world host:$HOST
+SHAPES
+$Q -nofast "$PDIR" "$IDX" < "$TMP/shapes.txt" > "$TMP/general.out" 2>&1
+$Q -stats "$PDIR" "$IDX" < "$TMP/shapes.txt" > "$TMP/fast.out" 2> "$TMP/fast.err"
+cmp "$TMP/general.out" "$TMP/fast.out"
+grep "taat fast paths: 1 one-word, 2 two-word and, 3 two-word or" "$TMP/fast.err" >/dev/null
+$Q -bloom "$PDIR" "$IDX" < "$TMP/shapes.txt" > "$TMP/fast.out" 2>&1
+cmp "$TMP/general.out" "$TMP/fast.out"
+
+# ranking order must not depend on the number of sorting threads
+echo "== sorting threads =="
+for threads in 1 3; do
+  $Q -threads $threads "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/threads.out" 2>&1
+  cmp "$TMP/basic.out" "$TMP/threads.out"
+done
+set +e
+$Q -threads 0 "$PDIR" "$IDX" < /dev/null > "$TMP/badthreads.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badthreads.out" >/dev/null
+
+# streamed results are the ranked results, with the count moved to the end
+echo "== streaming =="
+for k in "" "-k 3"; do
+  $Q $k "$PDIR" "$IDX" < "$TMP/batch.txt" 2> /dev/null \
+    | grep -v -E '^(Top|Matches) ' > "$TMP/ranked.out"
+  $Q $k -stream "$PDIR" "$IDX" < "$TMP/batch.txt" > "$TMP/streamed.out" 2> "$TMP/streamed.err"
+  grep -v -E '^(Top|Matched) ' "$TMP/streamed.out" | cmp - "$TMP/ranked.out"
+done
+grep -E '^Top [0-9]+ of [0-9]+ documents' "$TMP/streamed.out" >/dev/null
+grep "results printed before evaluation" "$TMP/streamed.err" >/dev/null
+
+# worker threads answer in input order, whatever node they run on
+echo "== workers =="
+$Q "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/serial.out" 2> /dev/null
+for mode in "-workers 3" "-numa replicate" "-numa interleave -workers 2"; do
+  $Q $mode "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/workers.out" 2> "$TMP/workers.err"
+  cmp "$TMP/serial.out" "$TMP/workers.out"
+done
+grep -E "node [0-9]+ \(cpus .*\): 2 workers" "$TMP/workers.err" >/dev/null
+$Q -k 3 -tiered -workers 2 "$PDIR" "$IDX" < "$TMP/q.txt" 2> /dev/null | cmp - "$TMP/topk.out"
+set +e
+$Q -numa everywhere "$PDIR" "$IDX" < /dev/null > "$TMP/badnuma.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badnuma.out" >/dev/null
+
+# in lanes the answers may come out of order, but each is whole
+echo "== lanes =="
+$Q -workers 3 -lanes 1 -slowcost 1 "$PDIR" "$IDX" < "$TMP/q.txt" > "$TMP/lanes.out" 2> "$TMP/lanes.err"
+awk -v RS='-----------------------------------------------\n' '{ print $0 "@" }' "$TMP/serial.out" | sort > "$TMP/serial.sorted"
+awk -v RS='-----------------------------------------------\n' '{ print $0 "@" }' "$TMP/lanes.out" | sort | cmp - "$TMP/serial.sorted"
+grep -E "fast lane: 2 workers" "$TMP/lanes.err" >/dev/null
+grep -E "slow lane: 1 workers, [1-9][0-9]* queries" "$TMP/lanes.err" >/dev/null
+set +e
+$Q -workers 2 -lanes 2 "$PDIR" "$IDX" < /dev/null > "$TMP/badlanes.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badlanes.out" >/dev/null
+
+# one thread taking turns between streams answers each as if alone
+echo "== interleaved inputs =="
+head -3 "$TMP/q.txt" > "$TMP/in1"
+tail -n +4 "$TMP/q.txt" > "$TMP/in2"
+$Q "$PDIR" "$IDX" < "$TMP/in1" > "$TMP/in1.serial" 2> /dev/null
+$Q "$PDIR" "$IDX" < "$TMP/in2" > "$TMP/in2.serial" 2> /dev/null
+for slice in 1 0; do
+  $Q -slice $slice -inputs "$TMP/in1,-" "$PDIR" "$IDX" < "$TMP/in2" > "$TMP/in2.out" 2> "$TMP/inputs.err"
+  cmp "$TMP/in1.serial" "$TMP/in1.out"
+  cmp "$TMP/in2.serial" "$TMP/in2.out"
+done
+$Q -inputs "$TMP/in1,$TMP/in2" "$PDIR" "$IDX" 2> "$TMP/inputs.err"
+cmp "$TMP/in2.serial" "$TMP/in2.out"
+grep -E "input .*in1: 3 queries in [0-9]+ slices" "$TMP/inputs.err" >/dev/null
+set +e
+$Q -slice 8 "$PDIR" "$IDX" < /dev/null > "$TMP/badslice.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badslice.out" >/dev/null
+
+echo "== listening =="
+# each client gets on its socket what stdout would have, with either loop
+nlines=$(( $(wc -l < "$TMP/serial.out") - 1 ))
+head -n $nlines "$TMP/serial.out" > "$TMP/listen.want"
+for io in uring epoll; do
+  rm -f "$TMP/listen.fifo"
+  mkfifo "$TMP/listen.fifo"
+  $Q -listen 0 -io $io "$PDIR" "$IDX" < "$TMP/listen.fifo" 2> "$TMP/listen.err" &
+  lpid=$!
+  exec 3> "$TMP/listen.fifo"          # serving lasts until this closes
+  for try in $(seq 50); do
+    grep -q 'listening on port' "$TMP/listen.err" && break
+    sleep 0.1
+  done
+  port=$(sed -n 's/.*listening on port \([0-9]*\).*/\1/p' "$TMP/listen.err")
+  clients=""
+  for c in 1 2; do
+    ( exec 4<> "/dev/tcp/127.0.0.1/$port"
+      cat "$TMP/q.txt" >&4
+      timeout 10 head -n $nlines <&4 > "$TMP/listen$c.out" ) &
+    clients="$clients $!"
+  done
+  wait $clients
+  # a last line with no newline is answered once the client shuts down
+  # its side of the connection
+  timeout 10 python3 - "$port" > "$TMP/listen3.out" <<'EOF'
+import socket, sys
+conn = socket.create_connection(("127.0.0.1", int(sys.argv[1])))
+conn.sendall(b"hello")
+conn.shutdown(socket.SHUT_WR)
+while True:
+    data = conn.recv(4096)
+    if not data:
+        break
+    sys.stdout.buffer.write(data)
+EOF
+  exec 3>&-
+  wait $lpid
+  cmp "$TMP/listen.want" "$TMP/listen1.out"
+  cmp "$TMP/listen.want" "$TMP/listen2.out"
+  grep -q '^Query: hello$' "$TMP/listen3.out"
+  grep -E "listen \(($io|epoll)\): 3 connections, [1-9][0-9]* queries" "$TMP/listen.err" >/dev/null
+done
+set +e
+$Q -io epoll "$PDIR" "$IDX" < /dev/null > "$TMP/badlisten.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badlisten.out" >/dev/null
+
+echo "== hedged replicas =="
+$Q -replicas 3 "$PDIR" "$IDX" < "$TMP/q.txt" 2> "$TMP/replicas.err" | cmp - "$TMP/serial.out"
+grep -E "replicas: 3 processes, 4 queries" "$TMP/replicas.err" >/dev/null
+# a burst of many more lines than the replicas' jobs and the read
+# buffer hold: none is dropped, and none is left waiting
+for i in $(seq 100); do cat "$TMP/q.txt"; done > "$TMP/burst.txt"
+$Q "$PDIR" "$IDX" < "$TMP/burst.txt" 2> /dev/null > "$TMP/burst.want"
+timeout 60 $Q -replicas 2 "$PDIR" "$IDX" < "$TMP/burst.txt" 2> /dev/null | cmp - "$TMP/burst.want"
+# freeze one replica once the latencies are known: its query is hedged
+# to the other, and the answers are the same, in the same order
+for i in $(seq 10); do cat "$TMP/q.txt"; done > "$TMP/warm.txt"
+cat "$TMP/warm.txt" "$TMP/q.txt" "$TMP/q.txt" | $Q "$PDIR" "$IDX" 2> /dev/null > "$TMP/hedge.want"
+nwarm=$($Q "$PDIR" "$IDX" < "$TMP/warm.txt" 2> /dev/null | wc -l)
+rm -f "$TMP/hedge.fifo"
+mkfifo "$TMP/hedge.fifo"
+$Q -replicas 2 "$PDIR" "$IDX" < "$TMP/hedge.fifo" > "$TMP/hedge.out" 2> "$TMP/hedge.err" &
+hpid=$!
+exec 3> "$TMP/hedge.fifo"
+cat "$TMP/warm.txt" >&3
+for try in $(seq 100); do
+  [[ $(wc -l < "$TMP/hedge.out") -ge $((nwarm - 1)) ]] && break
+  sleep 0.1
+done
+r0=$(sed -n 's/.*replica 0 is process \([0-9]*\).*/\1/p' "$TMP/hedge.err")
+kill -STOP $r0
+cat "$TMP/q.txt" "$TMP/q.txt" >&3
+for try in $(seq 100); do
+  [[ $(wc -l < "$TMP/hedge.out") -ge $(( $(wc -l < "$TMP/hedge.want") - 1 )) ]] && break
+  sleep 0.1
+done
+kill -CONT $r0
+exec 3>&-
+wait $hpid
+cmp "$TMP/hedge.want" "$TMP/hedge.out"
+grep -E "replicas: 2 processes, 48 queries, [1-9][0-9]* hedged .* [1-9][0-9]* won by the hedge, [1-9][0-9]* cancelled" "$TMP/hedge.err" >/dev/null
+set +e
+$Q -hedge 90 "$PDIR" "$IDX" < /dev/null > "$TMP/badhedge.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badhedge.out" >/dev/null
+
+echo "== cancellation =="
+$Q -timeout 60000 "$PDIR" "$IDX" < "$TMP/q.txt" 2> "$TMP/cancel.err" | cmp - "$TMP/serial.out"
+grep -E "cancelled 0 of [0-9]+ queries" "$TMP/cancel.err" >/dev/null
+head -1 "$TMP/q.txt" > "$TMP/one.txt"
+# endless queries: the querier must notice the reader is gone, and stop
+yes "$(cat "$TMP/one.txt")" | timeout 20 $Q "$PDIR" "$IDX" 2> /dev/null | head -1 > /dev/null
+[[ ${PIPESTATUS[1]} -eq 0 ]]
+set +e
+$Q -timeout 0 "$PDIR" "$IDX" < /dev/null > "$TMP/badtimeout.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badtimeout.out" >/dev/null
+
+echo "== serving =="
+printf "a %s %s\nb %s %s 64\n" "$PDIR" "$IDX" "$PDIR" "$IDX" > "$TMP/indexes"
+sed 's/^/@b /' "$TMP/q.txt" > "$TMP/qb.txt"
+{ cat "$TMP/q.txt" "$TMP/qb.txt" "$TMP/qb.txt"; echo "!reload b"; cat "$TMP/qb.txt"; } \
+  | $Q -serve "$TMP/indexes" -workers 2 -budget 256 > "$TMP/serve.out" 2> "$TMP/serve.err"
+grep -v '^Reloaded' "$TMP/serve.out" | grep -v '^$' > "$TMP/serve.got"
+cat "$TMP/serial.out" "$TMP/serial.out" "$TMP/serial.out" "$TMP/serial.out" | grep -v '^$' | cmp - "$TMP/serve.got"
+grep -E "^Reloaded index 'b' \(generation 1\)" "$TMP/serve.out" >/dev/null
+grep -E "index 'b': [0-9]+ queries, [1-9][0-9]* answered from the cache" "$TMP/serve.err" >/dev/null
+echo "@nosuch home" | $Q -serve "$TMP/indexes" 2>&1 >/dev/null | grep "no index named 'nosuch'" >/dev/null
+printf "a %s %s 512\n" "$PDIR" "$IDX" > "$TMP/toobig"
+set +e
+$Q -serve "$TMP/toobig" -budget 256 < /dev/null > /dev/null 2>&1
+status=$?
+set -e
+[[ $status -ne 0 ]]
+
+echo "== federated queries =="
+# the same crawl twice: every result is found twice, and shown once
+sed 's/^/@a,b /' "$TMP/q.txt" | $Q -serve "$TMP/indexes" 2> /dev/null > "$TMP/fed.out"
+grep -c '^score' "$TMP/serial.out" > "$TMP/nserial"
+grep -c '^score' "$TMP/fed.out" | cmp - "$TMP/nserial"
+! grep -q '  b doc' "$TMP/fed.out"
+grep -E '^\([0-9]+ duplicate URLs hidden\)' "$TMP/fed.out" >/dev/null
+sed 's/^/@* /' "$TMP/q.txt" | $Q -k 3 -serve "$TMP/indexes" 2> /dev/null \
+  | grep -E '^Top [0-9]+ documents from 2 indexes' >/dev/null
+echo "@a,b home sort:-length" | $Q -serve "$TMP/indexes" 2>&1 >/dev/null | grep "across indexes" >/dev/null
+
+echo "== shadow evaluation =="
+# the answers are unchanged, and every engine agrees with the counters
+for engine in taat daat block; do
+  $Q -shadow $engine -sample 100 "$PDIR" "$IDX" < "$TMP/q.txt" 2> "$TMP/shadow.err" | cmp - "$TMP/serial.out"
+  grep -E "shadow $engine: compared [1-9][0-9]* of [0-9]+ queries .* 0 mismatches" "$TMP/shadow.err" >/dev/null
+done
+$Q -k 2 -shadow daat -sample 50 -workers 2 "$PDIR" "$IDX" < "$TMP/q.txt" 2>&1 >/dev/null | grep -E " 0 mismatches" >/dev/null
+set +e
+$Q -sample 10 "$PDIR" "$IDX" < /dev/null > "$TMP/badshadow.out" 2>&1
+set -e
+grep -E '^usage:' "$TMP/badshadow.out" >/dev/null
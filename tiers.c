@@ -0,0 +1,323 @@
+/*
+ * tiers.c - 'tiers' module for the CS50 TSE querier
+ *
+ * see tiers.h for more information.
+ *
+ * For a document d and andsequence S, tier-1 evaluation either finds
+ * the exact min-count of S in d, or misses d. If it misses d, then d
+ * can only match S in full if some word of S has d in tier 2, so the
+ * true contribution is at most bound(S) = max over words of tier2max.
+ * We keep, for every document seen, the sum of bound(S) over the
+ * andsequences it matched, so its slack (possible gain) is
+ *   total - matched,  where total = sum of bound(S) over all S.
+ * A document never seen in tier 1 can score at most total.
+ *
+ * Riti Singh, November 2025
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "tiers.h"
+#include "mem.h"
+
+/**************** local types ****************/
+/* acc_t: union of andsequence results, sorted by docID. */
+typedef struct acc {
+  int n;
+  int *docs;
+  int *scores;
+  int *matched;        // sum of bound(S) over andsequences that hit doc
+} acc_t;
+
+/* tierdoc_t: a ranked document plus how much it could still gain. */
+typedef struct tierdoc {
+  docscore_t ds;
+  int slack;
+} tierdoc_t;
+
+/**************** local functions ****************/
+static int  rank_tier1(postings_t *postings, const query_t *query,
+                       const bitmap_t *allowed, tierdoc_t **ranked_out,
+                       int *total_out);
+static int  intersect_tier1(term_t **terms, const int nterms,
+                            const bitmap_t *allowed,
+                            int **docs_out, int **scores_out);
+static void acc_merge(acc_t *acc, const int *docs, const int *scores,
+                      const int n, const int bound);
+static int  cmp_tierdoc(const void *a, const void *b);
+
+/**************** tiers_topk ****************/
+/* see tiers.h for description */
+bool
+tiers_topk(postings_t *postings, const query_t *query,
+           const bitmap_t *allowed, const int k,
+           docscore_t **docs_out, int *ndocs_out)
+{
+  if (postings == NULL || query == NULL || k <= 0
+      || docs_out == NULL || ndocs_out == NULL) {
+    return false;
+  }
+
+  int total = 0;
+  tierdoc_t *ranked = NULL;
+  int n = rank_tier1(postings, query, allowed, &ranked, &total);
+
+  /* decide whether the top k is provably final */
+  bool proven;
+  int nout;
+  if (total == 0) {
+    proven = true;              // tier 2 cannot change any score
+    nout = (n < k) ? n : k;
+  } else if (n < k) {
+    proven = false;             // underfilled
+    nout = 0;
+  } else {
+    int kth = ranked[k-1].ds.score;
+    proven = (total < kth);     // unseen documents cannot catch up
+    for (int i = 0; proven && i < k; i++) {
+      if (ranked[i].slack != 0) {
+        proven = false;         // a top-k score is not exact
+      }
+    }
+    for (int i = k; proven && i < n; i++) {
+      if (ranked[i].ds.score + ranked[i].slack >= kth) {
+        proven = false;         // a lower document could catch up
+      }
+    }
+    nout = k;
+  }
+
+  if (proven) {
+    docscore_t *docs = mem_malloc_assert((nout + 1) * sizeof(docscore_t),
+                                         "tiers_topk");
+    for (int i = 0; i < nout; i++) {
+      docs[i] = ranked[i].ds;
+    }
+    *docs_out = docs;
+    *ndocs_out = nout;
+  }
+  mem_free(ranked);
+  return proven;
+}
+
+/**************** tiers_final ****************/
+/* see tiers.h for description */
+int
+tiers_final(postings_t *postings, const query_t *query,
+            const bitmap_t *allowed, docscore_t **docs_out)
+{
+  if (postings == NULL || query == NULL || docs_out == NULL) {
+    return 0;
+  }
+
+  int total = 0;
+  tierdoc_t *ranked = NULL;
+  int n = rank_tier1(postings, query, allowed, &ranked, &total);
+
+  /* ceiling[i]: the most any document ranked at i or below, or never
+   * seen, could score; a prefix is final when its last score beats the
+   * ceiling just below it and no score in it could still grow */
+  int *ceiling = mem_malloc_assert((n + 1) * sizeof(int), "tiers_final");
+  ceiling[n] = total;
+  for (int i = n - 1; i >= 0; i--) {
+    int most = ranked[i].ds.score + ranked[i].slack;
+    ceiling[i] = (most > ceiling[i+1]) ? most : ceiling[i+1];
+  }
+
+  int nfinal = 0;
+  if (total == 0) {
+    nfinal = n;                 // tier 2 cannot change anything
+  } else {
+    for (int p = 1; p <= n && ranked[p-1].slack == 0; p++) {
+      if (ceiling[p] < ranked[p-1].ds.score) {
+        nfinal = p;
+      }
+    }
+  }
+  mem_free(ceiling);
+
+  docscore_t *docs = mem_malloc_assert((nfinal + 1) * sizeof(docscore_t),
+                                       "tiers_final");
+  for (int i = 0; i < nfinal; i++) {
+    docs[i] = ranked[i].ds;
+  }
+  mem_free(ranked);
+  *docs_out = docs;
+  return nfinal;
+}
+
+/* rank_tier1 */
+/* Evaluate query over tier-1 postings. Returns the number of documents
+ * seen, in a new array *ranked_out (which the caller frees) in ranked
+ * order of their tier-1 scores, each with its slack; *total_out is the
+ * most a document never seen could score.
+ */
+static int
+rank_tier1(postings_t *postings, const query_t *query,
+           const bitmap_t *allowed, tierdoc_t **ranked_out, int *total_out)
+{
+  acc_t acc = { 0, NULL, NULL, NULL };
+  int total = 0;
+  term_t **terms = NULL;
+
+  for (int s = 0; s < query->nseqs; s++) {
+    const andseq_t *seq = &query->seqs[s];
+    mem_free(terms);
+    terms = mem_malloc_assert(seq->nterms * sizeof(term_t*), "rank_tier1");
+
+    /* a word missing from the index empties the whole andsequence */
+    bool empty = false;
+    int bound = 0;
+    for (int t = 0; t < seq->nterms; t++) {
+      terms[t] = postings_find(postings, seq->terms[t]);
+      if (terms[t] == NULL) {
+        empty = true;
+        break;
+      }
+      if (terms[t]->tier2max > bound) {
+        bound = terms[t]->tier2max;
+      }
+    }
+    if (empty) {
+      continue;
+    }
+
+    int *docs = NULL, *scores = NULL;
+    int n = intersect_tier1(terms, seq->nterms, allowed, &docs, &scores);
+    acc_merge(&acc, docs, scores, n, bound);
+    mem_free(docs);
+    mem_free(scores);
+    total += bound;
+  }
+  mem_free(terms);
+
+  tierdoc_t *ranked = mem_malloc_assert((acc.n + 1) * sizeof(tierdoc_t),
+                                        "rank_tier1");
+  for (int i = 0; i < acc.n; i++) {
+    ranked[i].ds.docID = acc.docs[i];
+    ranked[i].ds.score = acc.scores[i];
+    ranked[i].slack = total - acc.matched[i];
+  }
+  int n = acc.n;
+  mem_free(acc.docs);
+  mem_free(acc.scores);
+  mem_free(acc.matched);
+  qsort(ranked, n, sizeof(tierdoc_t), cmp_tierdoc);
+
+  *ranked_out = ranked;
+  *total_out = total;
+  return n;
+}
+
+/* intersect_tier1 */
+/* Intersect the tier-1 lists of nterms terms, scoring each common
+ * document with the minimum count. The shortest list drives the
+ * intersection and the others are probed with postings_seek; documents
+ * outside allowed (if not NULL) are skipped before any probing.
+ * Returns the number of results, in new arrays sorted by docID.
+ */
+static int
+intersect_tier1(term_t **terms, const int nterms, const bitmap_t *allowed,
+                int **docs_out, int **scores_out)
+{
+  int shortest = 0;
+  for (int t = 1; t < nterms; t++) {
+    if (terms[t]->tier1.n < terms[shortest]->tier1.n) {
+      shortest = t;
+    }
+  }
+  const plist_t *driver = &terms[shortest]->tier1;
+
+  int *docs = mem_malloc_assert((driver->n + 1) * sizeof(int),
+                                "intersect_tier1");
+  int *scores = mem_malloc_assert((driver->n + 1) * sizeof(int),
+                                  "intersect_tier1");
+  int *pos = mem_calloc_assert(nterms, sizeof(int), "intersect_tier1");
+
+  int n = 0;
+  for (int i = 0; i < driver->n; i++) {
+    int doc = driver->docs[i];
+    if (allowed != NULL && !bitmap_test(allowed, doc)) {
+      continue;
+    }
+    int score = driver->counts[i];
+    bool found = true;
+    for (int t = 0; t < nterms && found; t++) {
+      if (t == shortest) {
+        continue;
+      }
+      const plist_t *list = &terms[t]->tier1;
+      pos[t] = postings_seek(list, pos[t], doc);
+      if (pos[t] >= list->n || list->docs[pos[t]] != doc) {
+        found = false;
+      } else if (list->counts[pos[t]] < score) {
+        score = list->counts[pos[t]];
+      }
+    }
+    if (found) {
+      docs[n] = doc;
+      scores[n] = score;
+      n++;
+    }
+  }
+  mem_free(pos);
+
+  *docs_out = docs;
+  *scores_out = scores;
+  return n;
+}
+
+/* acc_merge */
+/* Union one andsequence's results into acc, summing scores and adding
+ * bound to the matched total of every document in the andsequence.
+ */
+static void
+acc_merge(acc_t *acc, const int *docs, const int *scores, const int n,
+          const int bound)
+{
+  int cap = acc->n + n + 1;
+  int *mdocs = mem_malloc_assert(cap * sizeof(int), "acc_merge");
+  int *mscores = mem_malloc_assert(cap * sizeof(int), "acc_merge");
+  int *mmatched = mem_malloc_assert(cap * sizeof(int), "acc_merge");
+
+  int i = 0, j = 0, m = 0;
+  while (i < acc->n || j < n) {
+    if (j >= n || (i < acc->n && acc->docs[i] < docs[j])) {
+      mdocs[m] = acc->docs[i];
+      mscores[m] = acc->scores[i];
+      mmatched[m] = acc->matched[i];
+      i++;
+    } else if (i >= acc->n || docs[j] < acc->docs[i]) {
+      mdocs[m] = docs[j];
+      mscores[m] = scores[j];
+      mmatched[m] = bound;
+      j++;
+    } else {
+      mdocs[m] = docs[j];
+      mscores[m] = acc->scores[i] + scores[j];
+      mmatched[m] = acc->matched[i] + bound;
+      i++;
+      j++;
+    }
+    m++;
+  }
+
+  mem_free(acc->docs);
+  mem_free(acc->scores);
+  mem_free(acc->matched);
+  acc->docs = mdocs;
+  acc->scores = mscores;
+  acc->matched = mmatched;
+  acc->n = m;
+}
+
+/* cmp_tierdoc */
+/* qsort comparison: ranked order of the embedded docscore_t. */
+static int
+cmp_tierdoc(const void *a, const void *b)
+{
+  const tierdoc_t *ta = a;
+  const tierdoc_t *tb = b;
+  return docscore_cmp(&ta->ds, &tb->ds);
+}
@@ -0,0 +1,60 @@
+/*
+ * tiers.h - header file for the querier's 'tiers' module
+ *
+ * Answers top-K queries from tier 1 of the postings (see postings.h)
+ * when the answer can be proven identical to the one the full index
+ * would give, and finds the leading results of any query that tier 1
+ * already proves final. Tier-2 counts are bounded by each term's
+ * tier2max, which bounds how much any document could gain from
+ * postings we skipped.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __TIERS_H
+#define __TIERS_H
+
+#include <stdbool.h>
+#include "postings.h"
+#include "query.h"
+#include "bitmap.h"
+
+/**************** tiers_topk ****************/
+/* Evaluate query over tier-1 postings and check whether its top k
+ * results are final.
+ *
+ * Caller provides:
+ *   postings already split with postings_tier, a parsed query, k > 0,
+ *   and allowed: the documents a host filter allows, or NULL for all.
+ * We return:
+ *   true if tier 1 alone proves the top-k list: every document in it
+ *   has an exact score, and no other document (seen or unseen) can
+ *   reach the k'th score. Then *docs_out is a new array, which the
+ *   caller frees with mem_free, of *ndocs_out <= k results in ranked
+ *   order; it may hold fewer than k if tier 2 cannot contribute at all.
+ *   false if the caller must fall back to the full index (the top k is
+ *   underfilled or not provably correct); nothing is allocated then.
+ */
+bool tiers_topk(postings_t *postings, const query_t *query,
+                const bitmap_t *allowed, const int k,
+                docscore_t **docs_out, int *ndocs_out);
+
+/**************** tiers_final ****************/
+/* Evaluate query over tier-1 postings and return how many of its
+ * leading results are already final.
+ *
+ * Caller provides:
+ *   postings already split with postings_tier, a parsed query, and
+ *   allowed: the documents a host filter allows, or NULL for all.
+ * We return:
+ *   the length p of the longest prefix of the ranked results that tier
+ *   1 proves: every document in it has an exact score, and no other
+ *   document (seen or unseen) can reach the p'th score, so the full
+ *   index would rank the same p documents first, in the same order.
+ *   *docs_out is a new array, which the caller frees with mem_free,
+ *   holding them in ranked order; it is allocated even when p is 0.
+ */
+int tiers_final(postings_t *postings, const query_t *query,
+                const bitmap_t *allowed, docscore_t **docs_out);
+
+#endif // __TIERS_H
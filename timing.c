@@ -0,0 +1,23 @@
+/*
+ * timing.c - 'timing' module for the CS50 TSE querier
+ *
+ * see timing.h for more information.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* clock_gettime is POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <time.h>
+#include "timing.h"
+
+/**************** timing_ms ****************/
+/* see timing.h for description */
+double
+timing_ms(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+}
@@ -0,0 +1,19 @@
+/*
+ * timing.h - header file for the querier's 'timing' module
+ *
+ * The monotonic clock, in milliseconds, that queries, latencies and
+ * deadlines are timed with.
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __TIMING_H
+#define __TIMING_H
+
+/**************** timing_ms ****************/
+/* Return a monotonic clock reading in milliseconds, from an arbitrary
+ * start; only differences between readings mean anything.
+ */
+double timing_ms(void);
+
+#endif // __TIMING_H
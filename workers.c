@@ -0,0 +1,397 @@
+/*
+ * workers.c - 'workers' module for the CS50 TSE querier
+ *
+ * see workers.h for more information.
+ *
+ * One mutex guards the whole pool: the queues, the list of lines in
+ * submission order, and the counts. A worker holds it only to take a
+ * line and to hand back the answer, never while answering; whoever
+ * prints holds it only to unlink an answer from the list.
+ *
+ * Riti Singh, November 2025
+ */
+
+/* open_memstream is POSIX */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "workers.h"
+#include "timing.h"
+#include "mem.h"
+
+/**************** local types ****************/
+/* job_t: one submitted line, and then its answer. */
+typedef struct job {
+  char *line;
+  char *output;            // the answer, once done
+  size_t length;
+  bool done;
+  double submitted;        // ms
+  struct job *next;        // next in its queue
+  struct job *nextOrder;   // next in submission order
+} job_t;
+
+/* queue_t: lines waiting for one group of workers. */
+typedef struct queue {
+  job_t *head, *tail;
+  int pending;             // submitted and not yet answered
+  workerstats_t stats;
+  pthread_cond_t ready;    // signalled when a line is queued
+} queue_t;
+
+/* worker_t: one thread of the pool. */
+typedef struct worker {
+  workers_t *pool;
+  int queue;
+  void *ctx;
+  pthread_t thread;
+} worker_t;
+
+struct workers {
+  int nworkers;
+  int nqueues;
+  worker_t *workers;
+  queue_t *queues;
+  job_t *first, *last;     // submission order, until printed
+  int unprinted;
+  bool stop;
+  startfn_t start;
+  workfn_t work;
+  FILE *out;               // after workers_output: where the printer prints
+  bool ordered;            // ...in submission order
+  pthread_t printer;
+  pthread_mutex_t lock;
+  pthread_cond_t done;     // signalled when an answer is ready
+  pthread_cond_t printed;  // signalled when the printer has printed one
+};
+
+/**************** local functions ****************/
+static void *worker_run(void *arg);
+static void *printer_run(void *arg);
+static job_t *take_ready(workers_t *pool);
+static void print_job(job_t *job, FILE *out);
+
+/**************** workers_new ****************/
+/* see workers.h for description */
+workers_t *
+workers_new(const int nworkers, const int nqueues, const int queueOf[],
+            void *ctxs[], startfn_t start, workfn_t work)
+{
+  if (nworkers < 1 || nworkers > WORKERS_MAX || nqueues < 1
+      || nqueues > WORKERS_MAX || ctxs == NULL || work == NULL) {
+    return NULL;
+  }
+
+  workers_t *pool = mem_calloc_assert(1, sizeof(workers_t), "workers_new");
+  pool->nworkers = nworkers;
+  pool->nqueues = nqueues;
+  pool->start = start;
+  pool->work = work;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  pthread_cond_init(&pool->printed, NULL);
+
+  pool->queues = mem_calloc_assert(nqueues, sizeof(queue_t), "workers_new");
+  for (int q = 0; q < nqueues; q++) {
+    pthread_cond_init(&pool->queues[q].ready, NULL);
+  }
+
+  pool->workers = mem_calloc_assert(nworkers, sizeof(worker_t),
+                                    "workers_new");
+  for (int w = 0; w < nworkers; w++) {
+    worker_t *worker = &pool->workers[w];
+    worker->pool = pool;
+    worker->queue = (queueOf == NULL) ? 0 : queueOf[w];
+    worker->ctx = ctxs[w];
+    pool->queues[worker->queue].stats.nworkers++;
+    if (pthread_create(&worker->thread, NULL, worker_run, worker) != 0) {
+      fprintf(stderr, "workers_new: cannot start threads\n");
+      exit(2);
+    }
+  }
+  return pool;
+}
+
+/**************** workers_output ****************/
+/* see workers.h for description */
+void
+workers_output(workers_t *pool, FILE *out, const bool ordered)
+{
+  if (pool == NULL || out == NULL || pool->out != NULL) {
+    return;
+  }
+  pool->out = out;
+  pool->ordered = ordered;
+  if (pthread_create(&pool->printer, NULL, printer_run, pool) != 0) {
+    fprintf(stderr, "workers_output: cannot start threads\n");
+    exit(2);
+  }
+}
+
+/**************** workers_submit ****************/
+/* see workers.h for description */
+void
+workers_submit(workers_t *pool, const char *line)
+{
+  workers_submit_to(pool, -1, line);
+}
+
+/**************** workers_submit_to ****************/
+/* see workers.h for description */
+void
+workers_submit_to(workers_t *pool, const int queue, const char *line)
+{
+  if (pool == NULL || line == NULL || queue < -1 || queue >= pool->nqueues) {
+    return;
+  }
+
+  job_t *job = mem_calloc_assert(1, sizeof(job_t), "workers_submit");
+  job->line = mem_malloc_assert(strlen(line) + 1, "workers_submit");
+  strcpy(job->line, line);
+  job->submitted = timing_ms();
+
+  pthread_mutex_lock(&pool->lock);
+
+  /* else the queue with the fewest unanswered lines per worker */
+  int best = queue;
+  for (int q = 0; queue < 0 && q < pool->nqueues; q++) {
+    const queue_t *qq = &pool->queues[q];
+    if (qq->stats.nworkers == 0) {
+      continue;
+    }
+    if (best < 0 || (long) qq->pending * pool->queues[best].stats.nworkers
+        < (long) pool->queues[best].pending * qq->stats.nworkers) {
+      best = q;
+    }
+  }
+  queue_t *target = &pool->queues[best];
+  if (target->tail == NULL) {
+    target->head = job;
+  } else {
+    target->tail->next = job;
+  }
+  target->tail = job;
+  target->pending++;
+
+  if (pool->last == NULL) {
+    pool->first = job;
+  } else {
+    pool->last->nextOrder = job;
+  }
+  pool->last = job;
+  pool->unprinted++;
+
+  pthread_cond_signal(&target->ready);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**************** workers_drain ****************/
+/* see workers.h for description */
+void
+workers_drain(workers_t *pool, const int maxPending, FILE *out)
+{
+  if (pool == NULL || out == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    job_t *job;
+    while (pool->out == NULL && (job = take_ready(pool)) != NULL) {
+      /* print without holding up the workers */
+      pthread_mutex_unlock(&pool->lock);
+      print_job(job, out);
+      pthread_mutex_lock(&pool->lock);
+      pool->unprinted--;
+    }
+    if (pool->unprinted <= maxPending) {
+      break;
+    }
+    pthread_cond_wait((pool->out == NULL) ? &pool->done : &pool->printed,
+                      &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  fflush(out);
+}
+
+/**************** workers_stats ****************/
+/* see workers.h for description */
+void
+workers_stats(workers_t *pool, const int queue, workerstats_t *stats)
+{
+  if (pool == NULL || queue < 0 || queue >= pool->nqueues || stats == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  *stats = pool->queues[queue].stats;
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/**************** workers_delete ****************/
+/* see workers.h for description */
+void
+workers_delete(workers_t *pool)
+{
+  if (pool == NULL) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = true;
+  for (int q = 0; q < pool->nqueues; q++) {
+    pthread_cond_broadcast(&pool->queues[q].ready);
+  }
+  pthread_cond_broadcast(&pool->done);
+  pthread_mutex_unlock(&pool->lock);
+  for (int w = 0; w < pool->nworkers; w++) {
+    pthread_join(pool->workers[w].thread, NULL);
+  }
+  if (pool->out != NULL) {
+    pthread_join(pool->printer, NULL);
+  }
+
+  while (pool->first != NULL) {
+    job_t *job = pool->first;
+    pool->first = job->nextOrder;
+    free(job->output);
+    mem_free(job->line);
+    mem_free(job);
+  }
+  for (int q = 0; q < pool->nqueues; q++) {
+    pthread_cond_destroy(&pool->queues[q].ready);
+  }
+  pthread_cond_destroy(&pool->printed);
+  pthread_cond_destroy(&pool->done);
+  pthread_mutex_destroy(&pool->lock);
+  mem_free(pool->queues);
+  mem_free(pool->workers);
+  mem_free(pool);
+}
+
+/* worker_run */
+/* One worker's thread: run start, then answer lines from its queue
+ * until the pool stops and the queue is empty. arg is a worker_t.
+ */
+static void *
+worker_run(void *arg)
+{
+  worker_t *worker = arg;
+  workers_t *pool = worker->pool;
+  queue_t *queue = &pool->queues[worker->queue];
+
+  if (pool->start != NULL) {
+    pool->start(worker->ctx);
+  }
+
+  pthread_mutex_lock(&pool->lock);
+  for (;;) {
+    while (queue->head == NULL && !pool->stop) {
+      pthread_cond_wait(&queue->ready, &pool->lock);
+    }
+    job_t *job = queue->head;
+    if (job == NULL) {
+      break;                  // stopped, and nothing left
+    }
+    queue->head = job->next;
+    if (queue->head == NULL) {
+      queue->tail = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    double start = timing_ms();
+    FILE *out = open_memstream(&job->output, &job->length);
+    if (out == NULL) {
+      fprintf(stderr, "workers: out of memory\n");
+      exit(2);
+    }
+    pool->work(worker->ctx, job->line, out);
+    fclose(out);
+    double end = timing_ms();
+
+    pthread_mutex_lock(&pool->lock);
+    job->done = true;
+    queue->pending--;
+    queue->stats.jobs++;
+    queue->stats.msbusy += end - start;
+    queue->stats.mslatency += end - job->submitted;
+    pthread_cond_broadcast(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/* printer_run */
+/* The printing thread of workers_output: print answers as take_ready
+ * allows, until the pool stops. arg is the pool.
+ */
+static void *
+printer_run(void *arg)
+{
+  workers_t *pool = arg;
+  pthread_mutex_lock(&pool->lock);
+  while (!pool->stop) {
+    job_t *job = take_ready(pool);
+    if (job == NULL) {
+      pthread_cond_wait(&pool->done, &pool->lock);
+      continue;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    print_job(job, pool->out);
+    fflush(pool->out);
+    pthread_mutex_lock(&pool->lock);
+    pool->unprinted--;          // only now is it on out
+    pthread_cond_broadcast(&pool->printed);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/* take_ready */
+/* With the lock held: unlink and return the next answer that may be
+ * printed, or NULL if none may yet. In submission order that is the
+ * first, if it is done; otherwise the earliest submitted that is done.
+ */
+static job_t *
+take_ready(workers_t *pool)
+{
+  job_t *prev = NULL;
+  job_t *job = pool->first;
+  if (pool->out == NULL || pool->ordered) {
+    if (job == NULL || !job->done) {
+      return NULL;
+    }
+  } else {
+    while (job != NULL && !job->done) {
+      prev = job;
+      job = job->nextOrder;
+    }
+    if (job == NULL) {
+      return NULL;
+    }
+  }
+
+  if (prev == NULL) {
+    pool->first = job->nextOrder;
+  } else {
+    prev->nextOrder = job->nextOrder;
+  }
+  if (pool->last == job) {
+    pool->last = prev;
+  }
+  return job;
+}
+
+/* print_job */
+/* Print job's answer onto out, and free the job. */
+static void
+print_job(job_t *job, FILE *out)
+{
+  fwrite(job->output, 1, job->length, out);
+  free(job->output);          // from open_memstream
+  mem_free(job->line);
+  mem_free(job);
+}
@@ -0,0 +1,94 @@
+/*
+ * workers.h - header file for the querier's 'workers' module
+ *
+ * A pool of threads that answer query lines, with the answers printed
+ * in the order the lines came in. Each worker serves one queue; a line
+ * goes to the queue it is submitted to, or else to the queue with the
+ * fewest unanswered lines per worker. A worker writes its answer to a
+ * memory buffer, which the submitting thread prints once every earlier
+ * answer has been printed; or, after workers_output, a printing thread
+ * of the pool's own prints as soon as it may, optionally without
+ * waiting for earlier answers.
+ *
+ * Each worker has its own context (for the querier: the index replica
+ * and caches it reads), and a start function that runs on its thread
+ * before any work (for the querier: pinning it to a NUMA node).
+ *
+ * Riti Singh, November 2025
+ */
+
+#ifndef __WORKERS_H
+#define __WORKERS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* most workers in a pool, and queues */
+#define WORKERS_MAX 256
+
+typedef struct workers workers_t;
+
+/* workfn_t: answer line, which the function may modify, onto out. */
+typedef void (*workfn_t)(void *ctx, char *line, FILE *out);
+
+/* startfn_t: prepare a worker's thread; called on it before any work. */
+typedef void (*startfn_t)(void *ctx);
+
+/* workerstats_t: what one queue's workers have done so far. */
+typedef struct workerstats {
+  int nworkers;        // workers serving the queue
+  long jobs;           // lines answered
+  double msbusy;       // ms spent answering them
+  double mslatency;    // ms from submission to answer, summed
+} workerstats_t;
+
+/**************** workers_new ****************/
+/* Start nworkers threads (1..WORKERS_MAX) serving nqueues queues:
+ * worker w serves queue queueOf[w] (or queue 0 if queueOf is NULL)
+ * with context ctxs[w], first calling start(ctxs[w]) if start is not
+ * NULL. Every queue must have a worker. Caller must workers_delete the
+ * pool. Exits if threads cannot be started.
+ */
+workers_t *workers_new(const int nworkers, const int nqueues,
+                       const int queueOf[], void *ctxs[],
+                       startfn_t start, workfn_t work);
+
+/**************** workers_output ****************/
+/* From now on, print every answer onto out (flushing it) as soon as it
+ * is ready, on a thread of the pool's own: in submission order if
+ * ordered, else as each is finished. Call it at most once, before
+ * submitting anything. Exits if the thread cannot be started.
+ */
+void workers_output(workers_t *pool, FILE *out, const bool ordered);
+
+/**************** workers_submit ****************/
+/* Copy line and queue it for an answer. */
+void workers_submit(workers_t *pool, const char *line);
+
+/**************** workers_submit_to ****************/
+/* Copy line and queue it for an answer on queue (0..nqueues-1), or, if
+ * queue is -1, on the queue with the fewest unanswered lines per
+ * worker.
+ */
+void workers_submit_to(workers_t *pool, const int queue, const char *line);
+
+/**************** workers_drain ****************/
+/* Print onto out, in submission order, every answer that is ready and
+ * follows only printed ones; wait while more than maxPending lines
+ * remain unprinted. workers_drain(pool, 0, out) prints everything.
+ * After workers_output, the pool's thread does the printing, and this
+ * only waits.
+ */
+void workers_drain(workers_t *pool, const int maxPending, FILE *out);
+
+/**************** workers_stats ****************/
+/* Fill *stats with queue's counts so far. */
+void workers_stats(workers_t *pool, const int queue, workerstats_t *stats);
+
+/**************** workers_delete ****************/
+/* Stop the workers, once they finish the lines queued, and free the
+ * pool; answers not yet printed are dropped. NULL is ignored.
+ */
+void workers_delete(workers_t *pool);
+
+#endif // __WORKERS_H